@@ -25,16 +25,26 @@
 #define MAX_NUM_SAMPLES             (1 << 28)
 #define MAX_NUM_CHANS               (1 << 8)
 
-void print_data (uint32_t chan, uint32_t *data, uint32_t size)
+void print_data (uint32_t chan, uint32_t *data, uint32_t size, bool soa)
 {
     /* FIXME: Make it more generic */
     if (chan == 0 /* Only ADC */ ) {
         int16_t *raw_data16 = (int16_t *) data;
-        for (uint32_t i = 0; i < (size/sizeof(uint16_t)) / 4; i++) {
+        uint32_t num_samples = (size/sizeof(uint16_t)) / 4;
+        for (uint32_t i = 0; i < num_samples; i++) {
             if (zctx_interrupted) {
                 break;
             }
 
+            if (soa) {
+                printf ("%6u\t %8d\t %8d\t %8d\t %8d\n", i,
+                        raw_data16[i],
+                        raw_data16[num_samples+i],
+                        raw_data16[(2*num_samples)+i],
+                        raw_data16[(3*num_samples)+i]);
+                continue;
+            }
+
             printf ("%6u\t %8d\t %8d\t %8d\t %8d\n", i,
                     raw_data16[(i*4)],
                     raw_data16[(i*4)+1],
@@ -44,11 +54,21 @@ void print_data (uint32_t chan, uint32_t *data, uint32_t size)
     }
     else {
         int32_t *raw_data32 = (int32_t *) data;
-        for (uint32_t i = 0; i < (size/sizeof(uint32_t)) / 4; i++) {
+        uint32_t num_samples = (size/sizeof(uint32_t)) / 4;
+        for (uint32_t i = 0; i < num_samples; i++) {
             if (zctx_interrupted) {
                 break;
             }
 
+            if (soa) {
+                printf ("%6u\t %8d\t %8d\t %8d\t %8d\n", i,
+                        raw_data32[i],
+                        raw_data32[num_samples+i],
+                        raw_data32[(2*num_samples)+i],
+                        raw_data32[(3*num_samples)+i]);
+                continue;
+            }
+
             printf ("%6u\t %8d\t %8d\t %8d\t %8d\n", i,
                     raw_data32[(i*4)],
                     raw_data32[(i*4)+1],
@@ -58,13 +78,115 @@ void print_data (uint32_t chan, uint32_t *data, uint32_t size)
     }
 }
 
+void print_decim_curve (bpm_client_t *bpm_client, char *service,
+        acq_req_t *acq_req, uint32_t num_buckets)
+{
+    smio_acq_decim_curve_t *curve = zmalloc (sizeof (*curve));
+
+    if (bpm_acq_start (bpm_client, service, acq_req) != BPM_CLIENT_SUCCESS ||
+            func_polling (bpm_client, ACQ_NAME_CHECK_DATA_ACQUIRE, service,
+                NULL, NULL, 50) != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:acq]: Acquisition failed\n");
+        goto err_acq;
+    }
+
+    if (bpm_acq_get_decim_curve (bpm_client, service, acq_req->chan,
+                num_buckets, curve) != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:acq]: bpm_acq_get_decim_curve failed\n");
+        goto err_acq;
+    }
+
+    /* min/max/mean of each of the 4 components */
+    for (uint32_t i = 0; i < curve->num_buckets; i++) {
+        if (zctx_interrupted) {
+            break;
+        }
+
+        smio_acq_decim_bucket_t *bucket = &curve->buckets[i];
+        printf ("%6u", i);
+        for (uint32_t j = 0; j < SMIO_ACQ_DECIM_NUM_COMP; j++) {
+            printf ("\t %8d %8d %8d", bucket->min[j], bucket->max[j],
+                    bucket->mean[j]);
+        }
+        printf ("\n");
+    }
+
+err_acq:
+    free (curve);
+}
+
+/* Positions of a position channel or, with ds_mode_str, computed from the
+ * amplitudes of an amplitude channel */
+void print_pos_curve (bpm_client_t *bpm_client, char *service,
+        acq_trans_t *acq_trans, char *ds_mode_str)
+{
+    uint32_t num_samples = (acq_trans->req.num_samples +
+            acq_trans->req.num_samples_post)*
+        (acq_trans->req.num_shots == 0 ? 1 : acq_trans->req.num_shots);
+    uint32_t data_size = num_samples*SMIO_ACQ_NUM_COMP*sizeof (double);
+    double *pos = (double *) zmalloc (data_size);
+    acq_trans_t pos_trans = {.req = acq_trans->req,
+                             .block = {
+                                        .data = (uint32_t *) pos,
+                                        .data_size = data_size,
+                                      }
+                            };
+
+    if (bpm_acq_start (bpm_client, service, &pos_trans.req) != BPM_CLIENT_SUCCESS ||
+            func_polling (bpm_client, ACQ_NAME_CHECK_DATA_ACQUIRE, service,
+                NULL, NULL, 50) != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:acq]: Acquisition failed\n");
+        goto err_acq;
+    }
+
+    bpm_client_err_e err = (ds_mode_str == NULL) ?
+        bpm_acq_get_pos_curve (bpm_client, service, &pos_trans) :
+        bpm_acq_get_ds_curve (bpm_client, service, &pos_trans,
+                strtoul (ds_mode_str, NULL, 10));
+    if (err != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:acq]: Could not get the positions\n");
+        goto err_acq;
+    }
+
+    /* X and Y in nm, Q and SUM */
+    uint32_t num_read = pos_trans.block.bytes_read/(SMIO_ACQ_NUM_COMP*sizeof (double));
+    for (uint32_t i = 0; i < num_read; i++) {
+        if (zctx_interrupted) {
+            break;
+        }
+
+        printf ("%6u\t %14.3f %14.3f %14.6f %14.3f\n", i,
+                pos[(i*4)],
+                pos[(i*4)+1],
+                pos[(i*4)+2],
+                pos[(i*4)+3]);
+    }
+
+err_acq:
+    free (pos);
+}
+
 void print_help (char *program_name)
 {
     printf( "Usage: %s [options]\n"
             "\t-h This help message\n"
             "\t-v Verbose output\n"
             "\t-b <broker_endpoint> Broker endpoint\n"
-            "\t-s <num_samples_str> Number of samples\n"
+            "\t-s <num_samples_str> Number of samples (pre-trigger samples, with a trigger)\n"
+            "\t-p <num_samples_post_str> Number of post-trigger samples\n"
+            "\t-shots <num_shots_str> Number of shots, one per trigger. More than\n"
+            "\t   one requires -s 0 and -p\n"
+            "\t-decim <num_buckets_str> Get the min/max/mean of this many buckets\n"
+            "\t   of samples, instead of all of the samples\n"
+            "\t-soa Have the server deinterleave the samples in columns\n"
+            "\t-nm Get the positions calibrated by the server, X and Y in nm\n"
+            "\t   (position channels only)\n"
+            "\t-ds <mode = [0 = delta over sum|1 = partial delta over sum]>\n"
+            "\t   Get the positions computed by the server from the amplitudes\n"
+            "\t   (ADC and amplitude channels only)\n"
+            "\t-gen <gen_str> Don't acquire. Wait for an acquisition newer than\n"
+            "\t   generation <gen_str>, started by another client, and read it\n"
+            "\t-trig <trigger type = [0 = skip|1 = external|2 = data-driven|3 = software]>\n"
             "\t-board <AMC board = [0|1|2|3|4|5]>\n"
             "\t-bpm <BPM number = [0|1]>\n"
             "\t-ch <chan_str> Acquisition channel\n"
@@ -74,8 +196,16 @@ void print_help (char *program_name)
 int main (int argc, char *argv [])
 {
     int verbose = 0;
+    bool soa = false;
+    bool nm = false;
     char *broker_endp = NULL;
     char *num_samples_str = NULL;
+    char *num_samples_post_str = NULL;
+    char *num_shots_str = NULL;
+    char *num_buckets_str = NULL;
+    char *ds_mode_str = NULL;
+    char *gen_str = NULL;
+    char *trig_str = NULL;
     char *board_number_str = NULL;
     char *bpm_number_str = NULL;
     char *chan_str = NULL;
@@ -95,6 +225,12 @@ int main (int argc, char *argv [])
         if (streq(argv[i], "-v")) {
             verbose = 1;
         }
+        else if (streq(argv[i], "-soa")) {
+            soa = true;
+        }
+        else if (streq(argv[i], "-nm")) {
+            nm = true;
+        }
         else if (streq(argv[i], "-h"))
         {
             print_help (argv [0]);
@@ -106,6 +242,24 @@ int main (int argc, char *argv [])
         else if (streq (argv[i], "-s")) { /* s: samples */
             str_p = &num_samples_str;
         }
+        else if (streq (argv[i], "-p")) { /* p: post-trigger samples */
+            str_p = &num_samples_post_str;
+        }
+        else if (streq (argv[i], "-shots")) { /* shots: number of shots */
+            str_p = &num_shots_str;
+        }
+        else if (streq (argv[i], "-decim")) { /* decim: number of buckets */
+            str_p = &num_buckets_str;
+        }
+        else if (streq (argv[i], "-ds")) { /* ds: position computation */
+            str_p = &ds_mode_str;
+        }
+        else if (streq (argv[i], "-gen")) { /* gen: generation already read */
+            str_p = &gen_str;
+        }
+        else if (streq (argv[i], "-trig")) { /* trig: trigger type */
+            str_p = &trig_str;
+        }
         else if (streq (argv[i], "-ch")) { /* ch: channel */
             str_p = &chan_str;
         }
@@ -198,21 +352,88 @@ int main (int argc, char *argv [])
         }
     }
 
+    uint32_t num_samples_post = 0;
+    if (num_samples_post_str != NULL) {
+        num_samples_post = strtoul (num_samples_post_str, NULL, 10);
+
+        if (num_samples + num_samples_post > MAX_NUM_SAMPLES) {
+            fprintf (stderr, "[client:acq]: Number of post-trigger samples too big! "
+                    "Defaulting to: %u\n", MAX_NUM_SAMPLES - num_samples);
+            num_samples_post = MAX_NUM_SAMPLES - num_samples;
+        }
+    }
+
+    uint32_t num_shots = 1;
+    if (num_shots_str != NULL) {
+        num_shots = strtoul (num_shots_str, NULL, 10);
+
+        /* The shots of a multi-shot acquisition start at their trigger */
+        if (num_shots == 0 || (num_shots > 1 && (num_samples != 0 ||
+                        num_samples_post == 0)) ||
+                (num_samples + num_samples_post)*num_shots > MAX_NUM_SAMPLES) {
+            fprintf (stderr, "[client:acq]: Invalid number of shots! Defaulting to: 1\n");
+            num_shots = 1;
+        }
+    }
+
     char service[50];
     sprintf (service, "BPM%u:DEVIO:ACQ%u", board_number, bpm_number);
 
-    uint32_t data_size = num_samples*acq_chan[chan].sample_size;
+    /* Without a trigger type, whatever is set is kept */
+    if (trig_str != NULL) {
+        uint32_t trig = strtoul (trig_str, NULL, 10);
+        bpm_client_err_e err = bpm_set_acq_trig (bpm_client, service, trig);
+        if (err != BPM_CLIENT_SUCCESS) {
+            fprintf (stderr, "[client:acq]: bpm_set_acq_trig failed\n");
+            goto err_bpm_set_acq_trig;
+        }
+    }
+
+    uint32_t data_size = (num_samples + num_samples_post)*num_shots*
+        acq_chan[chan].sample_size;
     uint32_t *data = (uint32_t *) zmalloc (data_size*sizeof (uint8_t));
     bool new_acq = true;
     acq_trans_t acq_trans = {.req =   {
                                         .num_samples = num_samples,
                                         .chan = chan,
+                                        .num_samples_post = num_samples_post,
+                                        .num_shots = num_shots,
                                       },
                              .block = {
                                         .data = data,
                                         .data_size = data_size,
+                                        .soa = soa,
                                       }
                             };
+    /* The server reduces the curve. Only the buckets are sent to us */
+    if (num_buckets_str != NULL) {
+        uint32_t num_buckets = strtoul (num_buckets_str, NULL, 10);
+        print_decim_curve (bpm_client, service, &acq_trans.req, num_buckets);
+        goto err_bpm_get_curve;
+    }
+
+    /* The server converts the positions, or computes them */
+    if (nm || ds_mode_str != NULL) {
+        print_pos_curve (bpm_client, service, &acq_trans, ds_mode_str);
+        goto err_bpm_get_curve;
+    }
+
+    /* Someone else acquires. The server serves us from its cache */
+    if (gen_str != NULL) {
+        uint32_t gen = 0;
+        if (bpm_acq_wait_gen (bpm_client, service, chan,
+                    strtoul (gen_str, NULL, 10), &gen, 50) != BPM_CLIENT_SUCCESS ||
+                bpm_acq_get_curve (bpm_client, service, &acq_trans) !=
+                BPM_CLIENT_SUCCESS) {
+            fprintf (stderr, "[client:acq]: No new acquisition could be read\n");
+            goto err_bpm_get_curve;
+        }
+
+        fprintf (stdout, "[client:acq]: Generation %u\n", gen);
+        print_data (chan, data, acq_trans.block.bytes_read, soa);
+        goto err_bpm_get_curve;
+    }
+
     bpm_client_err_e err = bpm_get_curve (bpm_client, service, &acq_trans,
             50000, new_acq);
     if (err != BPM_CLIENT_SUCCESS){
@@ -222,9 +443,29 @@ int main (int argc, char *argv [])
 
     //fprintf (stdout, "[client:acq]: bpm_get_curve was successfully executed\n");
     fprintf (stdout, "clear\n");
-    print_data (chan, data, acq_trans.block.bytes_read);
+    print_data (chan, data, acq_trans.block.bytes_read, soa);
 
 err_bpm_get_curve:
+    free (data);
+err_bpm_set_acq_trig:
+    str_p = &trig_str;
+    free (*str_p);
+    trig_str = NULL;
+    str_p = &num_buckets_str;
+    free (*str_p);
+    num_buckets_str = NULL;
+    str_p = &ds_mode_str;
+    free (*str_p);
+    ds_mode_str = NULL;
+    str_p = &gen_str;
+    free (*str_p);
+    gen_str = NULL;
+    str_p = &num_shots_str;
+    free (*str_p);
+    num_shots_str = NULL;
+    str_p = &num_samples_post_str;
+    free (*str_p);
+    num_samples_post_str = NULL;
     str_p = &chan_str;
     free (*str_p);
     chan_str = NULL;
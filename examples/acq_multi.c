@@ -0,0 +1,171 @@
+/*
+ *  * Simple example demonstrating concurrent acquisitions on
+ *   * both acquisition cores of a board
+ *    */
+
+#include <mdp.h>
+#include <czmq.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <bpm_client.h>
+
+#define DFLT_BIND_FOLDER            "/tmp/bpm"
+
+#define DFLT_NUM_SAMPLES            (1 << 16)
+#define DFLT_CHAN_NUM               0
+
+#define DFLT_BOARD_NUMBER           0
+#define MAX_BOARD_NUMBER            5
+
+#define NUM_ACQ_CORES               2
+#define ACQ_TIMEOUT                 10          /* in sec */
+
+void print_help (char *program_name)
+{
+    printf( "Usage: %s [options]\n"
+            "\t-h This help message\n"
+            "\t-v Verbose output\n"
+            "\t-b <broker_endpoint> Broker endpoint\n"
+            "\t-s <num_samples_str> Number of samples of each acquisition\n"
+            "\t-board <AMC board = [0|1|2|3|4|5]>\n"
+            "\t-ch <chan_str> Acquisition channel\n"
+            , program_name);
+}
+
+int main (int argc, char *argv [])
+{
+    int verbose = 0;
+    char *broker_endp = NULL;
+    char *num_samples_str = NULL;
+    char *board_number_str = NULL;
+    char *chan_str = NULL;
+    char **str_p = NULL;
+
+    /* FIXME: This is rather buggy! */
+    /* Simple handling of command-line options. This should be done
+     *      * with getopt, for instance*/
+    int i;
+    for (i = 1; i < argc; i++)
+    {
+        if (streq(argv[i], "-v")) {
+            verbose = 1;
+        }
+        else if (streq(argv[i], "-h"))
+        {
+            print_help (argv [0]);
+            exit (1);
+        }
+        else if (streq (argv[i], "-b")) {
+            str_p = &broker_endp;
+        }
+        else if (streq (argv[i], "-s")) { /* s: samples */
+            str_p = &num_samples_str;
+        }
+        else if (streq (argv[i], "-ch")) { /* ch: channel */
+            str_p = &chan_str;
+        }
+        else if (streq (argv[i], "-board")) { /* board_number: board number */
+            str_p = &board_number_str;
+        }
+        /* Fallout for options with parameters */
+        else if (str_p != NULL) {
+            *str_p = strdup (argv[i]);
+        }
+    }
+
+    /* Set default broker address */
+    if (broker_endp == NULL) {
+        broker_endp = strdup ("ipc://"DFLT_BIND_FOLDER);
+    }
+
+    uint32_t num_samples = (num_samples_str == NULL) ? DFLT_NUM_SAMPLES :
+        strtoul (num_samples_str, NULL, 10);
+
+    uint32_t chan = DFLT_CHAN_NUM;
+    if (chan_str != NULL) {
+        chan = strtoul (chan_str, NULL, 10);
+
+        if (chan > END_CHAN_ID-1) {
+            fprintf (stderr, "[client:acq_multi]: Channel number too big! Defaulting to: %u\n",
+                    END_CHAN_ID-1);
+            chan = END_CHAN_ID-1;
+        }
+    }
+
+    uint32_t board_number = DFLT_BOARD_NUMBER;
+    if (board_number_str != NULL) {
+        board_number = strtoul (board_number_str, NULL, 10);
+
+        if (board_number > MAX_BOARD_NUMBER) {
+            fprintf (stderr, "[client:acq_multi]: Board number too big! Defaulting to: %u\n",
+                    MAX_BOARD_NUMBER);
+            board_number = MAX_BOARD_NUMBER;
+        }
+    }
+
+    bpm_client_t *bpm_client = bpm_client_new (broker_endp, verbose, NULL);
+
+    /* One ACQ service per acquisition core */
+    char services [NUM_ACQ_CORES][50];
+    char *services_p [NUM_ACQ_CORES];
+    acq_trans_t acq_trans [NUM_ACQ_CORES];
+    uint32_t data_size = num_samples*acq_chan[chan].sample_size;
+
+    for (i = 0; i < NUM_ACQ_CORES; i++) {
+        sprintf (services[i], "BPM%u:DEVIO:ACQ%d", board_number, i);
+        services_p[i] = services[i];
+        acq_trans[i] = (acq_trans_t) {.req =   {
+                                                 .num_samples = num_samples,
+                                                 .chan = chan,
+                                               },
+                                      .block = {
+                                                 .data = (uint32_t *) zmalloc (data_size),
+                                                 .data_size = data_size,
+                                               }
+                                     };
+    }
+
+    /* One core after the other */
+    int64_t start = zclock_time ();
+    for (i = 0; i < NUM_ACQ_CORES; i++) {
+        if (bpm_full_acq (bpm_client, services[i], &acq_trans[i],
+                    ACQ_TIMEOUT) != BPM_CLIENT_SUCCESS) {
+            fprintf (stderr, "[client:acq_multi]: bpm_full_acq failed for %s\n",
+                    services[i]);
+            goto err_acq;
+        }
+    }
+    int64_t seq_time = zclock_time () - start;
+
+    /* Both cores at the same time */
+    start = zclock_time ();
+    bpm_client_err_e err = bpm_full_acq_multi (bpm_client, services_p, acq_trans,
+            NUM_ACQ_CORES, ACQ_TIMEOUT);
+    if (err != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:acq_multi]: bpm_full_acq_multi failed: %s\n",
+                bpm_client_err_str (err));
+        goto err_acq;
+    }
+    int64_t multi_time = zclock_time () - start;
+
+    for (i = 0; i < NUM_ACQ_CORES; i++) {
+        fprintf (stdout, "[client:acq_multi]: %s: %u bytes read\n", services[i],
+                acq_trans[i].block.bytes_read);
+    }
+
+    fprintf (stdout, "[client:acq_multi]: one core after the other: %"PRId64" ms, "
+            "both at the same time: %"PRId64" ms\n", seq_time, multi_time);
+
+err_acq:
+    for (i = 0; i < NUM_ACQ_CORES; i++) {
+        free (acq_trans[i].block.data);
+    }
+    bpm_client_destroy (&bpm_client);
+    free (chan_str);
+    free (board_number_str);
+    free (num_samples_str);
+    free (broker_endp);
+
+    return 0;
+}
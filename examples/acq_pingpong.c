@@ -0,0 +1,278 @@
+/*
+ *  * Simple example comparing back-to-back acquisitions with and
+ *   * without the ping-pong mode
+ *    */
+
+#include <mdp.h>
+#include <czmq.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <bpm_client.h>
+
+#define DFLT_BIND_FOLDER            "/tmp/bpm"
+
+#define DFLT_NUM_SAMPLES            (1 << 16)
+#define DFLT_CHAN_NUM               0
+#define DFLT_NUM_ACQS               20
+
+#define DFLT_BPM_NUMBER             0
+#define MAX_BPM_NUMBER              1
+
+#define DFLT_BOARD_NUMBER           0
+#define MAX_BOARD_NUMBER            5
+
+#define ACQ_TIMEOUT                 10          /* in sec */
+
+void print_help (char *program_name)
+{
+    printf( "Usage: %s [options]\n"
+            "\t-h This help message\n"
+            "\t-v Verbose output\n"
+            "\t-b <broker_endpoint> Broker endpoint\n"
+            "\t-s <num_samples_str> Number of samples of each acquisition\n"
+            "\t-n <num_acqs_str> Number of acquisitions in each mode\n"
+            "\t-board <AMC board = [0|1|2|3|4|5]>\n"
+            "\t-bpm <BPM number = [0|1]>\n"
+            "\t-ch <chan_str> Acquisition channel\n"
+            , program_name);
+}
+
+/* Time, in msec, the core takes to complete an acquisition, averaged over
+ * "num_acqs" acquisitions with nothing else going on. Negative on error */
+static double _acq_time (bpm_client_t *bpm_client, char *service,
+        acq_trans_t *acq_trans, uint32_t num_acqs)
+{
+    int64_t start = zclock_time ();
+    for (uint32_t i = 0; i < num_acqs; i++) {
+        if (bpm_acq_start (bpm_client, service, &acq_trans->req) != BPM_CLIENT_SUCCESS ||
+                func_polling (bpm_client, ACQ_NAME_CHECK_DATA_ACQUIRE, service,
+                    NULL, NULL, ACQ_TIMEOUT) != BPM_CLIENT_SUCCESS) {
+            return -1;
+        }
+    }
+
+    return (double) (zclock_time () - start) / num_acqs;
+}
+
+/* Print the results of "num_acqs" acquisitions and readouts that took
+ * "run_time" msec, for acquisitions of "acq_time" msec each. The dead time
+ * is what the core spent idle between two acquisitions and the duty cycle
+ * the fraction of the time it spent acquiring */
+static void _print_run (const char *mode, int64_t run_time, uint32_t num_acqs,
+        double acq_time)
+{
+    double dead_time = (double) run_time / num_acqs - acq_time;
+
+    fprintf (stdout, "[client:acq_pingpong]: %-10s %"PRId64" ms, %.1f acq/s, "
+            "dead time %.1f ms, duty cycle %.1f%%\n", mode, run_time,
+            num_acqs*1000.0/run_time, dead_time,
+            100.0*num_acqs*acq_time/run_time);
+}
+
+/* Acquire and read "num_acqs" curves, one after the other. In ping-pong mode,
+ * the next acquisition runs while the previous curve is read. Returns the
+ * total time in msec or a negative value on error */
+static int64_t _acq_run (bpm_client_t *bpm_client, char *service,
+        acq_trans_t *acq_trans, uint32_t num_acqs, bool pingpong)
+{
+    int64_t start = zclock_time ();
+    if (pingpong) {
+        if (bpm_acq_start (bpm_client, service, &acq_trans->req) != BPM_CLIENT_SUCCESS) {
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < num_acqs; i++) {
+        if (pingpong) {
+            /* Promotes the acquisition just completed to the one read */
+            if (func_polling (bpm_client, ACQ_NAME_CHECK_DATA_ACQUIRE, service,
+                        NULL, NULL, ACQ_TIMEOUT) != BPM_CLIENT_SUCCESS) {
+                return -1;
+            }
+
+            /* Arm the next one right away, to the other bank */
+            if (i < num_acqs-1 &&
+                    bpm_acq_start (bpm_client, service, &acq_trans->req) != BPM_CLIENT_SUCCESS) {
+                return -1;
+            }
+        }
+        else {
+            if (bpm_acq_start (bpm_client, service, &acq_trans->req) != BPM_CLIENT_SUCCESS ||
+                    func_polling (bpm_client, ACQ_NAME_CHECK_DATA_ACQUIRE, service,
+                        NULL, NULL, ACQ_TIMEOUT) != BPM_CLIENT_SUCCESS) {
+                return -1;
+            }
+        }
+
+        if (bpm_acq_get_curve (bpm_client, service, acq_trans) != BPM_CLIENT_SUCCESS) {
+            return -1;
+        }
+    }
+
+    return zclock_time () - start;
+}
+
+int main (int argc, char *argv [])
+{
+    int verbose = 0;
+    char *broker_endp = NULL;
+    char *num_samples_str = NULL;
+    char *num_acqs_str = NULL;
+    char *board_number_str = NULL;
+    char *bpm_number_str = NULL;
+    char *chan_str = NULL;
+    char **str_p = NULL;
+
+    /* FIXME: This is rather buggy! */
+    /* Simple handling of command-line options. This should be done
+     *      * with getopt, for instance*/
+    int i;
+    for (i = 1; i < argc; i++)
+    {
+        if (streq(argv[i], "-v")) {
+            verbose = 1;
+        }
+        else if (streq(argv[i], "-h"))
+        {
+            print_help (argv [0]);
+            exit (1);
+        }
+        else if (streq (argv[i], "-b")) {
+            str_p = &broker_endp;
+        }
+        else if (streq (argv[i], "-s")) { /* s: samples */
+            str_p = &num_samples_str;
+        }
+        else if (streq (argv[i], "-n")) { /* n: number of acquisitions */
+            str_p = &num_acqs_str;
+        }
+        else if (streq (argv[i], "-ch")) { /* ch: channel */
+            str_p = &chan_str;
+        }
+        else if (streq (argv[i], "-board")) { /* board_number: board number */
+            str_p = &board_number_str;
+        }
+        else if (streq(argv[i], "-bpm"))
+        {
+            str_p = &bpm_number_str;
+        }
+        /* Fallout for options with parameters */
+        else if (str_p != NULL) {
+            *str_p = strdup (argv[i]);
+        }
+    }
+
+    /* Set default broker address */
+    if (broker_endp == NULL) {
+        broker_endp = strdup ("ipc://"DFLT_BIND_FOLDER);
+    }
+
+    uint32_t num_samples = (num_samples_str == NULL) ? DFLT_NUM_SAMPLES :
+        strtoul (num_samples_str, NULL, 10);
+    uint32_t num_acqs = (num_acqs_str == NULL) ? DFLT_NUM_ACQS :
+        strtoul (num_acqs_str, NULL, 10);
+    if (num_acqs == 0) {
+        num_acqs = 1;
+    }
+
+    uint32_t chan = DFLT_CHAN_NUM;
+    if (chan_str != NULL) {
+        chan = strtoul (chan_str, NULL, 10);
+
+        if (chan > END_CHAN_ID-1) {
+            fprintf (stderr, "[client:acq_pingpong]: Channel number too big! Defaulting to: %u\n",
+                    END_CHAN_ID-1);
+            chan = END_CHAN_ID-1;
+        }
+    }
+
+    uint32_t board_number = DFLT_BOARD_NUMBER;
+    if (board_number_str != NULL) {
+        board_number = strtoul (board_number_str, NULL, 10);
+
+        if (board_number > MAX_BOARD_NUMBER) {
+            fprintf (stderr, "[client:acq_pingpong]: Board number too big! Defaulting to: %u\n",
+                    MAX_BOARD_NUMBER);
+            board_number = MAX_BOARD_NUMBER;
+        }
+    }
+
+    uint32_t bpm_number = DFLT_BPM_NUMBER;
+    if (bpm_number_str != NULL) {
+        bpm_number = strtoul (bpm_number_str, NULL, 10);
+
+        if (bpm_number > MAX_BPM_NUMBER) {
+            fprintf (stderr, "[client:acq_pingpong]: BPM number too big! Defaulting to: %u\n",
+                    MAX_BPM_NUMBER);
+            bpm_number = MAX_BPM_NUMBER;
+        }
+    }
+
+    bpm_client_t *bpm_client = bpm_client_new (broker_endp, verbose, NULL);
+
+    char service[50];
+    sprintf (service, "BPM%u:DEVIO:ACQ%u", board_number, bpm_number);
+
+    uint32_t data_size = num_samples*acq_chan[chan].sample_size;
+    uint32_t *data = (uint32_t *) zmalloc (data_size*sizeof (uint8_t));
+    acq_trans_t acq_trans = {.req =   {
+                                        .num_samples = num_samples,
+                                        .chan = chan,
+                                        .num_samples_post = 0,
+                                        .num_shots = 1,
+                                      },
+                             .block = {
+                                        .data = data,
+                                        .data_size = data_size,
+                                      }
+                            };
+
+    /* The duty cycle is the fraction of the time the core spends
+     * acquiring */
+    if (bpm_set_acq_pingpong (bpm_client, service, 0) != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:acq_pingpong]: bpm_set_acq_pingpong failed\n");
+        goto err_acq;
+    }
+
+    double acq_time = _acq_time (bpm_client, service, &acq_trans, num_acqs);
+    if (acq_time < 0) {
+        fprintf (stderr, "[client:acq_pingpong]: Could not time the acquisitions\n");
+        goto err_acq;
+    }
+
+    int64_t seq_time = _acq_run (bpm_client, service, &acq_trans, num_acqs, false);
+    if (seq_time <= 0) {
+        fprintf (stderr, "[client:acq_pingpong]: Sequential acquisitions failed\n");
+        goto err_acq;
+    }
+
+    if (bpm_set_acq_pingpong (bpm_client, service, 1) != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:acq_pingpong]: bpm_set_acq_pingpong failed\n");
+        goto err_acq;
+    }
+
+    int64_t pp_time = _acq_run (bpm_client, service, &acq_trans, num_acqs, true);
+    bpm_set_acq_pingpong (bpm_client, service, 0);
+    if (pp_time <= 0) {
+        fprintf (stderr, "[client:acq_pingpong]: Ping-pong acquisitions failed\n");
+        goto err_acq;
+    }
+
+    fprintf (stdout, "[client:acq_pingpong]: %u acquisitions of %u samples, "
+            "%.1f ms each\n", num_acqs, num_samples, acq_time);
+    _print_run ("sequential:", seq_time, num_acqs, acq_time);
+    _print_run ("ping-pong:", pp_time, num_acqs, acq_time);
+
+err_acq:
+    free (data);
+    bpm_client_destroy (&bpm_client);
+    free (chan_str);
+    free (bpm_number_str);
+    free (board_number_str);
+    free (num_acqs_str);
+    free (num_samples_str);
+    free (broker_endp);
+
+    return 0;
+}
@@ -0,0 +1,247 @@
+/*
+ *  * Simple example comparing a curve deinterleaved by the client,
+ *   * sample by sample, with a curve deinterleaved by the server
+ *    */
+
+#include <mdp.h>
+#include <czmq.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <bpm_client.h>
+
+#define DFLT_BIND_FOLDER            "/tmp/bpm"
+
+#define DFLT_NUM_SAMPLES            (1 << 16)
+#define DFLT_CHAN_NUM               0
+#define DFLT_NUM_READS              10
+
+#define DFLT_BPM_NUMBER             0
+#define MAX_BPM_NUMBER              1
+
+#define DFLT_BOARD_NUMBER           0
+#define MAX_BOARD_NUMBER            5
+
+#define ACQ_TIMEOUT                 10          /* in sec */
+
+void print_help (char *program_name)
+{
+    printf( "Usage: %s [options]\n"
+            "\t-h This help message\n"
+            "\t-v Verbose output\n"
+            "\t-b <broker_endpoint> Broker endpoint\n"
+            "\t-s <num_samples_str> Number of samples of the curve\n"
+            "\t-n <num_reads_str> Number of times the curve is read each way\n"
+            "\t-board <AMC board = [0|1|2|3|4|5]>\n"
+            "\t-bpm <BPM number = [0|1]>\n"
+            "\t-ch <chan_str> Acquisition channel\n"
+            , program_name);
+}
+
+/* The per-sample loop of print_data () in acq.c, storing the components in
+ * columns instead of printing them */
+static void _deinterleave (uint32_t sample_size, const uint32_t *data,
+        uint32_t *cols, uint32_t num_samples)
+{
+    if (sample_size == 4*sizeof (int16_t)) {
+        const int16_t *raw_data16 = (const int16_t *) data;
+        int16_t *cols16 = (int16_t *) cols;
+        for (uint32_t i = 0; i < num_samples; i++) {
+            cols16[i] = raw_data16[(i*4)];
+            cols16[num_samples+i] = raw_data16[(i*4)+1];
+            cols16[(2*num_samples)+i] = raw_data16[(i*4)+2];
+            cols16[(3*num_samples)+i] = raw_data16[(i*4)+3];
+        }
+    }
+    else {
+        const int32_t *raw_data32 = (const int32_t *) data;
+        int32_t *cols32 = (int32_t *) cols;
+        for (uint32_t i = 0; i < num_samples; i++) {
+            cols32[i] = raw_data32[(i*4)];
+            cols32[num_samples+i] = raw_data32[(i*4)+1];
+            cols32[(2*num_samples)+i] = raw_data32[(i*4)+2];
+            cols32[(3*num_samples)+i] = raw_data32[(i*4)+3];
+        }
+    }
+}
+
+int main (int argc, char *argv [])
+{
+    int verbose = 0;
+    char *broker_endp = NULL;
+    char *num_samples_str = NULL;
+    char *num_reads_str = NULL;
+    char *board_number_str = NULL;
+    char *bpm_number_str = NULL;
+    char *chan_str = NULL;
+    char **str_p = NULL;
+
+    /* FIXME: This is rather buggy! */
+    /* Simple handling of command-line options. This should be done
+     *      * with getopt, for instance*/
+    int i;
+    for (i = 1; i < argc; i++)
+    {
+        if (streq(argv[i], "-v")) {
+            verbose = 1;
+        }
+        else if (streq(argv[i], "-h"))
+        {
+            print_help (argv [0]);
+            exit (1);
+        }
+        else if (streq (argv[i], "-b")) {
+            str_p = &broker_endp;
+        }
+        else if (streq (argv[i], "-s")) { /* s: samples */
+            str_p = &num_samples_str;
+        }
+        else if (streq (argv[i], "-n")) { /* n: number of reads */
+            str_p = &num_reads_str;
+        }
+        else if (streq (argv[i], "-ch")) { /* ch: channel */
+            str_p = &chan_str;
+        }
+        else if (streq (argv[i], "-board")) { /* board_number: board number */
+            str_p = &board_number_str;
+        }
+        else if (streq(argv[i], "-bpm"))
+        {
+            str_p = &bpm_number_str;
+        }
+        /* Fallout for options with parameters */
+        else if (str_p != NULL) {
+            *str_p = strdup (argv[i]);
+        }
+    }
+
+    /* Set default broker address */
+    if (broker_endp == NULL) {
+        broker_endp = strdup ("ipc://"DFLT_BIND_FOLDER);
+    }
+
+    uint32_t num_samples = (num_samples_str == NULL) ? DFLT_NUM_SAMPLES :
+        strtoul (num_samples_str, NULL, 10);
+    uint32_t num_reads = (num_reads_str == NULL) ? DFLT_NUM_READS :
+        strtoul (num_reads_str, NULL, 10);
+    if (num_reads == 0) {
+        num_reads = 1;
+    }
+
+    uint32_t chan = DFLT_CHAN_NUM;
+    if (chan_str != NULL) {
+        chan = strtoul (chan_str, NULL, 10);
+
+        if (chan > END_CHAN_ID-1) {
+            fprintf (stderr, "[client:acq_soa]: Channel number too big! Defaulting to: %u\n",
+                    END_CHAN_ID-1);
+            chan = END_CHAN_ID-1;
+        }
+    }
+
+    uint32_t board_number = DFLT_BOARD_NUMBER;
+    if (board_number_str != NULL) {
+        board_number = strtoul (board_number_str, NULL, 10);
+
+        if (board_number > MAX_BOARD_NUMBER) {
+            fprintf (stderr, "[client:acq_soa]: Board number too big! Defaulting to: %u\n",
+                    MAX_BOARD_NUMBER);
+            board_number = MAX_BOARD_NUMBER;
+        }
+    }
+
+    uint32_t bpm_number = DFLT_BPM_NUMBER;
+    if (bpm_number_str != NULL) {
+        bpm_number = strtoul (bpm_number_str, NULL, 10);
+
+        if (bpm_number > MAX_BPM_NUMBER) {
+            fprintf (stderr, "[client:acq_soa]: BPM number too big! Defaulting to: %u\n",
+                    MAX_BPM_NUMBER);
+            bpm_number = MAX_BPM_NUMBER;
+        }
+    }
+
+    bpm_client_t *bpm_client = bpm_client_new (broker_endp, verbose, NULL);
+
+    char service[50];
+    sprintf (service, "BPM%u:DEVIO:ACQ%u", board_number, bpm_number);
+
+    uint32_t sample_size = acq_chan[chan].sample_size;
+    uint32_t data_size = num_samples*sample_size;
+    uint32_t *data = (uint32_t *) zmalloc (data_size*sizeof (uint8_t));
+    uint32_t *cols = (uint32_t *) zmalloc (data_size*sizeof (uint8_t));
+    uint32_t *soa_cols = (uint32_t *) zmalloc (data_size*sizeof (uint8_t));
+    acq_trans_t acq_trans = {.req =   {
+                                        .num_samples = num_samples,
+                                        .chan = chan,
+                                        .num_samples_post = 0,
+                                        .num_shots = 1,
+                                      },
+                             .block = {
+                                        .data = data,
+                                        .data_size = data_size,
+                                      }
+                            };
+
+    /* The same curve is read over and over */
+    if (bpm_acq_start (bpm_client, service, &acq_trans.req) != BPM_CLIENT_SUCCESS ||
+            func_polling (bpm_client, ACQ_NAME_CHECK_DATA_ACQUIRE, service,
+                NULL, NULL, ACQ_TIMEOUT) != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:acq_soa]: Acquisition failed\n");
+        goto err_acq;
+    }
+
+    /* Samples read and deinterleaved here, one by one */
+    int64_t loop_time = 0;
+    int64_t start = zclock_time ();
+    for (uint32_t j = 0; j < num_reads; j++) {
+        if (bpm_acq_get_curve (bpm_client, service, &acq_trans) != BPM_CLIENT_SUCCESS) {
+            fprintf (stderr, "[client:acq_soa]: bpm_acq_get_curve failed\n");
+            goto err_acq;
+        }
+
+        int64_t loop_start = zclock_time ();
+        _deinterleave (sample_size, data, cols,
+                acq_trans.block.bytes_read/sample_size);
+        loop_time += zclock_time () - loop_start;
+    }
+    int64_t aos_time = zclock_time () - start;
+
+    /* Samples deinterleaved by the server */
+    acq_trans.block.data = soa_cols;
+    acq_trans.block.soa = true;
+    start = zclock_time ();
+    for (uint32_t j = 0; j < num_reads; j++) {
+        if (bpm_acq_get_curve (bpm_client, service, &acq_trans) != BPM_CLIENT_SUCCESS) {
+            fprintf (stderr, "[client:acq_soa]: bpm_acq_get_curve failed\n");
+            goto err_acq;
+        }
+    }
+    int64_t soa_time = zclock_time () - start;
+
+    if (memcmp (cols, soa_cols, acq_trans.block.bytes_read) != 0) {
+        fprintf (stderr, "[client:acq_soa]: The columns do not match!\n");
+        goto err_acq;
+    }
+
+    fprintf (stdout, "[client:acq_soa]: %u reads of %u bytes\n", num_reads,
+            acq_trans.block.bytes_read);
+    fprintf (stdout, "[client:acq_soa]: deinterleaved here: %"PRId64" ms, "
+            "%"PRId64" ms of which in the per-sample loop\n", aos_time, loop_time);
+    fprintf (stdout, "[client:acq_soa]: deinterleaved by the server: %"PRId64" ms\n",
+            soa_time);
+
+err_acq:
+    free (soa_cols);
+    free (cols);
+    free (data);
+    bpm_client_destroy (&bpm_client);
+    free (chan_str);
+    free (bpm_number_str);
+    free (board_number_str);
+    free (num_reads_str);
+    free (num_samples_str);
+    free (broker_endp);
+
+    return 0;
+}
@@ -0,0 +1,215 @@
+/*
+ *  * Simple example demonstrating the streaming acquisition
+ *   * of a channel
+ *    */
+
+#include <mdp.h>
+#include <czmq.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <bpm_client.h>
+
+#define DFLT_BIND_FOLDER            "/tmp/bpm"
+
+#define DFLT_NUM_SAMPLES            (1 << 20)
+#define DFLT_CHAN_NUM               0
+#define DFLT_DURATION               10          /* in sec */
+
+#define DFLT_BPM_NUMBER             0
+#define MAX_BPM_NUMBER              1
+
+#define DFLT_BOARD_NUMBER           0
+#define MAX_BOARD_NUMBER            5
+
+#define RECV_TIMEOUT                1000        /* in msec */
+
+void print_help (char *program_name)
+{
+    printf( "Usage: %s [options]\n"
+            "\t-h This help message\n"
+            "\t-v Verbose output\n"
+            "\t-b <broker_endpoint> Broker endpoint\n"
+            "\t-s <num_samples_str> Number of samples of the ring\n"
+            "\t-t <duration_str> Seconds to stream for\n"
+            "\t-board <AMC board = [0|1|2|3|4|5]>\n"
+            "\t-bpm <BPM number = [0|1]>\n"
+            "\t-ch <chan_str> Acquisition channel\n"
+            , program_name);
+}
+
+int main (int argc, char *argv [])
+{
+    int verbose = 0;
+    char *broker_endp = NULL;
+    char *num_samples_str = NULL;
+    char *duration_str = NULL;
+    char *board_number_str = NULL;
+    char *bpm_number_str = NULL;
+    char *chan_str = NULL;
+    char **str_p = NULL;
+
+    /* FIXME: This is rather buggy! */
+    /* Simple handling of command-line options. This should be done
+     *      * with getopt, for instance*/
+    int i;
+    for (i = 1; i < argc; i++)
+    {
+        if (streq(argv[i], "-v")) {
+            verbose = 1;
+        }
+        else if (streq(argv[i], "-h"))
+        {
+            print_help (argv [0]);
+            exit (1);
+        }
+        else if (streq (argv[i], "-b")) {
+            str_p = &broker_endp;
+        }
+        else if (streq (argv[i], "-s")) { /* s: samples */
+            str_p = &num_samples_str;
+        }
+        else if (streq (argv[i], "-t")) { /* t: duration */
+            str_p = &duration_str;
+        }
+        else if (streq (argv[i], "-ch")) { /* ch: channel */
+            str_p = &chan_str;
+        }
+        else if (streq (argv[i], "-board")) { /* board_number: board number */
+            str_p = &board_number_str;
+        }
+        else if (streq(argv[i], "-bpm"))
+        {
+            str_p = &bpm_number_str;
+        }
+        /* Fallout for options with parameters */
+        else if (str_p != NULL) {
+            *str_p = strdup (argv[i]);
+        }
+    }
+
+    /* Set default broker address */
+    if (broker_endp == NULL) {
+        broker_endp = strdup ("ipc://"DFLT_BIND_FOLDER);
+    }
+
+    uint32_t num_samples = (num_samples_str == NULL) ? DFLT_NUM_SAMPLES :
+        strtoul (num_samples_str, NULL, 10);
+    uint32_t duration = (duration_str == NULL) ? DFLT_DURATION :
+        strtoul (duration_str, NULL, 10);
+
+    uint32_t chan = DFLT_CHAN_NUM;
+    if (chan_str != NULL) {
+        chan = strtoul (chan_str, NULL, 10);
+
+        if (chan > END_CHAN_ID-1) {
+            fprintf (stderr, "[client:acq_stream]: Channel number too big! Defaulting to: %u\n",
+                    END_CHAN_ID-1);
+            chan = END_CHAN_ID-1;
+        }
+    }
+
+    uint32_t board_number = DFLT_BOARD_NUMBER;
+    if (board_number_str != NULL) {
+        board_number = strtoul (board_number_str, NULL, 10);
+
+        if (board_number > MAX_BOARD_NUMBER) {
+            fprintf (stderr, "[client:acq_stream]: Board number too big! Defaulting to: %u\n",
+                    MAX_BOARD_NUMBER);
+            board_number = MAX_BOARD_NUMBER;
+        }
+    }
+
+    uint32_t bpm_number = DFLT_BPM_NUMBER;
+    if (bpm_number_str != NULL) {
+        bpm_number = strtoul (bpm_number_str, NULL, 10);
+
+        if (bpm_number > MAX_BPM_NUMBER) {
+            fprintf (stderr, "[client:acq_stream]: BPM number too big! Defaulting to: %u\n",
+                    MAX_BPM_NUMBER);
+            bpm_number = MAX_BPM_NUMBER;
+        }
+    }
+
+    bpm_client_t *bpm_client = bpm_client_new (broker_endp, verbose, NULL);
+    bpm_acq_stream_t *stream = NULL;
+    uint8_t *data = NULL;
+
+    char service[50];
+    sprintf (service, "BPM%u:DEVIO:ACQ%u", board_number, bpm_number);
+
+    bpm_client_err_e err = bpm_acq_stream_start (bpm_client, service, chan,
+            num_samples);
+    if (err != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:acq_stream]: bpm_acq_stream_start failed\n");
+        goto err_stream_start;
+    }
+
+    stream = bpm_acq_stream_subscribe (bpm_client, service);
+    if (stream == NULL) {
+        fprintf (stderr, "[client:acq_stream]: bpm_acq_stream_subscribe failed\n");
+        goto err_stream_subscribe;
+    }
+
+    data = (uint8_t *) zmalloc (BLOCK_SIZE);
+    uint64_t bytes = 0;
+    uint64_t lost = 0;
+    uint32_t msgs = 0;
+    uint32_t missed_msgs = 0;
+    uint32_t next_seq = 0;
+    int64_t end = zclock_time () + (int64_t) duration*1000;
+
+    while (zclock_time () < end && !zctx_interrupted) {
+        smio_acq_stream_hdr_t hdr;
+        uint32_t data_size = BLOCK_SIZE;
+        err = bpm_acq_stream_recv (stream, &hdr, data, &data_size, RECV_TIMEOUT);
+        if (err == BPM_CLIENT_ERR_TIMEOUT) {
+            fprintf (stderr, "[client:acq_stream]: No data for %u ms\n",
+                    RECV_TIMEOUT);
+            continue;
+        }
+        else if (err != BPM_CLIENT_SUCCESS) {
+            break;
+        }
+
+        /* We joined in the middle of the stream */
+        if (msgs > 0 && hdr.seq != next_seq) {
+            missed_msgs += hdr.seq - next_seq;
+        }
+        next_seq = hdr.seq + 1;
+
+        msgs++;
+        bytes += data_size;
+        lost += hdr.lost;
+        if (hdr.lost > 0) {
+            fprintf (stdout, "[client:acq_stream]: Overrun! %"PRIu64" samples "
+                    "lost before sample %"PRIu64"\n", hdr.lost, hdr.first_sample);
+        }
+    }
+
+    fprintf (stdout, "[client:acq_stream]: %u messages (%u missed), %"PRIu64
+            " bytes received, %"PRIu64" samples lost to overruns\n", msgs,
+            missed_msgs, bytes, lost);
+
+    smio_acq_stream_status_t status;
+    if (bpm_acq_stream_status (bpm_client, service, &status) == BPM_CLIENT_SUCCESS) {
+        fprintf (stdout, "[client:acq_stream]: Server published %"PRIu64" samples, "
+                "%"PRIu64" lost in %u overrun(s)\n", status.pos, status.lost,
+                status.overruns);
+    }
+
+    free (data);
+    bpm_acq_stream_unsubscribe (&stream);
+err_stream_subscribe:
+    bpm_acq_stream_stop (bpm_client, service);
+err_stream_start:
+    bpm_client_destroy (&bpm_client);
+    free (chan_str);
+    free (bpm_number_str);
+    free (board_number_str);
+    free (duration_str);
+    free (num_samples_str);
+    free (broker_endp);
+
+    return 0;
+}
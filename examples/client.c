@@ -1784,10 +1784,13 @@ int main (int argc, char *argv [])
     /* Request data acquisition on server */
 
     if (acq_start) {
-    /* Wrap the data request parameters */
+    /* Wrap the data request parameters. This client does not set up any
+     * trigger, so there are no post-trigger samples and a single shot */
         acq_req_t acq_req = {
-            acq_samples_val,
-            acq_chan_val
+            .num_samples = acq_samples_val,
+            .chan = acq_chan_val,
+            .num_samples_post = 0,
+            .num_shots = 1
         };
         bpm_client_err_e err = bpm_acq_start(bpm_client, acq_service, &acq_req);
         if (err != BPM_CLIENT_SUCCESS) {
@@ -1814,7 +1817,10 @@ int main (int argc, char *argv [])
         uint32_t *valid_data = (uint32_t *) zmalloc (data_size*sizeof (uint8_t));
         acq_trans_t acq_trans = {
             .req = {
+                .num_samples = acq_samples_val,
                 .chan = acq_chan_val,
+                .num_samples_post = 0,
+                .num_shots = 1
             },
             .block = {
                 .idx = acq_block_id,
@@ -1841,8 +1847,10 @@ int main (int argc, char *argv [])
 
         acq_trans_t acq_trans = {
             .req = {
+                .num_samples = acq_samples_val,
                 .chan = acq_chan_val,
-                .num_samples = acq_samples_val },
+                .num_samples_post = 0,
+                .num_shots = 1 },
             .block = {
                 .data = valid_data,
                 .data_size = data_size }
@@ -1868,8 +1876,10 @@ int main (int argc, char *argv [])
 
         acq_trans_t acq_trans = {
             .req = {
+                .num_samples = acq_samples_val,
                 .chan = acq_chan_val,
-                .num_samples = acq_samples_val },
+                .num_samples_post = 0,
+                .num_shots = 1 },
             .block = {
                 .data = valid_data,
                 .data_size = data_size }
@@ -16,13 +16,15 @@ void print_help (char *program_name)
     printf( "Usage: %s [options]\n"
             "\t-h This help message\n"
             "\t-v Verbose output\n"
-            "\t-b <broker_endpoint> Broker endpoint\n", program_name);
+            "\t-b <broker_endpoint> Broker endpoint\n"
+            "\t-t <ttl> Drop requests not served within <ttl> ms\n", program_name);
 }
 
 int main (int argc, char *argv [])
 {
     int verbose = 0;
     char *broker_endp = NULL;
+    char *ttl_str = NULL;
     char **str_p = NULL;
 
     if (argc < 2) {
@@ -47,6 +49,9 @@ int main (int argc, char *argv [])
         else if (streq (argv[i], "-b")) {
             str_p = &broker_endp;
         }
+        else if (streq (argv[i], "-t")) {
+            str_p = &ttl_str;
+        }
         /* Fallout for options with parameters */
         else {
             *str_p = strdup (argv[i]);
@@ -60,6 +65,11 @@ int main (int argc, char *argv [])
 
     bpm_client_t *bpm_client = bpm_client_new (broker_endp, verbose, NULL);
 
+    /* Stale readings are of no use to us */
+    if (ttl_str != NULL) {
+        bpm_client_set_request_ttl (bpm_client, strtoul (ttl_str, NULL, 10));
+    }
+
     uint32_t monit_pos;
     bpm_client_err_e err = bpm_get_monit_pos_x (bpm_client, "BPM0:DEVIO:DSP0",
             &monit_pos);
@@ -99,6 +109,9 @@ int main (int argc, char *argv [])
 
 err_get_monit_pos:
     bpm_client_destroy (&bpm_client);
+    str_p = &ttl_str;
+    free (*str_p);
+    ttl_str = NULL;
     str_p = &broker_endp;
     free (*str_p);
     broker_endp = NULL;
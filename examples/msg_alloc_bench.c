@@ -0,0 +1,178 @@
+/*
+ * Microbenchmark of the czmq allocations made by the SMIO for each register
+ * read. Reads the Kx register of a DSP service a number of times and reports,
+ * per read, how many messages and frames the SMIO needed and how many of them
+ * actually came from the heap. Without the message pool, every one of them
+ * would be a heap allocation (and a free)
+ */
+
+#include <mdp.h>
+#include <czmq.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include <bpm_client.h>
+
+#define DFLT_BIND_FOLDER            "/tmp/bpm"
+#define DFLT_SERVICE                "BPM0:DEVIO:DSP0"
+#define DFLT_NUM_READS              10000
+
+void print_help (char *program_name)
+{
+    printf( "Usage: %s [options]\n"
+            "\t-h This help message\n"
+            "\t-v Verbose output\n"
+            "\t-b <broker_endpoint> Broker endpoint\n"
+            "\t-s <service> DSP service name (e.g., BPM0:DEVIO:DSP0)\n"
+            "\t-n <num_reads> Number of register reads (default = 10000)\n",
+            program_name);
+}
+
+static uint64_t get_ts_us (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec*1000000 + ts.tv_nsec/1000;
+}
+
+/* Get the statistics of exactly the requested opcode */
+static bpm_client_err_e get_op_stats (bpm_client_t *bpm_client, char *service,
+        uint32_t opcode, smio_op_stats_t *op_stats)
+{
+    bpm_client_err_e err = bpm_get_smio_op_stats (bpm_client, service, opcode,
+            op_stats);
+
+    if (err == BPM_CLIENT_SUCCESS && op_stats->opcode != opcode) {
+        err = BPM_CLIENT_ERR_SERVER;
+    }
+
+    return err;
+}
+
+int main (int argc, char *argv [])
+{
+    int verbose = 0;
+    char *broker_endp = NULL;
+    char *service = NULL;
+    char *num_reads_str = NULL;
+    char **str_p = NULL;
+
+    if (argc < 2) {
+        print_help (argv[0]);
+        exit (1);
+    }
+
+    /* FIXME: This is rather buggy! */
+    /* Simple handling of command-line options. This should be done
+     * with getopt, for instance*/
+    int i;
+    for (i = 1; i < argc; i++)
+    {
+        if (streq(argv[i], "-v")) {
+            verbose = 1;
+        }
+        else if (streq(argv[i], "-h"))
+        {
+            print_help (argv [0]);
+            exit (1);
+        }
+        else if (streq (argv[i], "-b")) {
+            str_p = &broker_endp;
+        }
+        else if (streq (argv[i], "-s")) {
+            str_p = &service;
+        }
+        else if (streq (argv[i], "-n")) {
+            str_p = &num_reads_str;
+        }
+        /* Fallout for options with parameters */
+        else {
+            *str_p = strdup (argv[i]);
+        }
+    }
+
+    /* Set default broker address */
+    if (broker_endp == NULL) {
+        broker_endp = strdup ("ipc://"DFLT_BIND_FOLDER);
+    }
+
+    /* Set default service */
+    if (service == NULL) {
+        service = strdup (DFLT_SERVICE);
+    }
+
+    uint32_t num_reads = DFLT_NUM_READS;
+    if (num_reads_str != NULL) {
+        num_reads = strtoul (num_reads_str, NULL, 10);
+    }
+
+    bpm_client_t *bpm_client = bpm_client_new (broker_endp, verbose, NULL);
+    if (bpm_client == NULL) {
+        fprintf (stderr, "[client:msg_alloc_bench]: bpm_client could not be created\n");
+        goto err_bpm_client_new;
+    }
+
+    smio_op_stats_t stats_before;
+    bpm_client_err_e err = get_op_stats (bpm_client, service,
+            DSP_OPCODE_SET_GET_KX, &stats_before);
+    if (err != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:msg_alloc_bench]: could not get statistics "
+                "of %s\n", service);
+        goto err_get_stats;
+    }
+
+    uint32_t num_err = 0;
+    uint64_t start_us = get_ts_us ();
+    uint32_t n;
+    for (n = 0; n < num_reads && !zctx_interrupted; ++n) {
+        uint32_t kx = 0;
+        if (bpm_get_kx (bpm_client, service, &kx) != BPM_CLIENT_SUCCESS) {
+            num_err++;
+        }
+    }
+    uint64_t elapsed_us = get_ts_us () - start_us;
+
+    smio_op_stats_t stats_after;
+    err = get_op_stats (bpm_client, service, DSP_OPCODE_SET_GET_KX,
+            &stats_after);
+    if (err != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:msg_alloc_bench]: could not get statistics "
+                "of %s\n", service);
+        goto err_get_stats;
+    }
+
+    uint64_t calls = stats_after.calls - stats_before.calls;
+    uint64_t allocs = stats_after.msg_allocs - stats_before.msg_allocs;
+    uint64_t reuses = stats_after.msg_reuses - stats_before.msg_reuses;
+
+    fprintf (stdout, "[client:msg_alloc_bench]: %u reads of %s (%u errors) "
+            "in %"PRIu64" us, %.1f us per read\n", n, service, num_err,
+            elapsed_us, (n > 0) ? (double) elapsed_us/n : 0.0);
+
+    if (calls == 0) {
+        fprintf (stderr, "[client:msg_alloc_bench]: no calls accounted by "
+                "%s\n", service);
+        goto err_no_calls;
+    }
+
+    fprintf (stdout, "[client:msg_alloc_bench]: messages and frames per read: "
+            "%.2f\n", (double) (allocs + reuses)/calls);
+    fprintf (stdout, "[client:msg_alloc_bench]: heap allocations per read "
+            "without the pool: %.2f, with the pool: %.2f\n",
+            (double) (allocs + reuses)/calls, (double) allocs/calls);
+
+err_no_calls:
+err_get_stats:
+    bpm_client_destroy (&bpm_client);
+err_bpm_client_new:
+    str_p = &num_reads_str;
+    free (*str_p);
+    num_reads_str = NULL;
+    str_p = &service;
+    free (*str_p);
+    service = NULL;
+    str_p = &broker_endp;
+    free (*str_p);
+    broker_endp = NULL;
+    return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * Simple benchmark measuring the aggregate request throughput
+ * of a SMIO service as the number of concurrent clients grows.
+ * Run the DEVIO with different number of workers per SMIO
+ * (dev_io -w <num_workers>) to compare. As the requested operation is
+ * read-only, concurrent clients are also expected to have some of their
+ * requests coalesced (see the "coalesced" column of smio_stats). With -r,
+ * a DSP register is read instead, so each request goes to the DEVIO
+ */
+
+#include <mdp.h>
+#include <czmq.h>
+#include <inttypes.h>
+
+#include <bpm_client.h>
+
+#define DFLT_BIND_FOLDER            "/tmp/bpm"
+#define DFLT_SERVICE                "BPM0:DEVIO:DSP0"
+#define DFLT_MAX_CLIENTS            8
+#define DFLT_DURATION               5           /* in seconds */
+
+/* Client thread args structure */
+typedef struct {
+    char *broker_endp;
+    char *service;
+    int read_hw;                                /* Read a DSP register */
+    int64_t end_time;                           /* in msec */
+} bench_args_t;
+
+void print_help (char *program_name)
+{
+    printf( "Usage: %s [options]\n"
+            "\t-h This help message\n"
+            "\t-v Verbose output\n"
+            "\t-b <broker_endpoint> Broker endpoint\n"
+            "\t-s <service> SMIO service name (e.g., BPM0:DEVIO:ACQ0)\n"
+            "\t-r Read the monitoring amplitude of channel 0 instead of the\n"
+            "\t   statistics (DSP services only)\n"
+            "\t-c <max_clients> Maximum number of concurrent clients (default = 8)\n"
+            "\t-t <duration> Duration of each round, in seconds (default = 5)\n",
+            program_name);
+}
+
+/* Issue requests as fast as possible until the round is over and
+ * report the number of successful and failed requests to the parent */
+static void bench_client (void *args, zctx_t *ctx, void *pipe)
+{
+    (void) ctx;
+    bench_args_t *bench_args = (bench_args_t *) args;
+    uint32_t num_ok = 0;
+    uint32_t num_err = 0;
+
+    bpm_client_t *bpm_client = bpm_client_new (bench_args->broker_endp, 0, NULL);
+    if (bpm_client == NULL) {
+        fprintf (stderr, "[client:smio_bench]: bpm_client could not be created\n");
+        goto err_bpm_client_new;
+    }
+
+    smio_op_stats_t op_stats;
+    uint32_t monit_amp = 0;
+    while (zclock_time () < bench_args->end_time && !zctx_interrupted) {
+        bpm_client_err_e err = (bench_args->read_hw) ?
+            bpm_get_monit_amp_ch0 (bpm_client, bench_args->service, &monit_amp) :
+            bpm_get_smio_op_stats (bpm_client, bench_args->service, 0, &op_stats);
+
+        if (err == BPM_CLIENT_SUCCESS) {
+            num_ok++;
+        }
+        else {
+            num_err++;
+        }
+    }
+
+    bpm_client_destroy (&bpm_client);
+err_bpm_client_new:
+    zstr_sendf (pipe, "%u %u", num_ok, num_err);
+}
+
+int main (int argc, char *argv [])
+{
+    int verbose = 0;
+    int read_hw = 0;
+    char *broker_endp = NULL;
+    char *service = NULL;
+    char *max_clients_str = NULL;
+    char *duration_str = NULL;
+    char **str_p = NULL;
+
+    if (argc < 2) {
+        print_help (argv[0]);
+        exit (1);
+    }
+
+    /* FIXME: This is rather buggy! */
+    /* Simple handling of command-line options. This should be done
+     * with getopt, for instance*/
+    int i;
+    for (i = 1; i < argc; i++)
+    {
+        if (streq(argv[i], "-v")) {
+            verbose = 1;
+        }
+        else if (streq(argv[i], "-r")) {
+            read_hw = 1;
+        }
+        else if (streq(argv[i], "-h"))
+        {
+            print_help (argv [0]);
+            exit (1);
+        }
+        else if (streq (argv[i], "-b")) {
+            str_p = &broker_endp;
+        }
+        else if (streq (argv[i], "-s")) {
+            str_p = &service;
+        }
+        else if (streq (argv[i], "-c")) {
+            str_p = &max_clients_str;
+        }
+        else if (streq (argv[i], "-t")) {
+            str_p = &duration_str;
+        }
+        /* Fallout for options with parameters */
+        else {
+            *str_p = strdup (argv[i]);
+        }
+    }
+
+    /* Set default broker address */
+    if (broker_endp == NULL) {
+        broker_endp = strdup ("ipc://"DFLT_BIND_FOLDER);
+    }
+
+    /* Set default service */
+    if (service == NULL) {
+        service = strdup (DFLT_SERVICE);
+    }
+
+    uint32_t max_clients = DFLT_MAX_CLIENTS;
+    if (max_clients_str != NULL) {
+        max_clients = strtoul (max_clients_str, NULL, 10);
+    }
+
+    uint32_t duration = DFLT_DURATION;
+    if (duration_str != NULL) {
+        duration = strtoul (duration_str, NULL, 10);
+    }
+
+    zctx_t *ctx = zctx_new ();
+    if (ctx == NULL) {
+        fprintf (stderr, "[client:smio_bench]: zctx could not be created\n");
+        goto err_ctx_new;
+    }
+
+    void **pipes = zmalloc (sizeof (*pipes) * max_clients);
+    if (pipes == NULL) {
+        fprintf (stderr, "[client:smio_bench]: could not allocate pipes\n");
+        goto err_pipes_alloc;
+    }
+
+    fprintf (stdout, "[client:smio_bench]: service %s, %u s per round\n",
+            service, duration);
+    fprintf (stdout, "%8s %12s %10s %12s\n", "clients", "requests", "errors",
+            "req/s");
+
+    /* Double the number of clients each round */
+    uint32_t num_clients;
+    for (num_clients = 1; num_clients <= max_clients && !zctx_interrupted;
+            num_clients *= 2) {
+        bench_args_t bench_args = {
+            .broker_endp = broker_endp,
+            .service = service,
+            .read_hw = read_hw,
+            .end_time = zclock_time () + duration*1000};
+
+        uint32_t num_spawned;
+        for (num_spawned = 0; num_spawned < num_clients; ++num_spawned) {
+            pipes [num_spawned] = zthread_fork (ctx, bench_client, &bench_args);
+            if (pipes [num_spawned] == NULL) {
+                fprintf (stderr, "[client:smio_bench]: could not spawn client\n");
+                break;
+            }
+        }
+
+        uint64_t total_ok = 0;
+        uint64_t total_err = 0;
+        for (i = 0; i < (int) num_spawned; ++i) {
+            char *report = zstr_recv (pipes [i]);
+            uint32_t num_ok = 0;
+            uint32_t num_err = 0;
+
+            if (report != NULL) {
+                sscanf (report, "%u %u", &num_ok, &num_err);
+                free (report);
+            }
+
+            total_ok += num_ok;
+            total_err += num_err;
+            zsocket_destroy (ctx, pipes [i]);
+        }
+
+        fprintf (stdout, "%8u %12"PRIu64" %10"PRIu64" %12.1f\n", num_spawned,
+                total_ok, total_err, (double) total_ok/duration);
+
+        if (verbose) {
+            fprintf (stdout, "[client:smio_bench]: round with %u clients done\n",
+                    num_spawned);
+        }
+    }
+
+    free (pipes);
+err_pipes_alloc:
+    zctx_destroy (&ctx);
+err_ctx_new:
+    str_p = &duration_str;
+    free (*str_p);
+    duration_str = NULL;
+    str_p = &max_clients_str;
+    free (*str_p);
+    max_clients_str = NULL;
+    str_p = &service;
+    free (*str_p);
+    service = NULL;
+    str_p = &broker_endp;
+    free (*str_p);
+    broker_endp = NULL;
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * Reload a single SMIO while another client keeps requesting a different
+ * SMIO of the same DEVIO. Reports how long the reloaded SMIO was
+ * unavailable and the worst request latency seen by the other client
+ * before and after the reload was requested. The latter should not
+ * change much, as the other SMIOs keep running during the reload
+ */
+
+#include <mdp.h>
+#include <czmq.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include <bpm_client.h>
+
+#define DFLT_BIND_FOLDER            "/tmp/bpm"
+#define DFLT_SERVICE                "BPM0:DEVIO:DSP0"
+#define DFLT_MONIT_SERVICE          "BPM0:DEVIO:SWAP0"
+#define DFLT_DURATION               3           /* in seconds */
+
+/* Monitor thread args structure */
+typedef struct {
+    char *broker_endp;
+    char *service;
+    int64_t reload_time;                        /* in msec */
+    int64_t end_time;                           /* in msec */
+} monit_args_t;
+
+void print_help (char *program_name)
+{
+    printf( "Usage: %s [options]\n"
+            "\t-h This help message\n"
+            "\t-v Verbose output\n"
+            "\t-b <broker_endpoint> Broker endpoint\n"
+            "\t-s <service> SMIO service to be reloaded (e.g., BPM0:DEVIO:DSP0)\n"
+            "\t-m <service> SMIO service to be monitored (e.g., BPM0:DEVIO:SWAP0)\n"
+            "\t-t <duration> Duration of the monitoring, in seconds (default = 3)\n",
+            program_name);
+}
+
+static uint64_t get_ts_us (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec*1000000 + ts.tv_nsec/1000;
+}
+
+/* Issue requests to the monitored service as fast as possible and report
+ * the worst latency before and after the reload to the parent */
+static void monit_client (void *args, zctx_t *ctx, void *pipe)
+{
+    (void) ctx;
+    monit_args_t *monit_args = (monit_args_t *) args;
+    uint64_t max_before_us = 0;
+    uint64_t max_after_us = 0;
+    uint32_t num_ok = 0;
+    uint32_t num_err = 0;
+
+    bpm_client_t *bpm_client = bpm_client_new (monit_args->broker_endp, 0, NULL);
+    if (bpm_client == NULL) {
+        fprintf (stderr, "[client:smio_reload]: bpm_client could not be created\n");
+        goto err_bpm_client_new;
+    }
+
+    smio_op_stats_t op_stats;
+    while (zclock_time () < monit_args->end_time && !zctx_interrupted) {
+        int64_t req_time = zclock_time ();
+        uint64_t start_us = get_ts_us ();
+        bpm_client_err_e err = bpm_get_smio_op_stats (bpm_client,
+                monit_args->service, 0, &op_stats);
+        uint64_t latency_us = get_ts_us () - start_us;
+
+        if (err == BPM_CLIENT_SUCCESS) {
+            num_ok++;
+        }
+        else {
+            num_err++;
+        }
+
+        if (req_time < monit_args->reload_time) {
+            max_before_us = (latency_us > max_before_us) ? latency_us : max_before_us;
+        }
+        else {
+            max_after_us = (latency_us > max_after_us) ? latency_us : max_after_us;
+        }
+    }
+
+    bpm_client_destroy (&bpm_client);
+err_bpm_client_new:
+    zstr_sendf (pipe, "%u %u %"PRIu64" %"PRIu64, num_ok, num_err,
+            max_before_us, max_after_us);
+}
+
+int main (int argc, char *argv [])
+{
+    int verbose = 0;
+    char *broker_endp = NULL;
+    char *service = NULL;
+    char *monit_service = NULL;
+    char *duration_str = NULL;
+    char **str_p = NULL;
+
+    if (argc < 2) {
+        print_help (argv[0]);
+        exit (1);
+    }
+
+    /* FIXME: This is rather buggy! */
+    /* Simple handling of command-line options. This should be done
+     * with getopt, for instance*/
+    int i;
+    for (i = 1; i < argc; i++)
+    {
+        if (streq(argv[i], "-v")) {
+            verbose = 1;
+        }
+        else if (streq(argv[i], "-h"))
+        {
+            print_help (argv [0]);
+            exit (1);
+        }
+        else if (streq (argv[i], "-b")) {
+            str_p = &broker_endp;
+        }
+        else if (streq (argv[i], "-s")) {
+            str_p = &service;
+        }
+        else if (streq (argv[i], "-m")) {
+            str_p = &monit_service;
+        }
+        else if (streq (argv[i], "-t")) {
+            str_p = &duration_str;
+        }
+        /* Fallout for options with parameters */
+        else {
+            *str_p = strdup (argv[i]);
+        }
+    }
+
+    /* Set default broker address */
+    if (broker_endp == NULL) {
+        broker_endp = strdup ("ipc://"DFLT_BIND_FOLDER);
+    }
+
+    /* Set default services */
+    if (service == NULL) {
+        service = strdup (DFLT_SERVICE);
+    }
+
+    if (monit_service == NULL) {
+        monit_service = strdup (DFLT_MONIT_SERVICE);
+    }
+
+    uint32_t duration = DFLT_DURATION;
+    if (duration_str != NULL) {
+        duration = strtoul (duration_str, NULL, 10);
+    }
+
+    zctx_t *ctx = zctx_new ();
+    if (ctx == NULL) {
+        fprintf (stderr, "[client:smio_reload]: zctx could not be created\n");
+        goto err_ctx_new;
+    }
+
+    bpm_client_t *bpm_client = bpm_client_new (broker_endp, verbose, NULL);
+    if (bpm_client == NULL) {
+        fprintf (stderr, "[client:smio_reload]: bpm_client could not be created\n");
+        goto err_bpm_client_new;
+    }
+
+    /* Reload in the middle of the monitoring */
+    int64_t start_time = zclock_time ();
+    monit_args_t monit_args = {
+        .broker_endp = broker_endp,
+        .service = monit_service,
+        .reload_time = start_time + duration*1000/3,
+        .end_time = start_time + duration*1000};
+
+    void *monit_pipe = zthread_fork (ctx, monit_client, &monit_args);
+    if (monit_pipe == NULL) {
+        fprintf (stderr, "[client:smio_reload]: could not spawn monitor client\n");
+        goto err_monit_fork;
+    }
+
+    zclock_sleep (monit_args.reload_time - start_time);
+
+    uint64_t reload_start_us = get_ts_us ();
+    smio_reload_report_t reload_report;
+    bpm_client_err_e err = bpm_smio_reload (bpm_client, service, &reload_report);
+    if (err != BPM_CLIENT_SUCCESS) {
+        fprintf (stderr, "[client:smio_reload]: could not reload %s: %s\n",
+                service, bpm_client_err_str (err));
+    }
+    else {
+        fprintf (stdout, "[client:smio_reload]: %s exited in %"PRIu64" us, "
+                "down for %"PRIu64" us until spawned again\n", service,
+                reload_report.exit_us, reload_report.downtime_us);
+
+        /* Wait for the new SMIO to answer */
+        smio_op_stats_t op_stats;
+        while (!zctx_interrupted && bpm_get_smio_op_stats (bpm_client, service,
+                    0, &op_stats) != BPM_CLIENT_SUCCESS);
+
+        fprintf (stdout, "[client:smio_reload]: %s unavailable for %"PRIu64" us\n",
+                service, get_ts_us () - reload_start_us);
+    }
+
+    char *report = zstr_recv (monit_pipe);
+    uint32_t num_ok = 0;
+    uint32_t num_err = 0;
+    uint64_t max_before_us = 0;
+    uint64_t max_after_us = 0;
+
+    if (report != NULL) {
+        sscanf (report, "%u %u %"SCNu64" %"SCNu64, &num_ok, &num_err,
+                &max_before_us, &max_after_us);
+        free (report);
+    }
+
+    fprintf (stdout, "[client:smio_reload]: %s: %u requests, %u errors\n",
+            monit_service, num_ok, num_err);
+    fprintf (stdout, "[client:smio_reload]: %s: max latency %"PRIu64" us before "
+            "the reload, %"PRIu64" us after\n", monit_service, max_before_us,
+            max_after_us);
+
+    zsocket_destroy (ctx, monit_pipe);
+err_monit_fork:
+    bpm_client_destroy (&bpm_client);
+err_bpm_client_new:
+    zctx_destroy (&ctx);
+err_ctx_new:
+    str_p = &duration_str;
+    free (*str_p);
+    duration_str = NULL;
+    str_p = &monit_service;
+    free (*str_p);
+    monit_service = NULL;
+    str_p = &service;
+    free (*str_p);
+    service = NULL;
+    str_p = &broker_endp;
+    free (*str_p);
+    broker_endp = NULL;
+    return 0;
+}
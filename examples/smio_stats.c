@@ -0,0 +1,155 @@
+/*
+ * Simple example dumping the per-operation statistics
+ * of a SMIO service
+ */
+
+#include <mdp.h>
+#include <czmq.h>
+#include <inttypes.h>
+
+#include <bpm_client.h>
+
+#define DFLT_BIND_FOLDER            "/tmp/bpm"
+#define DFLT_SERVICE                "BPM0:DEVIO:DSP0"
+
+void print_help (char *program_name)
+{
+    printf( "Usage: %s [options]\n"
+            "\t-h This help message\n"
+            "\t-v Verbose output\n"
+            "\t-d Dump latency histograms as well\n"
+            "\t-b <broker_endpoint> Broker endpoint\n"
+            "\t-s <service> SMIO service name (e.g., BPM0:DEVIO:ACQ0)\n",
+            program_name);
+}
+
+static double mean_us (const smio_stats_hist_t *hist, uint64_t calls)
+{
+    return (calls == 0) ? 0.0 : (double) hist->total_ns/calls/1000.0;
+}
+
+static void print_hist (const char *hist_name, const smio_stats_hist_t *hist)
+{
+    fprintf (stdout, "\t%-8s:", hist_name);
+    for (uint32_t i = 0; i < SMIO_STATS_HIST_BINS; ++i) {
+        if (hist->bins[i] == 0) {
+            continue;
+        }
+
+        if (i == 0) {
+            fprintf (stdout, " [<1us]=%u", hist->bins[i]);
+        }
+        else if (i == SMIO_STATS_HIST_BINS-1) {
+            fprintf (stdout, " [>=%uus]=%u", 1U << (i-1), hist->bins[i]);
+        }
+        else {
+            fprintf (stdout, " [%u-%uus]=%u", 1U << (i-1), 1U << i, hist->bins[i]);
+        }
+    }
+    fprintf (stdout, "\n");
+}
+
+int main (int argc, char *argv [])
+{
+    int verbose = 0;
+    int dump_hist = 0;
+    char *broker_endp = NULL;
+    char *service = NULL;
+    char **str_p = NULL;
+
+    if (argc < 2) {
+        print_help (argv[0]);
+        exit (1);
+    }
+
+    /* FIXME: This is rather buggy! */
+    /* Simple handling of command-line options. This should be done
+     * with getopt, for instance*/
+    int i;
+    for (i = 1; i < argc; i++)
+    {
+        if (streq(argv[i], "-v")) {
+            verbose = 1;
+        }
+        else if (streq(argv[i], "-d")) {
+            dump_hist = 1;
+        }
+        else if (streq(argv[i], "-h"))
+        {
+            print_help (argv [0]);
+            exit (1);
+        }
+        else if (streq (argv[i], "-b")) {
+            str_p = &broker_endp;
+        }
+        else if (streq (argv[i], "-s")) {
+            str_p = &service;
+        }
+        /* Fallout for options with parameters */
+        else {
+            *str_p = strdup (argv[i]);
+        }
+    }
+
+    /* Set default broker address */
+    if (broker_endp == NULL) {
+        broker_endp = strdup ("ipc://"DFLT_BIND_FOLDER);
+    }
+
+    /* Set default service */
+    if (service == NULL) {
+        service = strdup (DFLT_SERVICE);
+    }
+
+    bpm_client_t *bpm_client = bpm_client_new (broker_endp, verbose, NULL);
+    if (bpm_client == NULL) {
+        fprintf (stderr, "[client:smio_stats]: bpm_client could not be created\n");
+        goto err_bpm_client_new;
+    }
+
+    fprintf (stdout, "[client:smio_stats]: statistics for %s (times in us)\n", service);
+    fprintf (stdout, "%-4s %-32s %10s %8s %10s %8s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+            "op", "name", "calls", "errors", "coalesced", "expired", "queue avg", "queue max",
+            "hdlr avg", "hdlr max", "thsafe avg", "thsafe max", "msg allocs", "msg reuses");
+
+    uint32_t opcode = 0;
+    uint32_t num_ops = 0;
+    smio_op_stats_t op_stats;
+    while (bpm_get_smio_op_stats (bpm_client, service, opcode, &op_stats) ==
+            BPM_CLIENT_SUCCESS) {
+        fprintf (stdout, "%-4u %-32s %10"PRIu64" %8"PRIu64" %10"PRIu64" %8"PRIu64
+                " %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10"PRIu64" %10"PRIu64"\n",
+                op_stats.opcode, op_stats.name, op_stats.calls, op_stats.errors,
+                op_stats.coalesced, op_stats.expired,
+                mean_us (&op_stats.queue, op_stats.calls),
+                (double) op_stats.queue.max_ns/1000.0,
+                mean_us (&op_stats.handler, op_stats.calls),
+                (double) op_stats.handler.max_ns/1000.0,
+                mean_us (&op_stats.thsafe, op_stats.calls),
+                (double) op_stats.thsafe.max_ns/1000.0,
+                op_stats.msg_allocs, op_stats.msg_reuses);
+
+        if (dump_hist) {
+            print_hist ("queue", &op_stats.queue);
+            print_hist ("handler", &op_stats.handler);
+            print_hist ("thsafe", &op_stats.thsafe);
+        }
+
+        opcode = op_stats.opcode + 1;
+        num_ops++;
+    }
+
+    if (num_ops == 0) {
+        fprintf (stderr, "[client:smio_stats]: bpm_get_smio_op_stats failed\n");
+    }
+
+    bpm_client_destroy (&bpm_client);
+err_bpm_client_new:
+    str_p = &service;
+    free (*str_p);
+    service = NULL;
+    str_p = &broker_endp;
+    free (*str_p);
+    broker_endp = NULL;
+    return 0;
+}
@@ -7,13 +7,38 @@
 #include "dev_io.h"
 #include "debug_print.h"
 #include "board.h"
+#include "hal_sched.h"
 
 #define DEVIO_SERVICE_LEN       50
 
+#ifdef __CFG_DIR__
+#define CFG_DIR                 STRINGIFY(__CFG_DIR__)
+#else
+#error "Config directory not defined!"
+#endif
+
+#ifdef __CFG_FILENAME__
+#define CFG_FILENAME            STRINGIFY(__CFG_FILENAME__)
+#else
+#error "Config filename not defined!"
+#endif
+
+/* Configuration file sections of each DEVIO type */
+#define DEVIO_CFG_AFE           "afe"
+#define DEVIO_CFG_DBE           "dbe"
+/* Configuration file section with the DEVIO process scheduling options */
+#define DEVIO_SCHED_PATH_PATTERN "/dev_io/board%u/sched/%s"
+#define DEVIO_SCHED_PATH_LEN    64
+
 static devio_err_e _spawn_platform_smios (devio_t *devio, devio_type_e devio_type,
         uint32_t smio_inst_id);
 static devio_err_e _spawn_be_platform_smios (devio_t *devio);
 static devio_err_e _spawn_fe_platform_smios (devio_t *devio, uint32_t smio_inst_id);
+static devio_err_e _serve_board (devio_t *devio, const char *cfg_file,
+        uint32_t dev_id, devio_type_e devio_type, uint32_t fe_smio_id);
+static int _apply_sched_cfg (const char *cfg_file, uint32_t dev_id,
+        const char *cfg_node);
+static int _split_list (char *list, char **items, int max_items);
 
 void print_help (char *program_name)
 {
@@ -27,6 +52,13 @@ void print_help (char *program_name)
             "\t-e <dev_entry = [ip_addr|/dev entry]> Device entry\n"
             "\t-i <dev_id> Device ID\n"
             "\t-s <fe_smio_id> FE SMIO ID (only valid for devio_type = fe)\n"
+            "\t   A single DEVIO can serve more than one device. In this case,\n"
+            "\t   -e, -i and -s take comma-separated lists, in the same order\n"
+            "\t-w <num_workers> Number of workers serving each SMIO (default = 1)\n"
+            "\t-r Restart mode. Only write the default values that differ from\n"
+            "\t   the ones already in the hardware\n"
+            "\t-c <cfg_file> Configuration file with the default values\n"
+            "\t   (default = "CFG_DIR"/"CFG_FILENAME")\n"
             "\t-l <log_filename> Log filename\n"
             "\t-b <broker_endpoint> Broker endpoint\n", program_name);
 }
@@ -35,13 +67,16 @@ int main (int argc, char *argv[])
 {
     int verbose = 0;
     int daemonize = 0;
+    int restart = 0;
     char *devio_type_str = NULL;
     char *dev_type = NULL;
     char *dev_entry = NULL;
     char *dev_id_str = NULL;
     char *fe_smio_id_str = NULL;
+    char *smio_nworkers_str = NULL;
     char *broker_endp = NULL;
     char *log_file_name = NULL;
+    char *cfg_file = NULL;
     char **str_p = NULL;
     int i;
 
@@ -63,6 +98,10 @@ int main (int argc, char *argv[])
             daemonize = 1;
             DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[dev_io] Demonize mode set\n");
         }
+        else if (streq (argv[i], "-r")) {
+            restart = 1;
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[dev_io] Restart mode set\n");
+        }
         else if (streq (argv[i], "-n")) {
             str_p = &devio_type_str;
             DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[dev_io] Will set devio_type parameter\n");
@@ -83,10 +122,18 @@ int main (int argc, char *argv[])
             str_p = &fe_smio_id_str;
             DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[dev_io] Will set fe_smio_id_str parameter\n");
         }
+        else if (streq (argv[i], "-w")) {
+            str_p = &smio_nworkers_str;
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[dev_io] Will set smio_nworkers_str parameter\n");
+        }
         else if (streq (argv[i], "-b")) {
             str_p = &broker_endp;
             DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[dev_io] Will set broker_endp parameter\n");
         }
+        else if (streq (argv[i], "-c")) {
+            str_p = &cfg_file;
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[dev_io] Will set cfg_file parameter\n");
+        }
         else if (streq (argv[i], "-l")) {
             str_p = &log_file_name;
             DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[dev_io] Will set log filename\n");
@@ -134,48 +181,79 @@ int main (int argc, char *argv[])
         goto err_exit;
     }
 
-    uint32_t dev_id = 0;
+    /* We can serve more than one board. Each one has its own entry, ID
+     * and FE SMIO ID, in the same order */
+    char *dev_entries [DEVIO_MAX_BOARDS];
+    int num_boards = _split_list (dev_entry, dev_entries, DEVIO_MAX_BOARDS);
+    if (num_boards <= 0) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] Dev_entry parameter is invalid.\n"
+                "\tUp to %u comma-separated entries are supported. Exiting ...\n",
+                DEVIO_MAX_BOARDS);
+        goto err_exit;
+    }
+
+    uint32_t dev_ids [DEVIO_MAX_BOARDS];
     /* Check for device ID */
     if (dev_id_str == NULL) {
         switch (llio_type) {
-            case ETH_DEV:
-                DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io] Dev_id parameter was not set. Exiting ...\n");
-                goto err_exit;
-            break;
-
             case PCIE_DEV:
                 DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io] Dev_id parameter was not set.\n"
                     "\tDefaulting it to the /dev file number ...\n");
 
-                int matches = sscanf (dev_entry, "/dev/fpga%u", &dev_id);
-                if (matches == 0) {
-                    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] Dev_entry parameter is invalid.\n"
-                            "\tIt must be in the format \"/dev/fpga<device_number>\". Exiting ...\n");
-                    goto err_exit;
+                for (i = 0; i < num_boards; ++i) {
+                    int matches = sscanf (dev_entries [i], "/dev/fpga%u", &dev_ids [i]);
+                    if (matches != 1) {
+                        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] Dev_entry parameter is invalid.\n"
+                                "\tIt must be in the format \"/dev/fpga<device_number>\". Exiting ...\n");
+                        goto err_exit;
+                    }
                 }
+            break;
 
             default:
                 DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io] Dev_id parameter was not set. Exiting ...\n");
                 goto err_exit;
         }
     }
-    /* Use the passed ID */
+    /* Use the passed IDs */
     else {
-        dev_id = strtoul (dev_id_str, NULL, 10);
+        char *dev_id_strs [DEVIO_MAX_BOARDS];
+        if (_split_list (dev_id_str, dev_id_strs, DEVIO_MAX_BOARDS) != num_boards) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] There must be one "
+                    "Dev_id for each Dev_entry. Exiting ...\n");
+            goto err_exit;
+        }
+
+        for (i = 0; i < num_boards; ++i) {
+            dev_ids [i] = strtoul (dev_id_strs [i], NULL, 10);
+        }
     }
 
-    uint32_t fe_smio_id = 0;
+    uint32_t fe_smio_ids [DEVIO_MAX_BOARDS] = {0};
     /* Check for FE SMIO ID */
-    if (devio_type == FE_DEVIO && fe_smio_id_str == NULL) {
-        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io] Fe_smio_id parameter was not set. Exiting ...\n");
-        goto err_exit;
-    }
-    else {
-        fe_smio_id = strtoul (fe_smio_id_str, NULL, 10);
+    if (devio_type == FE_DEVIO) {
+        char *fe_smio_id_strs [DEVIO_MAX_BOARDS];
+        if (fe_smio_id_str == NULL) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io] Fe_smio_id parameter was not set. Exiting ...\n");
+            goto err_exit;
+        }
+
+        if (_split_list (fe_smio_id_str, fe_smio_id_strs, DEVIO_MAX_BOARDS) !=
+                num_boards) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] There must be one "
+                    "Fe_smio_id for each Dev_entry. Exiting ...\n");
+            goto err_exit;
+        }
+
+        for (i = 0; i < num_boards; ++i) {
+            fe_smio_ids [i] = strtoul (fe_smio_id_strs [i], NULL, 10);
+        }
     }
 
-    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io] Dev_id parameter was set to %u.\n",
-            dev_id);
+    for (i = 0; i < num_boards; ++i) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io] Dev_id parameter of "
+                "%s was set to %u.\n", dev_entries [i], dev_ids [i]);
+    }
 
     /* We don't need it anymore */
     str_p = &fe_smio_id_str;
@@ -188,36 +266,115 @@ int main (int argc, char *argv[])
     free (*str_p);
     dev_id_str = NULL;
 
+    /* Place ourselves before creating any thread or allocating the DEVIO
+     * resources. The SMIO threads inherit these options */
+    int sched_err = _apply_sched_cfg ((cfg_file != NULL) ? cfg_file :
+            CFG_DIR"/"CFG_FILENAME, dev_ids [0], (devio_type == FE_DEVIO) ?
+            DEVIO_CFG_AFE : DEVIO_CFG_DBE);
+    if (sched_err != 0) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] _apply_sched_cfg error!\n");
+        goto err_exit;
+    }
+
     /* Initilialize dev_io */
     DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[dev_io] Creating DEVIO instance ...\n");
 
+    /* Each board keeps its own service names. A board that can't be set up
+     * is left out, so it does not take the others down with it */
     char devio_service_str [DEVIO_SERVICE_LEN];
-    snprintf (devio_service_str, DEVIO_SERVICE_LEN-1, "BPM%u:DEVIO", dev_id);
-    devio_service_str [DEVIO_SERVICE_LEN-1] = '\0'; /* Just in case ... */
-    devio_t *devio = devio_new (devio_service_str, dev_entry, llio_type,
-            broker_endp, verbose, log_file_name);
-    /* devio_t *devio = devio_new ("BPM0:DEVIO", *str_p, llio_type,
-            "tcp://localhost:5555", verbose); */
+    devio_t *devio = NULL;
+    for (i = 0; i < num_boards && devio == NULL; ++i) {
+        snprintf (devio_service_str, DEVIO_SERVICE_LEN-1, "BPM%u:DEVIO", dev_ids [i]);
+        devio_service_str [DEVIO_SERVICE_LEN-1] = '\0'; /* Just in case ... */
+        devio = devio_new (devio_service_str, dev_entries [i], llio_type,
+                broker_endp, verbose, log_file_name);
+        /* devio_t *devio = devio_new ("BPM0:DEVIO", *str_p, llio_type,
+                "tcp://localhost:5555", verbose); */
+
+        if (devio == NULL) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io] devio_new error for "
+                    "board %s. Skipping it ...\n", dev_entries [i]);
+        }
+    }
 
     if (devio == NULL) {
-        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] devio_new error!\n");
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] No board could be "
+                "served!\n");
         goto err_exit;
     }
 
+    /* The first board was added by devio_new () */
+    int first_board = i-1;
+
     /* We don't need it anymore */
-    str_p = &dev_entry;
-    free (*str_p);
-    dev_entry = NULL;
     str_p = &broker_endp;
     free (*str_p);
     broker_endp = NULL;
 
-    devio_err_e err = _spawn_platform_smios (devio, devio_type, fe_smio_id);
+    devio_err_e err = DEVIO_SUCCESS;
+    /* Set the number of workers serving each SMIO */
+    if (smio_nworkers_str != NULL) {
+        err = devio_set_smio_nworkers (devio, strtoul (smio_nworkers_str, NULL, 10));
+        if (err != DEVIO_SUCCESS) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] devio_set_smio_nworkers error!\n");
+            goto err_devio;
+        }
+    }
+
+    /* Do not disturb a running machine with values it already has */
+    err = devio_set_smio_config_diff (devio, restart);
     if (err != DEVIO_SUCCESS) {
-        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] _spawn_platform_smios error!\n");
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] devio_set_smio_config_diff error!\n");
+        goto err_devio;
+    }
+
+    /* Front-end boards are slow Ethernet endpoints. Serve all of them from
+     * one event loop, so none of them holds up the others */
+    if (devio_type == FE_DEVIO && llio_type == ETH_DEV) {
+        err = devio_enable_fe_loop (devio);
+        if (err != DEVIO_SUCCESS) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] devio_enable_fe_loop error!\n");
+            goto err_devio;
+        }
+    }
+
+    int num_served = 0;
+    for (i = first_board; i < num_boards; ++i) {
+        if (i > first_board) {
+            snprintf (devio_service_str, DEVIO_SERVICE_LEN-1, "BPM%u:DEVIO",
+                    dev_ids [i]);
+            err = devio_add_board (devio, devio_service_str, dev_entries [i],
+                    llio_type);
+            if (err != DEVIO_SUCCESS) {
+                DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io] devio_add_board "
+                        "error for board %s. Skipping it ...\n", dev_entries [i]);
+                continue;
+            }
+        }
+
+        err = _serve_board (devio, cfg_file, dev_ids [i], devio_type,
+                fe_smio_ids [i]);
+        if (err != DEVIO_SUCCESS) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io] Could not set up "
+                    "board %s. Skipping it ...\n", dev_entries [i]);
+            devio_remove_last_board (devio);
+            continue;
+        }
+
+        num_served++;
+    }
+
+    if (num_served == 0) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] No board could be "
+                "served!\n");
         goto err_devio;
     }
 
+    /* We don't need it anymore */
+    str_p = &dev_entry;
+    free (*str_p);
+    dev_entry = NULL;
+
     /* err = devio_init_poller_sm (devio); */
     err = devio_init_poller2_sm (devio);
     if (err != DEVIO_SUCCESS) {
@@ -242,10 +399,14 @@ int main (int argc, char *argv[])
 err_devio:
     devio_destroy (&devio);
 err_exit:
+    str_p = &cfg_file;
+    free (*str_p);
     str_p = &log_file_name;
     free (*str_p);
     str_p = &fe_smio_id_str;
     free (*str_p);
+    str_p = &smio_nworkers_str;
+    free (*str_p);
     str_p = &broker_endp;
     free (*str_p);
     str_p = &dev_id_str;
@@ -259,6 +420,30 @@ err_exit:
     return 0;
 }
 
+/* Configure and spawn the SMIOs of the last board added */
+static devio_err_e _serve_board (devio_t *devio, const char *cfg_file,
+        uint32_t dev_id, devio_type_e devio_type, uint32_t fe_smio_id)
+{
+    /* Default values overriding the built-in ones */
+    devio_err_e err = devio_set_smio_cfg (devio, (cfg_file != NULL) ? cfg_file :
+            CFG_DIR"/"CFG_FILENAME, dev_id, (devio_type == FE_DEVIO) ?
+            DEVIO_CFG_AFE : DEVIO_CFG_DBE);
+    if (err != DEVIO_SUCCESS) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io] devio_set_smio_cfg error!\n");
+        goto err_set_smio_cfg;
+    }
+
+    err = _spawn_platform_smios (devio, devio_type, fe_smio_id);
+    if (err != DEVIO_SUCCESS) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io] _spawn_platform_smios error!\n");
+        goto err_spawn_smios;
+    }
+
+err_spawn_smios:
+err_set_smio_cfg:
+    return err;
+}
+
 static devio_err_e _spawn_platform_smios (devio_t *devio, devio_type_e devio_type,
         uint32_t smio_inst_id)
 {
@@ -299,6 +484,20 @@ static devio_err_e _spawn_be_platform_smios (devio_t *devio)
 
 /* ML605 or AFCv3 */
 #if defined (__BOARD_ML605__) || defined (__BOARD_AFCV3__)
+    /* Discover our SMIOs from the SDB */
+    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io] Spawning SMIOs from SDB ...\n");
+    err = devio_register_all_sm (devio, WB_SDB_RAW_ADDR, WB_SDB_ADDR_FLAGS);
+    if (err == DEVIO_SUCCESS) {
+        goto err_register_sm;
+    }
+
+    /* Gateware without a SDB. Fall back to the static layout. We can
+     * only do this if no SMIO was registered */
+    if (err != DEVIO_ERR_SDB) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] devio_register_all_sm error!\n");
+        goto err_register_sm;
+    }
+
     DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io] Spawning default SMIOs ...\n");
     err = devio_register_sm (devio, fmc130m_4ch_id, FMC1_130M_BASE_ADDR, 0);
     if (err != DEVIO_SUCCESS) {
@@ -380,3 +579,66 @@ static devio_err_e _spawn_fe_platform_smios (devio_t *devio, uint32_t smio_inst_
 err_register_sm:
     return err;
 }
+
+/* Apply the scheduling options of this DEVIO process from the configuration
+ * file and report where we ended up running. Only invalid options are
+ * fatal. Not being allowed to apply them (e.g., no privileges) is not */
+static int _apply_sched_cfg (const char *cfg_file, uint32_t dev_id,
+        const char *cfg_node)
+{
+    zconfig_t *root_cfg = zconfig_load ((char *) cfg_file);
+    if (root_cfg != NULL) {
+        char sched_path [DEVIO_SCHED_PATH_LEN];
+        snprintf (sched_path, sizeof (sched_path), DEVIO_SCHED_PATH_PATTERN,
+                dev_id, cfg_node);
+
+        halutils_sched_cfg_t sched_cfg = {0};
+        halutils_err_e err = halutils_sched_cfg_load (root_cfg, sched_path,
+                &sched_cfg);
+        zconfig_destroy (&root_cfg);
+
+        if (err != HALUTILS_SUCCESS) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_FATAL, "[dev_io] Invalid scheduling "
+                    "options in %s: %s\n", sched_path, halutils_err_str (err));
+            return -1;
+        }
+
+        err = halutils_sched_apply (0, &sched_cfg);
+        if (err != HALUTILS_SUCCESS) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_WARN, "[dev_io] Could not apply the "
+                    "scheduling options from %s: %s\n", sched_path,
+                    halutils_err_str (err));
+        }
+        else if (sched_cfg.mlock) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io] Memory locked\n");
+        }
+    }
+
+    char placement [HALUTILS_SCHED_STR_LEN];
+    if (halutils_sched_placement_str (0, placement, sizeof (placement)) ==
+            HALUTILS_SUCCESS) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io] DEVIO PID %d "
+                "placement: %s\n", getpid (), placement);
+    }
+
+    return 0;
+}
+
+/* Split a comma-separated list in place. Returns the number of items or -1
+ * if there are more than max_items of them */
+static int _split_list (char *list, char **items, int max_items)
+{
+    int num_items = 0;
+    char *saveptr = NULL;
+    char *item = strtok_r (list, ",", &saveptr);
+
+    for (; item != NULL; item = strtok_r (NULL, ",", &saveptr)) {
+        if (num_items == max_items) {
+            return -1;
+        }
+
+        items [num_items++] = item;
+    }
+
+    return num_items;
+}
@@ -7,17 +7,28 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "dev_io_core.h"
 #include "dev_io_err.h"
+#include "dev_io_fe_loop.h"
 #include "hal_assert.h"
 #include "sm_io_mod_dispatch.h"
 #include "msg.h"
 #include "rw_param.h"
 #include "sm_io_thsafe_codes.h"
 #include "sm_io_bootstrap.h"
+#include "sm_io_stats.h"
+#include "sm_io_reload_exports.h"
+#include "dev_io_exports.h"
 #include "ll_io_utils.h"
 #include "hal_utils.h"
+#include "sdb.h"
 
 /* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
 #ifdef ASSERT_TEST
@@ -44,15 +55,70 @@
 
 #define LLIO_STR                            ":LLIO\0"
 #define DEVIO_POLLER_TIMEOUT                100        /* in msec */
+/* How long a SMIO has to exit after being told to */
+#define DEVIO_SMIO_EXIT_TIMEOUT             2000       /* in msec */
 #define DEVIO_DFLT_LOG_MODE                 "w"
 
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
+/* Parsed SDB topology cache, one per board. It is only used if every
+ * SDB record table it was parsed from is unchanged */
+#define DEVIO_SDB_CACHE_DIR                 "/var/cache/bpm_sw"
+#define DEVIO_SDB_CACHE_PATTERN             DEVIO_SDB_CACHE_DIR"/sdb_%s.cfg"
+#define DEVIO_SDB_CACHE_TMP_SUFFIX          ".tmp"
+#define DEVIO_SDB_CACHE_PATH_LEN            128
+#define DEVIO_SDB_MAX_DEVS                  64
+
+/* Section of the configuration file with the SMIO default values */
+#define DEVIO_SMIO_CFG_PATH_PATTERN         "/dev_io/board%u/bpm%u/%s/defaults/%s"
+/* Section of the configuration file with the SMIO scheduling options */
+#define DEVIO_SMIO_SCHED_PATH_PATTERN       "/dev_io/board%u/bpm%u/%s/sched/%s"
+
+/* How a SMIO was registered, so it can be registered again */
+struct _devio_smio_info_t {
+    devio_board_t *board;               /* Board the SMIO belongs to */
+    uint32_t smio_id;                   /* SMIO ID, the same from the SDB ID */
+    uint32_t base;                      /* SMIO base address */
+    uint32_t inst_id;                   /* SMIO instance ID */
+};
+
+typedef struct _devio_smio_info_t devio_smio_info_t;
+
 /* Do the SMIO operation */
-static devio_err_e _devio_do_smio_op (devio_t *self, void *msg);
+static devio_err_e _devio_do_smio_op (devio_t *self, devio_board_t *board,
+        void *msg);
 static devio_err_e _devio_send_destruct_msg (devio_t *self, void *pipe);
+static devio_err_e _devio_wait_smio_exit (devio_t *self, void *pipe,
+        devio_board_t *board);
+static bool _devio_is_exit_msg (zmsg_t *msg);
 static devio_err_e _devio_destroy_smio (devio_t *self, const char *smio_key);
 static devio_err_e _devio_destroy_smio_all (devio_t *self);
+static devio_err_e _devio_reset_pollers (devio_t *self);
+static void _devio_do_mngr_requests (devio_t *self);
+static bool _devio_sdb_cache_path (devio_board_t *board, char *path,
+        size_t len);
+static bool _devio_sdb_cache_owned (const struct stat *st);
+static ssize_t _devio_sdb_cache_load (const char *path, sdb_tables_t *tables,
+        sdb_dev_t *devs, size_t max_devs);
+static devio_err_e _devio_sdb_cache_save (const char *path,
+        const sdb_tables_t *tables, const sdb_dev_t *devs, size_t num_devs);
+static int _devio_sdb_dev_cmp (const void *a, const void *b);
+static bool _devio_smio_cfg_path (devio_board_t *board, const char *pattern,
+        uint32_t inst_id, const char *smio_name, char *path, size_t len);
+static devio_board_t *_devio_board_new (devio_t *parent, char *name,
+        char *endpoint_dev, llio_type_e type);
+static void _devio_board_destroy (devio_board_t **board_p);
+static devio_board_t *_devio_get_pipe_board (devio_t *self, void *pipe);
+static devio_err_e _devio_register_sm (devio_t *self, devio_board_t *board,
+        uint32_t smio_id, uint32_t base, uint32_t inst_id, uint64_t reload_ts);
+
+/* Management operations */
+static int _devio_mngr_reload (void *owner, void *args, void *ret);
+
+static const disp_table_func_fp devio_mngr_exp_fp [] = {
+    _devio_mngr_reload,
+    NULL
+};
 
 /* Creates a new instance of Device Information */
 devio_t * devio_new (char *name, char *endpoint_dev, llio_type_e type,
@@ -82,8 +148,12 @@ devio_t * devio_new (char *name, char *endpoint_dev, llio_type_e type,
             "Error setting log file!", err_log_file);
 
     /* Initialize the sockets structure to talk to nodes */
-    self->pipes = zmalloc (sizeof (*self->pipes) * NODES_MAX_LEN);
+    self->pipes = zmalloc (sizeof (*self->pipes) * NODES_MAX_LEN *
+            DEVIO_MAX_BOARDS);
     ASSERT_ALLOC(self->pipes, err_pipes_alloc);
+    self->pipes_board = zmalloc (sizeof (*self->pipes_board) * NODES_MAX_LEN *
+            DEVIO_MAX_BOARDS);
+    ASSERT_ALLOC(self->pipes_board, err_pipes_board_alloc);
     /* 0 nodes for now... */
     self->nnodes = 0;
 
@@ -104,23 +174,13 @@ devio_t * devio_new (char *name, char *endpoint_dev, llio_type_e type,
     self->endpoint_broker = strdup (endpoint_broker);
     ASSERT_ALLOC(self->endpoint_broker, err_endp_broker_alloc);
     self->verbose = verbose;
+    self->smio_nworkers = SMIO_DFLT_NUM_WORKERS;
+    self->smio_config_diff = false;
 
-    /* Concatenate recv'ed name with a llio identifier */
-    char *llio_name = zmalloc (sizeof (char)*(strlen(name)+strlen(LLIO_STR)+1));
-    ASSERT_ALLOC(llio_name, err_llio_name_alloc);
-    strcat (llio_name, name);
-    strcat (llio_name, LLIO_STR);
-    self->llio = llio_new (llio_name, endpoint_dev, type,
-            verbose);
-    ASSERT_ALLOC(self->llio, err_llio_alloc);
-
-    /* We try to open the device */
-    int err = llio_open (self->llio, NULL);
-    ASSERT_TEST(err==0, "Error opening device!", err_llio_open);
-
-    /* We can free llio_name now, as llio copies the string */
-    free (llio_name);
-    llio_name = NULL; /* Avoid double free error */
+    /* Our first board. Others might be added later */
+    self->boards [0] = _devio_board_new (self, name, endpoint_dev, type);
+    ASSERT_ALLOC(self->boards [0], err_board_alloc);
+    self->nboards = 1;
 
     /* Init sm_io_thsafe_server_ops_h. For now, we assume we want zmq
      * for exchanging messages between smio and devio instances */
@@ -130,6 +190,10 @@ devio_t * devio_new (char *name, char *endpoint_dev, llio_type_e type,
     self->sm_io_h = zhash_new ();
     ASSERT_ALLOC(self->sm_io_h, err_sm_io_h_alloc);
 
+    /* Init sm_io_info_h hash */
+    self->sm_io_info_h = zhash_new ();
+    ASSERT_ALLOC(self->sm_io_info_h, err_sm_io_info_h_alloc);
+
     /* Init sm_io_thsafe_ops_h dispatch table */
     self->disp_table_thsafe_ops = disp_table_new ();
     ASSERT_ALLOC(self->disp_table_thsafe_ops, err_disp_table_thsafe_ops_alloc);
@@ -139,6 +203,19 @@ devio_t * devio_new (char *name, char *endpoint_dev, llio_type_e type,
     ASSERT_TEST(halutils_err==HALUTILS_SUCCESS, "Could not initialize dispatch table",
             err_disp_table_init);
 
+    /* Init management dispatch table */
+    self->disp_table_mngr_ops = disp_table_new ();
+    ASSERT_ALLOC(self->disp_table_mngr_ops, err_disp_table_mngr_ops_alloc);
+
+    halutils_err = disp_table_fill_desc (self->disp_table_mngr_ops,
+            (disp_op_t **) smio_reload_exp_ops, devio_mngr_exp_fp);
+    ASSERT_TEST(halutils_err==HALUTILS_SUCCESS, "Could not fill management "
+            "operations description", err_disp_table_mngr_init);
+    halutils_err = disp_table_insert_all (self->disp_table_mngr_ops,
+            smio_reload_exp_ops);
+    ASSERT_TEST(halutils_err==HALUTILS_SUCCESS, "Could not initialize management "
+            "dispatch table", err_disp_table_mngr_init);
+
     /* Finally, initialize mdp_worker with service being the BPM<board_number> */
     /* self->worker = mdp_worker_new (endpoint_broker, name, verbose);
     ASSERT_ALLOC(self->worker, err_worker_alloc); */
@@ -155,23 +232,26 @@ devio_t * devio_new (char *name, char *endpoint_dev, llio_type_e type,
     return self;
 
 err_ctx_alloc:
+err_disp_table_mngr_init:
+    disp_table_destroy (&self->disp_table_mngr_ops);
+err_disp_table_mngr_ops_alloc:
 err_disp_table_init:
     disp_table_destroy (&self->disp_table_thsafe_ops);
 err_disp_table_thsafe_ops_alloc:
+    zhash_destroy (&self->sm_io_info_h);
+err_sm_io_info_h_alloc:
     zhash_destroy (&self->sm_io_h);
 err_sm_io_h_alloc:
-    llio_release (self->llio, NULL);
-err_llio_open:
-    llio_destroy (&self->llio);
-err_llio_alloc:
-    free (llio_name);
-err_llio_name_alloc:
+    _devio_board_destroy (&self->boards [0]);
+err_board_alloc:
     free (self->endpoint_broker);
 err_endp_broker_alloc:
     free (self->name);
 err_name_alloc:
     zpoller_destroy (&self->poller);
 err_poller_alloc:
+    free (self->pipes_board);
+err_pipes_board_alloc:
     free (self->pipes);
 err_pipes_alloc:
     free (self->log_file);
@@ -191,21 +271,37 @@ devio_err_e devio_destroy (devio_t **self_p)
 
         /* Destroy children threads before proceeding */
         _devio_destroy_smio_all (self);
+        /* Transfers still going on have nobody waiting for them */
+        devio_fe_loop_destroy (&self->fe_loop);
+        /* No more management requests either. The workers must go before
+         * the context */
+        uint32_t i;
+        for (i = 0; i < self->nboards; ++i) {
+            if (self->boards [i]->worker != NULL) {
+                mdp_worker_destroy (&self->boards [i]->worker);
+            }
+        }
+        /* No more requests will be handled by this thread */
+        msg_pool_release ();
 
         /* Starting destructing by the last resource */
         /* Notice that we destroy the worker first, as to
          * unregister from broker as soon as possible to avoid
          * loosing requests from clients */
         zctx_destroy (&self->ctx);
+        disp_table_destroy (&self->disp_table_mngr_ops);
         disp_table_destroy (&self->disp_table_thsafe_ops);
+        zhash_destroy (&self->sm_io_info_h);
         zhash_destroy (&self->sm_io_h);
         self->thsafe_server_ops = NULL;
-        llio_release (self->llio, NULL);
-        llio_destroy (&self->llio);
+        for (i = 0; i < self->nboards; ++i) {
+            _devio_board_destroy (&self->boards [i]);
+        }
         free (self->endpoint_broker);
         free (self->name);
         zpoller_destroy (&self->poller);
         free (self->poller2);
+        free (self->pipes_board);
         free (self->pipes);
         free (self->log_file);
         free (self);
@@ -215,6 +311,121 @@ devio_err_e devio_destroy (devio_t **self_p)
     return DEVIO_SUCCESS;
 }
 
+devio_err_e devio_add_board (devio_t *self, char *name, char *endpoint_dev,
+        llio_type_e type)
+{
+    assert (self);
+    assert (name);
+    assert (endpoint_dev);
+
+    devio_err_e err = DEVIO_SUCCESS;
+    ASSERT_TEST(self->nboards < DEVIO_MAX_BOARDS, "Too many boards added",
+            err_max_boards, DEVIO_ERR_INV_PARAM);
+
+    devio_board_t *board = _devio_board_new (self, name, endpoint_dev, type);
+    ASSERT_ALLOC(board, err_board_alloc, DEVIO_ERR_ALLOC);
+
+    if (self->fe_loop != NULL && type == ETH_DEV) {
+        err = devio_fe_loop_add_board (self->fe_loop, board);
+        ASSERT_TEST(err == DEVIO_SUCCESS, "Could not add board to the "
+                "front-end event loop", err_fe_loop_add);
+    }
+
+    self->boards [self->nboards++] = board;
+    return err;
+
+err_fe_loop_add:
+    _devio_board_destroy (&board);
+err_board_alloc:
+err_max_boards:
+    return err;
+}
+
+devio_err_e devio_remove_last_board (devio_t *self)
+{
+    assert (self);
+
+    devio_err_e err = DEVIO_SUCCESS;
+    ASSERT_TEST(self->nboards > 0, "No board to remove", err_no_board,
+            DEVIO_ERR_INV_PARAM);
+
+    devio_board_t *board = self->boards [self->nboards-1];
+
+    /* Its SMIOs first, as they might still need the board to shut down */
+    zlist_t *hash_keys = zhash_keys (self->sm_io_info_h);
+    ASSERT_ALLOC (hash_keys, err_hash_keys_alloc, DEVIO_ERR_ALLOC);
+    char *hash_item = zlist_first (hash_keys);
+
+    for (; hash_item != NULL; hash_item = zlist_next (hash_keys)) {
+        devio_smio_info_t *smio_info = zhash_lookup (self->sm_io_info_h,
+                hash_item);
+        if (smio_info->board != board) {
+            continue;
+        }
+
+        /* Keep going. The board is removed anyway */
+        devio_err_e smio_err = _devio_destroy_smio (self, hash_item);
+        if (smio_err != DEVIO_SUCCESS) {
+            err = smio_err;
+        }
+    }
+
+    zlist_destroy (&hash_keys);
+
+    devio_err_e poller_err = _devio_reset_pollers (self);
+    if (poller_err != DEVIO_SUCCESS) {
+        err = poller_err;
+    }
+
+    if (board->worker != NULL) {
+        mdp_worker_destroy (&board->worker);
+    }
+
+    if (board->fe_ep != NULL) {
+        devio_fe_loop_remove_board (self->fe_loop, board);
+    }
+
+    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io_core] No longer serving "
+            "board %s\n", board->name);
+    _devio_board_destroy (&self->boards [--self->nboards]);
+
+err_hash_keys_alloc:
+err_no_board:
+    return err;
+}
+
+devio_err_e devio_enable_fe_loop (devio_t *self)
+{
+    assert (self);
+
+    devio_err_e err = DEVIO_SUCCESS;
+    if (self->fe_loop != NULL) {
+        goto err_enabled;
+    }
+
+    self->fe_loop = devio_fe_loop_new ();
+    ASSERT_ALLOC(self->fe_loop, err_fe_loop_alloc, DEVIO_ERR_ALLOC);
+
+    uint32_t i;
+    for (i = 0; i < self->nboards; ++i) {
+        if (self->boards [i]->llio->type != ETH_DEV) {
+            continue;
+        }
+
+        err = devio_fe_loop_add_board (self->fe_loop, self->boards [i]);
+        ASSERT_TEST(err == DEVIO_SUCCESS, "Could not add board to the "
+                "front-end event loop", err_fe_loop_add);
+    }
+
+    return err;
+
+err_fe_loop_add:
+    devio_fe_loop_destroy (&self->fe_loop);
+err_fe_loop_alloc:
+err_enabled:
+    return err;
+}
+
 /* Read specific information about the device. Typically,
  * this is stored in the SDB structure inside the device */
 devio_err_e devio_print_info (devio_t *self)
@@ -223,20 +434,79 @@ devio_err_e devio_print_info (devio_t *self)
     return DEVIO_ERR_FUNC_NOT_IMPL;
 }
 
+devio_err_e devio_set_smio_nworkers (devio_t *self, uint32_t nworkers)
+{
+    assert (self);
+
+    devio_err_e err = DEVIO_SUCCESS;
+    ASSERT_TEST(nworkers > 0 && nworkers <= SMIO_MAX_NUM_WORKERS,
+            "Invalid number of SMIO workers", err_inv_nworkers,
+            DEVIO_ERR_INV_PARAM);
+
+    self->smio_nworkers = nworkers;
+
+err_inv_nworkers:
+    return err;
+}
+
+devio_err_e devio_set_smio_config_diff (devio_t *self, bool diff)
+{
+    assert (self);
+
+    self->smio_config_diff = diff;
+    return DEVIO_SUCCESS;
+}
+
+devio_err_e devio_set_smio_cfg (devio_t *self, const char *cfg_file,
+        uint32_t board_id, const char *node)
+{
+    assert (self);
+    assert (cfg_file);
+    assert (node);
+
+    devio_err_e err = DEVIO_SUCCESS;
+    char *new_cfg_file = strdup (cfg_file);
+    ASSERT_ALLOC(new_cfg_file, err_cfg_file_alloc, DEVIO_ERR_ALLOC);
+    char *new_cfg_node = strdup (node);
+    ASSERT_ALLOC(new_cfg_node, err_cfg_node_alloc, DEVIO_ERR_ALLOC);
+
+    devio_board_t *board = self->boards [self->nboards-1];
+    free (board->smio_cfg_file);
+    free (board->smio_cfg_node);
+    board->smio_cfg_file = new_cfg_file;
+    board->smio_cfg_node = new_cfg_node;
+    board->smio_cfg_board_id = board_id;
+
+    return err;
+
+err_cfg_node_alloc:
+    free (new_cfg_file);
+err_cfg_file_alloc:
+    return err;
+}
+
 /* Register an specific sm_io modules to this device */
 devio_err_e devio_register_sm (devio_t *self, uint32_t smio_id, uint32_t base,
         uint32_t inst_id)
 {
     assert (self);
+    return _devio_register_sm (self, self->boards [self->nboards-1], smio_id,
+            base, inst_id, 0);
+}
+
+static devio_err_e _devio_register_sm (devio_t *self, devio_board_t *board,
+        uint32_t smio_id, uint32_t base, uint32_t inst_id, uint64_t reload_ts)
+{
+    assert (self);
+    assert (board);
 
     /* Search the sm_io_mod_dsapatch table for the smio_id and,
      * if found, call the correspondent bootstrap code to initilize
      * the sm_io module */
     th_boot_args_t *th_args = NULL;
-    th_config_args_t *th_config_args = NULL;
-    void *config_pipe = NULL;
+    devio_smio_info_t *smio_info = NULL;
     char *key = NULL;
-    uint32_t pipe_idx = 0;
+    void *pipe = NULL;
 
     DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE,
             "[dev_io_core:register_sm] smio_mod_dispatch table size = %ld\n",
@@ -252,6 +522,13 @@ devio_err_e devio_register_sm (devio_t *self, uint32_t smio_id, uint32_t base,
 
         /* Found! Call bootstrap code and insert in
          * hash table */
+        unsigned int board_nnodes = 0;
+        unsigned int j;
+        for (j = 0; j < self->nnodes; ++j) {
+            board_nnodes += (self->pipes_board [j] == board);
+        }
+        ASSERT_TEST (board_nnodes < NODES_MAX_LEN, "Too many SMIOs registered",
+                err_max_nodes);
 
         /* Stringify ID. We do it before spawning a new thread as
          * alloc can fail */
@@ -259,107 +536,212 @@ devio_err_e devio_register_sm (devio_t *self, uint32_t smio_id, uint32_t base,
                 "[dev_io_core:register_sm] Stringify hash ID\n");
         char *inst_id_str = halutils_stringify_dec_key (inst_id);
         ASSERT_ALLOC(inst_id_str, err_inst_id_str_alloc);
-        char *key = halutils_concat_strings_no_sep (smio_mod_dispatch[i].name,
-                inst_id_str);
+        /* The same SMIO can be found on more than one board, so we
+         * use its whole service name */
+        key = halutils_concat_strings3 (board->name, smio_mod_dispatch[i].name,
+                inst_id_str, ':');
         /* We don't need this anymore */
         free (inst_id_str);
         inst_id_str = NULL;
         ASSERT_ALLOC (key, err_key_alloc);
 
+        /* Keep how we registered it, so we can do it again on reload */
+        smio_info = zmalloc (sizeof *smio_info);
+        ASSERT_ALLOC (smio_info, err_smio_info_alloc);
+        smio_info->board = board;
+        smio_info->smio_id = smio_id;
+        smio_info->base = base;
+        smio_info->inst_id = inst_id;
+
         DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE,
                 "[dev_io_core:register_sm] Allocating thread args\n");
 
         /* Alloacate thread arguments struct and pass it to the
          * thread. It is the responsability of the calling thread
          * to clear this structure after using it! */
-        th_boot_args_t *th_args = zmalloc (sizeof *th_args);
+        th_args = zmalloc (sizeof *th_args);
         ASSERT_ALLOC (th_args, err_th_args_alloc);
         th_args->parent = self;
         /* FIXME: weak identifier */
         th_args->smio_id = i;
         th_args->broker = self->endpoint_broker;
-        th_args->service = self->name;
+        th_args->service = board->name;
         th_args->verbose = self->verbose;
         th_args->base = base;
         th_args->inst_id = inst_id;
+        th_args->nworkers = self->smio_nworkers;
+        th_args->config_mode = (self->smio_config_diff) ?
+            SMIO_CONFIG_MODE_DIFF : SMIO_CONFIG_MODE_ALL;
+        th_args->cfg_file = board->smio_cfg_file;
+        if (board->smio_cfg_file != NULL) {
+            bool path_ok = _devio_smio_cfg_path (board,
+                    DEVIO_SMIO_CFG_PATH_PATTERN, inst_id,
+                    smio_mod_dispatch[i].name, th_args->cfg_path,
+                    sizeof (th_args->cfg_path));
+            path_ok = path_ok && _devio_smio_cfg_path (board,
+                    DEVIO_SMIO_SCHED_PATH_PATTERN, inst_id,
+                    smio_mod_dispatch[i].name, th_args->sched_path,
+                    sizeof (th_args->sched_path));
+
+            if (!path_ok) {
+                th_args->cfg_file = NULL;
+            }
+        }
+        th_args->reload_ts = reload_ts;
 
         DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE,
                 "[dev_io_core:register_sm] Calling boot func\n");
 
-        pipe_idx = self->nnodes++;
-        self->pipes [pipe_idx] = zthread_fork (self->ctx, smio_startup,
-                th_args);
-        ASSERT_TEST (self->pipes [pipe_idx] != NULL, "Could not spawn SMIO thread",
+        pipe = zthread_fork (self->ctx, smio_startup, th_args);
+        ASSERT_TEST (pipe != NULL, "Could not spawn SMIO thread",
                 err_spawn_smio_thread);
+        /* The thread owns its arguments from now on */
+        th_args = NULL;
 
         DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE,
                 "[dev_io_core:register_sm] Inserting hash with key: %s\n", key);
-        int zerr = zhash_insert (self->sm_io_h, key, self->pipes [pipe_idx]);
+        int zerr = zhash_insert (self->sm_io_h, key, pipe);
         /* We must not fail here, as we will loose our reference to the SMIO
          * thread otherwise */
         ASSERT_TEST (zerr == 0, "Could not insert PIPE hash key. Duplicated value?",
                 err_pipe_hash_insert);
 
-        /* Configure default values of the recently created SMIO using the
-         * bootstrap registered function config_defaults () */
+        zerr = zhash_insert (self->sm_io_info_h, key, smio_info);
+        ASSERT_TEST (zerr == 0, "Could not insert SMIO information hash key",
+                err_info_hash_insert);
+        zhash_freefn (self->sm_io_info_h, key, free);
 
-        /* Now, we create a short lived thread just to configure our SMIO */
-        /* Allocate config thread arguments struct and pass it to the
-         * thread. It is the responsability of the calling thread
-         * to clear this structure after using it! */
-        th_config_args = zmalloc (sizeof *th_config_args);
-        ASSERT_ALLOC (th_config_args, err_th_config_args_alloc);
-
-        th_config_args->broker = self->endpoint_broker;
-        /* FIXME: weak identifier */
-        th_config_args->smio_id = i;
-        th_config_args->service = self->name;
-        th_config_args->log_file = self->log_file;
-        th_config_args->inst_id = inst_id;
+        self->pipes_board [self->nnodes] = board;
+        self->pipes [self->nnodes++] = pipe;
 
-        config_pipe = zthread_fork (self->ctx, smio_config_defaults, th_config_args);
-        ASSERT_TEST (config_pipe != NULL, "Could not spawn config thread",
-                err_spawn_config_thread);
+        /* The SMIO configures its own default values, from its
+         * thread, before serving any request */
 
         /* stop on first match */
         break;
     }
 
-    /* On success, just "key"" is not deallocated. All of the other
-     * allocated parameters are either free'd or its ownership
-     * is transfered to the calling function/thread */
+    /* On success, just "key"" is deallocated, as the hash tables keep their
+     * own copies. All of the other allocated parameters are either free'd
+     * or its ownership is transfered to the calling function/thread */
     free (key);
     return DEVIO_SUCCESS;
 
-err_spawn_config_thread:
-    /* FIXME: Destroy SMIO thread as we could configure it? */
-    free (th_config_args);
-err_th_config_args_alloc:
+err_info_hash_insert:
     zhash_delete (self->sm_io_h, key);
 err_pipe_hash_insert:
     /* If we can't insert the SMIO thread key in hash,
      * destroy it as we won't have a reference to it later! */
-    _devio_send_destruct_msg (self, self->pipes [pipe_idx]);
+    _devio_send_destruct_msg (self, pipe);
+    zsocket_destroy (self->ctx, pipe);
 err_spawn_smio_thread:
     free (th_args);
 err_th_args_alloc:
+    free (smio_info);
+err_smio_info_alloc:
     free (key);
 err_key_alloc:
 err_inst_id_str_alloc:
+err_max_nodes:
     return DEVIO_ERR_ALLOC;
 }
 
 /* Register all sm_io module that this device can handle,
  * according to the device information stored in the SDB */
-devio_err_e devio_register_all_sm (devio_t *self)
+devio_err_e devio_register_all_sm (devio_t *self, loff_t sdb_addr,
+        loff_t addr_flags)
 {
-    (void) self;
-    return DEVIO_ERR_FUNC_NOT_IMPL;
+    assert (self);
+
+    devio_err_e err = DEVIO_SUCCESS;
+    char cache_path [DEVIO_SDB_CACHE_PATH_LEN];
+    sdb_tables_t tables;
+    sdb_dev_t *devs = zmalloc (sizeof (*devs) * DEVIO_SDB_MAX_DEVS);
+    ASSERT_ALLOC(devs, err_devs_alloc, DEVIO_ERR_ALLOC);
+
+    devio_board_t *board = self->boards [self->nboards-1];
+    bool use_cache = _devio_sdb_cache_path (board, cache_path,
+            sizeof (cache_path));
+
+    /* The cache remembers where every record table is and how big it is.
+     * Checking them all again takes a single read per table and spares us
+     * the header reads and the parsing of a cold walk */
+    ssize_t num_devs = -1;
+    if (use_cache) {
+        num_devs = _devio_sdb_cache_load (cache_path, &tables, devs,
+                DEVIO_SDB_MAX_DEVS);
+        if (num_devs >= 0 && !sdb_check_tables (board->llio, addr_flags,
+                    &tables)) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io_core:register_all_sm] "
+                    "SDB has changed since %s was cached\n", cache_path);
+            num_devs = -1;
+        }
+    }
+
+    if (num_devs >= 0) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io_core:register_all_sm] "
+                "Using cached SDB topology %s\n", cache_path);
+    }
+    else {
+        /* Cold start. Walk the whole bus */
+        num_devs = sdb_get_devices (board->llio, sdb_addr, addr_flags, devs,
+                DEVIO_SDB_MAX_DEVS, &tables);
+        ASSERT_TEST(num_devs >= 0, "Could not walk SDB tree", err_get_devices,
+                DEVIO_ERR_SDB);
+
+        /* Instance IDs are assigned in address order */
+        qsort (devs, num_devs, sizeof (*devs), _devio_sdb_dev_cmp);
+
+        /* Not being able to cache it only makes the next startup slower */
+        if (use_cache && tables.num_tables <= SDB_MAX_TABLES) {
+            _devio_sdb_cache_save (cache_path, &tables, devs, num_devs);
+        }
+    }
+
+    uint32_t inst_ids [MOD_DISPATCH_END] = {0};
+    ssize_t i;
+    for (i = 0; i < num_devs; ++i) {
+        unsigned int j;
+        for (j = 0; j < ARRAY_SIZE(smio_mod_dispatch); ++j) {
+            if (smio_mod_dispatch[j].sdb_vendor_id == devs [i].vendor_id &&
+                    smio_mod_dispatch[j].id == devs [i].device_id) {
+                break;
+            }
+        }
+
+        if (j == ARRAY_SIZE(smio_mod_dispatch)) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[dev_io_core:register_all_sm] "
+                    "No SMIO for SDB device %s\n", devs [i].name);
+            continue;
+        }
+
+        uint32_t base = addr_flags | (devs [i].addr_first -
+                smio_mod_dispatch[j].sdb_base_offs);
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io_core:register_all_sm] "
+                "Registering SMIO %s%u at 0x%08X\n", smio_mod_dispatch[j].name,
+                inst_ids [j], base);
+
+        err = _devio_register_sm (self, board, smio_mod_dispatch[j].id, base,
+                inst_ids [j], 0);
+        ASSERT_TEST(err == DEVIO_SUCCESS, "Could not register SMIO",
+                err_register_sm);
+        inst_ids [j]++;
+    }
+
+err_register_sm:
+err_get_devices:
+    free (devs);
+err_devs_alloc:
+    return err;
 }
 
 devio_err_e devio_unregister_sm (devio_t *self, const char *smio_key)
 {
-    return _devio_destroy_smio (self, smio_key);
+    devio_err_e err = _devio_destroy_smio (self, smio_key);
+    /* The pipe is gone even if the SMIO did not exit in time */
+    devio_err_e poller_err = _devio_reset_pollers (self);
+
+    return (err != DEVIO_SUCCESS) ? err : poller_err;
 }
 
 devio_err_e devio_unregister_all_sm (devio_t *self)
@@ -367,6 +749,55 @@ devio_err_e devio_unregister_all_sm (devio_t *self)
     return _devio_destroy_smio_all (self);
 }
 
+devio_err_e devio_reload_sm (devio_t *self, const char *smio_key,
+        smio_reload_report_t *report)
+{
+    assert (self);
+    assert (smio_key);
+
+    devio_err_e err = DEVIO_SUCCESS;
+    devio_smio_info_t *smio_info = zhash_lookup (self->sm_io_info_h, smio_key);
+    ASSERT_TEST (smio_info != NULL, "Could not find SMIO registered with this ID",
+            err_info_lookup, DEVIO_ERR_NO_SMIO_ID);
+    /* This is free'd when the SMIO is unregistered */
+    devio_smio_info_t info = *smio_info;
+
+    /* The SMIO is unavailable and the other SMIOs don't get any of their
+     * requests to us answered from now on until we are done */
+    uint64_t start_ts = smio_stats_get_ts ();
+
+    /* The old SMIO must be gone before the new one shows up, or both would
+     * be serving the same service and touching the same hardware */
+    err = _devio_destroy_smio (self, smio_key);
+    uint64_t exit_ts = smio_stats_get_ts ();
+    if (err == DEVIO_SUCCESS) {
+        err = _devio_register_sm (self, info.board, info.smio_id, info.base,
+                info.inst_id, start_ts);
+    }
+    /* The pipes changed, even if the old SMIO did not exit in time or we
+     * could not register it again */
+    devio_err_e poller_err = _devio_reset_pollers (self);
+    ASSERT_TEST (err == DEVIO_SUCCESS, "Could not reload SMIO", err_reload_sm);
+    ASSERT_TEST (poller_err == DEVIO_SUCCESS, "Could not initialize pollers",
+            err_reset_pollers, poller_err);
+
+    uint64_t end_ts = smio_stats_get_ts ();
+    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io_core:reload_sm] SMIO %s "
+            "reloaded. It took %"PRIu64" us to exit and the other SMIOs were "
+            "held for %"PRIu64" us\n", smio_key, exit_ts - start_ts,
+            end_ts - start_ts);
+
+    if (report != NULL) {
+        report->exit_us = exit_ts - start_ts;
+        report->downtime_us = end_ts - start_ts;
+    }
+
+err_reset_pollers:
+err_reload_sm:
+err_info_lookup:
+    return err;
+}
+
 devio_err_e devio_init_poller_sm (devio_t *self)
 {
     devio_err_e err = DEVIO_SUCCESS;
@@ -402,7 +833,8 @@ devio_err_e devio_init_poller2_sm (devio_t *self)
     ASSERT_TEST(self->nnodes > 0, "There are no SMIOs registered!",
             err_no_nodes, DEVIO_ERR_NO_NODES);
 
-    zmq_pollitem_t *items = zmalloc (sizeof (*items) * self->nnodes);
+    /* One more item for the front-end event loop, if any */
+    zmq_pollitem_t *items = zmalloc (sizeof (*items) * (self->nnodes + 1));
     ASSERT_ALLOC(items, err_alloc_items, DEVIO_ERR_ALLOC);
 
     unsigned int i;
@@ -411,6 +843,12 @@ devio_err_e devio_init_poller2_sm (devio_t *self)
         items [i].events = ZMQ_POLLIN;
     }
 
+    if (self->fe_loop != NULL) {
+        items [self->nnodes].socket = NULL;
+        items [self->nnodes].fd = devio_fe_loop_get_fd (self->fe_loop);
+        items [self->nnodes].events = ZMQ_POLLIN;
+    }
+
     /* This should be freed on dev_io exit */
     self->poller2 = items;
 
@@ -438,15 +876,19 @@ devio_err_e devio_poll_all_sm (devio_t *self)
     ASSERT_TEST(!zpoller_terminated (self->poller), "Poller terminated!",
             err_poller_terminated, DEVIO_ERR_TERMINATED);
 
-    zmsg_t *recv_msg = zmsg_recv (which);
+    zmsg_t *recv_msg = msg_pool_msg_recv (which);
     /* Prepare the args structure */
     zmq_server_args_t server_args = {.msg = &recv_msg, .reply_to = which};
-    err = _devio_do_smio_op (self, &server_args);
+    err = _devio_do_smio_op (self, _devio_get_pipe_board (self, which),
+            &server_args);
 
     /* Cleanup */
-    zmsg_destroy (&recv_msg);
+    msg_pool_msg_destroy (&recv_msg);
 
 err_poller_expired:
+    /* The pipes can only change now that we are done with them */
+    _devio_do_mngr_requests (self);
+
 err_poller_terminated:
 err_uninitialized_poller:
     return err;
@@ -459,11 +901,30 @@ devio_err_e devio_poll2_all_sm (devio_t *self)
     ASSERT_TEST(self->poller2, "Unitialized poller!",
             err_uninitialized_poller, DEVIO_ERR_UNINIT_POLLER);
 
+    unsigned int nitems = self->nnodes;
+    unsigned int i;
+    if (self->fe_loop != NULL) {
+        /* SMIOs of a board in the middle of a transfer must wait for it.
+         * Their requests stay queued in the pipes */
+        for (i = 0; i < self->nnodes; ++i) {
+            self->poller2 [i].events = devio_fe_loop_board_busy (self->fe_loop,
+                    self->pipes_board [i]) ? 0 : ZMQ_POLLIN;
+        }
+        ++nitems;
+    }
+
     /* Wait up to 100 ms */
-    int rc = zmq_poll (self->poller2, self->nnodes, DEVIO_POLLER_TIMEOUT);
+    int rc = zmq_poll (self->poller2, nitems, DEVIO_POLLER_TIMEOUT);
     ASSERT_TEST(rc != -1, "devio_poll2_all_sm: poller interrupted", err_poller_interrupted,
             DEVIO_ERR_INTERRUPTED_POLLER);
 
+    /* Endpoints ready for the transfers going on, if any. This also gives
+     * up on the transfers that took too long, so it is done on timeouts
+     * as well */
+    if (self->fe_loop != NULL) {
+        devio_fe_loop_run (self->fe_loop);
+    }
+
     /* Timeout */
     if (rc == 0) {  /* Exit silently */
         /*DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE,
@@ -472,23 +933,32 @@ devio_err_e devio_poll2_all_sm (devio_t *self)
     }
 
     /* Loop once through all the available sockets */
-    unsigned int i;
     for (i = 0; i < self->nnodes; ++i) {
         if (self->poller2 [i].revents & ZMQ_POLLIN) {
-            zmsg_t *recv_msg = zmsg_recv (self->poller2 [i].socket);
+            /* A request from another SMIO of the same board might have
+             * started a transfer in this round */
+            if (self->fe_loop != NULL && devio_fe_loop_board_busy (self->fe_loop,
+                        self->pipes_board [i])) {
+                continue;
+            }
+
+            zmsg_t *recv_msg = msg_pool_msg_recv (self->poller2 [i].socket);
             /* Prepare the args structure */
             zmq_server_args_t server_args = {
                 .tag = ZMQ_SERVER_ARGS_TAG,
                 .msg = &recv_msg,
                 .reply_to = self->poller2 [i].socket};
-            err = _devio_do_smio_op (self, &server_args);
+            err = _devio_do_smio_op (self, self->pipes_board [i], &server_args);
 
             /* Cleanup */
-            zmsg_destroy (&recv_msg);
+            msg_pool_msg_destroy (&recv_msg);
         }
     }
 
 err_poller_expired:
+    /* The pipes can only change now that we are done with them */
+    _devio_do_mngr_requests (self);
+
 err_poller_interrupted:
 err_uninitialized_poller:
     return err;
@@ -496,23 +966,84 @@ err_uninitialized_poller:
 
 devio_err_e devio_do_smio_op (devio_t *self, void *msg)
 {
-    return _devio_do_smio_op (self, msg);
+    zmq_server_args_t *server_args = (zmq_server_args_t *) msg;
+    return _devio_do_smio_op (self, _devio_get_pipe_board (self,
+                server_args->reply_to), msg);
+}
+
+/************************************************************/
+/************** Management exported operations **************/
+/************************************************************/
+
+static int _devio_mngr_reload (void *owner, void *args, void *ret)
+{
+    assert (owner);
+    assert (args);
+    assert (ret);
+
+    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[dev_io_core] Calling _devio_mngr_reload\n");
+    DEVIO_OWNER_TYPE *board = DEVIO_EXP_OWNER(owner);
+    devio_t *self = board->parent;
+
+    /* Message is:
+     * frame 0: operation code
+     * frame 1: service name of the SMIO to be reloaded */
+    char smio_key [SMIO_RELOAD_SERVICE_LEN];
+    memcpy (smio_key, EXP_MSG_ZMQ_FIRST_ARG(args), sizeof (smio_key));
+    smio_key [sizeof (smio_key)-1] = '\0';
+
+    /* Only the SMIOs of the board the request was sent to */
+    devio_smio_info_t *smio_info = zhash_lookup (self->sm_io_info_h, smio_key);
+    if (smio_info == NULL || smio_info->board != board) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_WARN, "[dev_io_core] No SMIO %s to "
+                "reload in %s\n", smio_key, board->name);
+        return -SMIO_RELOAD_NO_SMIO;
+    }
+
+    smio_reload_report_t *report = (smio_reload_report_t *) ret;
+    devio_err_e err = devio_reload_sm (self, smio_key, report);
+    if (err != DEVIO_SUCCESS) {
+        return -SMIO_RELOAD_ERR;
+    }
+
+    return sizeof (*report);
 }
 
 /**************** Helper Functions ***************/
-static devio_err_e _devio_do_smio_op (devio_t *self, void *msg)
+static devio_err_e _devio_do_smio_op (devio_t *self, devio_board_t *board,
+        void *msg)
 {
     assert (self);
     assert (msg);
 
     devio_err_e err = DEVIO_SUCCESS;
+    ASSERT_TEST (board != NULL, "Request from an unknown SMIO", err_no_board,
+            DEVIO_ERR_NO_SMIO_ID);
+
+    /* A SMIO that exited without being told to. There is nobody to reply to */
+    if (_devio_is_exit_msg (*((zmq_server_args_t *) msg)->msg)) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_WARN, "[dev_io_core] SMIO of board %s "
+                "exited unexpectedly\n", board->name);
+        goto exit_msg;
+    }
 
+    /* Block transfers to the Ethernet boards are left to the front-end
+     * event loop. It replies when they are over */
+    if (self->fe_loop != NULL && devio_fe_loop_start (self->fe_loop, board,
+                (zmq_server_args_t *) msg)) {
+        goto fe_loop_op;
+    }
+
+    /* The low-level operations are done on the board of the SMIO */
     disp_table_t *disp_table = self->disp_table_thsafe_ops;
-    msg_err_e merr = msg_handle_sock_request (self, msg, disp_table);
+    msg_err_e merr = msg_handle_sock_request (board, msg, disp_table);
     ASSERT_TEST (merr == MSG_SUCCESS, "Error handling request", err_hand_req,
            SMIO_ERR_MSG_NOT_SUPP /* returning a more meaningful error? */);
 
+fe_loop_op:
+exit_msg:
 err_hand_req:
+err_no_board:
     return err;
 }
 
@@ -580,12 +1111,501 @@ static devio_err_e _devio_destroy_smio (devio_t *self, const char *smio_key)
     ASSERT_TEST (err == DEVIO_SUCCESS, "Could not send self-destruct message to "
             "PIPE", err_send_msg, DEVIO_ERR_SMIO_DESTROY);
 
-    /* Finally, remove the pipe from hash. FIXME: What if the SMIO does not
-     * exit? We will loose its reference ...*/
+    err = _devio_wait_smio_exit (self, pipe, _devio_get_pipe_board (self, pipe));
+    if (err != DEVIO_SUCCESS) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io_core] SMIO %s did not exit "
+                "within %d ms. Dropping it anyway\n", smio_key,
+                DEVIO_SMIO_EXIT_TIMEOUT);
+    }
+
+    /* Finally, remove the pipe from hash */
     zhash_delete (self->sm_io_h, smio_key);
+    zhash_delete (self->sm_io_info_h, smio_key);
+
+    /* And from the pipes array */
+    unsigned int i;
+    for (i = 0; i < self->nnodes && self->pipes [i] != pipe; ++i);
+    if (i < self->nnodes) {
+        memmove (&self->pipes [i], &self->pipes [i+1],
+                (self->nnodes-i-1) * sizeof (*self->pipes));
+        memmove (&self->pipes_board [i], &self->pipes_board [i+1],
+                (self->nnodes-i-1) * sizeof (*self->pipes_board));
+        self->nnodes--;
+    }
+    zsocket_destroy (self->ctx, pipe);
 
 err_send_msg:
 err_hash_lookup:
     return err;
 }
 
+/* Wait for the SMIO on the other end of "pipe" to acknowledge it has exited.
+ * It might still need us to shut down, so its requests are served meanwhile */
+static devio_err_e _devio_wait_smio_exit (devio_t *self, void *pipe,
+        devio_board_t *board)
+{
+    assert (self);
+    assert (pipe);
+
+    devio_err_e err = DEVIO_ERR_SMIO_DESTROY;
+    int64_t deadline = zclock_time () + DEVIO_SMIO_EXIT_TIMEOUT;
+    int64_t now = zclock_time ();
+
+    for (; now < deadline; now = zclock_time ()) {
+        /* As in devio_poll2_all_sm (), a board in the middle of a transfer
+         * can't take requests */
+        bool busy = self->fe_loop != NULL &&
+            devio_fe_loop_board_busy (self->fe_loop, board);
+        zmq_pollitem_t items [] = {
+            {.socket = pipe, .events = busy ? 0 : ZMQ_POLLIN},
+            {.socket = NULL, .events = ZMQ_POLLIN,
+                .fd = (self->fe_loop != NULL) ?
+                    devio_fe_loop_get_fd (self->fe_loop) : -1}
+        };
+        int64_t timeout = deadline - now;
+
+        int rc = zmq_poll (items, (self->fe_loop != NULL) ? 2 : 1,
+                (timeout < DEVIO_POLLER_TIMEOUT) ? timeout : DEVIO_POLLER_TIMEOUT);
+        ASSERT_TEST (rc != -1, "Poller interrupted while waiting for SMIO",
+                err_poller_interrupted);
+
+        if (self->fe_loop != NULL) {
+            devio_fe_loop_run (self->fe_loop);
+        }
+
+        if (!(items [0].revents & ZMQ_POLLIN)) {
+            continue;
+        }
+
+        zmsg_t *recv_msg = msg_pool_msg_recv (pipe);
+        ASSERT_TEST (recv_msg != NULL, "Could not receive message from SMIO",
+                err_msg_recv);
+
+        if (_devio_is_exit_msg (recv_msg)) {
+            msg_pool_msg_destroy (&recv_msg);
+            err = DEVIO_SUCCESS;
+            break;
+        }
+
+        zmq_server_args_t server_args = {
+            .tag = ZMQ_SERVER_ARGS_TAG,
+            .msg = &recv_msg,
+            .reply_to = pipe};
+        _devio_do_smio_op (self, board, &server_args);
+        msg_pool_msg_destroy (&recv_msg);
+    }
+
+err_msg_recv:
+err_poller_interrupted:
+    return err;
+}
+
+/* SMIOs send an empty message when they exit */
+static bool _devio_is_exit_msg (zmsg_t *msg)
+{
+    return msg != NULL && zmsg_size (msg) == 1 &&
+        zframe_size (zmsg_first (msg)) == 0;
+}
+
+/* Start the pollers over with the current pipes, as they can't have
+ * sockets removed */
+static devio_err_e _devio_reset_pollers (devio_t *self)
+{
+    assert (self);
+
+    devio_err_e err = DEVIO_SUCCESS;
+    zpoller_destroy (&self->poller);
+    self->poller = zpoller_new (NULL);
+    ASSERT_ALLOC(self->poller, err_poller_alloc, DEVIO_ERR_ALLOC);
+
+    if (self->nnodes > 0) {
+        err = devio_init_poller_sm (self);
+        ASSERT_TEST(err == DEVIO_SUCCESS, "Could not initialize poller",
+                err_init_poller);
+    }
+
+    /* Only the one in use */
+    if (self->poller2 != NULL) {
+        free (self->poller2);
+        self->poller2 = NULL;
+
+        if (self->nnodes > 0) {
+            err = devio_init_poller2_sm (self);
+            ASSERT_TEST(err == DEVIO_SUCCESS, "Could not initialize poller",
+                    err_init_poller2);
+        }
+    }
+
+err_init_poller2:
+err_init_poller:
+err_poller_alloc:
+    return err;
+}
+
+/* Build the path of a SMIO section of the configuration file. Returns false
+ * if it does not fit in path */
+static bool _devio_smio_cfg_path (devio_board_t *board, const char *pattern,
+        uint32_t inst_id, const char *smio_name, char *path, size_t len)
+{
+    int errs = snprintf (path, len, pattern, board->smio_cfg_board_id,
+            inst_id, board->smio_cfg_node, smio_name);
+    /* Section names are lowercase */
+    unsigned int j;
+    for (j = 0; path [j] != '\0'; ++j) {
+        path [j] = tolower (path [j]);
+    }
+
+    return errs >= 0 && (size_t) errs < len;
+}
+
+/* Serve the management requests to each of the boards, if any. This is
+ * done between poll rounds, as it might change the pipes */
+static void _devio_do_mngr_requests (devio_t *self)
+{
+    assert (self);
+
+    uint32_t i;
+    for (i = 0; i < self->nboards; ++i) {
+        devio_board_t *board = self->boards [i];
+
+        if (board->worker == NULL) {
+            board->worker = mdp_worker_new (self->ctx, self->endpoint_broker,
+                    board->name, self->verbose);
+            ASSERT_ALLOC(board->worker, err_worker_alloc);
+        }
+
+        /* A single request per board and round, so the SMIOs are not held
+         * by a burst of them */
+        zframe_t *reply_to = NULL;
+        zmsg_t *request = mdp_worker_recv (board->worker, &reply_to, true);
+        if (request == NULL) {
+            continue;
+        }
+
+        exp_msg_zmq_t mngr_args = {
+            .tag = EXP_MSG_ZMQ_TAG,
+            .msg = &request,
+            .reply_to = reply_to,
+            .recv_ts = smio_stats_get_ts ()};
+        msg_err_e merr = msg_handle_mdp_mngr_request (board, &mngr_args,
+                self->disp_table_mngr_ops, board->worker);
+        if (merr != MSG_SUCCESS) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io_core] Could not handle "
+                    "management request to %s\n", board->name);
+        }
+
+        msg_pool_frame_destroy (&reply_to);
+        msg_pool_msg_destroy (&request);
+        continue;
+
+err_worker_alloc:
+        /* Try again on the next round */
+        continue;
+    }
+}
+
+/* Build the path of the SDB cache of "board" and make sure its directory
+ * is private to us. Returns false if the cache must not be used */
+static bool _devio_sdb_cache_path (devio_board_t *board, char *path,
+        size_t len)
+{
+    struct stat st;
+
+    if (mkdir (DEVIO_SDB_CACHE_DIR, S_IRWXU) != 0 && errno != EEXIST) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_WARN, "[dev_io_core:sdb_cache] "
+                "Could not create %s: %s\n", DEVIO_SDB_CACHE_DIR,
+                strerror (errno));
+        return false;
+    }
+
+    /* Anyone who can write to the directory could place a cache of their
+     * own there, so it must be a real directory that only we can write */
+    if (lstat (DEVIO_SDB_CACHE_DIR, &st) != 0 || !S_ISDIR(st.st_mode) ||
+            !_devio_sdb_cache_owned (&st)) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_WARN, "[dev_io_core:sdb_cache] "
+                "%s is not a directory private to us. Not using the SDB "
+                "cache\n", DEVIO_SDB_CACHE_DIR);
+        return false;
+    }
+
+    int errs = snprintf (path, len, DEVIO_SDB_CACHE_PATTERN, board->name);
+    if (errs < 0 || (size_t) errs + sizeof (DEVIO_SDB_CACHE_TMP_SUFFIX) > len) {
+        return false;
+    }
+
+    /* Board names are like "BPM0:DEVIO". Keep only safe characters in the
+     * file name */
+    char *name = path + sizeof (DEVIO_SDB_CACHE_DIR);
+    for (; *name != '\0'; ++name) {
+        if (!isalnum ((unsigned char) *name) && *name != '.' && *name != '_') {
+            *name = '_';
+        }
+    }
+
+    return true;
+}
+
+/* Whether a cache file or directory is ours and not writable by others */
+static bool _devio_sdb_cache_owned (const struct stat *st)
+{
+    return st->st_uid == geteuid () &&
+        (st->st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+/* Load a SDB topology cached by _devio_sdb_cache_save (). Returns the
+ * number of devices or a negative value if there is no usable cache.
+ * The record tables it was parsed from are stored in "tables", so the
+ * caller can check them against the hardware */
+static ssize_t _devio_sdb_cache_load (const char *path, sdb_tables_t *tables,
+        sdb_dev_t *devs, size_t max_devs)
+{
+    ssize_t num_devs = -1;
+    zconfig_t *root = NULL;
+    struct stat st;
+
+    /* Don't follow links, as they could point anywhere */
+    int fd = open (path, O_RDONLY | O_NOFOLLOW);
+    if (fd < 0) {
+        goto err_cache_open;
+    }
+
+    if (fstat (fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+            !_devio_sdb_cache_owned (&st)) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_WARN, "[dev_io_core:sdb_cache] "
+                "SDB cache %s has wrong type, owner or mode\n", path);
+        goto err_cache_stat;
+    }
+
+    /* The directory is private, so the file can't be replaced between
+     * the checks above and the load */
+    root = zconfig_load ((char *) path);
+    if (root == NULL) {
+        goto err_cache_load;
+    }
+
+    char *checksum_str = zconfig_resolve (root, "/sdb/checksum", NULL);
+    if (checksum_str == NULL) {
+        goto err_invalid_cache;
+    }
+    tables->checksum = strtoul (checksum_str, NULL, 0);
+    tables->num_tables = 0;
+
+    zconfig_t *sdb_cfg = zconfig_locate (root, "/sdb");
+    zconfig_t *cfg = zconfig_child (sdb_cfg);
+    size_t i = 0;
+    for (; cfg != NULL; cfg = zconfig_next (cfg)) {
+        if (streq (zconfig_name (cfg), "table")) {
+            if (tables->num_tables >= SDB_MAX_TABLES) {
+                goto err_invalid_cache;
+            }
+
+            sdb_table_t *table = &tables->table [tables->num_tables++];
+            table->addr = strtoull (zconfig_resolve (cfg, "addr", "0"),
+                    NULL, 0);
+            table->records = strtoul (zconfig_resolve (cfg, "records", "0"),
+                    NULL, 0);
+            continue;
+        }
+
+        if (!streq (zconfig_name (cfg), "device")) {
+            continue;
+        }
+
+        if (i >= max_devs) {
+            goto err_invalid_cache;
+        }
+
+        devs [i].vendor_id = strtoull (zconfig_resolve (cfg, "vendor_id", "0"),
+                NULL, 0);
+        devs [i].device_id = strtoul (zconfig_resolve (cfg, "device_id", "0"),
+                NULL, 0);
+        devs [i].addr_first = strtoull (zconfig_resolve (cfg, "addr_first", "0"),
+                NULL, 0);
+        devs [i].addr_last = strtoull (zconfig_resolve (cfg, "addr_last", "0"),
+                NULL, 0);
+        snprintf (devs [i].name, sizeof (devs [i].name), "%s",
+                zconfig_resolve (cfg, "name", ""));
+        i++;
+    }
+
+    if (tables->num_tables == 0) {
+        goto err_invalid_cache;
+    }
+
+    num_devs = i;
+
+err_invalid_cache:
+    if (num_devs < 0) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_WARN, "[dev_io_core:sdb_cache] "
+                "Invalid SDB cache %s\n", path);
+    }
+    zconfig_destroy (&root);
+err_cache_load:
+err_cache_stat:
+    close (fd);
+err_cache_open:
+    return num_devs;
+}
+
+static devio_err_e _devio_sdb_cache_save (const char *path,
+        const sdb_tables_t *tables, const sdb_dev_t *devs, size_t num_devs)
+{
+    devio_err_e err = DEVIO_SUCCESS;
+    char tmp_path [DEVIO_SDB_CACHE_PATH_LEN + sizeof (DEVIO_SDB_CACHE_TMP_SUFFIX)];
+    int errs = snprintf (tmp_path, sizeof (tmp_path), "%s"DEVIO_SDB_CACHE_TMP_SUFFIX,
+            path);
+    ASSERT_TEST(errs >= 0 && (size_t) errs < sizeof (tmp_path), "SDB cache "
+            "path is too long", err_tmp_path, DEVIO_ERR_SDB);
+
+    zconfig_t *root = zconfig_new ("root", NULL);
+    ASSERT_ALLOC(root, err_root_alloc, DEVIO_ERR_ALLOC);
+    zconfig_t *sdb_cfg = zconfig_new ("sdb", root);
+    ASSERT_ALLOC(sdb_cfg, err_cfg_alloc, DEVIO_ERR_ALLOC);
+    zconfig_t *cfg = zconfig_new ("checksum", sdb_cfg);
+    ASSERT_ALLOC(cfg, err_cfg_alloc, DEVIO_ERR_ALLOC);
+    zconfig_set_value (cfg, "0x%08X", tables->checksum);
+
+    size_t i;
+    for (i = 0; i < tables->num_tables; ++i) {
+        zconfig_t *table_cfg = zconfig_new ("table", sdb_cfg);
+        ASSERT_ALLOC(table_cfg, err_cfg_alloc, DEVIO_ERR_ALLOC);
+
+        cfg = zconfig_new ("addr", table_cfg);
+        ASSERT_ALLOC(cfg, err_cfg_alloc, DEVIO_ERR_ALLOC);
+        zconfig_set_value (cfg, "0x%016"PRIX64, tables->table [i].addr);
+        cfg = zconfig_new ("records", table_cfg);
+        ASSERT_ALLOC(cfg, err_cfg_alloc, DEVIO_ERR_ALLOC);
+        zconfig_set_value (cfg, "%u", tables->table [i].records);
+    }
+
+    for (i = 0; i < num_devs; ++i) {
+        zconfig_t *dev_cfg = zconfig_new ("device", sdb_cfg);
+        ASSERT_ALLOC(dev_cfg, err_cfg_alloc, DEVIO_ERR_ALLOC);
+
+        cfg = zconfig_new ("vendor_id", dev_cfg);
+        ASSERT_ALLOC(cfg, err_cfg_alloc, DEVIO_ERR_ALLOC);
+        zconfig_set_value (cfg, "0x%016"PRIX64, devs [i].vendor_id);
+        cfg = zconfig_new ("device_id", dev_cfg);
+        ASSERT_ALLOC(cfg, err_cfg_alloc, DEVIO_ERR_ALLOC);
+        zconfig_set_value (cfg, "0x%08X", devs [i].device_id);
+        cfg = zconfig_new ("addr_first", dev_cfg);
+        ASSERT_ALLOC(cfg, err_cfg_alloc, DEVIO_ERR_ALLOC);
+        zconfig_set_value (cfg, "0x%016"PRIX64, devs [i].addr_first);
+        cfg = zconfig_new ("addr_last", dev_cfg);
+        ASSERT_ALLOC(cfg, err_cfg_alloc, DEVIO_ERR_ALLOC);
+        zconfig_set_value (cfg, "0x%016"PRIX64, devs [i].addr_last);
+        cfg = zconfig_new ("name", dev_cfg);
+        ASSERT_ALLOC(cfg, err_cfg_alloc, DEVIO_ERR_ALLOC);
+        zconfig_set_value (cfg, "%s", devs [i].name);
+    }
+
+    /* Write it aside and rename it over the old one, so a reader never
+     * sees a partial cache */
+    unlink (tmp_path);
+    int zerr = zconfig_save (root, tmp_path);
+    ASSERT_TEST(zerr == 0, "Could not save SDB cache", err_cfg_save,
+            DEVIO_ERR_SDB);
+
+    zerr = chmod (tmp_path, S_IRUSR | S_IWUSR);
+    ASSERT_TEST(zerr == 0, "Could not set SDB cache mode", err_cfg_rename,
+            DEVIO_ERR_SDB);
+    zerr = rename (tmp_path, path);
+    ASSERT_TEST(zerr == 0, "Could not rename SDB cache", err_cfg_rename,
+            DEVIO_ERR_SDB);
+
+    zconfig_destroy (&root);
+    return err;
+
+err_cfg_rename:
+    unlink (tmp_path);
+err_cfg_save:
+err_cfg_alloc:
+    zconfig_destroy (&root);
+err_root_alloc:
+err_tmp_path:
+    return err;
+}
+
+static int _devio_sdb_dev_cmp (const void *a, const void *b)
+{
+    const sdb_dev_t *dev_a = (const sdb_dev_t *) a;
+    const sdb_dev_t *dev_b = (const sdb_dev_t *) b;
+
+    return (dev_a->addr_first > dev_b->addr_first) -
+        (dev_a->addr_first < dev_b->addr_first);
+}
+
+static devio_board_t *_devio_board_new (devio_t *parent, char *name,
+        char *endpoint_dev, llio_type_e type)
+{
+    devio_board_t *board = (devio_board_t *) zmalloc (sizeof *board);
+    ASSERT_ALLOC(board, err_board_alloc);
+
+    board->parent = parent;
+
+    board->name = strdup (name);
+    ASSERT_ALLOC(board->name, err_name_alloc);
+
+    /* Concatenate recv'ed name with a llio identifier */
+    char *llio_name = zmalloc (sizeof (char)*(strlen(name)+strlen(LLIO_STR)+1));
+    ASSERT_ALLOC(llio_name, err_llio_name_alloc);
+    strcat (llio_name, name);
+    strcat (llio_name, LLIO_STR);
+    board->llio = llio_new (llio_name, endpoint_dev, type,
+            parent->verbose);
+    ASSERT_ALLOC(board->llio, err_llio_alloc);
+
+    /* We try to open the device */
+    int err = llio_open (board->llio, NULL);
+    ASSERT_TEST(err==0, "Error opening device!", err_llio_open);
+
+    /* We can free llio_name now, as llio copies the string */
+    free (llio_name);
+    llio_name = NULL; /* Avoid double free error */
+
+    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io_core] Serving board %s, "
+            "located on %s\n", name, endpoint_dev);
+
+    return board;
+
+err_llio_open:
+    llio_destroy (&board->llio);
+err_llio_alloc:
+    free (llio_name);
+err_llio_name_alloc:
+    free (board->name);
+err_name_alloc:
+    free (board);
+err_board_alloc:
+    return NULL;
+}
+
+static void _devio_board_destroy (devio_board_t **board_p)
+{
+    assert (board_p);
+
+    if (*board_p) {
+        devio_board_t *board = *board_p;
+
+        llio_release (board->llio, NULL);
+        llio_destroy (&board->llio);
+        free (board->smio_cfg_node);
+        free (board->smio_cfg_file);
+        free (board->name);
+        free (board);
+        *board_p = NULL;
+    }
+}
+
+/* Find the board of the SMIO on the other end of "pipe" */
+static devio_board_t *_devio_get_pipe_board (devio_t *self, void *pipe)
+{
+    unsigned int i;
+    for (i = 0; i < self->nnodes; ++i) {
+        if (self->pipes [i] == pipe) {
+            return self->pipes_board [i];
+        }
+    }
+
+    return NULL;
+}
@@ -15,6 +15,7 @@
 #include "dispatch_table.h"
 #include "dev_io_err.h"
 #include "ll_io.h"
+#include "sm_io_reload_codes.h"
 /* #include "sm_io.h" */
 
 /* #include "sm_io_thsafe_codes.h" */
@@ -22,13 +23,38 @@
 
 /* SMIO hash key length in chars */
 #define SMIO_HKEY_LEN                   8
+/* Maximum number of SMIOs of each board */
 #define NODES_MAX_LEN                   20
+/* Maximum number of boards served by a single DEVIO */
+#define DEVIO_MAX_BOARDS                8
+
+/* A device served by a DEVIO, with its own set of SMIOs */
+struct _devio_board_t {
+    struct _devio_t *parent;            /* DEVIO serving this board */
+    char *name;                         /* Service name prefix of the board
+                                           SMIOs, e.g., BPM0:DEVIO */
+    /* ll_io instance for Low-Level operations*/
+    llio_t *llio;
+    char *smio_cfg_file;                /* Configuration file with the SMIO
+                                           default values. NULL if none */
+    uint32_t smio_cfg_board_id;         /* Board section of smio_cfg_file */
+    char *smio_cfg_node;                /* DEVIO type section of smio_cfg_file
+                                           ("dbe" or "afe") */
+    /* Endpoint state in the front-end event loop. NULL if the board is
+     * served synchronously */
+    struct _devio_fe_ep_t *fe_ep;
+    /* Management requests (e.g., SMIO reloads) to this board, under its
+     * service name. Created on the first poll round, when all of the SMIOs
+     * are already registered */
+    mdp_worker_t *worker;
+};
 
 struct _devio_t {
     /* General information */
     /*mdp_worker_t *worker;*/           /* zeroMQ Majordomo Worker */
     zctx_t *ctx;                        /* zeroMQ Context */
     void **pipes;                       /* Address nodes using this array of pipes */
+    struct _devio_board_t **pipes_board; /* Board of each of the pipes */
     zpoller_t *poller;                  /* Poller structure to multiplex threads messages */
     zmq_pollitem_t *poller2;            /* Poller structure to multiplex threads messages. New version */
     unsigned int nnodes;                /* Number of actual nodes */
@@ -36,9 +62,18 @@ struct _devio_t {
     char *log_file;                     /* Log filename for tracing and debugging */
     char *endpoint_broker;              /* Broker location to connect to */
     int verbose;                        /* Print activity to stdout */
+    uint32_t smio_nworkers;             /* Number of MDP workers spawned for
+                                           each SMIO */
+    bool smio_config_diff;              /* Only write the SMIO default values
+                                           that differ from the hardware */
 
-    /* ll_io instance for Low-Level operations*/
-    llio_t *llio;
+    /* Boards served by this DEVIO. SMIOs are registered to the last one
+     * added */
+    struct _devio_board_t *boards [DEVIO_MAX_BOARDS];
+    uint32_t nboards;
+    /* Event loop serving the block transfers of the Ethernet boards
+     * without blocking. NULL if not enabled */
+    struct _devio_fe_loop_t *fe_loop;
     /* Server part of the llio operations. This is the bridge between the
      * smio client part of the llio operations and the de-facto
      * llio operations */
@@ -47,10 +82,16 @@ struct _devio_t {
      * this dev_io can handle. It is composed
      * of key (10-char ID) / value (sm_io instance) */
     zhash_t *sm_io_h;
+    /* How each of the sm_io objects was registered, so it can be
+     * registered again. Same keys as sm_io_h */
+    zhash_t *sm_io_info_h;
     /* Dispatch table containg all the sm_io thsafe operations
      * that we need to handle. It is composed
      * of key (4-char ID) / value (pointer to funtion) */
     disp_table_t *disp_table_thsafe_ops;
+    /* Dispatch table with the management operations, requested through
+     * the worker of each board */
+    disp_table_t *disp_table_mngr_ops;
 };
 
 struct _smio_thsafe_server_ops_t {
@@ -76,6 +117,8 @@ struct _smio_thsafe_server_ops_t {
 
 /* Opaque llio_th_safe_ops structure */
 typedef struct _smio_thsafe_server_ops_t smio_thsafe_server_ops_t;
+/* Opaque board structure */
+typedef struct _devio_board_t devio_board_t;
 /* Opaque class structure */
 typedef struct _devio_t devio_t;
 
@@ -87,22 +130,56 @@ devio_t * devio_new (char *name, char *endpoint_dev,
         const char *log_file_name);
 /* Destroy an instance of the Device Information */
 devio_err_e devio_destroy (devio_t **self_p);
+/* Add another device to be served by this DEVIO instance. Its SMIOs are
+ * exported with the "name" prefix. The SMIOs registered from now on belong
+ * to this device */
+devio_err_e devio_add_board (devio_t *self, char *name, char *endpoint_dev,
+        llio_type_e type);
+/* Stop serving the last board added, unregistering all of its SMIOs. Used
+ * to give up on a board that could not be set up, without disturbing the
+ * others */
+devio_err_e devio_remove_last_board (devio_t *self);
+/* Serve the block transfers of the Ethernet boards (e.g., RFFEs) from a single
+ * event loop with non-blocking sockets, so a slow endpoint does not hold up
+ * the others. It applies to the boards already added and to the ones added
+ * from now on. Call it before devio_init_poller2_sm () */
+devio_err_e devio_enable_fe_loop (devio_t *self);
 
 /* Read specific information about the device. Typically,
  * this is stored in the SDB structure inside the device */
 devio_err_e devio_print_info (devio_t *self);
-/* Register an specific sm_io module to this device */
+/* Set the number of MDP workers serving each SMIO registered from now on */
+devio_err_e devio_set_smio_nworkers (devio_t *self, uint32_t nworkers);
+/* Set if the SMIOs registered from now on should only write the default
+ * values that differ from the ones already in the hardware. Used when
+ * restarting over a running machine */
+devio_err_e devio_set_smio_config_diff (devio_t *self, bool diff);
+/* Set the configuration file with the default values of the SMIOs of the
+ * last board added. They are looked up in the section
+ * /dev_io/board<board_id>/bpm<smio_inst_id>/<node>/defaults/<smio_name> */
+devio_err_e devio_set_smio_cfg (devio_t *self, const char *cfg_file,
+        uint32_t board_id, const char *node);
+/* Register an specific sm_io module to the last board added */
 devio_err_e devio_register_sm (devio_t *self, uint32_t smio_id, uint32_t base,
         uint32_t inst_id);
-/* Register all sm_io module that this device can handle,
- * according to the device information stored in the SDB */
-devio_err_e devio_register_all_sm (devio_t *self);
+/* Register all sm_io module that the last board added can handle,
+ * according to the device information stored in its SDB */
+devio_err_e devio_register_all_sm (devio_t *self, loff_t sdb_addr,
+        loff_t addr_flags);
 devio_err_e devio_unregister_sm (devio_t *self, const char *smio_key);
 devio_err_e devio_unregister_all_sm (devio_t *self);
+/* Destroy a sm_io module and register it again, with the same parameters.
+ * The other sm_io modules keep serving their clients. This must not be called
+ * while handling a sm_io message. How long it took is stored in "report",
+ * if not NULL. Clients request it through the smio_reload management
+ * operation */
+devio_err_e devio_reload_sm (devio_t *self, const char *smio_key,
+        smio_reload_report_t *report);
 /* Initilize poller with all of the initialized PIPE sockets */
 devio_err_e devio_init_poller_sm (devio_t *self);
 devio_err_e devio_init_poller2_sm (devio_t *self);
-/* Poll all PIPE sockets */
+/* Poll all PIPE sockets and serve the management requests. devio_poll2_all_sm ()
+ * also runs the front-end event loop, if enabled */
 devio_err_e devio_poll_all_sm (devio_t *self);
 devio_err_e devio_poll2_all_sm (devio_t *self);
 /* Router for all the opcodes registered for this dev_io */
@@ -23,7 +23,10 @@ static const char *devio_err [DEVIO_ERR_END] =
     [DEVIO_ERR_INTERRUPTED_POLLER]      = "Poller interrupted. zeroMQ context was terminated or received interrupt signal",
     [DEVIO_ERR_BAD_MSG]                 = "Malformed message received",
     [DEVIO_ERR_TERMINATED]              = "Terminated devio instance",
-    [DEVIO_ERR_SMIO_DESTROY]            = "Could not destroy sm_io instance"
+    [DEVIO_ERR_SMIO_DESTROY]            = "Could not destroy sm_io instance",
+    [DEVIO_ERR_INV_PARAM]               = "Invalid parameter value",
+    [DEVIO_ERR_SDB]                     = "Could not read or parse the SDB",
+    [DEVIO_ERR_FE_LOOP]                 = "Error in the front-end event loop"
 };
 
 /* Convert enumeration type to string */
@@ -25,6 +25,9 @@ enum _devio_err_e
     DEVIO_ERR_BAD_MSG,              /* Malformed message received */
     DEVIO_ERR_TERMINATED,           /* Terminated devio instance */
     DEVIO_ERR_SMIO_DESTROY,         /* Could not destroy sm_io instance */
+    DEVIO_ERR_INV_PARAM,            /* Invalid parameter value */
+    DEVIO_ERR_SDB,                  /* Could not read or parse the SDB */
+    DEVIO_ERR_FE_LOOP,              /* Error in the front-end event loop */
     DEVIO_ERR_END                   /* End of enum marker */
 };
 
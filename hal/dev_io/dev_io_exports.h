@@ -10,7 +10,9 @@
 
 #include "smio_thsafe_zmq_server.h"
 
-#define DEVIO_OWNER_TYPE                        devio_t
-#define DEVIO_EXP_OWNER(owner)                  ((devio_t *) owner)
+/* The low-level operations are served on behalf of the board of the
+ * requesting SMIO */
+#define DEVIO_OWNER_TYPE                        devio_board_t
+#define DEVIO_EXP_OWNER(owner)                  ((devio_board_t *) owner)
 
 #endif
@@ -0,0 +1,557 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+
+#include "dev_io_fe_loop.h"
+#include "dev_io_err.h"
+#include "hal_assert.h"
+#include "msg.h"
+#include "sm_io_thsafe_codes.h"
+#include "ll_io_eth.h"
+
+/* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
+#ifdef ASSERT_TEST
+#undef ASSERT_TEST
+#endif
+#define ASSERT_TEST(test_boolean, err_str, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_TEST(test_boolean, DEV_IO, "[dev_io_fe_loop]",       \
+            err_str, err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef ASSERT_ALLOC
+#undef ASSERT_ALLOC
+#endif
+#define ASSERT_ALLOC(ptr, err_goto_label, /* err_core */ ...)       \
+    ASSERT_HAL_ALLOC(ptr, DEV_IO, "[dev_io_fe_loop]",               \
+            devio_err_str(DEVIO_ERR_ALLOC),                         \
+            err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef CHECK_ERR
+#undef CHECK_ERR
+#endif
+#define CHECK_ERR(err, err_type)                                    \
+    CHECK_HAL_ERR(err, DEV_IO, "[dev_io_fe_loop]",                  \
+            devio_err_str (err_type))
+
+/* Events handled at each call to devio_fe_loop_run () */
+#define DEVIO_FE_LOOP_MAX_EVENTS        DEVIO_MAX_BOARDS
+
+enum _devio_fe_ep_state_e {
+    DEVIO_FE_EP_IDLE = 0,               /* No transfer going on */
+    DEVIO_FE_EP_SEND,                   /* Sending a write block */
+    DEVIO_FE_EP_RECV,                   /* Receiving a read block */
+    DEVIO_FE_EP_BROKEN                  /* Endpoint failed. Transfers fail
+                                           right away */
+};
+
+typedef enum _devio_fe_ep_state_e devio_fe_ep_state_e;
+
+struct _devio_fe_ep_t {
+    devio_board_t *board;               /* Board of this endpoint */
+    int fd;                             /* Socket in the epoll set, or -1 */
+    devio_fe_ep_state_e state;          /* Current state */
+    void *reply_to;                     /* Pipe of the SMIO waiting for the
+                                           current transfer */
+    zframe_t *send_frm;                 /* Data of the current write block */
+    uint8_t *recv_buf;                  /* Data of the read blocks */
+    uint8_t *buf;                       /* Data being transferred */
+    size_t len;                         /* Bytes to transfer */
+    size_t done;                        /* Bytes transferred so far */
+    uint64_t deadline_ms;               /* Give up on the transfer after this */
+    uint64_t reopen_ms;                 /* Try to reconnect a broken endpoint
+                                           after this */
+    uint32_t reopen_delay_ms;           /* Backoff of the next reconnection */
+};
+
+typedef struct _devio_fe_ep_t devio_fe_ep_t;
+
+struct _devio_fe_loop_t {
+    int epfd;                           /* epoll set of all endpoints */
+    devio_fe_ep_t *eps [DEVIO_MAX_BOARDS]; /* Our endpoints */
+    uint32_t neps;                      /* Number of endpoints */
+};
+
+static devio_err_e _devio_fe_ep_sync_fd (devio_fe_loop_t *self,
+        devio_fe_ep_t *ep);
+static void _devio_fe_ep_advance (devio_fe_loop_t *self, devio_fe_ep_t *ep);
+static void _devio_fe_ep_arm (devio_fe_loop_t *self, devio_fe_ep_t *ep,
+        uint32_t events);
+static void _devio_fe_ep_finish (devio_fe_loop_t *self, devio_fe_ep_t *ep,
+        ssize_t xfer_ret);
+static void _devio_fe_ep_break (devio_fe_loop_t *self, devio_fe_ep_t *ep);
+static void _devio_fe_ep_reopen (devio_fe_loop_t *self, devio_fe_ep_t *ep);
+static void _devio_fe_reply (void *reply_to, uint32_t opcode, ssize_t xfer_ret,
+        uint8_t *data);
+static uint64_t _devio_fe_get_ts_ms (void);
+
+/************ Our methods implementation **********/
+
+devio_fe_loop_t * devio_fe_loop_new (void)
+{
+    devio_fe_loop_t *self = (devio_fe_loop_t *) zmalloc (sizeof *self);
+    ASSERT_ALLOC(self, err_self_alloc);
+
+    self->epfd = epoll_create1 (EPOLL_CLOEXEC);
+    ASSERT_TEST(self->epfd != -1, "Could not create epoll set", err_epoll_create);
+
+    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io_fe_loop] Created front-end "
+            "event loop\n");
+    return self;
+
+err_epoll_create:
+    free (self);
+err_self_alloc:
+    return NULL;
+}
+
+devio_err_e devio_fe_loop_destroy (devio_fe_loop_t **self_p)
+{
+    assert (self_p);
+
+    if (*self_p) {
+        devio_fe_loop_t *self = *self_p;
+
+        uint32_t i;
+        for (i = 0; i < self->neps; ++i) {
+            devio_fe_ep_t *ep = self->eps [i];
+
+            /* Nobody will be waiting for the transfers anymore */
+            msg_pool_frame_destroy (&ep->send_frm);
+            free (ep->recv_buf);
+            ep->board->fe_ep = NULL;
+            free (ep);
+        }
+
+        close (self->epfd);
+        free (self);
+        *self_p = NULL;
+    }
+
+    return DEVIO_SUCCESS;
+}
+
+devio_err_e devio_fe_loop_add_board (devio_fe_loop_t *self, devio_board_t *board)
+{
+    assert (self);
+    assert (board);
+
+    devio_err_e err = DEVIO_SUCCESS;
+    ASSERT_TEST(board->llio->type == ETH_DEV, "Only Ethernet boards can be "
+            "served by the front-end event loop", err_inv_board,
+            DEVIO_ERR_INV_PARAM);
+    ASSERT_TEST(self->neps < DEVIO_MAX_BOARDS, "Too many boards in the "
+            "front-end event loop", err_inv_board, DEVIO_ERR_INV_PARAM);
+
+    devio_fe_ep_t *ep = (devio_fe_ep_t *) zmalloc (sizeof *ep);
+    ASSERT_ALLOC(ep, err_ep_alloc, DEVIO_ERR_ALLOC);
+
+    ep->recv_buf = zmalloc (sizeof (zmq_server_data_block_t));
+    ASSERT_ALLOC(ep->recv_buf, err_recv_buf_alloc, DEVIO_ERR_ALLOC);
+
+    ep->board = board;
+    ep->fd = -1;
+    ep->state = DEVIO_FE_EP_IDLE;
+    ep->reopen_delay_ms = DEVIO_FE_LOOP_REOPEN_MIN;
+
+    err = _devio_fe_ep_sync_fd (self, ep);
+    ASSERT_TEST(err == DEVIO_SUCCESS, "Could not add board endpoint to the "
+            "epoll set", err_sync_fd);
+
+    board->fe_ep = ep;
+    self->eps [self->neps++] = ep;
+
+    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io_fe_loop] Board %s served "
+            "by the front-end event loop\n", board->name);
+    return err;
+
+err_sync_fd:
+    free (ep->recv_buf);
+err_recv_buf_alloc:
+    free (ep);
+err_ep_alloc:
+err_inv_board:
+    return err;
+}
+
+devio_err_e devio_fe_loop_remove_board (devio_fe_loop_t *self,
+        devio_board_t *board)
+{
+    assert (self);
+    assert (board);
+
+    devio_err_e err = DEVIO_SUCCESS;
+    uint32_t i;
+    for (i = 0; i < self->neps && self->eps [i] != board->fe_ep; ++i);
+    ASSERT_TEST(i < self->neps, "Board is not served by the front-end event "
+            "loop", err_no_ep, DEVIO_ERR_INV_PARAM);
+
+    devio_fe_ep_t *ep = self->eps [i];
+    if (ep->fd != -1) {
+        epoll_ctl (self->epfd, EPOLL_CTL_DEL, ep->fd, NULL);
+    }
+
+    /* The SMIOs of the board are gone, so nobody is waiting for the
+     * transfers anymore */
+    msg_pool_frame_destroy (&ep->send_frm);
+    free (ep->recv_buf);
+    free (ep);
+    board->fe_ep = NULL;
+
+    memmove (&self->eps [i], &self->eps [i+1],
+            (self->neps-i-1) * sizeof (*self->eps));
+    self->neps--;
+
+    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io_fe_loop] Board %s no longer "
+            "served by the front-end event loop\n", board->name);
+
+err_no_ep:
+    return err;
+}
+
+int devio_fe_loop_get_fd (devio_fe_loop_t *self)
+{
+    assert (self);
+    return self->epfd;
+}
+
+bool devio_fe_loop_board_busy (devio_fe_loop_t *self, devio_board_t *board)
+{
+    (void) self;
+    assert (board);
+
+    devio_fe_ep_t *ep = board->fe_ep;
+    return ep != NULL && (ep->state == DEVIO_FE_EP_SEND ||
+            ep->state == DEVIO_FE_EP_RECV);
+}
+
+bool devio_fe_loop_start (devio_fe_loop_t *self, devio_board_t *board,
+        zmq_server_args_t *args)
+{
+    assert (self);
+    assert (board);
+    assert (args);
+
+    devio_fe_ep_t *ep = board->fe_ep;
+    if (ep == NULL) {
+        return false;
+    }
+
+    /* Peek at the opcode. Anything but the block transfers is handled as
+     * usual */
+    zframe_t *opcode_frm = THSAFE_MSG_ZMQ_PEEK_FIRST(args);
+    if (opcode_frm == NULL || zframe_size (opcode_frm) != MSG_OPCODE_SIZE) {
+        return false;
+    }
+
+    uint32_t opcode = *(uint32_t *) zframe_data (opcode_frm);
+    if (opcode != THSAFE_OPCODE_READ_BLOCK && opcode != THSAFE_OPCODE_WRITE_BLOCK) {
+        return false;
+    }
+
+    /* Message is:
+     * frame 0: opcode
+     * frame 1: offset (ignored by Ethernet devices)
+     * frame 2: size to read or data to write */
+    zframe_t *offset_frm = THSAFE_MSG_ZMQ_PEEK_NEXT_ARG(args);
+    zframe_t *data_frm = THSAFE_MSG_ZMQ_PEEK_NEXT_ARG(args);
+    if (offset_frm == NULL || data_frm == NULL) {
+        return false;
+    }
+
+    /* Only one transfer at a time. The DEVIO poller should not even have
+     * read this request */
+    if (devio_fe_loop_board_busy (self, board)) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io_fe_loop] Endpoint of "
+                "board %s is busy\n", board->name);
+        _devio_fe_reply (args->reply_to, opcode, -1, NULL);
+        return true;
+    }
+
+    /* The endpoint might have been reopened since the last transfer */
+    devio_err_e err = _devio_fe_ep_sync_fd (self, ep);
+    if (err != DEVIO_SUCCESS || ep->fd == -1 || ep->state == DEVIO_FE_EP_BROKEN) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io_fe_loop] Endpoint of "
+                "board %s is not available\n", board->name);
+        _devio_fe_reply (args->reply_to, opcode, -1, NULL);
+        return true;
+    }
+
+    ep->reply_to = args->reply_to;
+    ep->done = 0;
+    ep->deadline_ms = _devio_fe_get_ts_ms () + DEVIO_FE_LOOP_XFER_TIMEOUT;
+
+    if (opcode == THSAFE_OPCODE_WRITE_BLOCK) {
+        /* We keep the data frame until it is all sent */
+        zmsg_remove (THSAFE_MSG_ZMQ(args), data_frm);
+        ep->send_frm = data_frm;
+        ep->buf = zframe_data (data_frm);
+        ep->len = zframe_size (data_frm);
+        ep->state = DEVIO_FE_EP_SEND;
+    }
+    else {
+        /* We skip the dispatch table, so check the argument ourselves */
+        if (zframe_size (data_frm) != sizeof (size_t)) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io_fe_loop] Read block "
+                    "size argument has %zu bytes\n", zframe_size (data_frm));
+            _devio_fe_reply (args->reply_to, opcode, -1, NULL);
+            return true;
+        }
+
+        size_t read_bsize = *(size_t *) zframe_data (data_frm);
+        if (read_bsize > sizeof (zmq_server_data_block_t)) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io_fe_loop] Read block "
+                    "of %zu bytes is too big\n", read_bsize);
+            _devio_fe_reply (args->reply_to, opcode, -1, NULL);
+            return true;
+        }
+
+        ep->buf = ep->recv_buf;
+        ep->len = read_bsize;
+        ep->state = DEVIO_FE_EP_RECV;
+    }
+
+    /* Most of the time, the transfer is over right away */
+    _devio_fe_ep_advance (self, ep);
+    return true;
+}
+
+devio_err_e devio_fe_loop_run (devio_fe_loop_t *self)
+{
+    assert (self);
+
+    devio_err_e err = DEVIO_SUCCESS;
+    struct epoll_event events [DEVIO_FE_LOOP_MAX_EVENTS];
+
+    /* Only what is ready now. The DEVIO poller did the waiting */
+    int nevents = epoll_wait (self->epfd, events, DEVIO_FE_LOOP_MAX_EVENTS, 0);
+    ASSERT_TEST(nevents != -1 || errno == EINTR, "Could not wait for the "
+            "endpoints", err_epoll_wait, DEVIO_ERR_FE_LOOP);
+
+    int i;
+    for (i = 0; i < nevents; ++i) {
+        devio_fe_ep_t *ep = (devio_fe_ep_t *) events [i].data.ptr;
+
+        switch (ep->state) {
+            case DEVIO_FE_EP_SEND:
+            case DEVIO_FE_EP_RECV:
+                /* Errors are found out by the transfer itself */
+                _devio_fe_ep_advance (self, ep);
+                break;
+
+            default:
+                /* Nothing was asked of an idle endpoint, so this can only
+                 * be a hang up or an error */
+                DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io_fe_loop] Idle "
+                        "endpoint of board %s failed\n", ep->board->name);
+                _devio_fe_ep_break (self, ep);
+                break;
+        }
+    }
+
+    /* Don't let the SMIOs wait forever on a silent endpoint */
+    uint64_t now_ms = _devio_fe_get_ts_ms ();
+    uint32_t j;
+    for (j = 0; j < self->neps; ++j) {
+        devio_fe_ep_t *ep = self->eps [j];
+
+        if (devio_fe_loop_board_busy (self, ep->board) && now_ms > ep->deadline_ms) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io_fe_loop] Transfer "
+                    "to board %s timed out after %zu of %zu bytes\n",
+                    ep->board->name, ep->done, ep->len);
+            _devio_fe_ep_finish (self, ep, -1);
+        }
+
+        if (ep->state == DEVIO_FE_EP_BROKEN && now_ms >= ep->reopen_ms) {
+            _devio_fe_ep_reopen (self, ep);
+        }
+    }
+
+err_epoll_wait:
+    return err;
+}
+
+/**************** Helper Functions ***************/
+
+/* Keep the epoll set in sync with the socket of the board llio */
+static devio_err_e _devio_fe_ep_sync_fd (devio_fe_loop_t *self,
+        devio_fe_ep_t *ep)
+{
+    devio_err_e err = DEVIO_SUCCESS;
+    int fd = llio_eth_get_fd (ep->board->llio);
+
+    if (fd == ep->fd) {
+        goto no_change;
+    }
+
+    /* A closed socket leaves the epoll set by itself */
+    ep->fd = -1;
+    ep->state = DEVIO_FE_EP_IDLE;
+    if (fd == -1) {
+        goto no_socket;
+    }
+
+    llio_err_e llio_err = llio_eth_set_nonblock (ep->board->llio, true);
+    ASSERT_TEST(llio_err == LLIO_SUCCESS, "Could not set the endpoint socket "
+            "to non-blocking", err_nonblock, DEVIO_ERR_FE_LOOP);
+
+    /* Only errors and hang ups until there is a transfer */
+    struct epoll_event event = {.events = 0, .data.ptr = ep};
+    int rc = epoll_ctl (self->epfd, EPOLL_CTL_ADD, fd, &event);
+    ASSERT_TEST(rc == 0, "Could not add socket to the epoll set",
+            err_epoll_add, DEVIO_ERR_FE_LOOP);
+
+    ep->fd = fd;
+
+err_epoll_add:
+err_nonblock:
+no_socket:
+no_change:
+    return err;
+}
+
+/* Transfer what can be done now. Wait for the endpoint to be ready for the
+ * rest, if any */
+static void _devio_fe_ep_advance (devio_fe_loop_t *self, devio_fe_ep_t *ep)
+{
+    while (ep->done < ep->len) {
+        ssize_t n = (ep->state == DEVIO_FE_EP_SEND) ?
+            llio_eth_send_nb (ep->board->llio, ep->buf + ep->done,
+                    ep->len - ep->done) :
+            llio_eth_recv_nb (ep->board->llio, ep->buf + ep->done,
+                    ep->len - ep->done);
+
+        if (n == -1) {
+            DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io_fe_loop] Transfer "
+                    "to board %s failed after %zu of %zu bytes\n",
+                    ep->board->name, ep->done, ep->len);
+            _devio_fe_ep_finish (self, ep, -1);
+            return;
+        }
+
+        /* Not ready. Come back when it is */
+        if (n == 0) {
+            _devio_fe_ep_arm (self, ep, (ep->state == DEVIO_FE_EP_SEND) ?
+                    EPOLLOUT : EPOLLIN);
+            return;
+        }
+
+        ep->done += n;
+    }
+
+    _devio_fe_ep_finish (self, ep, ep->done);
+}
+
+static void _devio_fe_ep_arm (devio_fe_loop_t *self, devio_fe_ep_t *ep,
+        uint32_t events)
+{
+    struct epoll_event event = {.events = events, .data.ptr = ep};
+    int rc = epoll_ctl (self->epfd, EPOLL_CTL_MOD, ep->fd, &event);
+
+    if (rc != 0) {
+        DBE_DEBUG (DBG_DEV_IO | DBG_LVL_ERR, "[dev_io_fe_loop] Could not "
+                "wait for the endpoint of board %s\n", ep->board->name);
+        _devio_fe_ep_finish (self, ep, -1);
+    }
+}
+
+/* Reply to the SMIO and get ready for the next transfer */
+static void _devio_fe_ep_finish (devio_fe_loop_t *self, devio_fe_ep_t *ep,
+        ssize_t xfer_ret)
+{
+    uint32_t opcode = (ep->state == DEVIO_FE_EP_SEND) ?
+        THSAFE_OPCODE_WRITE_BLOCK : THSAFE_OPCODE_READ_BLOCK;
+    _devio_fe_reply (ep->reply_to, opcode, xfer_ret, ep->buf);
+
+    msg_pool_frame_destroy (&ep->send_frm);
+    ep->reply_to = NULL;
+    ep->buf = NULL;
+    ep->len = 0;
+    ep->done = 0;
+
+    /* A partial transfer leaves the byte stream out of sync. Don't
+     * pretend otherwise */
+    if (xfer_ret < 0) {
+        _devio_fe_ep_break (self, ep);
+        return;
+    }
+
+    ep->state = DEVIO_FE_EP_IDLE;
+    ep->reopen_delay_ms = DEVIO_FE_LOOP_REOPEN_MIN;
+    /* Back to errors and hang ups only */
+    struct epoll_event event = {.events = 0, .data.ptr = ep};
+    int rc = epoll_ctl (self->epfd, EPOLL_CTL_MOD, ep->fd, &event);
+    if (rc != 0) {
+        _devio_fe_ep_break (self, ep);
+    }
+}
+
+static void _devio_fe_ep_break (devio_fe_loop_t *self, devio_fe_ep_t *ep)
+{
+    if (ep->fd != -1) {
+        epoll_ctl (self->epfd, EPOLL_CTL_DEL, ep->fd, NULL);
+    }
+
+    ep->state = DEVIO_FE_EP_BROKEN;
+    ep->reopen_ms = _devio_fe_get_ts_ms () + ep->reopen_delay_ms;
+
+    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_WARN, "[dev_io_fe_loop] Reconnecting "
+            "endpoint of board %s in %u ms\n", ep->board->name,
+            ep->reopen_delay_ms);
+
+    ep->reopen_delay_ms *= 2;
+    if (ep->reopen_delay_ms > DEVIO_FE_LOOP_REOPEN_MAX) {
+        ep->reopen_delay_ms = DEVIO_FE_LOOP_REOPEN_MAX;
+    }
+}
+
+/* Connect a broken endpoint again and get it back to IDLE. The backoff is
+ * only reset by a successful transfer, so an endpoint that keeps failing
+ * right after reconnecting is not retried too often */
+static void _devio_fe_ep_reopen (devio_fe_loop_t *self, devio_fe_ep_t *ep)
+{
+    llio_err_e llio_err = llio_eth_reconnect (ep->board->llio);
+    if (llio_err != LLIO_SUCCESS) {
+        _devio_fe_ep_break (self, ep);
+        return;
+    }
+
+    /* The old socket left the epoll set when it broke. The new one might
+     * even have got the same number */
+    ep->fd = -1;
+    devio_err_e err = _devio_fe_ep_sync_fd (self, ep);
+    if (err != DEVIO_SUCCESS || ep->fd == -1) {
+        _devio_fe_ep_break (self, ep);
+        return;
+    }
+
+    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_INFO, "[dev_io_fe_loop] Endpoint of "
+            "board %s is back\n", ep->board->name);
+}
+
+/* Same replies the thsafe server would have sent */
+static void _devio_fe_reply (void *reply_to, uint32_t opcode, ssize_t xfer_ret,
+        uint8_t *data)
+{
+    if (opcode == THSAFE_OPCODE_WRITE_BLOCK) {
+        int32_t ret = xfer_ret;
+        msg_send_sock_reply (reply_to, sizeof (ret), &ret);
+    }
+    else {
+        msg_send_sock_reply (reply_to, xfer_ret, data);
+    }
+}
+
+static uint64_t _devio_fe_get_ts_ms (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec*1000 + ts.tv_nsec/1000000;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _DEV_IO_FE_LOOP_H_
+#define _DEV_IO_FE_LOOP_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "dev_io_core.h"
+#include "thsafe_msg_zmq.h"
+
+/* Longest time a block transfer can wait for its endpoint, in msec */
+#define DEVIO_FE_LOOP_XFER_TIMEOUT      1000
+/* Time to wait before reconnecting a failed endpoint, in msec. It doubles
+ * with each failed attempt, up to the maximum */
+#define DEVIO_FE_LOOP_REOPEN_MIN        1000
+#define DEVIO_FE_LOOP_REOPEN_MAX        32000
+
+/* Front-end event loop. It serves the block transfers of the Ethernet
+ * boards (e.g., RFFEs) of a DEVIO with non-blocking sockets, all of them
+ * multiplexed by a single epoll set. A transfer that can't complete right
+ * away is left to the loop and the DEVIO goes on serving the other boards.
+ * Each endpoint has a small state machine:
+ *
+ *  IDLE --(write block)--> SEND --(all sent)--> IDLE
+ *  IDLE --(read block)---> RECV --(all received)--> IDLE
+ *  SEND/RECV --(error, disconnection or timeout)--> BROKEN
+ *  BROKEN --(reconnected, after a backoff)--> IDLE
+ *
+ * The SMIO that requested the transfer gets its reply when it is over */
+struct _devio_fe_loop_t;
+
+typedef struct _devio_fe_loop_t devio_fe_loop_t;
+
+/***************** Our methods *****************/
+
+devio_fe_loop_t * devio_fe_loop_new (void);
+devio_err_e devio_fe_loop_destroy (devio_fe_loop_t **self_p);
+
+/* Serve the block transfers of an Ethernet board from the loop */
+devio_err_e devio_fe_loop_add_board (devio_fe_loop_t *self, devio_board_t *board);
+/* Stop serving the board. Its SMIOs must be gone already */
+devio_err_e devio_fe_loop_remove_board (devio_fe_loop_t *self,
+        devio_board_t *board);
+/* File descriptor to poll for the loop events */
+int devio_fe_loop_get_fd (devio_fe_loop_t *self);
+/* Whether the board is in the middle of a transfer. Its SMIOs must wait
+ * for it to be over */
+bool devio_fe_loop_board_busy (devio_fe_loop_t *self, devio_board_t *board);
+/* Take over the request if it is a block transfer to one of our boards.
+ * Returns false if the request must be handled as usual */
+bool devio_fe_loop_start (devio_fe_loop_t *self, devio_board_t *board,
+        zmq_server_args_t *args);
+/* Advance the transfers whose endpoints are ready and give up on the ones
+ * that took too long */
+devio_err_e devio_fe_loop_run (devio_fe_loop_t *self);
+
+#endif
@@ -20,6 +20,7 @@
 #include "dev_mngr.h"
 #include "debug_print.h"
 #include "hal_varg.h"
+#include "hal_sched.h"
 
 #define DFLT_BIND_FOLDER            "/tmp/bpm"
 #define DFLT_BIND_ADDR              "0"
@@ -27,6 +28,10 @@
 
 #define DFLT_LOG_DIR                "stdout"
 
+/* Longest time between device scans, in msec. Changes in the device
+ * directory wake us up earlier */
+#define DMNGR_SCAN_PERIOD           1000
+
 #ifdef __CFG_DIR__
 #define CFG_DIR                     STRINGIFY(__CFG_DIR__)
 #else
@@ -78,7 +83,7 @@ int dmngr_wait_chld_f (void)
                 WTERMSIG(chld_status));
     }
 
-    return 0;
+    return chld_pid;
 }
 
 int dmngr_spawn_chld_f (const char *program, char *const argv[])
@@ -97,13 +102,54 @@ int dmngr_spawn_chld_f (const char *program, char *const argv[])
 
         if (err < 0) {
             perror ("[dev_mngr] execl");
-            return -1;
+            /* Don't go on as a copy of dev_mngr */
+            _exit (EXIT_FAILURE);
         }
     }
     else { /* Parent */
     }
 
-    return 0; /* Success */
+    return child; /* Success */
+}
+
+/* Same as dmngr_spawn_chld_f (), but with the broker scheduling options
+ * applied to the child before exec, so the broker starts already placed */
+int dmngr_spawn_broker_f (const char *program, char *const argv[])
+{
+    pid_t child = fork ();
+
+    if (child == -1) {
+        perror ("[dev_mngr] fork");
+        return -1;
+    }
+    else if (child == 0) { /* Child */
+        /* CPU affinity and scheduling policy survive exec */
+        halutils_err_e sched_err = halutils_sched_apply (0, &dmngr_broker_sched);
+        if (sched_err != HALUTILS_SUCCESS) {
+            DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_WARN, "[dev_mngr] Could not apply "
+                    "the broker scheduling options: %s\n",
+                    halutils_err_str (sched_err));
+        }
+
+        char placement [HALUTILS_SCHED_STR_LEN];
+        if (halutils_sched_placement_str (0, placement, sizeof (placement)) ==
+                HALUTILS_SUCCESS) {
+            DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_INFO, "[dev_mngr] Broker PID %d "
+                    "placement: %s\n", getpid (), placement);
+        }
+
+        int err = execv (program, argv);
+
+        if (err < 0) {
+            perror ("[dev_mngr] execl");
+            /* Don't go on as a copy of dev_mngr */
+            _exit (EXIT_FAILURE);
+        }
+    }
+    else { /* Parent */
+    }
+
+    return child; /* Success */
 }
 
 void print_help (char *program_name)
@@ -229,6 +275,48 @@ int main (int argc, char *argv[])
     DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_INFO,
             "[dev_mngr] Daemonize set to \"%d\"\n", dmngr_daemonize);
 
+    /* Read the directory to look for devices in. Optional */
+    dmngr_dev_dir = zconfig_resolve (root_cfg, "/dev_mngr/dev_dir", NULL);
+    if (dmngr_dev_dir == NULL) {
+        dmngr_dev_dir = DMNGR_DFLT_DEV_DIR;
+    }
+
+    DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_INFO,
+            "[dev_mngr] Device directory set to \"%s\"\n", dmngr_dev_dir);
+
+    /* Read the number of devices served by each DEVIO. Optional */
+    char *dmngr_devio_boards_str = zconfig_resolve (root_cfg,
+            "/dev_mngr/devio_boards", NULL);
+    if (dmngr_devio_boards_str != NULL) {
+        dmngr_devio_boards = strtoul (dmngr_devio_boards_str, NULL, 10);
+        if (dmngr_devio_boards == 0 ||
+                dmngr_devio_boards > DMNGR_DEVIO_MAX_BOARDS) {
+            DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_FATAL, "[dev_mngr] Invalid option "
+                    "for devio_boards configuration variable. It must be "
+                    "between 1 and %u\n", DMNGR_DEVIO_MAX_BOARDS);
+            goto err_cfg_exit;
+        }
+    }
+
+    DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_INFO,
+            "[dev_mngr] Devices per DEVIO set to \"%u\"\n", dmngr_devio_boards);
+
+    /* Read the broker scheduling options, if any */
+    halutils_err_e sched_err = halutils_sched_cfg_load (root_cfg,
+            "/dev_mngr/broker/sched", &dmngr_broker_sched);
+    if (sched_err != HALUTILS_SUCCESS) {
+        DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_FATAL, "[dev_mngr] Invalid broker "
+                "scheduling options in configuration file\n");
+        goto err_cfg_exit;
+    }
+
+    /* Locked memory does not survive exec */
+    if (dmngr_broker_sched.mlock) {
+        DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_WARN, "[dev_mngr] mlock is not "
+                "supported for the broker. Ignoring it\n");
+        dmngr_broker_sched.mlock = false;
+    }
+
     /* Read DEVIO suggested bind endpoints and fill the hash table with
      * the corresponding keys */
     dmngr_err_e err = dmngr_get_hints (root_cfg, dmngr_hints);
@@ -278,7 +366,7 @@ int main (int argc, char *argv[])
     /* See the fake promiscuous endpoint tcp*:*. To be changed soon! */
     DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_TRACE, "[dev_mngr] Creating DEV_MNGR instance ...\n");
     dmngr_t *dmngr = dmngr_new ("dev_mngr", "tcp://*:*", dmngr_verbose, dmngr_log_dir,
-            dmngr_hints);
+            dmngr_hints, dmngr_dev_dir);
     if (dmngr == NULL) {
         DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_FATAL, "[dev_mngr] Fail to allocate dev_mngr instance\n");
         goto err_dmngr_alloc;
@@ -307,6 +395,7 @@ int main (int argc, char *argv[])
 
     dmngr_set_wait_clhd_handler (dmngr, &dmngr_wait_chld_f);
     dmngr_set_spawn_clhd_handler (dmngr, &dmngr_spawn_chld_f);
+    dmngr_set_spawn_broker_handler (dmngr, &dmngr_spawn_broker_f);
 
     err = dmngr_register_sig_handlers (dmngr);
     if (err != DMNGR_SUCCESS) {
@@ -314,11 +403,17 @@ int main (int argc, char *argv[])
         goto err_sig_handlers;
     }
 
-    /* Here we should monitor the plug of new devices, such as
-     * PCIe devices, by means of a udev event (or some other) and
-     * Ethernet ones, by using a discovery protocol based on zeroMQ
+    /* PCIe devices are found by watching the device directory. Ethernet
+     * ones should be found by using a discovery protocol based on zeroMQ
      * (zbeacon should provide a sufficient infrastructure for that)
      */
+    err = dmngr_watch_devs (dmngr);
+    if (err != DMNGR_SUCCESS) {
+        DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_WARN, "[dev_mngr] Could not watch "
+                "the device directory. Scanning it every %u ms\n",
+                DMNGR_SCAN_PERIOD);
+    }
+
     DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_TRACE, "[dev_mngr] DEV_MNGR PID: %d\n", getpid());
     DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_TRACE, "[dev_mngr] Monitoring devices ...\n");
 
@@ -334,6 +429,14 @@ int main (int argc, char *argv[])
             goto err_spawn_broker;
         }
 
+        /* Check the status of child processes. The ones that exited are
+         * respawned below */
+        err = dmngr_wait_chld (dmngr);
+        if (err != DMNGR_SUCCESS) {
+            DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_FATAL, "[dev_mngr] Could not wait for children!\n");
+            goto err_wait_chld;
+        }
+
         /* Search for new devices */
         err = dmngr_scan_devs (dmngr, NULL);
         if (err != DMNGR_SUCCESS) {
@@ -342,33 +445,29 @@ int main (int argc, char *argv[])
         }
 
         /* Spawn all found Device IOs that are ready to run */
-        bool respawn_killed_devio = false;
+        bool respawn_killed_devio = true;
         err = dmngr_spawn_all_devios (dmngr, dmngr_broker_endp,
-                dmngr_log_dir, respawn_killed_devio);
+                dmngr_log_dir, respawn_killed_devio, dmngr_devio_boards);
         if (err != DMNGR_SUCCESS) {
             DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_FATAL, "[dev_mngr] Could not spawn DEVIOs!\n");
             goto err_spawn_devios;
         }
 
-        /* Check the status of child processes */
-        /* DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_TRACE,
-         * "[dev_mngr] PID: %d will wait for child. # = %d\n", getpid(),  __dev_nums); */
-        err = dmngr_wait_chld (dmngr);
+        /* Wait for devices to show up, or for a DEVIO restart to be due */
+        err = dmngr_wait_devs (dmngr, DMNGR_SCAN_PERIOD);
         if (err != DMNGR_SUCCESS) {
-            DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_FATAL, "[dev_mngr] Could not wait for children!\n");
-            goto err_wait_chld;
+            DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_FATAL, "[dev_mngr] Could not wait for devices!\n");
+            goto err_wait_devs;
         }
-
-        /* Do some monitoring activities */
-        sleep(1);
     }
 
     DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_FATAL, "[dev_mngr] Monitoring loop interrupted!\n");
 
-err_wait_chld:
+err_wait_devs:
 err_spawn_devios:
 err_scan_devs:
 err_spawn_broker:
+err_wait_chld:
 err_sig_handlers:
     dmngr_destroy (&dmngr);
 err_dmngr_alloc:
@@ -7,6 +7,12 @@
 
 #include <string.h>
 #include <glob.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <inttypes.h>
+#include <sys/inotify.h>
 
 #include "dev_mngr_core.h"
 #include "hal_assert.h"
@@ -42,8 +48,21 @@
 
 #define DEVIO_DEV_NAME_LEN          40
 
-#define DEVIO_BE_DEV_PATTERN        "/dev/fpga%d"
-#define DEVIO_BE_DEV_GLOB           "/dev/fpga*"
+#define DEVIO_BE_DEV_PREFIX         "fpga"
+#define DEVIO_BE_DEV_PATTERN        DEVIO_BE_DEV_PREFIX "%u"
+#define DEVIO_BE_DEV_GLOB_PATTERN   "%s/" DEVIO_BE_DEV_PREFIX "*"
+#define DEVIO_BE_DEV_GLOB_LEN       256
+
+/* Enough for a few inotify events at once */
+#define DMNGR_WATCH_BUF_LEN         4096
+
+/* Restart backoff of the DEVIOs. The delay doubles each time the DEVIO
+ * dies again, up to DMNGR_RESTART_BACKOFF_MAX. A DEVIO that ran for
+ * DMNGR_RESTART_STABLE starts over from DMNGR_RESTART_BACKOFF_MIN. All in
+ * msec */
+#define DMNGR_RESTART_BACKOFF_MIN   500
+#define DMNGR_RESTART_BACKOFF_MAX   30000
+#define DMNGR_RESTART_STABLE        60000
 
 /******************* Configuration file property names ************************/
 
@@ -59,6 +78,7 @@
 #define DMNGR_CFG_BOARD_PATTERN     "board%u"
 #define DMNGR_CFG_BPM_TYPE          "%s"
 #define DMNGR_CFG_BPM_PATTERN       "bpm%u"
+#define DMNGR_CFG_BPM_PREFIX        "bpm"
 #define DMNGR_CFG_DEVIO_MODEL_TYPE  "%s"
 #define DMNGR_CFG_AFE               "afe"
 #define DMNGR_CFG_DBE               "dbe"
@@ -77,6 +97,8 @@
 #define DEVIO_MAX_FE_DEVIOS         16
 
 #define DEVIO_NAME                  "dev_io"
+/* Comma-separated lists of the devices served by a DEVIO */
+#define DEVIO_LIST_LEN              512
 
 /* FPGA DEVIO */
 #define DEVIO_BE_TYPE               BE_DEVIO
@@ -106,16 +128,26 @@ char *dmngr_verbose_str = NULL;
 int dmngr_verbose = 0;
 char *dmngr_daemonize_str = NULL;
 int dmngr_daemonize = 0;
+uint32_t dmngr_devio_boards = 1;
+char *dmngr_dev_dir = NULL;
+halutils_sched_cfg_t dmngr_broker_sched = {0};
 
 static void _devio_hash_free_item (void *data);
 static dmngr_err_e _dmngr_scan_devs (dmngr_t *self, uint32_t *num_devs_found);
 static dmngr_err_e _dmngr_prepare_devio (dmngr_t *self, const char *key,
         char *dev_pathname, uint32_t id, llio_type_e type,
         devio_type_e devio_type, uint32_t smio_inst_id, devio_state_e state);
+static dmngr_err_e _dmngr_spawn_devio (dmngr_t *self, char *broker_endp,
+        char *devio_log_prefix, devio_info_t **group, uint32_t ngroup);
+static bool _dmngr_list_append (char *list, size_t size, const char *fmt, ...);
+static void _dmngr_chld_exited (dmngr_t *self, pid_t chld_pid);
+static void _dmngr_devio_killed (devio_info_t *devio_info, int64_t now,
+        bool shared);
+static void _dmngr_drain_watch (dmngr_t *self);
 
 /* Creates a new instance of the Device Manager */
 dmngr_t * dmngr_new (char *name, char *endpoint, int verbose,
-        const char *log_prefix, zhash_t *hints_h)
+        const char *log_prefix, zhash_t *hints_h, const char *dev_dir)
 {
     assert (name);
     assert (endpoint);
@@ -167,7 +199,13 @@ dmngr_t * dmngr_new (char *name, char *endpoint, int verbose,
     self->hints_h = zhash_dup (hints_h);
     ASSERT_ALLOC(self->hints_h, err_hints_h_alloc);
 
+    self->dev_dir = strdup ((dev_dir != NULL) ? dev_dir : DMNGR_DFLT_DEV_DIR);
+    ASSERT_ALLOC(self->dev_dir, err_dev_dir_alloc);
+    /* Not watching anything until dmngr_watch_devs () */
+    self->watch_fd = -1;
+
     self->broker_running = false;
+    self->broker_pid = 0;
 
     /* Scan devios for the first time */
     uint32_t num_devs_found = 0;
@@ -182,6 +220,9 @@ dmngr_t * dmngr_new (char *name, char *endpoint, int verbose,
     return self;
 
 err_scan_devs:
+    free (self->dev_dir);
+err_dev_dir_alloc:
+    zhash_destroy (&self->hints_h);
 err_hints_h_alloc:
         zhash_destroy (&self->devio_info_h);
 err_devio_info_h_alloc:
@@ -211,6 +252,10 @@ dmngr_err_e dmngr_destroy (dmngr_t **self_p)
         dmngr_t *self = *self_p;
 
         /* Starting destructing by the last resource */
+        if (self->watch_fd >= 0) {
+            close (self->watch_fd);
+        }
+        free (self->dev_dir);
         zhash_destroy (&self->hints_h);
         zhash_destroy (&self->devio_info_h);
         zlist_destroy (&self->ops->sig_ops);
@@ -281,12 +326,20 @@ dmngr_err_e dmngr_set_wait_clhd_handler (dmngr_t *self, wait_chld_handler_fp fp)
     return DMNGR_SUCCESS;
 }
 
-static dmngr_err_e _dmngr_wait_chld (dmngr_t *self)
-    DMNGR_FUNC_WRAPPER(dmngr_wait_chld, DMNGR_ERR_WAITCHLD)
-
 dmngr_err_e dmngr_wait_chld (dmngr_t *self)
 {
-    return _dmngr_wait_chld (self);
+    assert (self);
+    CHECK_ERR(((self->ops->dmngr_wait_chld == NULL) ? -1 : 0),
+        DMNGR_ERR_FUNC_NOT_IMPL);
+
+    /* Reap all of the children that exited since the last time */
+    int chld_pid;
+    while ((chld_pid = self->ops->dmngr_wait_chld ()) > 0) {
+        _dmngr_chld_exited (self, (pid_t) chld_pid);
+    }
+    CHECK_ERR (chld_pid, DMNGR_ERR_WAITCHLD);
+
+    return DMNGR_SUCCESS;
 }
 
 dmngr_err_e dmngr_set_spawn_clhd_handler (dmngr_t *self, spawn_chld_handler_fp fp)
@@ -307,6 +360,14 @@ dmngr_err_e dmngr_spawn_chld (dmngr_t *self, const char *program,
     return _dmngr_spawn_chld (self, program, argv);
 }
 
+dmngr_err_e dmngr_set_spawn_broker_handler (dmngr_t *self, spawn_broker_handler_fp fp)
+{
+    assert (self);
+    self->ops->dmngr_spawn_broker = fp;
+
+    return DMNGR_SUCCESS;
+}
+
 dmngr_err_e dmngr_set_ops (dmngr_t *self, dmngr_ops_t *dmngr_ops)
 {
     assert (self);
@@ -348,13 +409,18 @@ dmngr_err_e dmngr_spawn_broker (dmngr_t *self, char *broker_endp)
     /* Specify if broker is to be run in verbose mode or not */
     char *argv_exec[] = {"mdp_broker", broker_endp, NULL};
     /* char *argv_exec[] = {"mdp_broker", "-v", NULL}; */
-    int spawn_err = _dmngr_spawn_chld (self, "mdp_broker", argv_exec);
+    spawn_broker_handler_fp spawn_broker = (self->ops->dmngr_spawn_broker != NULL) ?
+        self->ops->dmngr_spawn_broker : self->ops->dmngr_spawn_chld;
+    ASSERT_TEST(spawn_broker != NULL, "No spawn handler registered",
+            err_spawn_broker, DMNGR_ERR_FUNC_NOT_IMPL);
+    int chld_pid = spawn_broker ("mdp_broker", argv_exec);
 
     /* Just fail miserably, for now */
-    ASSERT_TEST(spawn_err >= 0, "Could not spawn broker",
+    ASSERT_TEST(chld_pid > 0, "Could not spawn broker",
             err_spawn_broker, DMNGR_ERR_SPAWNCHLD);
 
     self->broker_running = true;
+    self->broker_pid = (pid_t) chld_pid;
 
 err_spawn_broker:
 err_broker_run:
@@ -366,14 +432,87 @@ dmngr_err_e dmngr_scan_devs (dmngr_t *self, uint32_t *num_devs_found)
     return _dmngr_scan_devs (self, num_devs_found);
 }
 
+dmngr_err_e dmngr_watch_devs (dmngr_t *self)
+{
+    assert (self);
+
+    dmngr_err_e err = DMNGR_SUCCESS;
+
+    int watch_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+    ASSERT_TEST(watch_fd >= 0, "Could not create inotify instance",
+            err_inotify, DMNGR_ERR_WATCH);
+
+    /* udev creates the node and only then sets its permissions, so we
+     * look for both */
+    int wd = inotify_add_watch (watch_fd, self->dev_dir, IN_CREATE |
+            IN_ATTRIB | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM);
+    ASSERT_TEST(wd >= 0, "Could not watch the device directory",
+            err_add_watch, DMNGR_ERR_WATCH);
+
+    DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_INFO, "[dev_mngr_core] Watching %s "
+            "for devices\n", self->dev_dir);
+
+    self->watch_fd = watch_fd;
+    return err;
+
+err_add_watch:
+    close (watch_fd);
+err_inotify:
+    return err;
+}
+
+dmngr_err_e dmngr_wait_devs (dmngr_t *self, int timeout_ms)
+{
+    assert (self);
+
+    dmngr_err_e err = DMNGR_SUCCESS;
+
+    /* Don't sleep past the next DEVIO restart */
+    zlist_t *devio_info_key_list = zhash_keys (self->devio_info_h);
+    ASSERT_ALLOC (devio_info_key_list, err_hash_keys_alloc, DMNGR_ERR_ALLOC);
+
+    int64_t now = zclock_time ();
+    char *devio_info_key = zlist_first (devio_info_key_list);
+    for (; devio_info_key != NULL; devio_info_key = zlist_next (devio_info_key_list)) {
+        devio_info_t *devio_info = zhash_lookup (self->devio_info_h,
+                devio_info_key);
+
+        if (devio_info->state == KILLED &&
+                devio_info->restart_at - now < timeout_ms) {
+            timeout_ms = (devio_info->restart_at > now) ?
+                (int) (devio_info->restart_at - now) : 0;
+        }
+    }
+
+    zlist_destroy (&devio_info_key_list);
+
+    /* Without a watch, this is just a sleep */
+    struct pollfd pfd = {.fd = self->watch_fd, .events = POLLIN};
+    int rc = poll (&pfd, (self->watch_fd >= 0) ? 1 : 0, timeout_ms);
+    /* Interrupted by a signal. Let the caller check for it */
+    if (rc < 0 && errno == EINTR) {
+        goto err_interrupted;
+    }
+    ASSERT_TEST(rc >= 0, "Could not wait for device events",
+            err_poll, DMNGR_ERR_WATCH);
+
+    if (rc > 0) {
+        _dmngr_drain_watch (self);
+    }
+
+err_poll:
+err_interrupted:
+err_hash_keys_alloc:
+    return err;
+}
+
 dmngr_err_e dmngr_spawn_all_devios (dmngr_t *self, char *broker_endp,
-        char *devio_log_prefix, bool respawn_killed_devio)
+        char *devio_log_prefix, bool respawn_killed_devio, uint32_t max_boards)
 {
+    assert (self);
+    assert (max_boards > 0 && max_boards <= DMNGR_DEVIO_MAX_BOARDS);
+
     dmngr_err_e err = DMNGR_SUCCESS;
-    char *dev_type_c = NULL;
-    char *devio_type_c = NULL;
-    char *dev_id_c = NULL;
-    char *smio_inst_id_c = NULL;
 
     /* DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_TRACE, "[dev_mngr_core] Spawing all DEVIO workers\n");*/
 
@@ -381,9 +520,16 @@ dmngr_err_e dmngr_spawn_all_devios (dmngr_t *self, char *broker_endp,
     zlist_t *devio_info_key_list = zhash_keys (self->devio_info_h);
     ASSERT_ALLOC (devio_info_key_list, err_hash_keys_alloc, DMNGR_ERR_ALLOC);
 
+    /* DEVIOs to be spawned */
+    devio_info_t **pending = zmalloc (sizeof (*pending) *
+            (zlist_size (devio_info_key_list) + 1));
+    ASSERT_ALLOC (pending, err_pending_alloc, DMNGR_ERR_ALLOC);
+    uint32_t npending = 0;
+
+    int64_t now = zclock_time ();
     char *devio_info_key = zlist_first (devio_info_key_list);
 
-    /* Iterate over all keys spawning the DEVIOs */
+    /* Iterate over all keys looking for the DEVIOs to spawn */
     for (; devio_info_key != NULL; devio_info_key = zlist_next (devio_info_key_list)) {
         /* FIXME: Usage of stroul function for reconverting the string
          * into a uint32_t */
@@ -409,63 +555,62 @@ dmngr_err_e dmngr_spawn_all_devios (dmngr_t *self, char *broker_endp,
             continue;
         }
 
-        /* Get DEVIO type to set-up correct log filename */
-        devio_type_c = devio_type_to_str (devio_info->devio_type);
-        ASSERT_ALLOC (devio_type_c, err_devio_type_c_alloc, DMNGR_ERR_ALLOC);
+        /* Still backing off from the last failure */
+        if (devio_info->state == KILLED && now < devio_info->restart_at) {
+            continue;
+        }
+
+        /* The device is gone (e.g., the board was removed). Wait for
+         * dmngr_scan_devs () to find it again */
+        if (devio_info->type == PCIE_DEV &&
+                access (devio_info->dev_pathname, F_OK) != 0) {
+            DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_WARN, "[dev_mngr_core] Device "
+                    "%s is gone. Waiting for it to come back\n",
+                    devio_info->dev_pathname);
+            devio_info->state = INACTIVE;
+            /* Whatever comes back has to be configured from scratch */
+            devio_info->configured = false;
+            devio_info->alone = false;
+            continue;
+        }
 
-        /* Set up logdir. Defaulting it to stdout */
-        char devio_log_filename[LOG_FILENAME_LEN] = "stdout";
+        pending [npending++] = devio_info;
+    }
 
-        /* TODO: Check for the validity of the log filename */
-        if (devio_log_prefix != NULL) {
-            snprintf (devio_log_filename, LOG_FILENAME_LEN,
-                    "%s/"DEVIO_LOG_FILENAME_PATTERN, devio_log_prefix,
-                    devio_info->id, devio_type_c, devio_info->smio_inst_id);
+    /* Devices of the same type share a DEVIO, up to max_boards of them.
+     * The ones that already failed in a shared DEVIO get one of their own */
+    uint32_t i;
+    for (i = 0; i < npending; ++i) {
+        if (pending [i] == NULL) {
+            continue;
         }
 
-        /* Alloc and convert types */
-        dev_type_c = llio_type_to_str (devio_info->type);
-        ASSERT_ALLOC (dev_type_c, err_dev_type_c_alloc, DMNGR_ERR_ALLOC);
-        dev_id_c = halutils_stringify_dec_key (devio_info->id);
-        ASSERT_ALLOC (dev_id_c, err_dev_id_c_alloc, DMNGR_ERR_ALLOC);
-        smio_inst_id_c = halutils_stringify_dec_key (devio_info->smio_inst_id);
-        ASSERT_ALLOC (smio_inst_id_c, err_smio_inst_id_c_alloc, DMNGR_ERR_ALLOC);
-
-        /* Argument options are "process name", "device type" and
-         *"dev entry" */
-        DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_INFO, "[dev_mngr_core] Spawing DEVIO worker"
-                " for a %s device \n\tlocated on %s, ID %u, broker address %s, with "
-                "logfile on %s ...\n", dev_type_c, devio_info->dev_pathname, devio_info->id,
-                broker_endp, devio_log_filename);
-        char *argv_exec [] = {DEVIO_NAME, "-n", devio_type_c,"-t", dev_type_c,
-            "-i", dev_id_c, "-e", devio_info->dev_pathname, "-s", smio_inst_id_c,
-            "-b", broker_endp, "-l", devio_log_filename, NULL};
-        int spawn_err = _dmngr_spawn_chld (self, DEVIO_NAME, argv_exec);
-
-        free (dev_type_c);
-        dev_type_c = NULL;
-        free (devio_type_c);
-        devio_type_c = NULL;
-        free (dev_id_c);
-        dev_id_c = NULL;
-        free (smio_inst_id_c);
-        smio_inst_id_c = NULL;
-        /* Just fail miserably, for now */
-        ASSERT_TEST(spawn_err == 0, "Could not spawn DEVIO instance",
-                err_spawn, DMNGR_ERR_SPAWNCHLD);
-
-        devio_info->state = RUNNING;
+        devio_info_t *group [DMNGR_DEVIO_MAX_BOARDS] = {pending [i]};
+        uint32_t ngroup = 1;
+        uint32_t group_max = pending [i]->alone ? 1 : max_boards;
+        uint32_t j;
+        for (j = i + 1; j < npending && ngroup < group_max; ++j) {
+            if (pending [j] != NULL && !pending [j]->alone &&
+                    pending [j]->devio_type == pending [i]->devio_type &&
+                    pending [j]->type == pending [i]->type) {
+                group [ngroup++] = pending [j];
+                pending [j] = NULL;
+            }
+        }
+
+        /* A failed spawn must not hold back the other groups. Try it again
+         * later */
+        dmngr_err_e spawn_err = _dmngr_spawn_devio (self, broker_endp,
+                devio_log_prefix, group, ngroup);
+        if (spawn_err != DMNGR_SUCCESS) {
+            for (j = 0; j < ngroup; ++j) {
+                _dmngr_devio_killed (group [j], now, ngroup > 1);
+            }
+        }
     }
 
-err_spawn:
-    free (smio_inst_id_c);
-err_smio_inst_id_c_alloc:
-    free (dev_id_c);
-err_dev_id_c_alloc:
-    free (dev_type_c);
-err_dev_type_c_alloc:
-    free (devio_type_c);
-err_devio_type_c_alloc:
+    free (pending);
+err_pending_alloc:
     zlist_destroy (&devio_info_key_list);
 err_hash_keys_alloc:
     return err;
@@ -487,16 +632,27 @@ static dmngr_err_e _dmngr_scan_devs (dmngr_t *self, uint32_t *num_devs_found)
 
     /* Scan just the PCIe bus for now. We expect to find devices of
      * the form: /dev/fpga0 .. /dev/fpga5 */
-    glob (DEVIO_BE_DEV_GLOB, 0, NULL, &glob_dev);
+    uint32_t i = 0;
+    char dev_glob [DEVIO_BE_DEV_GLOB_LEN];
+    int glob_errs = snprintf (dev_glob, sizeof (dev_glob),
+            DEVIO_BE_DEV_GLOB_PATTERN, self->dev_dir);
+    ASSERT_TEST (glob_errs >= 0 && (size_t) glob_errs < sizeof (dev_glob),
+            "[dev_mngr] Could not generate the device pattern\n", err_dev_glob,
+            DMNGR_ERR_CFG);
+
+    glob (dev_glob, 0, NULL, &glob_dev);
 
     /* Initialize the devices we found */
-    uint32_t i = 0;
     for (; i < glob_dev.gl_pathc; ++i) {
         /* Check if the found device is already on the hash list */
 
         /* Extract ID */
+        const char *dev_name = strrchr (glob_dev.gl_pathv[i], '/');
+        dev_name = (dev_name != NULL) ? dev_name + 1 : glob_dev.gl_pathv[i];
         uint32_t devio_info_id;
-        sscanf (glob_dev.gl_pathv[i], DEVIO_BE_DEV_PATTERN, &devio_info_id);
+        if (sscanf (dev_name, DEVIO_BE_DEV_PATTERN, &devio_info_id) != 1) {
+            continue;
+        }
 
         /* Stringify ID */
         /* DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_TRACE,
@@ -514,11 +670,19 @@ static dmngr_err_e _dmngr_scan_devs (dmngr_t *self, uint32_t *num_devs_found)
                 "[dev_mngr] Could not generate DBE config path\n", err_cfg_key,
                 DMNGR_ERR_CFG);
 
-        const devio_info_t *devio_info_lookup = zhash_lookup (self->devio_info_h,
+        devio_info_t *devio_info_lookup = zhash_lookup (self->devio_info_h,
                 key);
 
-        /* If device is already registered, do nothing */
+        /* If device is already registered, do nothing. Unless it went away
+         * and is back now */
         if (devio_info_lookup != NULL) {
+            if (devio_info_lookup->state == INACTIVE) {
+                DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_INFO,
+                        "[dev_mngr_core:scan_devs] Device %s is back\n",
+                        glob_dev.gl_pathv[i]);
+                devio_info_lookup->state = READY_TO_RUN;
+                devio_info_lookup->restarts = 0;
+            }
             continue;
         }
 
@@ -574,6 +738,7 @@ err_cfg_exit:
 err_devio_insert_alloc:
 err_cfg_key:
     globfree (&glob_dev);
+err_dev_glob:
 
     /* Number of new devices found */
     if (num_devs_found != NULL) {
@@ -645,6 +810,12 @@ dmngr_err_e dmngr_get_hints (zconfig_t *root_cfg, zhash_t *hints_h)
             DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_TRACE, "[dev_mngr] Config file: "
                     "bpm_cfg name: %s\n", zconfig_name (bpm_cfg));
 
+            /* Boards have other sections (e.g., sched) besides the bpm ones */
+            if (strncmp (zconfig_name (bpm_cfg), DMNGR_CFG_BPM_PREFIX,
+                        strlen (DMNGR_CFG_BPM_PREFIX)) != 0) {
+                continue;
+            }
+
             /* Now, we expect to find the bind address of this bpm/board instance
              * in the configuration file */
             char *hints_value = zconfig_resolve (bpm_cfg, "/afe/bind",
@@ -682,3 +853,206 @@ err_cfg_exit:
     return err;
 }
 
+
+/* Spawn a single DEVIO serving all of the "group" devices */
+static dmngr_err_e _dmngr_spawn_devio (dmngr_t *self, char *broker_endp,
+        char *devio_log_prefix, devio_info_t **group, uint32_t ngroup)
+{
+    assert (self);
+    assert (group);
+    assert (ngroup > 0);
+
+    dmngr_err_e err = DMNGR_SUCCESS;
+    char dev_pathnames [DEVIO_LIST_LEN] = "";
+    char dev_ids [DEVIO_LIST_LEN] = "";
+    char smio_inst_ids [DEVIO_LIST_LEN] = "";
+    bool configured = true;
+
+    uint32_t i;
+    for (i = 0; i < ngroup; ++i) {
+        configured = configured && group [i]->configured;
+        const char *sep = (i == 0) ? "" : ",";
+        bool list_ok = _dmngr_list_append (dev_pathnames, sizeof (dev_pathnames),
+                "%s%s", sep, group [i]->dev_pathname);
+        list_ok = list_ok && _dmngr_list_append (dev_ids, sizeof (dev_ids),
+                "%s%u", sep, group [i]->id);
+        list_ok = list_ok && _dmngr_list_append (smio_inst_ids,
+                sizeof (smio_inst_ids), "%s%u", sep, group [i]->smio_inst_id);
+        ASSERT_TEST(list_ok, "Too many devices for a single DEVIO",
+                err_list, DMNGR_ERR_SPAWNCHLD);
+    }
+
+    /* Get DEVIO type to set-up correct log filename */
+    char *devio_type_c = devio_type_to_str (group [0]->devio_type);
+    ASSERT_ALLOC (devio_type_c, err_devio_type_c_alloc, DMNGR_ERR_ALLOC);
+
+    /* Set up logdir. Defaulting it to stdout */
+    char devio_log_filename[LOG_FILENAME_LEN] = "stdout";
+
+    /* TODO: Check for the validity of the log filename. The log is named
+     * after the first device */
+    if (devio_log_prefix != NULL) {
+        snprintf (devio_log_filename, LOG_FILENAME_LEN,
+                "%s/"DEVIO_LOG_FILENAME_PATTERN, devio_log_prefix,
+                group [0]->id, devio_type_c, group [0]->smio_inst_id);
+    }
+
+    /* Alloc and convert types */
+    char *dev_type_c = llio_type_to_str (group [0]->type);
+    ASSERT_ALLOC (dev_type_c, err_dev_type_c_alloc, DMNGR_ERR_ALLOC);
+
+    /* Argument options are "process name", "device type" and
+     *"dev entry" */
+    DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_INFO, "[dev_mngr_core] Spawing DEVIO worker"
+            " for %u %s device(s) \n\tlocated on %s, ID(s) %s, broker address %s, with "
+            "logfile on %s%s ...\n", ngroup, dev_type_c, dev_pathnames, dev_ids,
+            broker_endp, devio_log_filename, configured ? ", in restart mode" : "");
+    /* Devices we configured before keep their registers across a DEVIO
+     * restart, so only what differs has to be written again */
+    char *argv_exec [] = {DEVIO_NAME, "-n", devio_type_c,"-t", dev_type_c,
+        "-i", dev_ids, "-e", dev_pathnames, "-s", smio_inst_ids,
+        "-b", broker_endp, "-l", devio_log_filename,
+        configured ? "-r" : NULL, NULL};
+    ASSERT_TEST(self->ops->dmngr_spawn_chld != NULL, "No spawn handler "
+            "registered", err_spawn, DMNGR_ERR_FUNC_NOT_IMPL);
+    int chld_pid = self->ops->dmngr_spawn_chld (DEVIO_NAME, argv_exec);
+    ASSERT_TEST(chld_pid > 0, "Could not spawn DEVIO instance",
+            err_spawn, DMNGR_ERR_SPAWNCHLD);
+
+    int64_t now = zclock_time ();
+    for (i = 0; i < ngroup; ++i) {
+        group [i]->state = RUNNING;
+        group [i]->pid = (pid_t) chld_pid;
+        group [i]->started_at = now;
+        group [i]->configured = true;
+    }
+
+err_spawn:
+    free (dev_type_c);
+err_dev_type_c_alloc:
+    free (devio_type_c);
+err_devio_type_c_alloc:
+err_list:
+    return err;
+}
+
+/* Append a formatted string to list. Returns false if it does not fit */
+static bool _dmngr_list_append (char *list, size_t size, const char *fmt, ...)
+{
+    size_t len = strlen (list);
+
+    va_list ap;
+    va_start (ap, fmt);
+    int errs = vsnprintf (list + len, size - len, fmt, ap);
+    va_end (ap);
+
+    /* Only when the number of characters written is less than the whole buffer,
+     * it is guaranteed that the string was written successfully */
+    return errs >= 0 && (size_t) errs < size - len;
+}
+
+/* A child process exited. Whatever it served has to be respawned */
+static void _dmngr_chld_exited (dmngr_t *self, pid_t chld_pid)
+{
+    if (chld_pid == self->broker_pid) {
+        DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_WARN, "[dev_mngr_core] Broker "
+                "(PID %d) exited. Respawning it\n", chld_pid);
+        self->broker_running = false;
+        self->broker_pid = 0;
+        return;
+    }
+
+    zlist_t *devio_info_key_list = zhash_keys (self->devio_info_h);
+    if (devio_info_key_list == NULL) {
+        return;
+    }
+
+    /* All of the devices of a DEVIO share its PID */
+    uint32_t ndevs = 0;
+    char *devio_info_key = zlist_first (devio_info_key_list);
+    for (; devio_info_key != NULL; devio_info_key = zlist_next (devio_info_key_list)) {
+        devio_info_t *devio_info = zhash_lookup (self->devio_info_h,
+                devio_info_key);
+
+        if (devio_info->state == RUNNING && devio_info->pid == chld_pid) {
+            ndevs++;
+        }
+    }
+
+    int64_t now = zclock_time ();
+    devio_info_key = zlist_first (devio_info_key_list);
+    for (; devio_info_key != NULL; devio_info_key = zlist_next (devio_info_key_list)) {
+        devio_info_t *devio_info = zhash_lookup (self->devio_info_h,
+                devio_info_key);
+
+        if (devio_info->state == RUNNING && devio_info->pid == chld_pid) {
+            _dmngr_devio_killed (devio_info, now, ndevs > 1);
+        }
+    }
+
+    zlist_destroy (&devio_info_key_list);
+}
+
+/* Schedule the restart of a DEVIO that died or could not be spawned.
+ * "shared" tells whether the DEVIO served other devices as well */
+static void _dmngr_devio_killed (devio_info_t *devio_info, int64_t now,
+        bool shared)
+{
+    /* It ran for long enough. Whatever made it die was not its fault */
+    if (devio_info->started_at != 0 &&
+            now - devio_info->started_at >= DMNGR_RESTART_STABLE) {
+        devio_info->restarts = 0;
+    }
+    /* We can't tell which of the devices made it fail. Split them up, so a
+     * broken one only takes its own DEVIO down from now on */
+    else if (shared && !devio_info->alone) {
+        DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_WARN, "[dev_mngr_core] Device %s "
+                "will get a DEVIO of its own\n", devio_info->dev_pathname);
+        devio_info->alone = true;
+    }
+
+    int64_t backoff = DMNGR_RESTART_BACKOFF_MIN;
+    uint32_t i;
+    for (i = 0; i < devio_info->restarts &&
+            backoff < DMNGR_RESTART_BACKOFF_MAX; ++i) {
+        backoff *= 2;
+    }
+    if (backoff > DMNGR_RESTART_BACKOFF_MAX) {
+        backoff = DMNGR_RESTART_BACKOFF_MAX;
+    }
+
+    DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_WARN, "[dev_mngr_core] DEVIO of device %s "
+            "is not running. Restarting it in %" PRId64 " ms\n",
+            devio_info->dev_pathname, backoff);
+
+    devio_info->state = KILLED;
+    devio_info->pid = 0;
+    devio_info->started_at = 0;
+    devio_info->restart_at = now + backoff;
+    ++devio_info->restarts;
+}
+
+/* Consume the pending inotify events. We rescan the whole directory
+ * anyway, so they are only logged */
+static void _dmngr_drain_watch (dmngr_t *self)
+{
+    char buf [DMNGR_WATCH_BUF_LEN]
+        __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+    ssize_t len;
+
+    while ((len = read (self->watch_fd, buf, sizeof (buf))) > 0) {
+        char *it = buf;
+        while (it < buf + len) {
+            const struct inotify_event *event = (const struct inotify_event *) it;
+
+            if (event->len > 0 && strncmp (event->name, DEVIO_BE_DEV_PREFIX,
+                        strlen (DEVIO_BE_DEV_PREFIX)) == 0) {
+                DBE_DEBUG (DBG_DEV_MNGR | DBG_LVL_TRACE, "[dev_mngr_core] %s "
+                        "%s/%s\n", (event->mask & (IN_DELETE | IN_MOVED_FROM)) ?
+                        "Removed" : "Added", self->dev_dir, event->name);
+            }
+
+            it += sizeof (struct inotify_event) + event->len;
+        }
+    }
+}
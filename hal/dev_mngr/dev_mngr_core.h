@@ -11,6 +11,7 @@
 #include "czmq.h"
 #include "dev_mngr_err.h"
 #include "dev_mngr_dev_info.h"
+#include "hal_sched.h"
 
 /* Configuration variables. To be filled by dev_mngr */
 extern const char *dmngr_log_filename;
@@ -20,14 +21,26 @@ extern char *dmngr_verbose_str;
 extern int dmngr_verbose;
 extern char *dmngr_daemonize_str;
 extern int dmngr_daemonize;
+extern halutils_sched_cfg_t dmngr_broker_sched;
+extern uint32_t dmngr_devio_boards;
+extern char *dmngr_dev_dir;
+
+/* Maximum number of devices a single DEVIO can serve. Same as
+ * DEVIO_MAX_BOARDS */
+#define DMNGR_DEVIO_MAX_BOARDS      8
+
+/* Where the PCIe devices (fpga*) show up by default */
+#define DMNGR_DFLT_DEV_DIR          "/dev"
 
 /* Signal handler function pointer */
 typedef void (*sig_handler_fp)(int sig, siginfo_t *siginfo, void *context);
-/* Wait child handler function pointer */
+/* Wait child handler function pointer. Returns the PID of a child that
+ * exited, 0 if there is none or -1 on error */
 typedef int (*wait_chld_handler_fp)(void);
-/* Spawn child handler function pointer */
+/* Spawn child handler function pointer. Returns the PID of the new child
+ * or -1 on error */
 typedef int (*spawn_chld_handler_fp)(const char *program, char *const argv[]);
-/* Spawn broker handler function pointer */
+/* Spawn broker handler function pointer. Same as above */
 typedef int (*spawn_broker_handler_fp)(const char *program, char *const argv[]);
 
 /* Node of sig_ops list */
@@ -58,10 +71,14 @@ struct _dmngr_t {
 
     /* zeroMQ broker management */
     bool broker_running;        /* true if broker is already running */
+    pid_t broker_pid;           /* Broker process, so we know when it dies */
 
     /* Device managment */
     zhash_t *devio_info_h;
     zhash_t *hints_h;           /* Config hints from configuration file */
+    char *dev_dir;              /* Directory to look for devices in */
+    int watch_fd;               /* inotify instance watching dev_dir. -1 if
+                                   the directory is not being watched */
 };
 
 /* Opaque class signal handler structure */
@@ -73,9 +90,10 @@ typedef struct _dmngr_t dmngr_t;
 
 /***************** Our methods *****************/
 
-/* Creates a new instance of the Device Manager */
+/* Creates a new instance of the Device Manager. Devices are looked for
+ * in dev_dir, or in DMNGR_DFLT_DEV_DIR if NULL */
 dmngr_t * dmngr_new (char *name, char *endpoint, int verbose,
-        const char *log_prefix, zhash_t *hints_h);
+        const char *log_prefix, zhash_t *hints_h, const char *dev_dir);
 /* Destroy an instance of the Device Manager */
 dmngr_err_e dmngr_destroy (dmngr_t **self_p);
 
@@ -85,12 +103,16 @@ dmngr_err_e dmngr_set_sig_handler (dmngr_t *self, dmngr_sig_handler_t *sig_handl
 dmngr_err_e dmngr_register_sig_handlers (dmngr_t *self);
 /* Register function to wait a all child process */
 dmngr_err_e dmngr_set_wait_clhd_handler (dmngr_t *self, wait_chld_handler_fp fp);
-/* Execute function to wait a all child process */
+/* Execute function to wait a all child process. The DEVIOs of the children
+ * that exited are scheduled to be respawned */
 dmngr_err_e dmngr_wait_chld (dmngr_t *self);
 /* Register function to spawn a all child process */
 dmngr_err_e dmngr_set_spawn_clhd_handler (dmngr_t *self, spawn_chld_handler_fp fp);
 /* Execute function to spawn a all child process */
 dmngr_err_e dmngr_spawn_chld (dmngr_t *self, const char *program, char *const argv[]);
+/* Register function to spawn the broker. If none is set, the broker is
+ * spawned as any other child process */
+dmngr_err_e dmngr_set_spawn_broker_handler (dmngr_t *self, spawn_broker_handler_fp fp);
 
 /* Setting all operations at once */
 dmngr_err_e dmngr_set_ops (dmngr_t *self, dmngr_ops_t *dmngr_ops);
@@ -100,9 +122,19 @@ bool dmngr_is_broker_running (dmngr_t *self);
 dmngr_err_e dmngr_spawn_broker (dmngr_t *self, char *broker_endp);
 /* Scan for Devices to control */
 dmngr_err_e dmngr_scan_devs (dmngr_t *self, uint32_t *num_devs_found);
-/* Spwan all devices previously found by dmngr_scan_devs () */
+/* Watch the device directory, so dmngr_wait_devs () returns as soon as
+ * a device shows up or goes away */
+dmngr_err_e dmngr_watch_devs (dmngr_t *self);
+/* Wait up to timeout_ms for a change in the device directory. Returns
+ * earlier if a DEVIO restart is due */
+dmngr_err_e dmngr_wait_devs (dmngr_t *self, int timeout_ms);
+/* Spwan all devices previously found by dmngr_scan_devs (). Up to
+ * "max_boards" devices of the same type are served by the same DEVIO.
+ * A DEVIO that could not be spawned, or died, is retried later, backing off
+ * each time it fails again */
 dmngr_err_e dmngr_spawn_all_devios (dmngr_t *self, char *broker_endp,
-        char *devio_log_filename, bool respawn_killed_devio);
+        char *devio_log_filename, bool respawn_killed_devio,
+        uint32_t max_boards);
 
 /* Utility functions */
 dmngr_err_e dmngr_get_hints (zconfig_t *root_cfg, zhash_t *hints_h);
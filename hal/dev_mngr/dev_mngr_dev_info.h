@@ -8,6 +8,9 @@
 #ifndef _DEV_MNGR_DEV_INFO_H_
 #define _DEV_MNGR_DEV_INFO_H_
 
+#include <sys/types.h>
+#include <stdbool.h>
+
 #include "czmq.h"
 #include "dev_mngr_err.h"
 #include "ll_io_utils.h"            /* LLIO types */
@@ -29,6 +32,19 @@ struct _devio_info_t {
                                            with a single SMIO */
     char *dev_pathname;                 /* /dev pathname */
     enum _devio_state_e state;          /* Device IO state */
+    pid_t pid;                          /* DEVIO process serving the device.
+                                           0 if not running */
+    int64_t started_at;                 /* When the DEVIO was spawned, in msec */
+    uint32_t restarts;                  /* Restarts since the last stable run */
+    int64_t restart_at;                 /* Not to be restarted before this,
+                                           in msec */
+    bool configured;                    /* A DEVIO was spawned for the device
+                                           already, so the hardware holds
+                                           its default values. Respawns only
+                                           write the ones that differ */
+    bool alone;                         /* A DEVIO shared with other devices
+                                           failed early, so this one gets a
+                                           DEVIO of its own from now on */
 };
 
 typedef struct _devio_info_t devio_info_t;
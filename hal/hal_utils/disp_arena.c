@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include <czmq.h>
+
+#include "disp_arena.h"
+#include "hal_assert.h"
+
+/* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
+#ifdef ASSERT_TEST
+#undef ASSERT_TEST
+#endif
+#define ASSERT_TEST(test_boolean, err_str, err_goto_label, /* err_core */ ...)  \
+    ASSERT_HAL_TEST(test_boolean, HAL_UTILS, "[halutils:disp_arena]",           \
+            err_str, err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef ASSERT_ALLOC
+#undef ASSERT_ALLOC
+#endif
+#define ASSERT_ALLOC(ptr, err_goto_label, /* err_core */ ...)                   \
+    ASSERT_HAL_ALLOC(ptr, HAL_UTILS, "[halutils:disp_arena]",                   \
+            halutils_err_str(HALUTILS_ERR_ALLOC),                               \
+            err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef CHECK_ERR
+#undef CHECK_ERR
+#endif
+#define CHECK_ERR(err, err_type)                                                \
+    CHECK_HAL_ERR(err, HAL_UTILS, "[halutils:disp_arena]",                      \
+            halutils_err_str (err_type))
+
+/* Size class of buffers that are not cached */
+#define DISP_ARENA_UNCACHED                 DISP_ARENA_NUM_CLASSES
+
+/* Header preceding every buffer handed out. Keep it aligned, so the
+ * buffer itself can hold any type */
+struct _disp_arena_buf_t {
+    struct _disp_arena_buf_t *next;     /* Next free buffer */
+    uint32_t size_class;                /* Size class of this buffer */
+    uint32_t size;                      /* Usable size of this buffer */
+} __attribute__ ((aligned (8)));
+
+typedef struct _disp_arena_buf_t disp_arena_buf_t;
+
+#define DISP_ARENA_BUF_DATA(buf)            ((void *) ((buf) + 1))
+#define DISP_ARENA_DATA_BUF(data)           (((disp_arena_buf_t *) (data)) - 1)
+
+static uint32_t _disp_arena_size_class (uint32_t size);
+static void _disp_arena_free_all (disp_arena_t *self);
+
+/* Creates a new instance of the return value arena */
+disp_arena_t *disp_arena_new (void)
+{
+    disp_arena_t *self = (disp_arena_t *) zmalloc (sizeof *self);
+    ASSERT_ALLOC (self, err_self_alloc);
+
+    return self;
+
+err_self_alloc:
+    return NULL;
+}
+
+/* Destroys an instance of the return value arena */
+halutils_err_e disp_arena_destroy (disp_arena_t **self_p)
+{
+    assert (self_p);
+
+    if (*self_p) {
+        disp_arena_t *self = *self_p;
+
+        if (self->outstanding != 0) {
+            DBE_DEBUG (DBG_HAL_UTILS | DBG_LVL_WARN,
+                    "[halutils:disp_arena] Destroying arena with %u buffer(s) "
+                    "still in use\n", self->outstanding);
+        }
+
+        DBE_DEBUG (DBG_HAL_UTILS | DBG_LVL_TRACE,
+                "[halutils:disp_arena] Arena allocated %"PRIu64" buffer(s) and "
+                "reused %"PRIu64" buffer(s)\n", self->allocs, self->reuses);
+
+        _disp_arena_free_all (self);
+        free (self);
+        *self_p = NULL;
+    }
+
+    return HALUTILS_SUCCESS;
+}
+
+void *disp_arena_get (disp_arena_t *self, uint32_t size)
+{
+    assert (self);
+
+    disp_arena_buf_t *buf = NULL;
+    uint32_t size_class = _disp_arena_size_class (size);
+
+    if (size_class != DISP_ARENA_UNCACHED && self->free_list [size_class] != NULL) {
+        buf = self->free_list [size_class];
+        self->free_list [size_class] = buf->next;
+        self->free_count [size_class]--;
+        self->reuses++;
+
+        memset (DISP_ARENA_BUF_DATA(buf), 0, size);
+        goto buf_ready;
+    }
+
+    /* Round cached buffers up to the size class, so they can be reused
+     * by any other call in the same class */
+    uint32_t buf_size = (size_class == DISP_ARENA_UNCACHED) ? size :
+        (uint32_t) DISP_ARENA_MIN_SIZE << size_class;
+
+    buf = (disp_arena_buf_t *) zmalloc (sizeof *buf + buf_size);
+    ASSERT_ALLOC (buf, err_buf_alloc);
+    buf->size_class = size_class;
+    buf->size = buf_size;
+    self->allocs++;
+
+buf_ready:
+    buf->next = NULL;
+    self->outstanding++;
+    return DISP_ARENA_BUF_DATA(buf);
+
+err_buf_alloc:
+    return NULL;
+}
+
+void disp_arena_put (disp_arena_t *self, void **buf_p)
+{
+    assert (self);
+    assert (buf_p);
+
+    if (*buf_p == NULL) {
+        return;
+    }
+
+    disp_arena_buf_t *buf = DISP_ARENA_DATA_BUF(*buf_p);
+    uint32_t size_class = buf->size_class;
+    *buf_p = NULL;
+
+    assert (self->outstanding > 0);
+    self->outstanding--;
+
+    if (size_class == DISP_ARENA_UNCACHED ||
+            self->free_count [size_class] >= DISP_ARENA_MAX_FREE_PER_CLASS) {
+        free (buf);
+        return;
+    }
+
+    buf->next = self->free_list [size_class];
+    self->free_list [size_class] = buf;
+    self->free_count [size_class]++;
+}
+
+/**************** Static Functions ***************/
+
+static uint32_t _disp_arena_size_class (uint32_t size)
+{
+    if (size > DISP_ARENA_MAX_CACHED_SIZE) {
+        return DISP_ARENA_UNCACHED;
+    }
+
+    uint32_t size_class = 0;
+    for ( ; ((uint32_t) DISP_ARENA_MIN_SIZE << size_class) < size; ++size_class);
+
+    return size_class;
+}
+
+static void _disp_arena_free_all (disp_arena_t *self)
+{
+    uint32_t i;
+    for (i = 0; i < DISP_ARENA_NUM_CLASSES; ++i) {
+        while (self->free_list [i] != NULL) {
+            disp_arena_buf_t *buf = self->free_list [i];
+            self->free_list [i] = buf->next;
+            free (buf);
+        }
+
+        self->free_count [i] = 0;
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+/* Return value arena for the dispatch table calls. Each worker (the thread
+ * calling the dispatch table functions) owns its arena, so there is no
+ * locking whatsoever. A buffer is handed out for every call and given back
+ * after the reply is sent, so it can be reused by the next call.
+ *
+ * Small buffers are kept in per-size-class free lists. Buffers larger than
+ * DISP_ARENA_MAX_CACHED_SIZE (e.g., ACQ data blocks) are not cached at all,
+ * so they are not pinned for the lifetime of the process */
+
+#ifndef _DISP_ARENA_H_
+#define _DISP_ARENA_H_
+
+#include <inttypes.h>
+#include "hal_utils_err.h"
+
+/* Smallest size class, in bytes */
+#define DISP_ARENA_MIN_SIZE                 64
+/* Number of size classes. Each one doubles the previous size, so the
+ * largest cached buffer is DISP_ARENA_MIN_SIZE << (DISP_ARENA_NUM_CLASSES-1) */
+#define DISP_ARENA_NUM_CLASSES              11
+#define DISP_ARENA_MAX_CACHED_SIZE          (DISP_ARENA_MIN_SIZE << \
+                                                (DISP_ARENA_NUM_CLASSES-1))
+/* Maximum number of free buffers kept per size class */
+#define DISP_ARENA_MAX_FREE_PER_CLASS       4
+
+struct _disp_arena_buf_t;
+
+struct _disp_arena_t {
+    /* Free buffers, one singly linked list per size class */
+    struct _disp_arena_buf_t *free_list [DISP_ARENA_NUM_CLASSES];
+    uint32_t free_count [DISP_ARENA_NUM_CLASSES];
+    uint32_t outstanding;               /* Buffers handed out and not yet
+                                           given back */
+    uint64_t allocs;                    /* Buffers allocated from the heap */
+    uint64_t reuses;                    /* Buffers taken from a free list */
+};
+
+/* Opaque class structure */
+typedef struct _disp_arena_t disp_arena_t;
+
+/***************** Our methods *****************/
+
+/* Creates a new instance of the return value arena */
+disp_arena_t *disp_arena_new (void);
+/* Destroys an instance of the return value arena. All of the buffers must
+ * have been given back already */
+halutils_err_e disp_arena_destroy (disp_arena_t **self_p);
+
+/* Get a zeroed buffer of, at least, size bytes. Returns NULL on error */
+void *disp_arena_get (disp_arena_t *self, uint32_t size);
+/* Give a buffer back to the arena. The pointer is set to NULL. Putting
+ * a NULL buffer is a no-op */
+void disp_arena_put (disp_arena_t *self, void **buf_p);
+
+#endif
@@ -58,10 +58,12 @@ static halutils_err_e _disp_table_check_thsafe_zmq_args (const disp_op_t *disp_o
         zmq_server_args_t *args);
 static int _disp_table_call (disp_table_t *self, uint32_t key, void *owner, void *args,
         void *ret);
-static halutils_err_e _disp_table_alloc_ret (const disp_op_t *disp_op, void **ret);
-static halutils_err_e _disp_table_set_ret_op (const disp_op_t * disp_op, void **ret);
+static halutils_err_e _disp_table_alloc_ret (const disp_op_t *disp_op,
+        disp_arena_t *arena, void **ret);
+static halutils_err_e _disp_table_set_ret_op (const disp_op_t * disp_op,
+        disp_arena_t *arena, void **ret);
 static halutils_err_e _disp_table_set_ret (disp_table_t *self, uint32_t key, void **ret);
-static halutils_err_e _disp_table_cleanup_args_op (const disp_op_t *disp_op);
+static halutils_err_e _disp_table_release_ret (disp_table_t *self, void **ret);
 
 disp_table_t *disp_table_new (void)
 {
@@ -71,9 +73,13 @@ disp_table_t *disp_table_new (void)
     ASSERT_ALLOC (self->table_h, err_table_h_alloc);
     /* Only work for strings
     zhash_autofree (self->table_h);*/
+    self->arena = disp_arena_new ();
+    ASSERT_ALLOC (self->arena, err_arena_alloc);
 
     return self;
 
+err_arena_alloc:
+    zhash_destroy (&self->table_h);
 err_table_h_alloc:
     free (self);
 err_self_alloc:
@@ -89,6 +95,7 @@ halutils_err_e disp_table_destroy (disp_table_t **self_p)
 
         _disp_table_remove_all (self);
         zhash_destroy (&self->table_h);
+        disp_arena_destroy (&self->arena);
         free (self);
         *self_p = NULL;
     }
@@ -149,19 +156,6 @@ halutils_err_e disp_table_check_args (disp_table_t *self, uint32_t key,
     return _disp_table_check_args (self, key, args, ret);
 }
 
-halutils_err_e disp_table_cleanup_args (disp_table_t *self, uint32_t key)
-{
-    halutils_err_e err = HALUTILS_SUCCESS;
-    disp_op_t *disp_op = _disp_table_lookup (self, key);
-    ASSERT_TEST (disp_op != NULL, "Could not find registered key",
-            err_disp_op_null, HALUTILS_ERR_NO_FUNC_REG);
-
-    err = _disp_table_cleanup_args_op (disp_op);
-
-err_disp_op_null:
-    return err;
-}
-
 disp_op_t *disp_table_lookup (disp_table_t *self, uint32_t key)
 {
     return _disp_table_lookup (self, key);
@@ -183,8 +177,8 @@ int disp_table_check_call (disp_table_t *self, uint32_t key, void *owner, void *
     ASSERT_TEST(herr == HALUTILS_SUCCESS, "Wrong arguments received",
             err_invalid_args, -1);
 
-    /* Received arguments are OK, and the return value "ret" was allocated if the
-     * ownership is ours */
+    /* Received arguments are OK, and the return value "ret" was taken from
+     * the arena if the ownership is ours */
 
     /* Do the actual work... */
     err = _disp_table_call (self, key, owner, args, *ret);
@@ -198,6 +192,11 @@ halutils_err_e disp_table_set_ret (disp_table_t *self, uint32_t key, void **ret)
     return _disp_table_set_ret (self, key, ret);
 }
 
+halutils_err_e disp_table_release_ret (disp_table_t *self, void **ret)
+{
+    return _disp_table_release_ret (self, ret);
+}
+
 /**** Local helper functions ****/
 
 static halutils_err_e _disp_table_remove (disp_table_t *self, uint32_t key)
@@ -205,15 +204,11 @@ static halutils_err_e _disp_table_remove (disp_table_t *self, uint32_t key)
     char *key_c = halutils_stringify_hex_key (key);
     ASSERT_ALLOC (key_c, err_key_c_alloc);
 
-    /* Do a lookup first to free the return value */
+    /* Do a lookup first to check if the key is registered */
     disp_op_t *disp_op = _disp_table_lookup (self, key);
     ASSERT_TEST (disp_op != NULL, "Could not find registered key",
             err_disp_op_null);
 
-    halutils_err_e err = _disp_table_cleanup_args_op (disp_op);
-    ASSERT_TEST (err == HALUTILS_SUCCESS, "Could not free registered return value",
-            err_disp_op_null);
-
     DBE_DEBUG (DBG_HAL_UTILS | DBG_LVL_TRACE,
         "[halutils:disp_table] Removing function (key = %u) into dispatch table\n",
         key);
@@ -253,11 +248,6 @@ static halutils_err_e _disp_table_insert (disp_table_t *self, const disp_op_t *d
             "[halutils:disp_table] Registering function \"%s\" (%p) opcode (%u) "
             "into dispatch table\n", disp_op->name, disp_op->func_fp, disp_op->opcode);
 
-    /* FIXME: We want disp_op to be const, but we need to allocate the return value */
-    halutils_err_e herr = _disp_table_alloc_ret (disp_op, (void **) &disp_op->ret);
-    ASSERT_TEST (herr == HALUTILS_SUCCESS, "Return value could not be allocated",
-            err_alloc_ret);
-
     char *key_c = halutils_stringify_hex_key (disp_op->opcode);
     ASSERT_ALLOC (key_c, err_key_c_alloc);
     int zerr = zhash_insert (self->table_h, key_c, (void *) disp_op);
@@ -272,8 +262,6 @@ static halutils_err_e _disp_table_insert (disp_table_t *self, const disp_op_t *d
 err_insert_hash:
     free (key_c);
 err_key_c_alloc:
-    _disp_table_cleanup_args_op (disp_op);
-err_alloc_ret:
     return HALUTILS_ERR_ALLOC;
 }
 
@@ -301,9 +289,11 @@ err_disp_insert:
 }
 
 
-static halutils_err_e _disp_table_alloc_ret (const disp_op_t *disp_op, void **ret)
+static halutils_err_e _disp_table_alloc_ret (const disp_op_t *disp_op,
+        disp_arena_t *arena, void **ret)
 {
     assert (disp_op);
+    assert (arena);
     halutils_err_e err = HALUTILS_SUCCESS;
 
     if (disp_op->retval_owner == DISP_OWNER_FUNC) {
@@ -319,7 +309,9 @@ static halutils_err_e _disp_table_alloc_ret (const disp_op_t *disp_op, void **re
             "[halutils:disp_table] Allocating %u bytes for the return value of"
             " function %s\n", DISP_GET_ASIZE(disp_op->retval), disp_op->name);
 
-    *ret = zmalloc(DISP_GET_ASIZE(disp_op->retval));
+    /* Every call gets its own buffer, so the same function can be in use
+     * by more than one caller at the same time */
+    *ret = disp_arena_get (arena, size);
     ASSERT_ALLOC (*ret, err_ret_alloc, HALUTILS_ERR_ALLOC);
 
 err_size_zero:
@@ -328,10 +320,12 @@ err_no_ownership:
     return err;
 }
 
-static halutils_err_e _disp_table_set_ret_op (const disp_op_t * disp_op, void **ret)
+static halutils_err_e _disp_table_set_ret_op (const disp_op_t * disp_op,
+        disp_arena_t *arena, void **ret)
 {
     assert (disp_op);
     halutils_err_e err = HALUTILS_SUCCESS;
+    *ret = NULL;
 
     /* Check if there is a return value registered */
     if (disp_op->retval == DISP_ARG_END) {
@@ -343,10 +337,9 @@ static halutils_err_e _disp_table_set_ret_op (const disp_op_t * disp_op, void **
     DBE_DEBUG (DBG_HAL_UTILS | DBG_LVL_TRACE,
             "[halutils:disp_table] _disp_table_set_ret_op: Setting return value ...\n");
 
-    /* FIXME: This shouldn't happen, as this type of error is caught on
-     * initialization of the dispatch function */
-    ASSERT_ALLOC (disp_op->ret, err_ret_alloc, HALUTILS_ERR_ALLOC);
-    *ret = disp_op->ret;
+    err = _disp_table_alloc_ret (disp_op, arena, ret);
+    ASSERT_TEST (err == HALUTILS_SUCCESS, "Return value could not be allocated",
+            err_ret_alloc);
 
     DBE_DEBUG (DBG_HAL_UTILS | DBG_LVL_TRACE,
             "[halutils:disp_table] _disp_table_set_ret_op: Return value set\n");
@@ -363,12 +356,21 @@ static halutils_err_e _disp_table_set_ret (disp_table_t *self, uint32_t key, voi
     ASSERT_TEST (disp_op != NULL, "Could not find registered key",
             err_disp_op_null, HALUTILS_ERR_NO_FUNC_REG);
 
-    err = _disp_table_set_ret_op (disp_op, ret);
+    err = _disp_table_set_ret_op (disp_op, self->arena, ret);
 
 err_disp_op_null:
     return err;
 }
 
+static halutils_err_e _disp_table_release_ret (disp_table_t *self, void **ret)
+{
+    assert (self);
+    assert (ret);
+
+    disp_arena_put (self->arena, ret);
+    return HALUTILS_SUCCESS;
+}
+
 static void _disp_table_free_item (void *data)
 {
     (void) data;
@@ -407,8 +409,8 @@ static halutils_err_e _disp_table_check_args (disp_table_t *self, uint32_t key,
     ASSERT_TEST (err == HALUTILS_SUCCESS, "Arguments received are invalid",
             err_inv_args);
 
-    /* Point "ret" to previously allocated return value */
-    err = _disp_table_set_ret_op (disp_op, ret);
+    /* Get a return value buffer for this call */
+    err = _disp_table_set_ret_op (disp_op, self->arena, ret);
 
 err_inv_args:
 err_disp_op_null:
@@ -486,24 +488,6 @@ static halutils_err_e _disp_table_check_thsafe_zmq_args (const disp_op_t *disp_o
     return _disp_table_check_gen_zmq_args (disp_op, THSAFE_MSG_ZMQ(args));
 }
 
-static halutils_err_e _disp_table_cleanup_args_op (const disp_op_t *disp_op)
-{
-    assert (disp_op);
-    if (disp_op->ret) {
-        if (disp_op->retval_owner == DISP_OWNER_FUNC) {
-            goto err_no_ownership;
-        }
-
-        /* I know... But we have to free the item anyway */
-        disp_op_t *disp_op_tmp = (disp_op_t *) disp_op;
-        free (disp_op_tmp->ret);
-
-    }
-
-err_no_ownership:
-    return HALUTILS_SUCCESS;
-}
-
 static disp_op_t *_disp_table_lookup (disp_table_t *self, uint32_t key)
 {
     disp_op_t *disp_op = NULL;
@@ -16,12 +16,17 @@
 
 #include <czmq.h>
 #include "hal_utils_err.h"
+#include "disp_arena.h"
 
 struct _disp_table_t {
     /* Hash containg all the sm_io thsafe operations
      * that we need to handle. It is composed
      * of key (4-char ID) / value (pointer to funtion) */
     zhash_t *table_h;
+    /* Return values of the calls made through this table. A buffer
+     * is handed out per call and must be released with
+     * disp_table_release_ret () after the reply is sent */
+    disp_arena_t *arena;
 };
 
 /* Opaque class structure */
@@ -67,13 +72,26 @@ enum _disp_val_owner_e {
 
 typedef enum _disp_val_owner_e disp_val_owner_e;
 
+/* Operation flags. They describe the side effects of a function, so callers
+ * can tell if identical calls might share a single result */
+#define DISP_OP_FLAG_NONE           0
+#define DISP_OP_FLAG_READ_ONLY      (1 << 0)    /* No side effects at all */
+#define DISP_OP_FLAG_RW_PARAM       (1 << 1)    /* Set/get function. Read-only
+                                                   if the first argument (rw)
+                                                   is not zero */
+#define DISP_OP_FLAG_MOD_STATE      (1 << 2)    /* Read-only, but updates state
+                                                   kept by the caller (caches,
+                                                   for instance), so it must
+                                                   not run alongside other
+                                                   calls */
+
 struct _disp_op_t {
     const char *name;                   /* Function name */
     uint32_t opcode;                    /* Operation code */
     disp_table_func_fp func_fp;         /* Pointer to exported function */
     uint32_t retval;                    /* Type of return value */
     disp_val_owner_e retval_owner;      /* Who owns the return value */
-    void *ret;                          /* Buffer for function return value */
+    uint32_t flags;                     /* DISP_OP_FLAG_* */
     uint32_t args [];                   /* Zero-terminated */
 };
 
@@ -96,13 +114,16 @@ halutils_err_e disp_table_fill_desc (disp_table_t *self, disp_op_t **disp_ops,
 
 halutils_err_e disp_table_check_args (disp_table_t *self, uint32_t key,
         void *args, void **ret);
-halutils_err_e disp_table_cleanup_args (disp_table_t *self, uint32_t key);
 disp_op_t *disp_table_lookup (disp_table_t *self, uint32_t key);
 int disp_table_call (disp_table_t *self, uint32_t key, void *owner, void *args,
         void *ret);
 int disp_table_check_call (disp_table_t *self, uint32_t key, void *owner,
         void *args, void **ret);
 halutils_err_e disp_table_set_ret (disp_table_t *self, uint32_t key, void **ret);
+/* Give the return value obtained by disp_table_check_call (),
+ * disp_table_check_args () or disp_table_set_ret () back to the table arena.
+ * "ret" is set to NULL */
+halutils_err_e disp_table_release_ret (disp_table_t *self, void **ret);
 
 #endif
 
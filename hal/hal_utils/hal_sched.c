@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+/* For the CPU affinity functions */
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "hal_sched.h"
+#include "hal_assert.h"
+
+/* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
+#ifdef ASSERT_TEST
+#undef ASSERT_TEST
+#endif
+#define ASSERT_TEST(test_boolean, err_str, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_TEST(test_boolean, HAL_UTILS, "[halutils:sched]",    \
+            err_str, err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef ASSERT_ALLOC
+#undef ASSERT_ALLOC
+#endif
+#define ASSERT_ALLOC(ptr, err_goto_label, /* err_core */ ...)       \
+    ASSERT_HAL_ALLOC(ptr, HAL_UTILS, "[halutils:sched]",            \
+            halutils_err_str(HALUTILS_ERR_ALLOC),                   \
+            err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef CHECK_ERR
+#undef CHECK_ERR
+#endif
+#define CHECK_ERR(err, err_type)                                    \
+    CHECK_HAL_ERR(err, HAL_UTILS, "[halutils:sched]",               \
+            halutils_err_str (err_type))
+
+static bool _halutils_sched_cfg_has_cpu (const halutils_sched_cfg_t *cfg,
+        uint32_t cpu);
+static size_t _halutils_sched_append (char *str, size_t len, size_t pos,
+        const char *fmt, ...);
+static const char *_halutils_sched_policy_str (int policy);
+
+halutils_err_e halutils_sched_cfg_load (zconfig_t *root_cfg, const char *path,
+        halutils_sched_cfg_t *cfg)
+{
+    assert (root_cfg);
+    assert (path);
+    assert (cfg);
+
+    halutils_err_e err = HALUTILS_SUCCESS;
+    zconfig_t *sched_cfg = zconfig_locate (root_cfg, (char *) path);
+    /* No options for us. Nothing to do */
+    if (sched_cfg == NULL) {
+        goto err_no_sched_cfg;
+    }
+
+    char *cpus_str = zconfig_resolve (sched_cfg, "cpus", NULL);
+    if (cpus_str != NULL && *cpus_str != '\0') {
+        err = halutils_sched_parse_cpus (cpus_str, cfg);
+        ASSERT_TEST(err == HALUTILS_SUCCESS, "Invalid CPU list in configuration "
+                "file", err_inv_cfg);
+    }
+
+    char *priority_str = zconfig_resolve (sched_cfg, "priority", NULL);
+    if (priority_str != NULL && *priority_str != '\0') {
+        char *end = NULL;
+        long priority = strtol (priority_str, &end, 10);
+        ASSERT_TEST(*end == '\0' && priority >= 0 &&
+                priority <= sched_get_priority_max (SCHED_FIFO),
+                "Invalid priority in configuration file", err_inv_cfg,
+                HALUTILS_ERR_INV_CFG);
+        cfg->priority = (int) priority;
+    }
+
+    char *mlock_str = zconfig_resolve (sched_cfg, "mlock", NULL);
+    if (mlock_str != NULL && *mlock_str != '\0') {
+        ASSERT_TEST(streq (mlock_str, "yes") || streq (mlock_str, "no"),
+                "Invalid mlock option in configuration file. Options are: "
+                "yes or no", err_inv_cfg, HALUTILS_ERR_INV_CFG);
+        cfg->mlock = streq (mlock_str, "yes");
+    }
+
+err_inv_cfg:
+err_no_sched_cfg:
+    return err;
+}
+
+halutils_err_e halutils_sched_parse_cpus (const char *cpus_str,
+        halutils_sched_cfg_t *cfg)
+{
+    assert (cpus_str);
+    assert (cfg);
+
+    halutils_err_e err = HALUTILS_SUCCESS;
+    uint64_t cpus [HALUTILS_SCHED_CPU_WORDS] = {0};
+    const char *it = cpus_str;
+
+    /* Comma-separated list of CPUs or CPU ranges, e.g., "0,2-3" */
+    while (*it != '\0') {
+        char *end = NULL;
+        unsigned long first = strtoul (it, &end, 10);
+        ASSERT_TEST(end != it, "Invalid CPU number", err_inv_cpus,
+                HALUTILS_ERR_INV_CFG);
+
+        unsigned long last = first;
+        if (*end == '-') {
+            it = end + 1;
+            last = strtoul (it, &end, 10);
+            ASSERT_TEST(end != it, "Invalid CPU range", err_inv_cpus,
+                    HALUTILS_ERR_INV_CFG);
+        }
+
+        ASSERT_TEST(first <= last && last < HALUTILS_SCHED_MAX_CPUS,
+                "CPU number out of range", err_inv_cpus, HALUTILS_ERR_INV_CFG);
+
+        unsigned long cpu;
+        for (cpu = first; cpu <= last; ++cpu) {
+            cpus [cpu/64] |= 1ULL << (cpu % 64);
+        }
+
+        it = end;
+        if (*it == ',') {
+            ++it;
+        }
+        else {
+            ASSERT_TEST(*it == '\0', "Invalid CPU list separator", err_inv_cpus,
+                    HALUTILS_ERR_INV_CFG);
+        }
+    }
+
+    uint64_t any_cpu = 0;
+    uint32_t i;
+    for (i = 0; i < HALUTILS_SCHED_CPU_WORDS; ++i) {
+        any_cpu |= cpus [i];
+    }
+    ASSERT_TEST(any_cpu != 0, "Empty CPU list", err_inv_cpus,
+            HALUTILS_ERR_INV_CFG);
+
+    memcpy (cfg->cpus, cpus, sizeof (cfg->cpus));
+    cfg->set_cpus = true;
+
+err_inv_cpus:
+    return err;
+}
+
+halutils_err_e halutils_sched_apply (pid_t pid, const halutils_sched_cfg_t *cfg)
+{
+    assert (cfg);
+
+    halutils_err_e err = HALUTILS_SUCCESS;
+
+    if (cfg->set_cpus) {
+        cpu_set_t cpu_set;
+        CPU_ZERO (&cpu_set);
+
+        uint32_t cpu;
+        for (cpu = 0; cpu < HALUTILS_SCHED_MAX_CPUS; ++cpu) {
+            if (_halutils_sched_cfg_has_cpu (cfg, cpu)) {
+                CPU_SET (cpu, &cpu_set);
+            }
+        }
+
+        int rc = sched_setaffinity (pid, sizeof (cpu_set), &cpu_set);
+        ASSERT_TEST(rc == 0, "Could not set the CPU affinity", err_sched,
+                HALUTILS_ERR_SCHED);
+    }
+
+    if (cfg->priority > 0) {
+        struct sched_param param = {.sched_priority = cfg->priority};
+        int rc = sched_setscheduler (pid, SCHED_FIFO, &param);
+        ASSERT_TEST(rc == 0, "Could not set the SCHED_FIFO priority. Is "
+                "CAP_SYS_NICE missing?", err_sched, HALUTILS_ERR_SCHED);
+    }
+
+    if (cfg->mlock) {
+        ASSERT_TEST(pid == 0 || pid == getpid (), "Memory can only be locked "
+                "by the process itself", err_sched, HALUTILS_ERR_SCHED);
+        int rc = mlockall (MCL_CURRENT | MCL_FUTURE);
+        ASSERT_TEST(rc == 0, "Could not lock the process memory. Is "
+                "CAP_IPC_LOCK missing?", err_sched, HALUTILS_ERR_SCHED);
+    }
+
+err_sched:
+    return err;
+}
+
+halutils_err_e halutils_sched_placement_str (pid_t pid, char *str, size_t len)
+{
+    assert (str);
+    assert (len > 0);
+
+    halutils_err_e err = HALUTILS_SUCCESS;
+    cpu_set_t cpu_set;
+    int rc = sched_getaffinity (pid, sizeof (cpu_set), &cpu_set);
+    ASSERT_TEST(rc == 0, "Could not get the CPU affinity", err_sched,
+            HALUTILS_ERR_SCHED);
+
+    int policy = sched_getscheduler (pid);
+    struct sched_param param;
+    rc = sched_getparam (pid, &param);
+    ASSERT_TEST(policy != -1 && rc == 0, "Could not get the scheduling policy",
+            err_sched, HALUTILS_ERR_SCHED);
+
+    /* Print the CPUs as ranges, e.g., "cpus 0-3,8" */
+    size_t pos = _halutils_sched_append (str, len, 0, "cpus ");
+    bool first_range = true;
+    int cpu = 0;
+    while (cpu < CPU_SETSIZE) {
+        if (!CPU_ISSET (cpu, &cpu_set)) {
+            ++cpu;
+            continue;
+        }
+
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET (last + 1, &cpu_set)) {
+            ++last;
+        }
+
+        pos = _halutils_sched_append (str, len, pos, (last == cpu) ? "%s%d" :
+                "%s%d-%d", first_range ? "" : ",", cpu, last);
+        first_range = false;
+        cpu = last + 1;
+    }
+
+    pos = _halutils_sched_append (str, len, pos, ", %s",
+            _halutils_sched_policy_str (policy));
+    if (policy == SCHED_FIFO || policy == SCHED_RR) {
+        pos = _halutils_sched_append (str, len, pos, " %d",
+                param.sched_priority);
+    }
+
+err_sched:
+    return err;
+}
+
+/**************** Static Functions ***************/
+
+static bool _halutils_sched_cfg_has_cpu (const halutils_sched_cfg_t *cfg,
+        uint32_t cpu)
+{
+    return (cfg->cpus [cpu/64] >> (cpu % 64)) & 0x1;
+}
+
+/* Append to str at pos, truncating at len. Returns the new position */
+static size_t _halutils_sched_append (char *str, size_t len, size_t pos,
+        const char *fmt, ...)
+{
+    if (pos >= len - 1) {
+        return pos;
+    }
+
+    va_list ap;
+    va_start (ap, fmt);
+    int rc = vsnprintf (str + pos, len - pos, fmt, ap);
+    va_end (ap);
+
+    if (rc < 0) {
+        return pos;
+    }
+
+    pos += rc;
+    return (pos < len - 1) ? pos : len - 1;
+}
+
+static const char *_halutils_sched_policy_str (int policy)
+{
+    switch (policy) {
+        case SCHED_OTHER:
+            return "SCHED_OTHER";
+        case SCHED_FIFO:
+            return "SCHED_FIFO";
+        case SCHED_RR:
+            return "SCHED_RR";
+        case SCHED_BATCH:
+            return "SCHED_BATCH";
+        case SCHED_IDLE:
+            return "SCHED_IDLE";
+        default:
+            return "unknown policy";
+    }
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _HAL_SCHED_H_
+#define _HAL_SCHED_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "czmq.h"
+#include "hal_utils_err.h"
+
+/* Highest CPU number that can be selected, plus one */
+#define HALUTILS_SCHED_MAX_CPUS         256
+#define HALUTILS_SCHED_CPU_WORDS        (HALUTILS_SCHED_MAX_CPUS/64)
+/* Enough for a placement string like "cpus 0-3,8, SCHED_FIFO 50" */
+#define HALUTILS_SCHED_STR_LEN          128
+
+/* Placement and priority options of a process or thread, as read from
+ * the configuration file:
+ *
+ *  sched
+ *      cpus = 2-3,6        # CPUs we can run on. All of them, if unset
+ *      priority = 50       # SCHED_FIFO priority (1-99). 0 keeps the
+ *                          # default policy
+ *      mlock = yes         # Lock all the process memory (processes only)
+ */
+struct _halutils_sched_cfg_t {
+    bool set_cpus;                      /* Restrict the CPUs we run on */
+    uint64_t cpus [HALUTILS_SCHED_CPU_WORDS]; /* CPU bitmask */
+    int priority;                       /* SCHED_FIFO priority. 0 keeps
+                                           the default policy */
+    bool mlock;                         /* Lock current and future memory
+                                           pages of the process */
+};
+
+typedef struct _halutils_sched_cfg_t halutils_sched_cfg_t;
+
+/* Read the scheduling options in the section at path of the configuration
+ * file. Options not found keep the values already in cfg. A missing section
+ * is not an error */
+halutils_err_e halutils_sched_cfg_load (zconfig_t *root_cfg, const char *path,
+        halutils_sched_cfg_t *cfg);
+/* Parse a CPU list, e.g., "0,2-3", into the CPU bitmask of cfg */
+halutils_err_e halutils_sched_parse_cpus (const char *cpus_str,
+        halutils_sched_cfg_t *cfg);
+/* Apply cfg to a process or thread. A pid of 0 means the calling thread.
+ * mlock can only be applied to the calling process */
+halutils_err_e halutils_sched_apply (pid_t pid, const halutils_sched_cfg_t *cfg);
+/* Describe the effective CPUs and policy of a process or thread (0 means the
+ * calling thread) into str, e.g., "cpus 2-3, SCHED_FIFO 50" */
+halutils_err_e halutils_sched_placement_str (pid_t pid, char *str, size_t len);
+
+#endif
@@ -4,7 +4,9 @@ hal_utils_DIR = hal/hal_utils
 # we are dealing with
 hal_utils_OBJS = $(hal_utils_DIR)/hal_utils.o \
 		 $(hal_utils_DIR)/hal_math.o \
+		 $(hal_utils_DIR)/hal_sched.o \
 		 $(hal_utils_DIR)/hal_utils_err.o \
+		 $(hal_utils_DIR)/disp_arena.o \
 		 $(hal_utils_DIR)/dispatch_table.o \
 		 $(msg_DIR)/msg.o
 
@@ -18,7 +18,9 @@ static const char *halutils_err [HALUTILS_ERR_END] =
     [HALUTILS_ERR_NO_FUNC_REG]      = "No function registered",
     [HALUTILS_ERR_INV_LESS_ARGS]    = "Less arguments than specified passed",
     [HALUTILS_ERR_INV_MORE_ARGS]    = "More arguments than specified passed",
-    [HALUTILS_ERR_INV_SIZE_ARG]     = "Invalid size of argument size"
+    [HALUTILS_ERR_INV_SIZE_ARG]     = "Invalid size of argument size",
+    [HALUTILS_ERR_INV_CFG]          = "Invalid configuration value",
+    [HALUTILS_ERR_SCHED]            = "Could not apply scheduling options"
 };
 
 /* Convert enumeration type to string */
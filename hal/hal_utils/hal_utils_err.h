@@ -20,6 +20,8 @@ enum _halutils_err_e
     HALUTILS_ERR_INV_LESS_ARGS,         /* Less arguments than specified passed */
     HALUTILS_ERR_INV_MORE_ARGS,         /* More arguments than specified passed */
     HALUTILS_ERR_INV_SIZE_ARG,          /* Invalid size of argument size */
+    HALUTILS_ERR_INV_CFG,               /* Invalid configuration value */
+    HALUTILS_ERR_SCHED,                 /* Could not apply scheduling options */
     HALUTILS_ERR_END
 };
 
@@ -21,6 +21,9 @@
 /* Should be autodiscovered by SDB */
 
 /* Wishbone RAW Addresses */
+/* SDB record table of the main crossbar */
+#define WB_SDB_RAW_ADDR                             0x00300000
+
 #define FMC1_130M_BASE_RAW_ADDR                     0x00310000
 
 #define FMC1_130M_CTRL_RAW_REGS                     (FMC1_130M_BASE_RAW_ADDR +  \
@@ -79,6 +82,9 @@
 #define DSP_BPM_SWAP_OFFS                           (/*BAR4_ADDR |*/ DSP_BPM_RAW_SWAP_OFFS)
 
 /* Wishbone Addresses */
+/* Flags for the addresses found in the SDB */
+#define WB_SDB_ADDR_FLAGS                           BAR4_ADDR
+
 #define FMC1_130M_BASE_ADDR                         (BAR4_ADDR | FMC1_130M_BASE_RAW_ADDR)
 
 #define FMC1_130M_CTRL_REGS                         (/*BAR4_ADDR |*/ FMC1_130M_CTRL_RAW_REGS)
@@ -18,7 +18,8 @@ static const char *llio_err [LLIO_ERR_END] =
     [LLIO_ERR_INV_FUNC_PARAM]   = "Invalid function parameter",
     [LLIO_ERR_SET_ENDP]         = "Could not change enpoint (device opened)",
     [LLIO_ERR_DEV_CLOSE]        = "Could not close device appropriately",
-    [LLIO_ERR_CONN]             = "Could establish connection to endpoint"
+    [LLIO_ERR_CONN]             = "Could establish connection to endpoint",
+    [LLIO_ERR_SOCK_OPT]         = "Could not set socket options"
 };
 
 /* Convert enumeration type to string */
@@ -9,6 +9,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <netdb.h>
 #include <inttypes.h>
 #include <netinet/in.h>
@@ -60,12 +62,19 @@
 #define LLIO_ETH_REGEX_ADDR_HIT             2
 #define LLIO_ETH_REGEX_PORT_HIT             3
 
+/* Give up on a connection attempt after this, in msec */
+#define LLIO_ETH_CONN_TIMEOUT               2000
+
 static llio_eth_type_e _llio_str_to_eth_type (const char *type_str);
 static int _llio_eth_conn (int *fd, llio_eth_type_e type, char *hostname,
         char* port);
 static void *_get_in_addr(struct sockaddr *sa);
 static ssize_t _eth_sendall (int fd, uint8_t *buf, size_t len);
 static ssize_t _eth_recvall (int fd, uint8_t *buf, size_t len);
+static int _eth_connect (int fd, const struct sockaddr *addr,
+        socklen_t addrlen);
+static bool _eth_would_block (void);
+static int _eth_wait (int fd, short events);
 static ssize_t _eth_read_generic (llio_t *self, loff_t offs, uint32_t *data,
         size_t size);
 static ssize_t _eth_write_generic (llio_t *self, loff_t offs, const uint32_t *data,
@@ -130,6 +139,104 @@ llio_err_e llio_dev_eth_destroy (llio_dev_eth_t **self_p)
     return LLIO_SUCCESS;
 }
 
+int llio_eth_get_fd (llio_t *self)
+{
+    assert (self);
+
+    if (!self->endpoint->opened || self->dev_handler == NULL) {
+        return -1;
+    }
+
+    return LLIO_ETH_HANDLER(self)->fd;
+}
+
+llio_err_e llio_eth_set_nonblock (llio_t *self, bool nonblock)
+{
+    assert (self);
+
+    llio_err_e err = LLIO_SUCCESS;
+    int fd = llio_eth_get_fd (self);
+    ASSERT_TEST(fd >= 0, "Endpoint is not opened", err_not_opened,
+            LLIO_ERR_INV_FUNC_PARAM);
+
+    int flags = fcntl (fd, F_GETFL, 0);
+    ASSERT_TEST(flags != -1, "Could not get socket flags", err_fcntl,
+            LLIO_ERR_SOCK_OPT);
+
+    flags = nonblock ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    int rc = fcntl (fd, F_SETFL, flags);
+    ASSERT_TEST(rc != -1, "Could not set socket flags", err_fcntl,
+            LLIO_ERR_SOCK_OPT);
+
+err_fcntl:
+err_not_opened:
+    return err;
+}
+
+llio_err_e llio_eth_reconnect (llio_t *self)
+{
+    assert (self);
+
+    llio_err_e err = LLIO_SUCCESS;
+    ASSERT_TEST(llio_eth_get_fd (self) >= 0, "Endpoint is not opened",
+            err_not_opened, LLIO_ERR_INV_FUNC_PARAM);
+
+    llio_dev_eth_t *dev_eth = LLIO_ETH_HANDLER(self);
+    int fd = -1;
+    int conn_err = _llio_eth_conn (&fd, dev_eth->type, dev_eth->hostname,
+            dev_eth->port);
+    ASSERT_TEST(conn_err == 0, "Could not reconnect to endpoint", err_eth_conn,
+            LLIO_ERR_CONN);
+
+    close (dev_eth->fd);
+    dev_eth->fd = fd;
+
+    DBE_DEBUG (DBG_LL_IO | DBG_LVL_INFO,
+            "[ll_io_eth] Reconnected to ETH device located at %s\n",
+            self->endpoint->name);
+
+err_eth_conn:
+err_not_opened:
+    return err;
+}
+
+ssize_t llio_eth_send_nb (llio_t *self, const uint8_t *buf, size_t len)
+{
+    assert (self);
+    assert (buf);
+
+    ssize_t n = send (LLIO_ETH_HANDLER(self)->fd, (const char *) buf, len,
+            MSG_DONTWAIT | MSG_NOSIGNAL);
+    DBE_DEBUG (DBG_LL_IO | DBG_LVL_TRACE, "[ll_io_eth] Sent %ld bytes\n", n);
+
+    if (n == -1) {
+        return (_eth_would_block ()) ? 0 : -1;
+    }
+
+    return n;
+}
+
+ssize_t llio_eth_recv_nb (llio_t *self, uint8_t *buf, size_t len)
+{
+    assert (self);
+    assert (buf);
+
+    ssize_t n = recv (LLIO_ETH_HANDLER(self)->fd, (char *) buf, len,
+            MSG_DONTWAIT);
+    DBE_DEBUG (DBG_LL_IO | DBG_LVL_TRACE, "[ll_io_eth] Received %ld bytes\n", n);
+
+    if (n == -1) {
+        return (_eth_would_block ()) ? 0 : -1;
+    }
+
+    /* Disconnected endpoint */
+    if (n == 0 && len > 0) {
+        return -1;
+    }
+
+    return n;
+}
+
 /************ llio_ops_eth Implementation **********/
 
 /* Open ETH device */
@@ -198,9 +305,14 @@ int eth_open (llio_t *self, llio_endpoint_t *endpoint)
             "[ll_io_eth] Opened ETH device located at %s\n",
             self->endpoint->name);
 
+    zrex_destroy (&endp_regex);
     return 0;
 
 err_eth_conn:
+    /* Nothing to close. The socket is gone already */
+    LLIO_ETH_HANDLER(self)->fd = -1;
+    llio_dev_eth_destroy ((llio_dev_eth_t **) &self->dev_handler);
+    self->dev_handler = NULL;
 err_dev_handler_alloc:
 err_endp_port_retrieve:
 err_endp_addr_retrieve:
@@ -363,7 +475,7 @@ static int _llio_eth_conn (int *fd, llio_eth_type_e type, char *hostname,
         ASSERT_TEST (rv == 0, "Could not set endpoint options",
                 err_setsockopt, -1);
 
-        if (connect(*fd, p->ai_addr, p->ai_addrlen) == -1) {
+        if (_eth_connect (*fd, p->ai_addr, p->ai_addrlen) == -1) {
             DBE_DEBUG (DBG_LL_IO | DBG_LVL_ERR,
                     "[ll_io_eth] Error executing connect: %s\n", strerror(errno));
             close(*fd);
@@ -414,6 +526,14 @@ static ssize_t _eth_sendall (int fd, uint8_t *buf, size_t len)
         n = send (fd, (char *) buf+total, bytesleft, 0);
         DBE_DEBUG (DBG_LL_IO | DBG_LVL_TRACE, "[ll_io_eth] Sent %ld bytes\n", n);
 
+        /* The socket might be in non-blocking mode */
+        if (n == -1 && _eth_would_block ()) {
+            if (_eth_wait (fd, POLLOUT) == -1) {
+                return -1;
+            }
+            continue;
+        }
+
         /* On error, don't try to recover, just inform it to the caller*/
         if (n == -1) {
             return -1;
@@ -438,6 +558,14 @@ static ssize_t _eth_recvall (int fd, uint8_t *buf, size_t len)
         n = recv (fd, (char *) buf+total, bytesleft, 0);
         DBE_DEBUG (DBG_LL_IO | DBG_LVL_TRACE, "[ll_io_eth] Received %ld bytes\n", n);
 
+        /* The socket might be in non-blocking mode */
+        if (n == -1 && _eth_would_block ()) {
+            if (_eth_wait (fd, POLLIN) == -1) {
+                return -1;
+            }
+            continue;
+        }
+
         /* On error, don't try to recover, just inform it to the caller*/
         if (n == -1) {
             return -1;
@@ -455,6 +583,58 @@ static ssize_t _eth_recvall (int fd, uint8_t *buf, size_t len)
     return total; /* return actual number of bytes sent here */
 }
 
+/* Same as connect (), but giving up after LLIO_ETH_CONN_TIMEOUT instead of
+ * the much longer system timeout. The socket is left as it was */
+static int _eth_connect (int fd, const struct sockaddr *addr,
+        socklen_t addrlen)
+{
+    int flags = fcntl (fd, F_GETFL, 0);
+    if (flags == -1 || fcntl (fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        return -1;
+    }
+
+    int rc = connect (fd, addr, addrlen);
+    if (rc == -1 && errno == EINPROGRESS) {
+        struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+        do {
+            rc = poll (&pfd, 1, LLIO_ETH_CONN_TIMEOUT);
+        } while (rc == -1 && errno == EINTR);
+
+        int sock_err = ETIMEDOUT;
+        socklen_t sock_err_len = sizeof (sock_err);
+        if (rc == 1) {
+            getsockopt (fd, SOL_SOCKET, SO_ERROR, &sock_err, &sock_err_len);
+        }
+
+        rc = (sock_err == 0) ? 0 : -1;
+        errno = sock_err;
+    }
+
+    if (fcntl (fd, F_SETFL, flags) == -1) {
+        rc = -1;
+    }
+
+    return rc;
+}
+
+static bool _eth_would_block (void)
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+/* Wait until the socket is ready for the blocking operations */
+static int _eth_wait (int fd, short events)
+{
+    struct pollfd pfd = {.fd = fd, .events = events};
+    int rc;
+
+    do {
+        rc = poll (&pfd, 1, -1);
+    } while (rc == -1 && errno == EINTR);
+
+    return (rc == 1 && !(pfd.revents & (POLLERR | POLLNVAL))) ? 0 : -1;
+}
+
 const llio_ops_t llio_ops_eth = {
     .open           = eth_open,         /* Open device */
     .release        = eth_release,      /* Release device */
@@ -46,4 +46,21 @@ llio_dev_eth_t * llio_dev_eth_new (const char *sock_type, const char *hostname,
 /* Destroy an instance of the Ethernet Endpoint */
 llio_err_e llio_dev_eth_destroy (llio_dev_eth_t **self_p);
 
+/* Non-blocking I/O, for event loops serving several endpoints at once. The
+ * regular read and write operations keep working on a non-blocking socket,
+ * waiting for it as needed */
+
+/* Socket of an opened endpoint, or -1 */
+int llio_eth_get_fd (llio_t *self);
+/* Connect the opened endpoint again, e.g., after the connection failed. The
+ * old socket is only replaced once the new one is connected */
+llio_err_e llio_eth_reconnect (llio_t *self);
+/* Put the socket of an opened endpoint in non-blocking mode, or back */
+llio_err_e llio_eth_set_nonblock (llio_t *self, bool nonblock);
+/* Send or receive as much as possible without blocking. Returns the number of
+ * bytes transferred (0 if the socket is not ready) or -1 on error or
+ * disconnection */
+ssize_t llio_eth_send_nb (llio_t *self, const uint8_t *buf, size_t len);
+ssize_t llio_eth_recv_nb (llio_t *self, uint8_t *buf, size_t len);
+
 #endif
@@ -20,6 +20,8 @@ struct _exp_msg_zmq_t {
     uint32_t tag;
     zmsg_t **msg;
     zframe_t *reply_to;
+    uint64_t recv_ts;       /* When the request was received, as given by
+                               smio_stats_get_ts (). 0 if unknown */
 };
 
 typedef struct _exp_msg_zmq_t exp_msg_zmq_t;
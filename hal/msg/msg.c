@@ -11,6 +11,7 @@
 #include "sm_io.h"
 #include "sm_io_exports.h"
 #include "rw_param_codes.h"
+#include "sm_io_deadline_codes.h"
 
 /* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
 #ifdef ASSERT_TEST
@@ -35,9 +36,13 @@
     CHECK_HAL_ERR(err, MSG, "[msg]",                                \
             msg_err_str (err_type))
 
+#define MSG_NS_PER_US                   1000ULL
+
 static msg_type_e _msg_guess_type (void *msg);
 static msg_err_e _msg_validate (void *msg, msg_type_e expected_msg_type);
 static msg_err_e _msg_exp_zmq_get_opcode (exp_msg_zmq_t *msg, uint32_t *opcode);
+static uint64_t _msg_exp_zmq_get_deadline (exp_msg_zmq_t *msg);
+static bool _msg_deadline_expired (uint64_t deadline_ts);
 static msg_err_e _msg_thsafe_zmq_get_opcode (zmq_server_args_t *msg, uint32_t *opcode);
 static msg_err_e _msg_gen_get_opcode (zmsg_t *zmq_msg, uint32_t *opcode);
 static msg_err_e _msg_format_client_response (int disp_table_ret,
@@ -71,7 +76,8 @@ msg_err_e msg_handle_mdp_request (void *owner, void *args,
     uint32_t opcode_data = 0;
 
     /* Our simple packet is composed of:
-     * frame 0: operation
+     * frame 0: deadline (optional)
+     * frame 1: operation
      * frame n: arguments*/
     err = _msg_validate (args, MSG_EXP_ZMQ); /* Only EXP ZMQ messages */
     /* FIXME. Improve error codes */
@@ -81,14 +87,60 @@ msg_err_e msg_handle_mdp_request (void *owner, void *args,
     /* If we are here, this is the only option */
     SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
     exp_msg_zmq_t *msg = (exp_msg_zmq_t *) args;
+    /* Get deadline, if any */
+    uint64_t deadline_ts = _msg_exp_zmq_get_deadline (msg);
     /* Get opcode */
     err = _msg_exp_zmq_get_opcode (msg, &opcode_data);
     ASSERT_TEST(err == MSG_SUCCESS, "Could not get message opcode", err_get_opcode);
 
     /* Check registered function arguments */
     void *ret = NULL;
-    int disp_table_ret = disp_table_check_call (disp_table, opcode_data, owner,
-            args, &ret);
+    bool coalesced = false;
+    /* Identical read requests that were waiting for this one might share
+     * its result, so take note of when it got here */
+    uint64_t req_ts = (msg->recv_ts != 0) ? msg->recv_ts : smio_stats_get_ts ();
+    /* Workers of a pool share the SMIO handler. Read-only calls run alongside
+     * each other, so several thsafe requests can be in flight, but anything
+     * else has the handler for itself. The reply is sent without holding
+     * the lock */
+    if (self->pool != NULL) {
+        const disp_op_t *disp_op = disp_table_lookup (disp_table, opcode_data);
+        bool shared = disp_op != NULL &&
+            !(disp_op->flags & DISP_OP_FLAG_MOD_STATE) &&
+            smio_coalesce_is_read (disp_op, args);
+        smio_pool_handler_lock (self->pool, shared);
+    }
+    int disp_table_ret = 0;
+    /* The client gave up on requests that waited too long. Don't waste
+     * time on them, so the ones behind are served sooner */
+    bool expired = _msg_deadline_expired (deadline_ts);
+    if (expired) {
+        DBE_DEBUG (DBG_MSG | DBG_LVL_INFO, "[msg] Dropping expired request "
+                "to opcode %u\n", opcode_data);
+        disp_table_ret = -SMIO_DEADLINE_EXPIRED;
+    }
+    else {
+        smio_stats_call_begin (self->stats, req_ts);
+        disp_table_ret = smio_coalesce_check_call (self->coalesce, disp_table,
+                opcode_data, owner, args, req_ts, &ret, &coalesced);
+    }
+    if (self->pool != NULL) {
+        smio_pool_handler_unlock (self->pool);
+        /* Statistics of the workers are read by the others */
+        smio_pool_lock (self->pool);
+    }
+    if (expired) {
+        smio_stats_add_expired (self->stats, opcode_data);
+    }
+    else {
+        smio_stats_call_end (self->stats, opcode_data, disp_table_ret);
+        if (coalesced) {
+            smio_stats_add_coalesced (self->stats, opcode_data);
+        }
+    }
+    if (self->pool != NULL) {
+        smio_pool_unlock (self->pool);
+    }
 
     RW_REPLY_TYPE reply_code = PARAM_ERR;
     bool with_data_frame = false;
@@ -99,10 +151,14 @@ msg_err_e msg_handle_mdp_request (void *owner, void *args,
     /* Send response back to client */
     _msg_send_client_response_mdp (reply_code, disp_table_ret, ret, with_data_frame,
            self->worker, msg->reply_to);
+    /* The reply was copied into the message, so the return value can be
+     * reused by the next call */
+    disp_table_release_ret (disp_table, &ret);
 
     return err;
 
 err_format_response:
+    disp_table_release_ret (disp_table, &ret);
 err_get_opcode:
     _msg_send_client_response_mdp (PARAM_ERR, 0, NULL, false, self->worker,
             msg->reply_to);
@@ -110,6 +166,55 @@ err_inv_msg:
     return err;
 }
 
+/* Handle MDP protocol request to an owner other than a SMIO. These are not
+ * accounted nor coalesced, as the SMIO ones */
+msg_err_e msg_handle_mdp_mngr_request (void *owner, void *args,
+        disp_table_t *disp_table, mdp_worker_t *worker)
+{
+    msg_err_e err = MSG_SUCCESS;
+    uint32_t opcode_data = 0;
+
+    /* Our simple packet is composed of:
+     * frame 0: deadline (optional)
+     * frame 1: operation
+     * frame n: arguments*/
+    err = _msg_validate (args, MSG_EXP_ZMQ); /* Only EXP ZMQ messages */
+    /* Sanity checks */
+    ASSERT_TEST(err == MSG_SUCCESS, "Could not receive opcode", err_inv_msg);
+
+    exp_msg_zmq_t *msg = (exp_msg_zmq_t *) args;
+    uint64_t deadline_ts = _msg_exp_zmq_get_deadline (msg);
+    err = _msg_exp_zmq_get_opcode (msg, &opcode_data);
+    ASSERT_TEST(err == MSG_SUCCESS, "Could not get message opcode", err_get_opcode);
+
+    void *ret = NULL;
+    int disp_table_ret = -SMIO_DEADLINE_EXPIRED;
+    if (!_msg_deadline_expired (deadline_ts)) {
+        disp_table_ret = disp_table_check_call (disp_table, opcode_data, owner,
+                args, &ret);
+    }
+
+    RW_REPLY_TYPE reply_code = PARAM_ERR;
+    bool with_data_frame = false;
+    err = _msg_format_client_response (disp_table_ret, &reply_code, &with_data_frame);
+    ASSERT_TEST(err == MSG_SUCCESS, "Could not format client response",
+            err_format_response);
+
+    _msg_send_client_response_mdp (reply_code, disp_table_ret, ret, with_data_frame,
+           worker, msg->reply_to);
+    disp_table_release_ret (disp_table, &ret);
+
+    return err;
+
+err_format_response:
+    disp_table_release_ret (disp_table, &ret);
+err_get_opcode:
+    _msg_send_client_response_mdp (PARAM_ERR, 0, NULL, false, worker,
+            msg->reply_to);
+err_inv_msg:
+    return err;
+}
+
 /* Handle regular protocol (used by DEVIOs, for instance) request */
 msg_err_e msg_handle_sock_request (void *owner, void *args,
         disp_table_t *disp_table)
@@ -145,16 +250,38 @@ msg_err_e msg_handle_sock_request (void *owner, void *args,
     /* Send response back to client */
     _msg_send_client_response_sock (reply_code, disp_table_ret, ret, with_data_frame,
            msg->reply_to);
+    /* The reply was copied into the message, so the return value can be
+     * reused by the next call */
+    disp_table_release_ret (disp_table, &ret);
 
     return err;
 
 err_format_response:
+    disp_table_release_ret (disp_table, &ret);
 err_get_opcode:
     _msg_send_client_response_sock (PARAM_ERR, 0, NULL, false, msg->reply_to);
 err_inv_msg:
     return err;
 }
 
+msg_err_e msg_send_sock_reply (void *reply_to, int disp_table_ret, void *ret)
+{
+    assert (reply_to);
+
+    RW_REPLY_TYPE reply_code = PARAM_ERR;
+    bool with_data_frame = false;
+    msg_err_e err = _msg_format_client_response (disp_table_ret, &reply_code,
+            &with_data_frame);
+    ASSERT_TEST(err == MSG_SUCCESS, "Could not format client response",
+            err_format_response);
+
+    _msg_send_client_response_sock (reply_code, disp_table_ret, ret,
+            with_data_frame, reply_to);
+
+err_format_response:
+    return err;
+}
+
 /*************************** Static Functions *****************************/
 
 static msg_type_e _msg_guess_type (void *msg)
@@ -203,6 +330,40 @@ static msg_err_e _msg_exp_zmq_get_opcode (exp_msg_zmq_t *msg, uint32_t *opcode)
     return _msg_gen_get_opcode (EXP_MSG_ZMQ(msg), opcode);
 }
 
+/* Pop the optional deadline frame and turn its time-to-live into a
+ * deadline on the smio_stats_get_ts () clock, counted from the arrival of
+ * the request. Returns 0 if there is none */
+static uint64_t _msg_exp_zmq_get_deadline (exp_msg_zmq_t *msg)
+{
+    uint64_t deadline_ts = 0;
+    zframe_t *deadline_frm = zmsg_first (EXP_MSG_ZMQ(msg));
+
+    /* The opcode frame has a different size, so there is no ambiguity */
+    if (deadline_frm == NULL || zframe_size (deadline_frm) != sizeof (smio_deadline_t)) {
+        goto no_deadline;
+    }
+
+    smio_deadline_t *deadline = (smio_deadline_t *) zframe_data (deadline_frm);
+    if (deadline->tag != SMIO_DEADLINE_TAG) {
+        goto no_deadline;
+    }
+
+    uint64_t recv_ts = (msg->recv_ts != 0) ? msg->recv_ts : smio_stats_get_ts ();
+    deadline_ts = recv_ts + deadline->ttl_us*MSG_NS_PER_US;
+    deadline_frm = zmsg_pop (EXP_MSG_ZMQ(msg));
+    msg_pool_frame_destroy (&deadline_frm);
+
+no_deadline:
+    return deadline_ts;
+}
+
+/* Monotonic, as smio_stats_get_ts (), so changes to the wall-clock time
+ * don't expire requests or keep them alive */
+static bool _msg_deadline_expired (uint64_t deadline_ts)
+{
+    return deadline_ts != 0 && smio_stats_get_ts () > deadline_ts;
+}
+
 static msg_err_e _msg_thsafe_zmq_get_opcode (zmq_server_args_t *msg, uint32_t *opcode)
 {
     return _msg_gen_get_opcode (THSAFE_MSG_ZMQ(msg), opcode);
@@ -229,12 +390,12 @@ static msg_err_e _msg_gen_get_opcode (zmsg_t *zmq_msg, uint32_t *opcode)
     ASSERT_TEST(*opcode < MSG_OPCODE_MAX, "Invalid opcode received",
             err_invalid_opcode, MSG_ERR_WRONG_ARGS);
 
-    zframe_destroy (&opcode_frm);
+    msg_pool_frame_destroy (&opcode_frm);
     return err;
 
 err_invalid_opcode:
 err_wrong_opcode_size:
-    zframe_destroy (&opcode_frm);
+    msg_pool_frame_destroy (&opcode_frm);
 err_null_opcode:
     return err;
 }
@@ -278,6 +439,8 @@ static void _msg_send_client_response_mdp (RW_REPLY_TYPE reply_code, uint32_t re
     ASSERT_TEST(msg != NULL, "Could format client message",
             err_fmt_client_message);
 
+    /* The Majordomo worker takes the message over, so it does not go
+     * back to the pool */
     mdp_worker_send (worker, &msg, reply_to);
 err_fmt_client_message:
     return;
@@ -291,7 +454,7 @@ static void _msg_send_client_response_sock (RW_REPLY_TYPE reply_code, uint32_t r
     ASSERT_TEST(msg != NULL, "Could format client message",
             err_fmt_client_message);
 
-    zmsg_send (&msg, reply_to);
+    msg_pool_msg_send (&msg, reply_to);
 err_fmt_client_message:
     return;
 }
@@ -300,7 +463,7 @@ static zmsg_t * _msg_create_client_response (RW_REPLY_TYPE reply_code, uint32_t
         uint32_t *data_out, bool with_data_frame)
 {
     /* Send reply back to client */
-    zmsg_t *report = zmsg_new ();
+    zmsg_t *report = msg_pool_msg_new ();
     ASSERT_ALLOC(report, err_send_msg_alloc);
 
     /* Message is:
@@ -308,14 +471,14 @@ static zmsg_t * _msg_create_client_response (RW_REPLY_TYPE reply_code, uint32_t
      * frame 1: size (in bytes) or return code
      * frame 2: data
      * */
-    int zerr = zmsg_addmem (report, &reply_code, sizeof(reply_code));
+    int zerr = msg_pool_msg_addmem (report, &reply_code, sizeof(reply_code));
     ASSERT_TEST(zerr==0, "Could not add reply code in message", err_reply_code);
 
     if (with_data_frame) {
-        zerr = zmsg_addmem (report, &reply_size, sizeof(reply_size));
+        zerr = msg_pool_msg_addmem (report, &reply_size, sizeof(reply_size));
         ASSERT_TEST(zerr==0, "Could not add reply size or return code in message",
                 err_size_ret);
-        zerr = zmsg_addmem (report, data_out, reply_size);
+        zerr = msg_pool_msg_addmem (report, data_out, reply_size);
         ASSERT_TEST(zerr==0, "Could not add reply data in message",
                 err_data);
     }
@@ -331,6 +494,6 @@ err_data:
 err_size_ret:
 err_reply_code:
 err_send_msg_alloc:
-    zmsg_destroy (&report);
+    msg_pool_msg_destroy (&report);
     return NULL;
 }
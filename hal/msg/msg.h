@@ -9,6 +9,7 @@
 #define _MSG_H_
 
 #include "msg_err.h"
+#include "msg_pool.h"
 /* EXP ops */
 #include "exp_msg_zmq.h"
 #include "exp_ops_codes.h"
@@ -17,6 +18,7 @@
 #include "smio_thsafe_zmq_client.h"
 
 #include "dispatch_table.h"
+#include "mdp.h"
 
 #define MSG_OPCODE_SIZE                     (sizeof (uint32_t))
 /* Arbitrary number*/
@@ -36,9 +38,18 @@ msg_err_e msg_validate (void *msg, msg_type_e expected_msg_type);
 /* Handle MDP protocol (used by SMIOs, for instance) request */
 msg_err_e msg_handle_mdp_request (void *owner, void *args,
         disp_table_t *disp_table);
+/* Handle MDP protocol request to an owner other than a SMIO, e.g., a DEVIO
+ * management one. The reply is sent through "worker" */
+msg_err_e msg_handle_mdp_mngr_request (void *owner, void *args,
+        disp_table_t *disp_table, mdp_worker_t *worker);
 /* Handle regular protocol (used by DEVIOs, for instance) request */
 msg_err_e msg_handle_sock_request (void *owner, void *args,
         disp_table_t *disp_table);
+/* Reply to a regular protocol request that was handled outside of
+ * msg_handle_sock_request (), e.g., one completed later by an event loop.
+ * disp_table_ret and ret are what the registered function would have
+ * returned */
+msg_err_e msg_send_sock_reply (void *reply_to, int disp_table_ret, void *ret);
 
 #endif
 
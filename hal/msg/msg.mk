@@ -5,6 +5,7 @@ msg_DIR = hal/msg
 
 msg_OBJS = $(msg_DIR)/msg.o \
 	   $(msg_DIR)/msg_err.o \
+	   $(msg_DIR)/msg_pool.o \
 	   $(exp_ops_OBJS) \
 	   $(smio_thsafe_ops_OBJS)
 
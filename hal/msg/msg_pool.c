@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include "msg_pool.h"
+#include "msg_err.h"
+#include "hal_assert.h"
+
+/* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
+#ifdef ASSERT_TEST
+#undef ASSERT_TEST
+#endif
+#define ASSERT_TEST(test_boolean, err_str, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_TEST(test_boolean, MSG, "[msg:pool]",                \
+            err_str, err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef ASSERT_ALLOC
+#undef ASSERT_ALLOC
+#endif
+#define ASSERT_ALLOC(ptr, err_goto_label, /* err_core */ ...)       \
+    ASSERT_HAL_ALLOC(ptr, MSG, "[msg:pool]",                        \
+            msg_err_str(MSG_ERR_ALLOC),                             \
+            err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef CHECK_ERR
+#undef CHECK_ERR
+#endif
+#define CHECK_ERR(err, err_type)                                    \
+    CHECK_HAL_ERR(err, MSG, "[msg:pool]",                           \
+            msg_err_str (err_type))
+
+struct _msg_pool_t {
+    zmsg_t *msgs [MSG_POOL_MSGS_MAX];   /* Idle (empty) messages */
+    uint32_t nmsgs;
+    zframe_t *frames [MSG_POOL_FRAMES_MAX]; /* Idle frames */
+    uint32_t nframes;
+    msg_pool_stats_t stats;
+};
+
+typedef struct _msg_pool_t msg_pool_t;
+
+/* One pool per thread */
+static __thread msg_pool_t msg_pool_tls;
+
+zmsg_t *msg_pool_msg_new (void)
+{
+    msg_pool_t *self = &msg_pool_tls;
+
+    if (self->nmsgs > 0) {
+        self->stats.msg_reuses++;
+        return self->msgs [--self->nmsgs];
+    }
+
+    zmsg_t *msg = zmsg_new ();
+    ASSERT_ALLOC(msg, err_msg_alloc);
+    self->stats.msg_allocs++;
+
+err_msg_alloc:
+    return msg;
+}
+
+void msg_pool_msg_destroy (zmsg_t **msg_p)
+{
+    assert (msg_p);
+
+    if (*msg_p) {
+        msg_pool_t *self = &msg_pool_tls;
+        zmsg_t *msg = *msg_p;
+
+        zframe_t *frame = zmsg_pop (msg);
+        for ( ; frame != NULL; frame = zmsg_pop (msg)) {
+            msg_pool_frame_destroy (&frame);
+        }
+
+        if (self->nmsgs < MSG_POOL_MSGS_MAX) {
+            self->msgs [self->nmsgs++] = msg;
+        }
+        else {
+            zmsg_destroy (&msg);
+        }
+
+        *msg_p = NULL;
+    }
+}
+
+int msg_pool_msg_addmem (zmsg_t *msg, const void *src, size_t size)
+{
+    assert (msg);
+
+    zframe_t *frame = msg_pool_frame_new (src, size);
+    ASSERT_ALLOC(frame, err_frame_alloc);
+
+    return zmsg_append (msg, &frame);
+
+err_frame_alloc:
+    return -1;
+}
+
+int msg_pool_msg_send (zmsg_t **msg_p, void *socket)
+{
+    assert (msg_p);
+    assert (socket);
+
+    zmsg_t *msg = *msg_p;
+    ASSERT_TEST(msg != NULL, "Could not send NULL message", err_null_msg);
+
+    /* Send copies of the frames, so they can all go back to the pool
+     * afterwards. Small frames are copied without touching the heap */
+    int rc = 0;
+    zframe_t *frame = zmsg_first (msg);
+    while (frame != NULL && rc == 0) {
+        zframe_t *next = zmsg_next (msg);
+        rc = zframe_send (&frame, socket, ZFRAME_REUSE |
+                ((next != NULL) ? ZFRAME_MORE : 0));
+        frame = next;
+    }
+
+    msg_pool_msg_destroy (msg_p);
+    return rc;
+
+err_null_msg:
+    return -1;
+}
+
+/* Release a part moved into a frame by _msg_pool_frame_move (). This may be
+ * called by whichever thread drops the last reference to the frame data, so
+ * the part is not kept in the pool */
+static void _msg_pool_part_free (void *data, void *arg)
+{
+    (void) data;
+    zmq_msg_t *part = (zmq_msg_t *) arg;
+
+    zmq_msg_close (part);
+    free (part);
+}
+
+/* Get a frame referencing the data of part, without copying it. The part is
+ * always consumed */
+static zframe_t *_msg_pool_frame_move (zmq_msg_t *part)
+{
+    msg_pool_t *self = &msg_pool_tls;
+    zframe_t *frame = NULL;
+
+    zmq_msg_t *moved_part = (zmq_msg_t *) zmalloc (sizeof *moved_part);
+    ASSERT_ALLOC(moved_part, err_part_alloc);
+
+    zmq_msg_init (moved_part);
+    zmq_msg_move (moved_part, part);
+
+    frame = zframe_new_zero_copy (zmq_msg_data (moved_part),
+            zmq_msg_size (moved_part), _msg_pool_part_free, moved_part);
+    ASSERT_ALLOC(frame, err_frame_alloc);
+    self->stats.frame_allocs++;
+
+    return frame;
+
+err_frame_alloc:
+    _msg_pool_part_free (NULL, moved_part);
+    return NULL;
+
+err_part_alloc:
+    zmq_msg_close (part);
+    return NULL;
+}
+
+zmsg_t *msg_pool_msg_recv (void *socket)
+{
+    assert (socket);
+
+    zmsg_t *msg = msg_pool_msg_new ();
+    ASSERT_ALLOC(msg, err_msg_alloc);
+
+    int more = 1;
+    while (more) {
+        zmq_msg_t part;
+        zmq_msg_init (&part);
+
+        if (zmq_msg_recv (&part, socket, 0) == -1) {
+            /* Interrupted */
+            zmq_msg_close (&part);
+            goto err_recv;
+        }
+
+        more = zmq_msg_more (&part);
+        zframe_t *frame = NULL;
+
+        if (zmq_msg_size (&part) <= MSG_POOL_FRAME_SIZE_MAX) {
+            frame = msg_pool_frame_new (zmq_msg_data (&part),
+                    zmq_msg_size (&part));
+            zmq_msg_close (&part);
+        }
+        else {
+            /* Big parts (e.g. block reads) are moved into the frame, instead
+             * of being copied */
+            frame = _msg_pool_frame_move (&part);
+        }
+        ASSERT_ALLOC(frame, err_frame_alloc);
+
+        zmsg_append (msg, &frame);
+    }
+
+    return msg;
+
+err_frame_alloc:
+err_recv:
+    msg_pool_msg_destroy (&msg);
+err_msg_alloc:
+    return NULL;
+}
+
+zframe_t *msg_pool_frame_new (const void *src, size_t size)
+{
+    msg_pool_t *self = &msg_pool_tls;
+
+    if (self->nframes > 0 && size <= MSG_POOL_FRAME_SIZE_MAX &&
+            (src != NULL || size == 0)) {
+        zframe_t *frame = self->frames [--self->nframes];
+        zframe_reset (frame, src, size);
+        self->stats.frame_reuses++;
+        return frame;
+    }
+
+    zframe_t *frame = zframe_new (src, size);
+    ASSERT_ALLOC(frame, err_frame_alloc);
+    self->stats.frame_allocs++;
+
+err_frame_alloc:
+    return frame;
+}
+
+void msg_pool_frame_destroy (zframe_t **frame_p)
+{
+    assert (frame_p);
+
+    if (*frame_p) {
+        msg_pool_t *self = &msg_pool_tls;
+
+        /* Don't hold on to big buffers */
+        if (self->nframes < MSG_POOL_FRAMES_MAX &&
+                zframe_size (*frame_p) <= MSG_POOL_FRAME_SIZE_MAX) {
+            self->frames [self->nframes++] = *frame_p;
+            *frame_p = NULL;
+        }
+        else {
+            zframe_destroy (frame_p);
+        }
+    }
+}
+
+void msg_pool_get_stats (msg_pool_stats_t *stats)
+{
+    assert (stats);
+    *stats = msg_pool_tls.stats;
+}
+
+void msg_pool_release (void)
+{
+    msg_pool_t *self = &msg_pool_tls;
+
+    DBE_DEBUG (DBG_MSG | DBG_LVL_INFO, "[msg:pool] Releasing pool. "
+            "Messages: %"PRIu64" allocated, %"PRIu64" reused. "
+            "Frames: %"PRIu64" allocated, %"PRIu64" reused\n",
+            self->stats.msg_allocs, self->stats.msg_reuses,
+            self->stats.frame_allocs, self->stats.frame_reuses);
+
+    for ( ; self->nmsgs > 0; --self->nmsgs) {
+        zmsg_destroy (&self->msgs [self->nmsgs-1]);
+    }
+
+    for ( ; self->nframes > 0; --self->nframes) {
+        zframe_destroy (&self->frames [self->nframes-1]);
+    }
+}
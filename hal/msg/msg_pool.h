@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+/* Per-thread free lists of czmq messages and small frames. Every register
+ * access goes through a few of them (request, opcode and argument frames,
+ * reply), so recycling them keeps the request paths off the heap.
+ *
+ * The free lists are thread-local, so no locking is involved. Objects
+ * taken from a thread's pool may be given back by that same thread only */
+
+#ifndef _MSG_POOL_H_
+#define _MSG_POOL_H_
+
+#include <inttypes.h>
+#include <czmq.h>
+
+/* Frames up to this size are stored inline by ZeroMQ, so a recycled frame
+ * does not touch the heap when it is reset. Bigger ones are not kept */
+#define MSG_POOL_FRAME_SIZE_MAX             29
+/* Maximum number of idle objects kept by each thread */
+#define MSG_POOL_FRAMES_MAX                 64
+#define MSG_POOL_MSGS_MAX                   16
+
+struct _msg_pool_stats_t {
+    uint64_t msg_allocs;                /* Messages allocated from the heap */
+    uint64_t msg_reuses;                /* Messages taken from the free list */
+    uint64_t frame_allocs;              /* Frames allocated from the heap */
+    uint64_t frame_reuses;              /* Frames taken from the free list */
+};
+
+typedef struct _msg_pool_stats_t msg_pool_stats_t;
+
+/* Get an empty message */
+zmsg_t *msg_pool_msg_new (void);
+/* Give a message and all of its frames back to the pool */
+void msg_pool_msg_destroy (zmsg_t **msg_p);
+/* Same as zmsg_addmem (), but with a recycled frame */
+int msg_pool_msg_addmem (zmsg_t *msg, const void *src, size_t size);
+/* Same as zmsg_send (). The message is given back to the pool, even if it
+ * could not be sent */
+int msg_pool_msg_send (zmsg_t **msg_p, void *socket);
+/* Same as zmsg_recv (), but with recycled objects. Parts bigger than
+ * MSG_POOL_FRAME_SIZE_MAX are handed to their frames without a copy */
+zmsg_t *msg_pool_msg_recv (void *socket);
+
+/* Get a frame with a copy of the size bytes at src */
+zframe_t *msg_pool_frame_new (const void *src, size_t size);
+/* Give a frame back to the pool */
+void msg_pool_frame_destroy (zframe_t **frame_p);
+
+/* Get the counters of the calling thread */
+void msg_pool_get_stats (msg_pool_stats_t *stats);
+/* Free the idle objects of the calling thread. Must be called before
+ * the thread exits */
+void msg_pool_release (void);
+
+#endif
@@ -8,6 +8,7 @@
 #include "smio_thsafe_zmq_client.h"
 #include "hal_assert.h"
 #include "msg_err.h"
+#include "msg_pool.h"
 
 /* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
 #ifdef ASSERT_TEST
@@ -91,7 +92,7 @@ ssize_t thsafe_zmq_client_read_block (smio_t *self, loff_t offs, size_t size, ui
 {
     assert (self);
     ssize_t ret_size = -1;
-    zmsg_t *send_msg = zmsg_new ();
+    zmsg_t *send_msg = msg_pool_msg_new ();
     ASSERT_ALLOC(send_msg, err_msg_alloc);
     uint32_t opcode = THSAFE_OPCODE_READ_BLOCK;
 
@@ -101,13 +102,13 @@ ssize_t thsafe_zmq_client_read_block (smio_t *self, loff_t offs, size_t size, ui
      * frame 0: READ_BLOCK opcode
      * frame 1: offset
      * frame 2: number of bytes to be read */
-    int zerr = zmsg_addmem (send_msg, &opcode, sizeof (opcode));
+    int zerr = msg_pool_msg_addmem (send_msg, &opcode, sizeof (opcode));
     ASSERT_TEST(zerr == 0, "Could not add READ opcode in message",
             err_add_opcode);
-    zerr = zmsg_addmem (send_msg, &offs, sizeof (offs));
+    zerr = msg_pool_msg_addmem (send_msg, &offs, sizeof (offs));
     ASSERT_TEST(zerr == 0, "Could not add offset in message",
             err_add_offset);
-    zerr = zmsg_addmem (send_msg, &size, sizeof (size));
+    zerr = msg_pool_msg_addmem (send_msg, &size, sizeof (size));
     ASSERT_TEST(zerr == 0, "Could not add size in message",
             err_add_size);
 
@@ -116,7 +117,7 @@ ssize_t thsafe_zmq_client_read_block (smio_t *self, loff_t offs, size_t size, ui
     debug_log_print_zmq_msg (send_msg);
 #endif
 
-    zerr = zmsg_send (&send_msg, self->pipe);
+    zerr = msg_pool_msg_send (&send_msg, self->pipe);
     ASSERT_TEST(zerr == 0, "Could not send message", err_send_msg);
 
     /* Message is:
@@ -129,7 +130,7 @@ err_send_msg:
 err_add_size:
 err_add_offset:
 err_add_opcode:
-    zmsg_destroy (&send_msg);
+    msg_pool_msg_destroy (&send_msg);
 err_msg_alloc:
     return ret_size;
 }
@@ -138,7 +139,7 @@ err_msg_alloc:
 ssize_t thsafe_zmq_client_write_block (smio_t *self, loff_t offs, size_t size, const uint32_t *data)
 {
     assert (self);
-    zmsg_t *send_msg = zmsg_new ();
+    zmsg_t *send_msg = msg_pool_msg_new ();
     ASSERT_ALLOC(send_msg, err_msg_alloc);
     uint32_t opcode = THSAFE_OPCODE_WRITE_BLOCK;
 
@@ -149,13 +150,13 @@ ssize_t thsafe_zmq_client_write_block (smio_t *self, loff_t offs, size_t size, c
      * frame 1: offset
      * frame 2: data to be written
      * */
-    int zerr = zmsg_addmem (send_msg, &opcode, sizeof (opcode));
+    int zerr = msg_pool_msg_addmem (send_msg, &opcode, sizeof (opcode));
     ASSERT_TEST(zerr == 0, "Could not add WRITE opcode in message",
             err_add_opcode);
-    zerr = zmsg_addmem (send_msg, &offs, sizeof (offs));
+    zerr = msg_pool_msg_addmem (send_msg, &offs, sizeof (offs));
     ASSERT_TEST(zerr == 0, "Could not add offset in message",
             err_add_offset);
-    zerr = zmsg_addmem (send_msg, data, size);
+    zerr = msg_pool_msg_addmem (send_msg, data, size);
     ASSERT_TEST(zerr == 0, "Could not add data in message",
             err_add_data);
 
@@ -164,7 +165,7 @@ ssize_t thsafe_zmq_client_write_block (smio_t *self, loff_t offs, size_t size, c
     debug_log_print_zmq_msg (send_msg);
 #endif
 
-    zerr = zmsg_send (&send_msg, self->pipe);
+    zerr = msg_pool_msg_send (&send_msg, self->pipe);
     ASSERT_TEST(zerr == 0, "Could not send message", err_send_msg);
 
     /* Message is:
@@ -177,7 +178,7 @@ ssize_t thsafe_zmq_client_write_block (smio_t *self, loff_t offs, size_t size, c
     ASSERT_TEST(ret_size == sizeof (ret_data), "Data size does not match the expected",
             err_data_size);
 
-    zmsg_destroy (&send_msg);
+    msg_pool_msg_destroy (&send_msg);
     return ret_data;
 
 err_data_size:
@@ -185,7 +186,7 @@ err_send_msg:
 err_add_data:
 err_add_offset:
 err_add_opcode:
-    zmsg_destroy (&send_msg);
+    msg_pool_msg_destroy (&send_msg);
 err_msg_alloc:
     return -1;
 }
@@ -224,17 +225,17 @@ int _thsafe_zmq_client_open_release (smio_t *self, llio_endpoint_t *endpoint, ui
 {
     assert (self);
     int ret = -1;
-    zmsg_t *send_msg = zmsg_new ();
+    zmsg_t *send_msg = msg_pool_msg_new ();
     ASSERT_ALLOC(send_msg, err_msg_alloc);
 
     DBE_DEBUG (DBG_MSG | DBG_LVL_TRACE, "[smio_thsafe_client:zmq] Calling thsafe_release\n");
     /* Message is:
      * frame 0: RELEASE opcode
      * frame 1: endpopint struct (FIXME?) */
-    int zerr = zmsg_addmem (send_msg, &opcode, sizeof (opcode));
+    int zerr = msg_pool_msg_addmem (send_msg, &opcode, sizeof (opcode));
     ASSERT_TEST(zerr == 0, "Could not add OPEN opcode in message",
             err_add_opcode);
-    zerr = zmsg_addmem (send_msg, endpoint, sizeof (*endpoint));
+    zerr = msg_pool_msg_addmem (send_msg, endpoint, sizeof (*endpoint));
     ASSERT_TEST(zerr == 0, "Could not add endpoint in message",
             err_add_endpoint);
 
@@ -242,7 +243,7 @@ int _thsafe_zmq_client_open_release (smio_t *self, llio_endpoint_t *endpoint, ui
 #ifdef LOCAL_MSG_DBG
     debug_log_print_zmq_msg (send_msg);
 #endif
-    zerr = zmsg_send (&send_msg, self->pipe);
+    zerr = msg_pool_msg_send (&send_msg, self->pipe);
     ASSERT_TEST(zerr == 0, "Could not send message", err_send_msg);
 
     /* Message is:
@@ -270,14 +271,14 @@ int _thsafe_zmq_client_open_release (smio_t *self, llio_endpoint_t *endpoint, ui
     DBE_DEBUG (DBG_MSG | DBG_LVL_TRACE, "[smio_thsafe_client:zmq] Received return code: %08X\n", ret);
 
 err_recv_data_size:
-    zframe_destroy (&ret_code_frame);
+    msg_pool_frame_destroy (&ret_code_frame);
 err_recv_data:
 err_null_raw_data:
-    zmsg_destroy (&recv_msg);
+    msg_pool_msg_destroy (&recv_msg);
 err_send_msg:
 err_add_endpoint:
 err_add_opcode:
-    zmsg_destroy (&send_msg);
+    msg_pool_msg_destroy (&send_msg);
 err_msg_alloc:
     return ret;
 }
@@ -287,7 +288,7 @@ static ssize_t _thsafe_zmq_client_read_generic (smio_t *self, loff_t offs, uint8
 {
     assert (self);
     ssize_t ret_size = -1;
-    zmsg_t *send_msg = zmsg_new ();
+    zmsg_t *send_msg = msg_pool_msg_new ();
     ASSERT_ALLOC(send_msg, err_msg_alloc);
     uint32_t opcode;
 
@@ -313,10 +314,10 @@ static ssize_t _thsafe_zmq_client_read_generic (smio_t *self, loff_t offs, uint8
     /* Message is:
      * frame 0: READ<size> opcode
      * frame 1: offset */
-    int zerr = zmsg_addmem (send_msg, &opcode, sizeof (opcode));
+    int zerr = msg_pool_msg_addmem (send_msg, &opcode, sizeof (opcode));
     ASSERT_TEST(zerr == 0, "Could not add READ opcode in message",
             err_add_opcode);
-    zerr = zmsg_addmem (send_msg, &offs, sizeof (offs));
+    zerr = msg_pool_msg_addmem (send_msg, &offs, sizeof (offs));
     ASSERT_TEST(zerr == 0, "Could not add offset in message",
             err_add_offset);
 
@@ -325,7 +326,7 @@ static ssize_t _thsafe_zmq_client_read_generic (smio_t *self, loff_t offs, uint8
     debug_log_print_zmq_msg (send_msg);
 #endif
 
-    zerr = zmsg_send (&send_msg, self->pipe);
+    zerr = msg_pool_msg_send (&send_msg, self->pipe);
     ASSERT_TEST(zerr == 0, "Could not send message", err_send_msg);
 
     /* Message is:
@@ -337,7 +338,7 @@ static ssize_t _thsafe_zmq_client_read_generic (smio_t *self, loff_t offs, uint8
 err_send_msg:
 err_add_offset:
 err_add_opcode:
-    zmsg_destroy (&send_msg);
+    msg_pool_msg_destroy (&send_msg);
 err_msg_alloc:
     return ret_size;
 }
@@ -346,7 +347,7 @@ static ssize_t _thsafe_zmq_client_write_generic (smio_t *self, loff_t offs, cons
         uint32_t size)
 {
     assert (self);
-    zmsg_t *send_msg = zmsg_new ();
+    zmsg_t *send_msg = msg_pool_msg_new ();
     ASSERT_ALLOC(send_msg, err_msg_alloc);
     uint32_t opcode;
 
@@ -374,13 +375,13 @@ static ssize_t _thsafe_zmq_client_write_generic (smio_t *self, loff_t offs, cons
      * frame 1: offset
      * frame 2: data to be written
      * */
-    int zerr = zmsg_addmem (send_msg, &opcode, sizeof (opcode));
+    int zerr = msg_pool_msg_addmem (send_msg, &opcode, sizeof (opcode));
     ASSERT_TEST(zerr == 0, "Could not add WRITE opcode in message",
             err_add_opcode);
-    zerr = zmsg_addmem (send_msg, &offs, sizeof (offs));
+    zerr = msg_pool_msg_addmem (send_msg, &offs, sizeof (offs));
     ASSERT_TEST(zerr == 0, "Could not add offset in message",
             err_add_offset);
-    zerr = zmsg_addmem (send_msg, data, size);
+    zerr = msg_pool_msg_addmem (send_msg, data, size);
     ASSERT_TEST(zerr == 0, "Could not add READ opcode in message",
             err_add_data);
 
@@ -389,7 +390,7 @@ static ssize_t _thsafe_zmq_client_write_generic (smio_t *self, loff_t offs, cons
     debug_log_print_zmq_msg (send_msg);
 #endif
 
-    zerr = zmsg_send (&send_msg, self->pipe);
+    zerr = msg_pool_msg_send (&send_msg, self->pipe);
     ASSERT_TEST(zerr == 0, "Could not send message",
             err_send_msg);
 
@@ -403,7 +404,7 @@ static ssize_t _thsafe_zmq_client_write_generic (smio_t *self, loff_t offs, cons
     ASSERT_TEST(ret_size == sizeof (ret_data), "Data size does not match the expected",
             err_data_size);
 
-    zmsg_destroy (&send_msg);
+    msg_pool_msg_destroy (&send_msg);
     return ret_data;
 
 err_data_size:
@@ -411,7 +412,7 @@ err_send_msg:
 err_add_data:
 err_add_offset:
 err_add_opcode:
-    zmsg_destroy (&send_msg);
+    msg_pool_msg_destroy (&send_msg);
 err_msg_alloc:
     return -1;
 }
@@ -422,7 +423,9 @@ static zmsg_t *_thsafe_zmq_client_recv_confirmation (smio_t *self)
 
     assert (self);
     /* Wait for response */
-    zmsg_t *recv_msg = zmsg_recv (self->pipe);
+    uint64_t wait_start_ts = smio_stats_get_ts ();
+    zmsg_t *recv_msg = msg_pool_msg_recv (self->pipe);
+    smio_stats_add_thsafe_wait (self->stats, smio_stats_get_ts () - wait_start_ts);
     /* Do not pop the message, just set a cursor to it */
     zframe_t *reply_frame = zmsg_first (recv_msg);
 
@@ -455,7 +458,7 @@ static zmsg_t *_thsafe_zmq_client_recv_confirmation (smio_t *self)
 err_reply_code_not_ok:
 err_null_raw_data:
 err_recv_data:
-    zmsg_destroy (&recv_msg);
+    msg_pool_msg_destroy (&recv_msg);
     return NULL;
 }
 
@@ -472,7 +475,7 @@ static ssize_t _thsafe_zmq_client_recv_rw (smio_t *self, uint8_t *data,
 
     /* If we are here, confirmation code was OK. Check for second frame */
     zframe_t *reply_frame = zmsg_pop (recv_msg);
-    zframe_destroy (&reply_frame); /* Don't do anything with the reply code */
+    msg_pool_frame_destroy (&reply_frame); /* Don't do anything with the reply code */
 
     zframe_t *return_frame = zmsg_pop (recv_msg);
     zframe_t *data_frame = NULL;
@@ -516,12 +519,12 @@ static ssize_t _thsafe_zmq_client_recv_rw (smio_t *self, uint8_t *data,
             "successfully\n");
 err_buf_size_data:
 err_data_frame_size:
-    zframe_destroy (&data_frame);
+    msg_pool_frame_destroy (&data_frame);
 err_recv_data:
 err_wrong_size_ret_frame:
-    zframe_destroy (&return_frame);
+    msg_pool_frame_destroy (&return_frame);
 err_null_ret_code_frame:
-    zmsg_destroy (&recv_msg);
+    msg_pool_msg_destroy (&recv_msg);
 err_null_recv_msg:
     return ret_size;
 }
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ *
+ * The bus walk is based on the one available in the wrpc-sw reposytory at
+ * http://www.ohwr.org/projects/wrpc-sw/repository
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdb.h"
+#include "hal_assert.h"
+
+/* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
+#ifdef ASSERT_TEST
+#undef ASSERT_TEST
+#endif
+#define ASSERT_TEST(test_boolean, err_str, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_TEST(test_boolean, DEV_IO, "[sdb]",                  \
+            err_str, err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef ASSERT_ALLOC
+#undef ASSERT_ALLOC
+#endif
+#define ASSERT_ALLOC(ptr, err_goto_label, /* err_core */ ...)       \
+    ASSERT_HAL_ALLOC(ptr, DEV_IO, "[sdb]",                          \
+            "Could not allocate memory",                            \
+            err_goto_label, /* err_core */ __VA_ARGS__)
+
+/* Word offsets inside a record */
+#define SDB_W_MAGIC                 0
+#define SDB_W_RECORDS               1
+#define SDB_W_BRIDGE_CHILD          0
+#define SDB_W_ADDR_FIRST            2
+#define SDB_W_ADDR_LAST             4
+#define SDB_W_VENDOR_ID             6
+#define SDB_W_DEVICE_ID             8
+#define SDB_W_NAME                  11
+#define SDB_W_RECORD_TYPE           15
+
+#define SDB_RECORDS_R(word)         (((word) >> 16) & 0xFFFF)
+#define SDB_RECORD_TYPE_R(word)     ((word) & 0xFF)
+#define SDB_W64(rec, word)          ((((uint64_t) (rec) [word]) << 32) | \
+                                        (rec) [(word)+1])
+
+static ssize_t _sdb_get_devices (llio_t *llio, loff_t table_addr, uint64_t base,
+        loff_t addr_flags, sdb_dev_t *devs, size_t max_devs, size_t num_devs,
+        sdb_tables_t *tables, unsigned int depth);
+static void _sdb_get_name (const uint32_t *rec, char *name);
+
+ssize_t sdb_read_table (llio_t *llio, loff_t addr, uint32_t **table_p)
+{
+    assert (llio);
+    assert (table_p);
+
+    ssize_t num_records = -1;
+    uint32_t *table = NULL;
+    uint32_t header [SDB_RECORD_WORDS];
+
+    /* Interconnect record first, so we know how many records there are */
+    ssize_t llio_ret = llio_read_block (llio, addr, sizeof (header), header);
+    ASSERT_TEST(llio_ret == sizeof (header), "Could not read SDB interconnect record",
+            err_read_header);
+    ASSERT_TEST(header [SDB_W_MAGIC] == SDB_MAGIC, "Invalid SDB magic number",
+            err_read_header);
+
+    size_t records = SDB_RECORDS_R(header [SDB_W_RECORDS]);
+    ASSERT_TEST(records > 0, "Empty SDB record table", err_read_header);
+
+    table = malloc (records*SDB_RECORD_SIZE);
+    ASSERT_ALLOC(table, err_table_alloc);
+
+    llio_ret = llio_read_block (llio, addr, records*SDB_RECORD_SIZE, table);
+    ASSERT_TEST(llio_ret == (ssize_t) (records*SDB_RECORD_SIZE),
+            "Could not read SDB record table", err_read_table);
+
+    *table_p = table;
+    num_records = records;
+    return num_records;
+
+err_read_table:
+    free (table);
+err_table_alloc:
+err_read_header:
+    return num_records;
+}
+
+uint32_t sdb_checksum (const uint32_t *table, size_t size)
+{
+    return sdb_checksum_update (0, table, size);
+}
+
+uint32_t sdb_checksum_update (uint32_t checksum, const uint32_t *table,
+        size_t size)
+{
+    assert (table);
+
+    const uint8_t *data = (const uint8_t *) table;
+    uint32_t crc = ~checksum;
+
+    size_t i;
+    for (i = 0; i < size; ++i) {
+        crc ^= data [i];
+
+        unsigned int bit;
+        for (bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+
+    return ~crc;
+}
+
+ssize_t sdb_get_devices (llio_t *llio, loff_t sdb_addr, loff_t addr_flags,
+        sdb_dev_t *devs, size_t max_devs, sdb_tables_t *tables)
+{
+    assert (llio);
+    assert (devs);
+
+    if (tables != NULL) {
+        tables->num_tables = 0;
+        tables->checksum = 0;
+    }
+
+    /* The root bus starts at address 0 */
+    return _sdb_get_devices (llio, sdb_addr, 0, addr_flags, devs, max_devs, 0,
+            tables, 0);
+}
+
+bool sdb_check_tables (llio_t *llio, loff_t addr_flags,
+        const sdb_tables_t *tables)
+{
+    assert (llio);
+    assert (tables);
+
+    bool valid = false;
+    uint32_t checksum = 0;
+    uint32_t *table = NULL;
+
+    ASSERT_TEST(tables->num_tables > 0 && tables->num_tables <= SDB_MAX_TABLES,
+            "SDB tables were not all stored", err_num_tables);
+
+    size_t i;
+    for (i = 0; i < tables->num_tables; ++i) {
+        size_t size = tables->table [i].records*SDB_RECORD_SIZE;
+        ASSERT_TEST(size > 0, "Empty SDB record table", err_read_table);
+
+        table = malloc (size);
+        ASSERT_ALLOC(table, err_table_alloc);
+
+        /* We already know the size, so the whole table is read at once.
+         * A different number of records changes the checksum as well */
+        ssize_t llio_ret = llio_read_block (llio,
+                tables->table [i].addr | addr_flags, size, table);
+        ASSERT_TEST(llio_ret == (ssize_t) size, "Could not read SDB record table",
+                err_read_table);
+        ASSERT_TEST(table [SDB_W_MAGIC] == SDB_MAGIC &&
+                SDB_RECORDS_R(table [SDB_W_RECORDS]) == tables->table [i].records,
+                "SDB record table has changed", err_read_table);
+
+        checksum = sdb_checksum_update (checksum, table, size);
+        free (table);
+        table = NULL;
+    }
+
+    valid = (checksum == tables->checksum);
+
+err_read_table:
+    free (table);
+err_table_alloc:
+err_num_tables:
+    return valid;
+}
+
+/**************** Helper Functions ***************/
+
+static ssize_t _sdb_get_devices (llio_t *llio, loff_t table_addr, uint64_t base,
+        loff_t addr_flags, sdb_dev_t *devs, size_t max_devs, size_t num_devs,
+        sdb_tables_t *tables, unsigned int depth)
+{
+    ssize_t ret = -1;
+    uint32_t *table = NULL;
+
+    ASSERT_TEST(depth <= SDB_MAX_DEPTH, "Too many nested SDB bridges",
+            err_depth);
+
+    ssize_t num_records = sdb_read_table (llio, table_addr | addr_flags, &table);
+    ASSERT_TEST(num_records > 0, "Could not read SDB record table",
+            err_read_table);
+
+    if (tables != NULL) {
+        if (tables->num_tables < SDB_MAX_TABLES) {
+            tables->table [tables->num_tables].addr = table_addr;
+            tables->table [tables->num_tables].records = num_records;
+        }
+        tables->num_tables++;
+        tables->checksum = sdb_checksum_update (tables->checksum, table,
+                num_records*SDB_RECORD_SIZE);
+    }
+
+    /* Skip the interconnect record */
+    ssize_t i;
+    for (i = 1; i < num_records; ++i) {
+        const uint32_t *rec = table + i*SDB_RECORD_WORDS;
+
+        switch (SDB_RECORD_TYPE_R(rec [SDB_W_RECORD_TYPE])) {
+            case SDB_DEVICE:
+                if (num_devs >= max_devs) {
+                    DBE_DEBUG (DBG_DEV_IO | DBG_LVL_WARN, "[sdb] Too many SDB "
+                            "devices. Ignoring the remaining ones\n");
+                    break;
+                }
+
+                devs [num_devs].vendor_id = SDB_W64(rec, SDB_W_VENDOR_ID);
+                devs [num_devs].device_id = rec [SDB_W_DEVICE_ID];
+                devs [num_devs].addr_first = base + SDB_W64(rec, SDB_W_ADDR_FIRST);
+                devs [num_devs].addr_last = base + SDB_W64(rec, SDB_W_ADDR_LAST);
+                _sdb_get_name (rec, devs [num_devs].name);
+
+                DBE_DEBUG (DBG_DEV_IO | DBG_LVL_TRACE, "[sdb] Found device %s, "
+                        "vendor 0x%016"PRIX64", device 0x%08X at 0x%08"PRIX64"\n",
+                        devs [num_devs].name, devs [num_devs].vendor_id,
+                        devs [num_devs].device_id, devs [num_devs].addr_first);
+                num_devs++;
+                break;
+
+            case SDB_BRIDGE:
+                {
+                    /* Child addresses are relative to the bridge */
+                    uint64_t child_base = base + SDB_W64(rec, SDB_W_ADDR_FIRST);
+                    loff_t child_table = base + SDB_W64(rec, SDB_W_BRIDGE_CHILD);
+
+                    ssize_t child_devs = _sdb_get_devices (llio, child_table,
+                            child_base, addr_flags, devs, max_devs, num_devs,
+                            tables, depth+1);
+                    ASSERT_TEST(child_devs >= 0, "Could not walk SDB bridge",
+                            err_child_devs);
+                    num_devs = child_devs;
+                    break;
+                }
+
+            default:
+                /* Interconnect, empty and meta-information records */
+                break;
+        }
+    }
+
+    ret = num_devs;
+
+err_child_devs:
+    free (table);
+err_read_table:
+err_depth:
+    return ret;
+}
+
+/* Names are 19 big-endian bytes, padded with spaces, starting at
+ * word SDB_W_NAME */
+static void _sdb_get_name (const uint32_t *rec, char *name)
+{
+    size_t i;
+    for (i = 0; i < SDB_NAME_SIZE; ++i) {
+        uint32_t word = rec [SDB_W_NAME + i/sizeof (uint32_t)];
+        name [i] = (word >> (24 - 8*(i % sizeof (uint32_t)))) & 0xFF;
+    }
+
+    /* Strip the padding */
+    name [SDB_NAME_SIZE] = '\0';
+    for (i = SDB_NAME_SIZE; i > 0 && (name [i-1] == ' ' || name [i-1] == '\0'); --i) {
+        name [i-1] = '\0';
+    }
+}
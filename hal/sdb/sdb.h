@@ -12,12 +12,28 @@
 #define _SDB_H_
 
 #include <inttypes.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "ll_io.h"
 
 #define SDB_INTERCONNET             0x00
 #define SDB_DEVICE                  0x01
 #define SDB_BRIDGE                  0x02
+#define SDB_INTEGRATION             0x80
+#define SDB_REPO_URL                0x81
+#define SDB_SYNTHESIS               0x82
 #define SDB_EMPTY                   0xFF
 
+#define SDB_MAGIC                   0x5344422D      /* "SDB-" */
+#define SDB_RECORD_SIZE             64              /* in bytes */
+#define SDB_RECORD_WORDS            (SDB_RECORD_SIZE/sizeof (uint32_t))
+#define SDB_NAME_SIZE               19
+/* Maximum number of bridges we follow from the root interconnect */
+#define SDB_MAX_DEPTH               4
+/* Maximum number of record tables remembered by a walk */
+#define SDB_MAX_TABLES              16
+
 typedef struct pair64 {
     uint32_t high;
     uint32_t low;
@@ -71,4 +87,66 @@ typedef union sdb_record {
     struct sdb_interconnect interconnect;
 } sdb_record_t;
 
+/* The structures above describe the records as they are laid out in
+ * the device memory (big-endian). As we read them through llio, 32 bits
+ * at a time, we get each word already in host order. So, we parse the
+ * records word by word instead of overlaying these structures */
+
+/* Device found while walking the SDB tree */
+struct _sdb_dev_t {
+    uint64_t vendor_id;             /* SDB vendor ID */
+    uint32_t device_id;             /* SDB device ID */
+    uint64_t addr_first;            /* Absolute first address, without
+                                       any llio address flags */
+    uint64_t addr_last;             /* Absolute last address */
+    char name [SDB_NAME_SIZE+1];    /* NULL-terminated device name */
+};
+
+typedef struct _sdb_dev_t sdb_dev_t;
+
+/* Record table visited while walking the SDB tree */
+struct _sdb_table_t {
+    uint64_t addr;                  /* Table address, without any llio
+                                       address flags */
+    uint32_t records;               /* Number of records, including the
+                                       interconnect one */
+};
+
+typedef struct _sdb_table_t sdb_table_t;
+
+/* Every record table visited while walking the SDB tree, in walk order */
+struct _sdb_tables_t {
+    sdb_table_t table [SDB_MAX_TABLES];
+    size_t num_tables;              /* Number of tables visited. Only the
+                                       first SDB_MAX_TABLES are stored */
+    uint32_t checksum;              /* Checksum of all tables visited */
+};
+
+typedef struct _sdb_tables_t sdb_tables_t;
+
+/* Read the whole SDB record table at llio address "addr", including the
+ * interconnect record. On success, returns the number of records and
+ * the allocated table in "table_p", owned by the caller. Returns a
+ * negative value on error */
+ssize_t sdb_read_table (llio_t *llio, loff_t addr, uint32_t **table_p);
+/* Checksum (CRC-32) of "size" bytes of a SDB record table */
+uint32_t sdb_checksum (const uint32_t *table, size_t size);
+/* Continue the checksum "checksum" of previous tables with "size" bytes
+ * of another one. sdb_checksum () is the same as starting from 0 */
+uint32_t sdb_checksum_update (uint32_t checksum, const uint32_t *table,
+        size_t size);
+/* Walk the SDB tree, starting at the root record table at "sdb_addr"
+ * and following bridges, and store up to "max_devs" devices found in
+ * "devs". "addr_flags" is ORed to every address passed to llio (e.g., the
+ * PCIe BAR number). If "tables" is not NULL, the record tables visited and
+ * their checksum are stored in it. Returns the number of devices found or
+ * a negative value on error */
+ssize_t sdb_get_devices (llio_t *llio, loff_t sdb_addr, loff_t addr_flags,
+        sdb_dev_t *devs, size_t max_devs, sdb_tables_t *tables);
+/* Read again the record tables from a previous walk, one read per table,
+ * and check that they are all unchanged. Returns false if any of them
+ * differs, could not be read or was not stored in "tables" */
+bool sdb_check_tables (llio_t *llio, loff_t addr_flags,
+        const sdb_tables_t *tables);
+
 #endif
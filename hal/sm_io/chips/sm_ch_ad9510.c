@@ -14,6 +14,7 @@
 #include "sm_ch_ad9510.h"
 #include "sm_pr.h"
 #include "hal_assert.h"
+#include "hal_stddef.h"
 #include "ad9510_regs.h"
 #include "sm_ch_ad9510_defaults.h"
 
@@ -53,6 +54,87 @@ static ssize_t _smch_ad9510_read_8 (smch_ad9510_t *self, uint8_t addr,
 static smch_err_e _smch_ad9510_init (smch_ad9510_t *self);
 static bool _smch_ad9510_wait_completion (smch_ad9510_t *self, unsigned int tries);
 static smch_err_e _smch_ad9510_reg_update (smch_ad9510_t *self);
+static void _smch_ad9510_write_regs (smch_ad9510_t *self,
+        const smch_ad9510_reg_t *regs, size_t num_regs);
+static smch_err_e _smch_ad9510_match_regs (smch_ad9510_t *self,
+        const smch_ad9510_reg_t *regs, size_t num_regs, bool *match);
+
+/* Default function pin configuration: SYNCB */
+#define SMCH_AD9510_DFLT_FUNCTION           AD9510_FUNCTION_FUNC_SEL_W(0x1)
+
+/* Registers set up by smch_ad9510_cfg_defaults () before the first update */
+static const smch_ad9510_reg_t _smch_ad9510_dflt_pll_regs [] = {
+    /* Setup A and B PLL divider. MSB part of B first */
+    {AD9510_REG_PLL_A_COUNTER, AD9510_PLL_A_COUNTER_W(0)},
+    {AD9510_REG_PLL_B_MSB_COUNTER, AD9510_PLL_B_MSB_COUNTER_W(
+            SMCH_AD9510_DFLT_PLL_B_COUNTER >> AD9510_PLL_B_LSB_COUNTER_SIZE)},
+    {AD9510_REG_PLL_B_LSB_COUNTER, AD9510_PLL_B_LSB_COUNTER_W(
+            SMCH_AD9510_DFLT_PLL_B_COUNTER)},
+    /* Setup MUX status pin: CP normal operation, Digital Lock Detect,
+     * PFD positive polarity */
+    {AD9510_REG_PLL_2, AD9510_PLL_2_CP_MODE_W(0x03) |
+            AD9510_PLL_2_MUX_SEL_W(0x01) | AD9510_PLL_2_PFD_POL_POS},
+    /* Setup Prescaler (divide by 1) and Power PLL Up */
+    {AD9510_REG_PLL_4, AD9510_PLL_4_PRESCALER_P_W(0) |
+            AD9510_PLL_4_PLL_PDOWN_W(0x0)},
+    /* Setup R divider */
+    {AD9510_REG_PLL_R_MSB_COUNTER, AD9510_PLL_R_MSB_COUNTER_W(
+            SMCH_AD9510_DFLT_PLL_R_COUNTER >> AD9510_PLL_R_LSB_COUNTER_SIZE)},
+    {AD9510_REG_PLL_R_LSB_COUNTER, AD9510_PLL_R_LSB_COUNTER_W(
+            SMCH_AD9510_DFLT_PLL_R_COUNTER)},
+    /* Power-up LVPECL outputs 0-3, 810 mV output */
+    {AD9510_REG_LVPECL_OUT0, AD9510_LVPECL_OUT_LVL_W(0x02) | AD9510_LVPECL_OUT_PDOWN_W(0x0)},
+    {AD9510_REG_LVPECL_OUT1, AD9510_LVPECL_OUT_LVL_W(0x02) | AD9510_LVPECL_OUT_PDOWN_W(0x0)},
+    {AD9510_REG_LVPECL_OUT2, AD9510_LVPECL_OUT_LVL_W(0x02) | AD9510_LVPECL_OUT_PDOWN_W(0x0)},
+    {AD9510_REG_LVPECL_OUT3, AD9510_LVPECL_OUT_LVL_W(0x02) | AD9510_LVPECL_OUT_PDOWN_W(0x0)},
+    /* Power-up LVCMOS/LVDS output 4 (DEBUG), 3.5 mA, 100 Ohm */
+    {AD9510_REG_LVDS_CMOS_OUT4, AD9510_LVDS_CMOS_CURR_W(0x1) & ~AD9510_LVDS_CMOS_PDOWN},
+    /* Power-down LVCMOS/LVDS outputs 5-7 */
+    {AD9510_REG_LVDS_CMOS_OUT5, AD9510_LVDS_CMOS_CURR_W(0x1) | AD9510_LVDS_CMOS_PDOWN},
+    {AD9510_REG_LVDS_CMOS_OUT6, AD9510_LVDS_CMOS_CURR_W(0x1) | AD9510_LVDS_CMOS_PDOWN},
+    {AD9510_REG_LVDS_CMOS_OUT7, AD9510_LVDS_CMOS_CURR_W(0x1) | AD9510_LVDS_CMOS_PDOWN},
+    /* Set-up clock selection (distribution mode)
+     * CLK1 - power off
+     * CLK2 - power on
+     * Clock select = CLK2
+     * Prescaler Clock -  Power-Up
+     * REFIN - Power-Up
+     */
+    {AD9510_REG_CLK_OPT, AD9510_CLK_OPT_CLK1_PD & (~AD9510_CLK_OPT_REFIN_PD &
+            ~AD9510_CLK_OPT_PS_PD & ~AD9510_CLK_OPT_SEL_CLK1)}
+};
+
+/* Registers set up by smch_ad9510_cfg_defaults () before the second update */
+static const smch_ad9510_reg_t _smch_ad9510_dflt_div_regs [] = {
+    /* Clock dividers OUT0 - OUT7
+     * divide = off (bypassed, ratio 1)
+     * duty cycle 50%
+     * lo-hi 0x00
+     */
+    {AD9510_REG_DIV0_DCYCLE, AD9510_DIV_DCYCLE_LOW_W(0x0) | AD9510_DIV_DCYCLE_HIGH_W(0x0)},
+    {AD9510_REG_DIV1_DCYCLE, AD9510_DIV_DCYCLE_LOW_W(0x0) | AD9510_DIV_DCYCLE_HIGH_W(0x0)},
+    {AD9510_REG_DIV2_DCYCLE, AD9510_DIV_DCYCLE_LOW_W(0x0) | AD9510_DIV_DCYCLE_HIGH_W(0x0)},
+    {AD9510_REG_DIV3_DCYCLE, AD9510_DIV_DCYCLE_LOW_W(0x0) | AD9510_DIV_DCYCLE_HIGH_W(0x0)},
+    {AD9510_REG_DIV4_DCYCLE, AD9510_DIV_DCYCLE_LOW_W(0x0) | AD9510_DIV_DCYCLE_HIGH_W(0x0)},
+    {AD9510_REG_DIV5_DCYCLE, AD9510_DIV_DCYCLE_LOW_W(0x0) | AD9510_DIV_DCYCLE_HIGH_W(0x0)},
+    {AD9510_REG_DIV6_DCYCLE, AD9510_DIV_DCYCLE_LOW_W(0x0) | AD9510_DIV_DCYCLE_HIGH_W(0x0)},
+    {AD9510_REG_DIV7_DCYCLE, AD9510_DIV_DCYCLE_LOW_W(0x0) | AD9510_DIV_DCYCLE_HIGH_W(0x0)},
+    /* Clock dividers OUT0 - OUT7
+     * phase offset = 0
+     * start high
+     * bypass
+     */
+    {AD9510_REG_DIV0_OPT, AD9510_DIV_BYPASS | AD9510_DIV_START_HIGH | AD9510_DIV_OPT_PHASE_W(0x0)},
+    {AD9510_REG_DIV1_OPT, AD9510_DIV_BYPASS | AD9510_DIV_START_HIGH | AD9510_DIV_OPT_PHASE_W(0x0)},
+    {AD9510_REG_DIV2_OPT, AD9510_DIV_BYPASS | AD9510_DIV_START_HIGH | AD9510_DIV_OPT_PHASE_W(0x0)},
+    {AD9510_REG_DIV3_OPT, AD9510_DIV_BYPASS | AD9510_DIV_START_HIGH | AD9510_DIV_OPT_PHASE_W(0x0)},
+    {AD9510_REG_DIV4_OPT, AD9510_DIV_BYPASS | AD9510_DIV_START_HIGH | AD9510_DIV_OPT_PHASE_W(0x0)},
+    {AD9510_REG_DIV5_OPT, AD9510_DIV_BYPASS | AD9510_DIV_START_HIGH | AD9510_DIV_OPT_PHASE_W(0x0)},
+    {AD9510_REG_DIV6_OPT, AD9510_DIV_BYPASS | AD9510_DIV_START_HIGH | AD9510_DIV_OPT_PHASE_W(0x0)},
+    {AD9510_REG_DIV7_OPT, AD9510_DIV_BYPASS | AD9510_DIV_START_HIGH | AD9510_DIV_OPT_PHASE_W(0x0)},
+    /* Function pin is SYNCB */
+    {AD9510_REG_FUNCTION, SMCH_AD9510_DFLT_FUNCTION}
+};
 
 /* Creates a new instance of the SMCH AD9510 */
 smch_ad9510_t * smch_ad9510_new (smio_t *parent, uint32_t base, uint32_t ss,
@@ -154,122 +236,27 @@ smch_err_e smch_ad9510_cfg_defaults (smch_ad9510_t *self)
     ASSERT_TEST(err == SMCH_SUCCESS, "Could not initialize AD9510",
             err_smpr_write, SMCH_ERR_RW_SMPR);
 
-    /* Setup A and B PLL divider */
-    uint8_t data = AD9510_PLL_A_COUNTER_W(0);
-    _smch_ad9510_write_8 (self, AD9510_REG_PLL_A_COUNTER, &data);
-
-    /* Extract MSB part of the divider */
-    data = AD9510_PLL_B_MSB_COUNTER_W(SMCH_AD9510_DFLT_PLL_B_COUNTER >>
-            AD9510_PLL_B_LSB_COUNTER_SIZE);
-    _smch_ad9510_write_8 (self, AD9510_REG_PLL_B_MSB_COUNTER, &data);
-
-        /* Extract LSB part of the divider */
-    data = AD9510_PLL_B_LSB_COUNTER_W(SMCH_AD9510_DFLT_PLL_B_COUNTER);
-    _smch_ad9510_write_8 (self, AD9510_REG_PLL_B_LSB_COUNTER, &data);
-
-    /* Setup MUX status pin */
-    data = AD9510_PLL_2_CP_MODE_W(0x03 /* CP normal operation*/) |
-        AD9510_PLL_2_MUX_SEL_W(0x01 /* Digital Lock Detect */) |
-        AD9510_PLL_2_PFD_POL_POS; /* PFD positive polarity */
-    _smch_ad9510_write_8 (self, AD9510_REG_PLL_2, &data);
-
-    /* Setup Prescaler and Power PLL Up*/
-    data = AD9510_PLL_4_PRESCALER_P_W(0 /* Divide by 1 */) |
-        AD9510_PLL_4_PLL_PDOWN_W(0x0);
-    _smch_ad9510_write_8 (self, AD9510_REG_PLL_4, &data);
-
-    /* Setup R divider */
-    data = AD9510_PLL_R_MSB_COUNTER_W(SMCH_AD9510_DFLT_PLL_R_COUNTER >>
-            AD9510_PLL_R_LSB_COUNTER_SIZE);
-    _smch_ad9510_write_8 (self, AD9510_REG_PLL_R_MSB_COUNTER, &data);
-    data = AD9510_PLL_R_LSB_COUNTER_W(SMCH_AD9510_DFLT_PLL_R_COUNTER);
-    _smch_ad9510_write_8 (self, AD9510_REG_PLL_R_LSB_COUNTER, &data);
-
-    /* Power-up LVPECL outputs */
-    DBE_DEBUG (DBG_SM_CH | DBG_LVL_INFO,
-            "[sm_ch:ad9510] Powering up LVPECL outputs 0-3\n");
-    data = AD9510_LVPECL_OUT_LVL_W(0x02) /* 810 mV output */ |
-        AD9510_LVPECL_OUT_PDOWN_W(0x0) /* Do not power down */;
-    _smch_ad9510_write_8 (self, AD9510_REG_LVPECL_OUT0, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_LVPECL_OUT1, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_LVPECL_OUT2, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_LVPECL_OUT3, &data);
-
-    /* Power-up LVCMOS/LVDS output 4 (DEBUG) */
+    /* Setup PLL, outputs and clock selection */
     DBE_DEBUG (DBG_SM_CH | DBG_LVL_INFO,
-            "[sm_ch:ad9510] Powering up LVDS/CMOS output 4\n");
-    data = AD9510_LVDS_CMOS_CURR_W(0x1) /* 3.5 mA, 100 Ohm */ & (
-        ~AD9510_LVDS_CMOS_PDOWN /* Do not power down */);
-    _smch_ad9510_write_8 (self, AD9510_REG_LVDS_CMOS_OUT4, &data);
-
-    /* Power-down LVCMOS/LVDS outputs 5-7*/
-    DBE_DEBUG (DBG_SM_CH | DBG_LVL_INFO,
-            "[sm_ch:ad9510] Powering down LVDS/CMOS outputs 5-7\n");
-    data = AD9510_LVDS_CMOS_CURR_W(0x1) /* 3.5 mA, 100 Ohm */ | (
-        AD9510_LVDS_CMOS_PDOWN /* Power down */);
-    _smch_ad9510_write_8 (self, AD9510_REG_LVDS_CMOS_OUT5, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_LVDS_CMOS_OUT6, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_LVDS_CMOS_OUT7, &data);
-
-    /* Set-up clock selection (distribution mode)
-     * CLK1 - power off
-     * CLK2 - power on
-     * Clock select = CLK2
-     * Prescaler Clock -  Power-Up
-     * REFIN - Power-Up
-     */
-    data = AD9510_CLK_OPT_CLK1_PD /* Power CLK1 down */ & (
-                ~AD9510_CLK_OPT_REFIN_PD /* Power Reference In Up*/ &
-                ~AD9510_CLK_OPT_PS_PD /* Power Prescaler Up*/ &
-                ~AD9510_CLK_OPT_SEL_CLK1 /* Select CLK2*/);
-    _smch_ad9510_write_8 (self, AD9510_REG_CLK_OPT, &data);
+            "[sm_ch:ad9510] Powering up LVPECL outputs 0-3 and LVDS/CMOS "
+            "output 4. Powering down LVDS/CMOS outputs 5-7\n");
+    _smch_ad9510_write_regs (self, _smch_ad9510_dflt_pll_regs,
+            ARRAY_SIZE(_smch_ad9510_dflt_pll_regs));
 
     /* Update registers */
     _smch_ad9510_reg_update (self);
     SMCH_AD9510_WAIT_DFLT;
 
-    /* Clock dividers OUT0 - OUT7
-     * divide = off (bypassed, ratio 1)
-     * duty cycle 50%
-     * lo-hi 0x00
-     */
-    data = AD9510_DIV_DCYCLE_LOW_W(0x0) | AD9510_DIV_DCYCLE_HIGH_W(0x0);
-
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV0_DCYCLE, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV1_DCYCLE, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV2_DCYCLE, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV3_DCYCLE, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV4_DCYCLE, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV5_DCYCLE, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV6_DCYCLE, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV7_DCYCLE, &data);
-
-    /* Clock dividers OUT0 - OUT7
-     * phase offset = 0
-     * start high
-     * bypass
-     */
-    data = AD9510_DIV_BYPASS | AD9510_DIV_START_HIGH | AD9510_DIV_OPT_PHASE_W(0x0);
-
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV0_OPT, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV1_OPT, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV2_OPT, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV3_OPT, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV4_OPT, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV5_OPT, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV6_OPT, &data);
-    _smch_ad9510_write_8 (self, AD9510_REG_DIV7_OPT, &data);
-
-    /* Function pin is SYNCB */
-    data = AD9510_FUNCTION_FUNC_SEL_W(0x1);
-    _smch_ad9510_write_8 (self, AD9510_REG_FUNCTION, &data);
+    /* Setup clock dividers and function pin */
+    _smch_ad9510_write_regs (self, _smch_ad9510_dflt_div_regs,
+            ARRAY_SIZE(_smch_ad9510_dflt_div_regs));
 
     /* Update registers */
     _smch_ad9510_reg_update (self);
     SMCH_AD9510_WAIT_DFLT;
 
     /* Software sync */
-    data |= AD9510_FUNCTION_SYNC_REG;
+    uint8_t data = SMCH_AD9510_DFLT_FUNCTION | AD9510_FUNCTION_SYNC_REG;
     _smch_ad9510_write_8 (self, AD9510_REG_FUNCTION, &data);
 
     /* Update registers */
@@ -285,6 +272,33 @@ err_smpr_write:
     return err;
 }
 
+smch_err_e smch_ad9510_cfg_defaults_match (smch_ad9510_t *self, bool *match)
+{
+    assert (self);
+    assert (match);
+
+    smch_err_e err = SMCH_SUCCESS;
+
+    *match = false;
+    err = _smch_ad9510_match_regs (self, _smch_ad9510_dflt_pll_regs,
+            ARRAY_SIZE(_smch_ad9510_dflt_pll_regs), match);
+    ASSERT_TEST(err == SMCH_SUCCESS, "Could not read AD9510 PLL registers",
+            err_smpr_read);
+
+    if (*match) {
+        err = _smch_ad9510_match_regs (self, _smch_ad9510_dflt_div_regs,
+                ARRAY_SIZE(_smch_ad9510_dflt_div_regs), match);
+        ASSERT_TEST(err == SMCH_SUCCESS, "Could not read AD9510 divider registers",
+                err_smpr_read);
+    }
+
+    DBE_DEBUG (DBG_SM_CH | DBG_LVL_TRACE, "[sm_ch:ad9510] Default configuration "
+            "%s\n", (*match) ? "already in place" : "differs");
+
+err_smpr_read:
+    return err;
+}
+
 smch_err_e smch_ad9510_set_pll_a_div (smch_ad9510_t *self, uint32_t *div)
 {
     smch_err_e err = SMCH_SUCCESS;
@@ -851,3 +865,38 @@ static smch_err_e _smch_ad9510_reg_update (smch_ad9510_t *self)
 err_write_8:
     return err;
 }
+
+static void _smch_ad9510_write_regs (smch_ad9510_t *self,
+        const smch_ad9510_reg_t *regs, size_t num_regs)
+{
+    size_t i;
+    for (i = 0; i < num_regs; ++i) {
+        _smch_ad9510_write_8 (self, regs [i].addr, &regs [i].data);
+    }
+}
+
+/* Check if all of the registers hold the specified values */
+static smch_err_e _smch_ad9510_match_regs (smch_ad9510_t *self,
+        const smch_ad9510_reg_t *regs, size_t num_regs, bool *match)
+{
+    smch_err_e err = SMCH_SUCCESS;
+    *match = true;
+
+    size_t i;
+    for (i = 0; i < num_regs; ++i) {
+        uint8_t data = 0;
+        ssize_t rw_err = _smch_ad9510_read_8 (self, regs [i].addr, &data);
+        ASSERT_TEST(rw_err == sizeof(uint8_t), "Could not read AD9510 register",
+                err_read_8, SMCH_ERR_RW_SMPR);
+
+        if (data != regs [i].data) {
+            DBE_DEBUG (DBG_SM_CH | DBG_LVL_TRACE, "[sm_ch:ad9510] Register 0x%02X "
+                    "is 0x%02X, expected 0x%02X\n", regs [i].addr, data, regs [i].data);
+            *match = false;
+            break;
+        }
+    }
+
+err_read_8:
+    return err;
+}
@@ -22,6 +22,14 @@ struct _smch_ad9510_t {
 /* Opaque sm_ch_ad9510 structure */
 typedef struct _smch_ad9510_t smch_ad9510_t;
 
+/* AD9510 register address and value */
+struct _smch_ad9510_reg_t {
+    uint8_t addr;
+    uint8_t data;
+};
+
+typedef struct _smch_ad9510_reg_t smch_ad9510_reg_t;
+
 /***************** Our methods *****************/
 
 /* Creates a new instance of the SMCH AD9510 */
@@ -47,6 +55,9 @@ smch_err_e smch_ad9510_reg_update (smch_ad9510_t *self);
 
 /* Simple test for configuring a few AD9510 registers */
 smch_err_e smch_ad9510_cfg_defaults (smch_ad9510_t *self);
+/* Check if the AD9510 registers already hold the values set by
+ * smch_ad9510_cfg_defaults (), without touching the chip configuration */
+smch_err_e smch_ad9510_cfg_defaults_match (smch_ad9510_t *self, bool *match);
 
 /* AD9510 PLL divider functions */
 smch_err_e smch_ad9510_set_pll_a_div (smch_ad9510_t *self, uint32_t *div);
@@ -193,6 +193,63 @@ err_exit:
     return err;
 }
 
+smch_err_e smch_si57x_match_freq (smch_si57x_t *self, double frequency,
+        bool *match)
+{
+    assert (self);
+    assert (match);
+    smch_err_e err = SMCH_SUCCESS;
+    uint64_t rfreq;
+    unsigned int n1, hs_div;
+    uint64_t exp_rfreq;
+    unsigned int exp_n1, exp_hs_div;
+
+    *match = false;
+
+    /* Read dividers currently in use. This does not disturb the output,
+     * as opposed to smch_si57x_get_defaults () */
+    err = _smch_si57x_get_divs (self, &rfreq, &n1, &hs_div);
+    ASSERT_TEST(err == SMCH_SUCCESS, "Could not get divider values", err_exit);
+
+    /* Dividers selected by smch_si57x_set_freq () for this frequency. They
+     * do not depend on the crystal frequency, so use the nominal one */
+    smch_si57x_t nominal = *self;
+    nominal.fxtal = SMCH_SI57X_NOMINAL_FXTAL;
+    err = _smch_si57x_calc_divs (&nominal, frequency, &exp_rfreq, &exp_n1,
+            &exp_hs_div);
+    ASSERT_TEST(err == SMCH_SUCCESS, "Could not calculate optimal divider values",
+            err_exit);
+
+    if (rfreq == 0 || n1 != exp_n1 || hs_div != exp_hs_div) {
+        goto err_exit;
+    }
+
+    /* The crystal frequency implied by the current RFREQ must be
+     * within the part tolerance */
+    double fxtal = frequency * (double) n1 * (double) hs_div * POW_2_28 /
+        (double) rfreq;
+    double dev_ppm = (fxtal - SMCH_SI57X_NOMINAL_FXTAL) * 1e6 /
+        SMCH_SI57X_NOMINAL_FXTAL;
+
+    DBE_DEBUG (DBG_SM_CH | DBG_LVL_TRACE, "[sm_ch:si57x_match_freq] "
+            "Implied fxtal: %f (%f ppm)\n", fxtal, dev_ppm);
+
+    if (dev_ppm > SMCH_SI57X_FXTAL_TOL_PPM || dev_ppm < -SMCH_SI57X_FXTAL_TOL_PPM) {
+        goto err_exit;
+    }
+
+    /* Adopt the running configuration */
+    self->fxtal = fxtal;
+    self->rfreq = rfreq;
+    self->n1 = n1;
+    self->hs_div = hs_div;
+    self->frequency = frequency;
+    *match = true;
+
+err_exit:
+    return err;
+}
+
 /***************** Static functions *****************/
 
 static smch_err_e _smch_si57x_write_8 (smch_si57x_t *self, uint8_t addr,
@@ -57,5 +57,9 @@ smch_err_e smch_si57x_get_defaults (smch_si57x_t *self, double fout);
 
 /* Setup new frequency */
 smch_err_e smch_si57x_set_freq (smch_si57x_t *self, double frequency);
+/* Check if Si57X is already generating the specified frequency, without
+ * changing its configuration. If so, adopt the current divider values */
+smch_err_e smch_si57x_match_freq (smch_si57x_t *self, double frequency,
+        bool *match);
 
 #endif
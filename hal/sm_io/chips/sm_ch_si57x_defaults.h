@@ -16,5 +16,10 @@
 #define SMCH_SI57X_DFLT_RFREQ                   0ULL
 #define SMCH_SI57X_DFLT_FREQUENCY               SI57X_FOUT_FACTORY_DFLT
 
+/* Nominal internal crystal frequency and the tolerance used when
+ * inferring it from the divider values already in the chip */
+#define SMCH_SI57X_NOMINAL_FXTAL                114285000.0
+#define SMCH_SI57X_FXTAL_TOL_PPM                2000.0
+
 #endif
 
@@ -3,6 +3,12 @@ sm_io_acq_DIR = hal/sm_io/modules/acq
 sm_io_acq_OBJS = $(sm_io_acq_DIR)/sm_io_acq_core.o \
 		 $(sm_io_acq_DIR)/sm_io_acq_exp.o \
 		 $(sm_io_acq_DIR)/sm_io_acq_exports.o \
+		 $(sm_io_acq_DIR)/sm_io_acq_stream.o \
+		 $(sm_io_acq_DIR)/sm_io_acq_decim.o \
+		 $(sm_io_acq_DIR)/sm_io_acq_soa.o \
+		 $(sm_io_acq_DIR)/sm_io_acq_pos.o \
+		 $(sm_io_acq_DIR)/sm_io_acq_ds.o \
+		 $(sm_io_acq_DIR)/sm_io_acq_cache.o \
 		 $(sm_io_acq_DIR)/ddr3_map.o
 
 sm_io_acq_INCLUDE_DIRS = $(sm_io_acq_DIR)
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "sm_io_acq_cache.h"
+#include "sm_io_err.h"
+#include "hal_assert.h"
+
+/* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
+#ifdef ASSERT_ALLOC
+#undef ASSERT_ALLOC
+#endif
+#define ASSERT_ALLOC(ptr, err_goto_label, /* err_core */ ...)   \
+    ASSERT_HAL_ALLOC(ptr, SM_IO, "[sm_io:acq_cache]",           \
+            smio_err_str(SMIO_ERR_ALLOC),                       \
+            err_goto_label, /* err_core */ __VA_ARGS__)
+
+static uint32_t _acq_cache_num_chunks (const acq_cache_entry_t *entry);
+static bool _acq_cache_alloc (acq_cache_t *self, acq_cache_entry_t *entry);
+static void _acq_cache_free (acq_cache_t *self, acq_cache_entry_t *entry);
+
+void acq_cache_complete (acq_cache_t *self, uint32_t chan, uint32_t size)
+{
+    assert (self);
+    assert (chan < END_CHAN_ID);
+
+    acq_cache_entry_t *entry = &self->entries [chan];
+    _acq_cache_free (self, entry);
+    entry->gen++;
+    entry->valid = true;
+    entry->size = size;
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq_cache] "
+            "Generation %u of channel %u, %u bytes\n", entry->gen, chan, size);
+}
+
+void acq_cache_overwrite (acq_cache_t *self, uint32_t chan)
+{
+    assert (self);
+    assert (chan < END_CHAN_ID);
+
+    acq_cache_entry_t *entry = &self->entries [chan];
+    /* A curve read in full doesn't need the DDR3 anymore */
+    if (entry->data != NULL && entry->num_filled == _acq_cache_num_chunks (entry)) {
+        return;
+    }
+
+    acq_cache_drop (self, chan);
+}
+
+void acq_cache_drop (acq_cache_t *self, uint32_t chan)
+{
+    assert (self);
+    assert (chan < END_CHAN_ID);
+
+    acq_cache_entry_t *entry = &self->entries [chan];
+    if (entry->valid) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq_cache] "
+                "Generation %u of channel %u dropped\n", entry->gen, chan);
+    }
+
+    _acq_cache_free (self, entry);
+    entry->valid = false;
+}
+
+uint32_t acq_cache_gen (const acq_cache_t *self, uint32_t chan)
+{
+    assert (self);
+    assert (chan < END_CHAN_ID);
+
+    return self->entries [chan].gen;
+}
+
+ssize_t acq_cache_read (acq_cache_t *self, uint32_t chan, uint32_t off,
+        uint32_t size, uint8_t *data, acq_cache_fill_fp fill, void *owner)
+{
+    assert (self);
+    assert (chan < END_CHAN_ID);
+    assert (fill);
+
+    acq_cache_entry_t *entry = &self->entries [chan];
+    if (!_acq_cache_alloc (self, entry) || off >= entry->size) {
+        return fill (owner, chan, off, size, data);
+    }
+
+    if (size > entry->size - off) {
+        size = entry->size - off;
+    }
+
+    uint32_t read_bytes = 0;
+    while (read_bytes < size) {
+        uint32_t pos = off + read_bytes;
+        uint32_t chunk = pos / ACQ_CACHE_CHUNK_SIZE;
+        uint32_t chunk_off = chunk * ACQ_CACHE_CHUNK_SIZE;
+        uint32_t chunk_size = entry->size - chunk_off;
+        if (chunk_size > ACQ_CACHE_CHUNK_SIZE) {
+            chunk_size = ACQ_CACHE_CHUNK_SIZE;
+        }
+
+        if (!entry->filled [chunk]) {
+            ssize_t chunk_bytes = fill (owner, chan, chunk_off, chunk_size,
+                    entry->data + chunk_off);
+            /* The rest is read as without a cache, so the error is the
+             * same */
+            if (chunk_bytes != (ssize_t) chunk_size) {
+                ssize_t rest = fill (owner, chan, pos, size - read_bytes,
+                        data + read_bytes);
+                return (rest < 0) ? -1 : (ssize_t) read_bytes + rest;
+            }
+
+            entry->filled [chunk] = true;
+            entry->num_filled++;
+        }
+
+        uint32_t copy_size = size - read_bytes;
+        if (copy_size > chunk_off + chunk_size - pos) {
+            copy_size = chunk_off + chunk_size - pos;
+        }
+
+        memcpy (data + read_bytes, entry->data + pos, copy_size);
+        read_bytes += copy_size;
+    }
+
+    return read_bytes;
+}
+
+void acq_cache_destroy (acq_cache_t *self)
+{
+    assert (self);
+
+    for (uint32_t i = 0; i < END_CHAN_ID; i++) {
+        acq_cache_drop (self, i);
+    }
+}
+
+static uint32_t _acq_cache_num_chunks (const acq_cache_entry_t *entry)
+{
+    return (entry->size + ACQ_CACHE_CHUNK_SIZE - 1) / ACQ_CACHE_CHUNK_SIZE;
+}
+
+/* Whether the curve of "entry" can be cached. Its memory is allocated on
+ * the first call */
+static bool _acq_cache_alloc (acq_cache_t *self, acq_cache_entry_t *entry)
+{
+    if (!entry->valid || entry->size == 0) {
+        return false;
+    }
+
+    if (entry->data != NULL) {
+        return true;
+    }
+
+    if (entry->size > ACQ_CACHE_MAX_BYTES - self->bytes) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq_cache] "
+                "No room for %u more bytes\n", entry->size);
+        return false;
+    }
+
+    entry->data = (uint8_t *) malloc (entry->size);
+    ASSERT_ALLOC(entry->data, err_data_alloc);
+    entry->filled = (bool *) calloc (_acq_cache_num_chunks (entry),
+            sizeof (bool));
+    ASSERT_ALLOC(entry->filled, err_filled_alloc);
+
+    entry->num_filled = 0;
+    self->bytes += entry->size;
+    return true;
+
+err_filled_alloc:
+    free (entry->data);
+    entry->data = NULL;
+err_data_alloc:
+    return false;
+}
+
+static void _acq_cache_free (acq_cache_t *self, acq_cache_entry_t *entry)
+{
+    if (entry->data != NULL) {
+        self->bytes -= entry->size;
+    }
+
+    free (entry->filled);
+    entry->filled = NULL;
+    free (entry->data);
+    entry->data = NULL;
+    entry->num_filled = 0;
+}
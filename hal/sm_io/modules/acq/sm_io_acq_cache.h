@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_ACQ_CACHE_H_
+#define _SM_IO_ACQ_CACHE_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "sm_io_acq_codes.h"
+#include "board.h"
+
+/* Cache of the last completed acquisition of each channel of a core. The
+ * curve is kept in time order and filled on demand, a chunk at a time, so
+ * each chunk is read from the DDR3 once however many clients read it. The
+ * generation of a channel counts its acquisitions completed so far */
+#define ACQ_CACHE_CHUNK_SIZE            BLOCK_SIZE
+/* Memory of all of the curves cached for a core. Curves that don't fit
+ * are read from the DDR3 every time, as without a cache */
+#define ACQ_CACHE_MAX_BYTES             (1 << 26)
+
+struct _acq_cache_entry_t {
+    uint32_t gen;                   /* Acquisitions completed so far */
+    bool valid;                     /* Holds the last completed acquisition */
+    uint32_t size;                  /* Size of the curve, in bytes */
+    uint32_t num_filled;            /* Chunks read from the DDR3 so far */
+    uint8_t *data;                  /* Curve. Allocated on the first read */
+    bool *filled;                   /* Whether each chunk was read */
+};
+
+typedef struct _acq_cache_entry_t acq_cache_entry_t;
+
+struct _acq_cache_t {
+    acq_cache_entry_t entries [END_CHAN_ID];
+    uint32_t bytes;                 /* Allocated by all of the entries */
+};
+
+typedef struct _acq_cache_t acq_cache_t;
+
+/* Reads "size" bytes of the curve of channel "chan" from the DDR3, starting
+ * at byte "off" of it. Returns the number of bytes read or -1 on error */
+typedef ssize_t (*acq_cache_fill_fp) (void *owner, uint32_t chan, uint32_t off,
+        uint32_t size, uint8_t *data);
+
+/***************** Our methods *****************/
+
+/* An acquisition of "size" bytes of channel "chan" was completed. Drop the
+ * previous curve and start a new generation */
+void acq_cache_complete (acq_cache_t *self, uint32_t chan, uint32_t size);
+/* The DDR3 was overwritten under the curve of channel "chan". Drop it,
+ * unless it was read in full */
+void acq_cache_overwrite (acq_cache_t *self, uint32_t chan);
+/* The last acquisition of channel "chan" is not completed anymore. Drop
+ * its curve */
+void acq_cache_drop (acq_cache_t *self, uint32_t chan);
+/* Generation of channel "chan" */
+uint32_t acq_cache_gen (const acq_cache_t *self, uint32_t chan);
+/* Read "size" bytes of the curve of channel "chan", starting at byte "off"
+ * of it. The chunks not cached yet are read with "fill". Returns the number
+ * of bytes read or -1 on error */
+ssize_t acq_cache_read (acq_cache_t *self, uint32_t chan, uint32_t off,
+        uint32_t size, uint8_t *data, acq_cache_fill_fp fill, void *owner);
+/* Release all of the curves */
+void acq_cache_destroy (acq_cache_t *self);
+
+#endif
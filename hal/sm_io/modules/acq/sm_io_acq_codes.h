@@ -18,6 +18,72 @@ struct _smio_acq_data_block_t {
 
 typedef struct _smio_acq_data_block_t smio_acq_data_block_t;
 
+/* Samples are made of this many components: the 4 antennas, or X, Y, Q and
+ * SUM, for instance. In a block read with ACQ_OPCODE_GET_SOA_DATA_BLOCK, the
+ * N samples of the block are deinterleaved in SMIO_ACQ_NUM_COMP columns of
+ * N components each, one after the other */
+#define SMIO_ACQ_NUM_COMP               4
+
+/* Streaming acquisition. Each message published to the stream endpoint is:
+ * frame 0: smio_acq_stream_hdr_t
+ * frame 1: samples, in time order */
+struct _smio_acq_stream_hdr_t {
+    uint32_t seq;                   /* Message sequence number. A gap means
+                                       the subscriber missed messages */
+    uint32_t chan;                  /* Channel streamed */
+    uint64_t first_sample;          /* Stream index of the first sample */
+    uint64_t lost;                  /* Samples overwritten by the core before
+                                       they could be read, right before this
+                                       message */
+};
+
+typedef struct _smio_acq_stream_hdr_t smio_acq_stream_hdr_t;
+
+#define SMIO_ACQ_STREAM_ENDP_LEN        128
+
+struct _smio_acq_stream_status_t {
+    uint32_t running;               /* 1 if the stream is started */
+    uint32_t chan;                  /* Channel streamed */
+    uint32_t num_samples;           /* Size of the ring, in samples */
+    uint32_t overruns;              /* Number of overruns */
+    uint64_t pos;                   /* Samples published */
+    uint64_t lost;                  /* Samples lost to overruns */
+    char endpoint [SMIO_ACQ_STREAM_ENDP_LEN];   /* Endpoint to subscribe to */
+};
+
+typedef struct _smio_acq_stream_status_t smio_acq_stream_status_t;
+
+/* Decimated curve. The curve of the last acquisition of a channel is split
+ * in buckets of consecutive samples, and each of the components of the
+ * samples is reduced to its minimum, maximum and mean over each bucket */
+#define SMIO_ACQ_DECIM_NUM_COMP         SMIO_ACQ_NUM_COMP
+#define SMIO_ACQ_DECIM_MAX_BUCKETS      2048
+
+struct _smio_acq_decim_bucket_t {
+    int32_t min [SMIO_ACQ_DECIM_NUM_COMP];
+    int32_t max [SMIO_ACQ_DECIM_NUM_COMP];
+    int32_t mean [SMIO_ACQ_DECIM_NUM_COMP];
+};
+
+typedef struct _smio_acq_decim_bucket_t smio_acq_decim_bucket_t;
+
+struct _smio_acq_decim_curve_t {
+    uint32_t num_buckets;           /* Buckets returned. Fewer than requested
+                                       if the curve has fewer samples */
+    uint32_t num_samples;           /* Samples of the curve */
+    smio_acq_decim_bucket_t buckets [SMIO_ACQ_DECIM_MAX_BUCKETS];
+};
+
+typedef struct _smio_acq_decim_curve_t smio_acq_decim_curve_t;
+
+/* Calibrated positions. A block read with ACQ_OPCODE_GET_POS_DATA_BLOCK
+ * holds up to SMIO_ACQ_POS_BLOCK_SAMPLES samples of a position channel, each
+ * made of SMIO_ACQ_NUM_COMP doubles: X and Y in nm, Q and SUM. Block n starts
+ * at sample n*SMIO_ACQ_POS_BLOCK_SAMPLES of the curve. Blocks read with
+ * ACQ_OPCODE_GET_DS_DATA_BLOCK, computed from an amplitude channel, are laid
+ * out the same way */
+#define SMIO_ACQ_POS_BLOCK_SAMPLES      (BLOCK_SIZE/(SMIO_ACQ_NUM_COMP*sizeof (double)))
+
 /* Messaging OPCODES */
 #define ACQ_OPCODE_SIZE                  (sizeof(uint32_t))
 #define ACQ_OPCODE_TYPE                  uint32_t
@@ -28,7 +94,56 @@ typedef struct _smio_acq_data_block_t smio_acq_data_block_t;
 #define ACQ_NAME_GET_DATA_BLOCK         "acq_get_data_block"
 #define ACQ_OPCODE_CHECK_DATA_ACQUIRE   2
 #define ACQ_NAME_CHECK_DATA_ACQUIRE     "acq_check_data_acquire"
-#define ACQ_OPCODE_END                  3
+#define ACQ_OPCODE_CFG_TRIG             3
+#define ACQ_NAME_CFG_TRIG               "acq_cfg_trig"
+#define ACQ_OPCODE_HW_TRIG_POL          4
+#define ACQ_NAME_HW_TRIG_POL            "acq_hw_trig_pol"
+#define ACQ_OPCODE_HW_DATA_TRIG_SEL     5
+#define ACQ_NAME_HW_DATA_TRIG_SEL       "acq_hw_data_trig_sel"
+#define ACQ_OPCODE_HW_DATA_TRIG_THRES   6
+#define ACQ_NAME_HW_DATA_TRIG_THRES     "acq_hw_data_trig_thres"
+#define ACQ_OPCODE_HW_TRIG_DLY          7
+#define ACQ_NAME_HW_TRIG_DLY            "acq_hw_trig_dly"
+#define ACQ_OPCODE_SW_TRIG              8
+#define ACQ_NAME_SW_TRIG                "acq_sw_trig"
+#define ACQ_OPCODE_FSM_STOP             9
+#define ACQ_NAME_FSM_STOP               "acq_fsm_stop"
+#define ACQ_OPCODE_GET_SHOT_DATA_BLOCK  10
+#define ACQ_NAME_GET_SHOT_DATA_BLOCK    "acq_get_shot_data_block"
+#define ACQ_OPCODE_STREAM_START         11
+#define ACQ_NAME_STREAM_START           "acq_stream_start"
+#define ACQ_OPCODE_STREAM_STOP          12
+#define ACQ_NAME_STREAM_STOP            "acq_stream_stop"
+#define ACQ_OPCODE_STREAM_STATUS        13
+#define ACQ_NAME_STREAM_STATUS          "acq_stream_status"
+#define ACQ_OPCODE_PINGPONG             14
+#define ACQ_NAME_PINGPONG               "acq_pingpong"
+#define ACQ_OPCODE_GET_DECIM_CURVE      15
+#define ACQ_NAME_GET_DECIM_CURVE        "acq_get_decim_curve"
+#define ACQ_OPCODE_GET_SOA_DATA_BLOCK   16
+#define ACQ_NAME_GET_SOA_DATA_BLOCK     "acq_get_soa_data_block"
+#define ACQ_OPCODE_GET_POS_DATA_BLOCK   17
+#define ACQ_NAME_GET_POS_DATA_BLOCK     "acq_get_pos_data_block"
+#define ACQ_OPCODE_GET_DS_DATA_BLOCK    18
+#define ACQ_NAME_GET_DS_DATA_BLOCK      "acq_get_ds_data_block"
+#define ACQ_OPCODE_GET_GEN              19
+#define ACQ_NAME_GET_GEN                "acq_get_gen"
+#define ACQ_OPCODE_END                  20
+
+/* Trigger types, set with ACQ_OPCODE_CFG_TRIG */
+#define ACQ_TRIG_SKIP                   0   /* No trigger. Acquire right away */
+#define ACQ_TRIG_EXTERNAL               1   /* External hardware trigger */
+#define ACQ_TRIG_DATA_DRIVEN            2   /* Acquired data crossing a threshold */
+#define ACQ_TRIG_SOFTWARE               3   /* ACQ_OPCODE_SW_TRIG */
+#define ACQ_TRIG_END                    4   /* End marker */
+
+/* Position computations of ACQ_OPCODE_GET_DS_DATA_BLOCK, from the A, B, C
+ * and D amplitudes */
+#define ACQ_DS_MODE_DS                  0   /* Delta over sum, as the
+                                               position calculation core */
+#define ACQ_DS_MODE_PDS                 1   /* Partial delta over sum, of
+                                               the A/C and B/D pairs */
+#define ACQ_DS_MODE_END                 2   /* End marker */
 
 /* Messaging Reply OPCODES */
 #define ACQ_REPLY_SIZE                  (sizeof(uint32_t))
@@ -40,6 +155,13 @@ typedef struct _smio_acq_data_block_t smio_acq_data_block_t;
 #define ACQ_BLOCK_OOR                   3   /* Block number out of range */
 #define ACQ_NUM_CHAN_OOR                4   /* Channel number out of range */
 #define ACQ_COULD_NOT_READ              5   /* Could not read memory block */
-#define ACQ_REPLY_END                   6   /* End marker */
+#define ACQ_SHOT_OOR                    6   /* Shot number out of range */
+#define ACQ_STREAM_BUSY                 7   /* A streaming acquisition is running */
+#define ACQ_STREAM_UNAVAIL              8   /* Streaming is not available */
+#define ACQ_BUCKETS_OOR                 9   /* Number of buckets out of range */
+#define ACQ_NOT_POS_CHAN                10  /* Channel does not hold positions */
+#define ACQ_NOT_AMP_CHAN                11  /* Channel does not hold amplitudes */
+#define ACQ_DS_MODE_OOR                 12  /* Position computation out of range */
+#define ACQ_REPLY_END                   13  /* End marker */
 
 #endif
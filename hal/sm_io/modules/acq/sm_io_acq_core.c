@@ -10,6 +10,7 @@
 #include <czmq.h>
 
 #include "sm_io_acq_core.h"
+#include "sm_io_acq_codes.h"
 #include "sm_io_err.h"
 #include "hal_assert.h"
 
@@ -36,27 +37,40 @@
     CHECK_HAL_ERR(err, SM_IO, "[sm_io_acq_core]",                               \
             smio_err_str (err_type))
 
+static bool _smio_acq_buf_shared (uint32_t inst_id);
+
 /* Creates a new instance of Device Information */
 smio_acq_t * smio_acq_new (smio_t *parent, uint32_t num_samples)
 {
     smio_acq_t *self = (smio_acq_t *) zmalloc (sizeof *self);
     ASSERT_ALLOC(self, err_self_alloc);
 
+    /* initilize acquisition buffer areas. Defined in ddr3_map.h */
+    ASSERT_TEST(parent->inst_id < NUM_ACQ_CORE_SMIOS, "Instance ID invalid",
+            err_inst_id);
+
+    /* The cores acquire independently of each other, so one of them must
+     * never write where another one might be acquiring or being read */
+    ASSERT_TEST(!_smio_acq_buf_shared (parent->inst_id),
+            "DDR3 regions shared with another acquisition core", err_inst_id);
+
+    self->acq_buf = __acq_buf[parent->inst_id];
+
     /* Set default value for all channels */
     for (uint32_t i = 0; i < END_CHAN_ID; i++) {
+        self->acq_params[i].start_addr = self->acq_buf[i].start_addr;
         self->acq_params[i].num_samples = num_samples;
+        self->acq_params[i].num_samples_pre = num_samples;
+        self->acq_params[i].num_shots = 1;
     }
 
-    /* initilize acquisition buffer areas. Defined in ddr3_map.h */
-    if (parent->inst_id > NUM_ACQ_CORE_SMIOS-1) {
-        DBE_DEBUG (DBG_SM_IO | DBG_LVL_ERR, "[sm_io:acq_core] Instance ID invalid\n");
-        return NULL;
-    }
-
-    self->acq_buf = __acq_buf[parent->inst_id];
+    /* Same as the hardware reset state */
+    self->trig_type = ACQ_TRIG_SKIP;
 
     return self;
 
+err_inst_id:
+    free (self);
 err_self_alloc:
     return NULL;
 }
@@ -69,6 +83,7 @@ smio_err_e smio_acq_destroy (smio_acq_t **self_p)
     if (*self_p) {
         smio_acq_t *self = *self_p;
 
+        acq_cache_destroy (&self->cache);
         self->acq_buf = NULL;
         free (self);
         *self_p = NULL;
@@ -77,3 +92,29 @@ smio_err_e smio_acq_destroy (smio_acq_t **self_p)
     return SMIO_SUCCESS;
 }
 
+/* Whether a channel of ACQ core "inst_id" shares DDR3 memory with a channel
+ * of another core. The channels of the same core do share it, as a core only
+ * acquires one of them at a time */
+static bool _smio_acq_buf_shared (uint32_t inst_id)
+{
+    for (uint32_t i = 0; i < END_CHAN_ID; i++) {
+        const acq_buf_t *acq_buf = &__acq_buf[inst_id][i];
+        if (acq_buf->max_samples == 0) {
+            continue;
+        }
+
+        for (uint32_t core = 0; core < NUM_ACQ_CORE_SMIOS; core++) {
+            for (uint32_t j = 0; core != inst_id && j < END_CHAN_ID; j++) {
+                const acq_buf_t *other = &__acq_buf[core][j];
+                /* end_addr is the address of the last sample */
+                if (other->max_samples != 0 &&
+                        acq_buf->start_addr <= other->end_addr &&
+                        other->start_addr <= acq_buf->end_addr) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
@@ -9,17 +9,56 @@
 #define _SM_IO_ACQ_CORE_H_
 
 #include <inttypes.h>
+#include <stdbool.h>
 #include "sm_io_err.h"
 #include "ddr3_map.h"
 #include "sm_io.h"
+#include "sm_io_acq_stream.h"
+#include "sm_io_acq_pos.h"
+#include "sm_io_acq_cache.h"
 
 typedef struct _acq_params_t {
-      uint32_t num_samples;
+      uint32_t start_addr;          /* Where the acquisition was written.
+                                       The start of the channel region or,
+                                       in ping-pong mode, of one of its banks */
+      uint32_t num_samples;         /* Samples requested, pre + post-trigger */
+      uint32_t num_samples_pre;     /* Pre-trigger samples requested */
+      uint32_t num_samples_pre_hw;  /* Pre-trigger samples written by the
+                                       hardware, after alignment. 0 for
+                                       multi-shot acquisitions */
+      uint32_t num_samples_hw;      /* Samples written by the hardware for
+                                       each shot, after alignment. Size of the
+                                       region of each shot */
+      uint32_t num_shots;           /* Shots, one after the other */
+      bool triggered;               /* Acquisition waited for a trigger */
+      bool trig_off_valid;          /* trig_off was read from the hardware */
+      uint32_t trig_off;            /* Offset of the trigger sample from the
+                                       channel start address, in bytes */
+      bool pos_cal_valid;           /* pos_cal was read from the hardware */
+      acq_pos_cal_t pos_cal;        /* Calibration of a position or an
+                                       amplitude channel, as of the start
+                                       of the acquisition */
 } acq_params_t;
 
 struct _smio_acq_t {
     acq_params_t acq_params[END_CHAN_ID];
     const acq_buf_t *acq_buf;
+    uint32_t trig_type;             /* One of ACQ_TRIG_* */
+    acq_stream_t stream;            /* Streaming acquisition */
+    /* Ping-pong mode. The channel regions are split in two banks and the
+     * acquisitions alternate between them, so the last completed one can
+     * be read while the next one is written */
+    bool pingpong;                  /* Ping-pong mode is on */
+    bool pp_armed;                  /* pp_params is in flight */
+    uint32_t pp_chan;               /* Channel of pp_params */
+    acq_params_t pp_params;         /* Acquisition in flight. Becomes the
+                                       one read by the clients once it is
+                                       over */
+    bool acq_pending;               /* An acquisition out of ping-pong mode
+                                       was started, but not seen over yet */
+    uint32_t acq_pending_chan;      /* Channel of that acquisition */
+    acq_cache_t cache;              /* Last completed acquisition of each
+                                       channel */
 };
 
 /* Opaque class structure */
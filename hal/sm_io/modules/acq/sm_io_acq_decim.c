@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "sm_io_acq_decim.h"
+
+/* The components of a sample fit a vector of 4 lanes, so the reduction of
+ * a sample is a single vector min, max and add. Generic GCC vectors map to
+ * SSE2 or NEON registers, or to plain scalar code otherwise */
+typedef int32_t acq_decim_v4si __attribute__ ((vector_size (16)));
+
+/* Partial sums of 16-bit components can't overflow 32 bits before this
+ * many samples */
+#define ACQ_DECIM_SUM16_SAMPLES         (1 << 15)
+
+static void _acq_decim_reduce_16 (acq_decim_acc_t *acc, const int16_t *data,
+        uint32_t num_samples);
+static void _acq_decim_reduce_32 (acq_decim_acc_t *acc, const int32_t *data,
+        uint32_t num_samples);
+
+void acq_decim_acc_init (acq_decim_acc_t *acc)
+{
+    for (uint32_t i = 0; i < SMIO_ACQ_DECIM_NUM_COMP; i++) {
+        acc->min [i] = INT32_MAX;
+        acc->max [i] = INT32_MIN;
+        acc->sum [i] = 0;
+    }
+    acc->num_samples = 0;
+}
+
+bool acq_decim_sample_size_ok (uint32_t sample_size)
+{
+    return sample_size == SMIO_ACQ_DECIM_NUM_COMP*sizeof (int16_t) ||
+        sample_size == SMIO_ACQ_DECIM_NUM_COMP*sizeof (int32_t);
+}
+
+void acq_decim_reduce (acq_decim_acc_t *acc, const uint8_t *data,
+        uint32_t num_samples, uint32_t sample_size)
+{
+    assert (acq_decim_sample_size_ok (sample_size));
+
+    if (sample_size == SMIO_ACQ_DECIM_NUM_COMP*sizeof (int16_t)) {
+        _acq_decim_reduce_16 (acc, (const int16_t *) data, num_samples);
+    }
+    else {
+        _acq_decim_reduce_32 (acc, (const int32_t *) data, num_samples);
+    }
+    acc->num_samples += num_samples;
+}
+
+void acq_decim_acc_fill (const acq_decim_acc_t *acc,
+        smio_acq_decim_bucket_t *bucket)
+{
+    for (uint32_t i = 0; i < SMIO_ACQ_DECIM_NUM_COMP; i++) {
+        bucket->min [i] = acc->min [i];
+        bucket->max [i] = acc->max [i];
+        bucket->mean [i] = (acc->num_samples == 0) ? 0 :
+            (int32_t) (acc->sum [i] / (int64_t) acc->num_samples);
+    }
+}
+
+/* Lane-wise min and max, with the comparison masks */
+static inline acq_decim_v4si _acq_decim_min (acq_decim_v4si a, acq_decim_v4si b)
+{
+    acq_decim_v4si mask = a < b;
+    return (a & mask) | (b & ~mask);
+}
+
+static inline acq_decim_v4si _acq_decim_max (acq_decim_v4si a, acq_decim_v4si b)
+{
+    acq_decim_v4si mask = a > b;
+    return (a & mask) | (b & ~mask);
+}
+
+static void _acq_decim_reduce_16 (acq_decim_acc_t *acc, const int16_t *data,
+        uint32_t num_samples)
+{
+    acq_decim_v4si vmin, vmax;
+    memcpy (&vmin, acc->min, sizeof (vmin));
+    memcpy (&vmax, acc->max, sizeof (vmax));
+
+    while (num_samples > 0) {
+        uint32_t n = (num_samples > ACQ_DECIM_SUM16_SAMPLES) ?
+            ACQ_DECIM_SUM16_SAMPLES : num_samples;
+        acq_decim_v4si vsum = {0, 0, 0, 0};
+
+        for (uint32_t i = 0; i < n; i++, data += SMIO_ACQ_DECIM_NUM_COMP) {
+            acq_decim_v4si v = {data [0], data [1], data [2], data [3]};
+            vmin = _acq_decim_min (v, vmin);
+            vmax = _acq_decim_max (v, vmax);
+            vsum += v;
+        }
+
+        for (uint32_t i = 0; i < SMIO_ACQ_DECIM_NUM_COMP; i++) {
+            acc->sum [i] += vsum [i];
+        }
+        num_samples -= n;
+    }
+
+    memcpy (acc->min, &vmin, sizeof (vmin));
+    memcpy (acc->max, &vmax, sizeof (vmax));
+}
+
+static void _acq_decim_reduce_32 (acq_decim_acc_t *acc, const int32_t *data,
+        uint32_t num_samples)
+{
+    acq_decim_v4si vmin, vmax;
+    memcpy (&vmin, acc->min, sizeof (vmin));
+    memcpy (&vmax, acc->max, sizeof (vmax));
+    /* The sums need 64 bits */
+    int64_t sum [SMIO_ACQ_DECIM_NUM_COMP] = {0};
+
+    for (uint32_t i = 0; i < num_samples; i++, data += SMIO_ACQ_DECIM_NUM_COMP) {
+        acq_decim_v4si v;
+        memcpy (&v, data, sizeof (v));
+        vmin = _acq_decim_min (v, vmin);
+        vmax = _acq_decim_max (v, vmax);
+        sum [0] += data [0];
+        sum [1] += data [1];
+        sum [2] += data [2];
+        sum [3] += data [3];
+    }
+
+    for (uint32_t i = 0; i < SMIO_ACQ_DECIM_NUM_COMP; i++) {
+        acc->sum [i] += sum [i];
+    }
+
+    memcpy (acc->min, &vmin, sizeof (vmin));
+    memcpy (acc->max, &vmax, sizeof (vmax));
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_ACQ_DECIM_H_
+#define _SM_IO_ACQ_DECIM_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "sm_io_acq_codes.h"
+
+/* Min/max/mean reduction of the samples of a bucket of a decimated curve.
+ * The samples are made of SMIO_ACQ_DECIM_NUM_COMP signed components of 16
+ * bits (ADC channels) or 32 bits (all of the others), reduced
+ * independently */
+struct _acq_decim_acc_t {
+    int32_t min [SMIO_ACQ_DECIM_NUM_COMP];
+    int32_t max [SMIO_ACQ_DECIM_NUM_COMP];
+    int64_t sum [SMIO_ACQ_DECIM_NUM_COMP];
+    uint32_t num_samples;           /* Samples reduced so far */
+};
+
+typedef struct _acq_decim_acc_t acq_decim_acc_t;
+
+/***************** Our methods *****************/
+
+/* Start over an empty bucket */
+void acq_decim_acc_init (acq_decim_acc_t *acc);
+/* Whether samples of "sample_size" bytes can be reduced */
+bool acq_decim_sample_size_ok (uint32_t sample_size);
+/* Reduce "num_samples" samples of "sample_size" bytes into the bucket */
+void acq_decim_reduce (acq_decim_acc_t *acc, const uint8_t *data,
+        uint32_t num_samples, uint32_t sample_size);
+/* Fill the reply bucket with the reduction so far */
+void acq_decim_acc_fill (const acq_decim_acc_t *acc,
+        smio_acq_decim_bucket_t *bucket);
+
+#endif
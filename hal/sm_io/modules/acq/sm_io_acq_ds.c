@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "sm_io_acq_ds.h"
+#include "board.h"
+
+/* Amplitudes come in columns, so consecutive samples are computed at once:
+ * a vector of each of the A, B, C and D columns is converted to doubles,
+ * and every lane goes through the same sums, divisions and threshold masks.
+ * Vectors of 2 doubles fill an SSE2 register. Wider ones are split by the
+ * compiler when AVX is not enabled, which is slower than the scalar loop.
+ * __builtin_convertvector is only available on clang and on GCC 9 on, so
+ * anything else gets the scalar loop */
+#if defined (__clang__) || (defined (__GNUC__) && __GNUC__ >= 9)
+#define ACQ_DS_CONVERTVECTOR
+typedef int16_t acq_ds_v2hi __attribute__ ((vector_size (4)));
+typedef int32_t acq_ds_v2si __attribute__ ((vector_size (8)));
+typedef int64_t acq_ds_v2di __attribute__ ((vector_size (16)));
+typedef double acq_ds_v2df __attribute__ ((vector_size (16)));
+
+/* Samples computed at once */
+#define ACQ_DS_VEC_SAMPLES              2
+#endif
+
+static double _acq_ds_amp (const uint8_t *col, uint32_t comp_size, uint32_t i);
+static void _acq_ds_calc_sample (const acq_pos_cal_t *cal, uint32_t mode,
+        double a, double b, double c, double d, uint8_t *pos);
+#ifdef ACQ_DS_CONVERTVECTOR
+static acq_ds_v2df _acq_ds_amp_vec (const uint8_t *col, uint32_t comp_size,
+        uint32_t i);
+static acq_ds_v2df _acq_ds_mask (acq_ds_v2df v, acq_ds_v2di valid);
+#endif
+
+bool acq_ds_chan_ok (uint32_t chan)
+{
+    return chan == ADC0_CHAN_ID ||
+#ifdef ADCSWAP0_CHAN_ID
+        chan == ADCSWAP0_CHAN_ID ||
+#endif
+        chan == TBTAMP0_CHAN_ID || chan == FOFBAMP0_CHAN_ID ||
+        chan == MONITAMP0_CHAN_ID;
+}
+
+void acq_ds_calc (const acq_pos_cal_t *cal, uint32_t mode, const uint8_t *cols,
+        uint32_t num_samples, uint32_t sample_size, uint8_t *pos)
+{
+    assert (cal);
+    assert (mode < ACQ_DS_MODE_END);
+    assert (sample_size == SMIO_ACQ_NUM_COMP*sizeof (int16_t) ||
+            sample_size == SMIO_ACQ_NUM_COMP*sizeof (int32_t));
+
+    uint32_t comp_size = sample_size / SMIO_ACQ_NUM_COMP;
+    const uint8_t *col_a = cols;
+    const uint8_t *col_b = col_a + num_samples*comp_size;
+    const uint8_t *col_c = col_b + num_samples*comp_size;
+    const uint8_t *col_d = col_c + num_samples*comp_size;
+    uint32_t pos_sample_size = SMIO_ACQ_NUM_COMP*sizeof (double);
+    uint32_t i = 0;
+
+#ifdef ACQ_DS_CONVERTVECTOR
+    const acq_ds_v2df zero = {0.0, 0.0};
+    const acq_ds_v2df one = {1.0, 1.0};
+    const acq_ds_v2df half = {0.5, 0.5};
+    const acq_ds_v2df thres = zero + (double) cal->ds_thres;
+    const acq_ds_v2df kx = zero + (double) cal->kx;
+    const acq_ds_v2df ky = zero + (double) cal->ky;
+    const acq_ds_v2df ksum = zero + cal->scale [3];
+
+    for (; i + ACQ_DS_VEC_SAMPLES <= num_samples; i += ACQ_DS_VEC_SAMPLES) {
+        acq_ds_v2df a = _acq_ds_amp_vec (col_a, comp_size, i);
+        acq_ds_v2df b = _acq_ds_amp_vec (col_b, comp_size, i);
+        acq_ds_v2df c = _acq_ds_amp_vec (col_c, comp_size, i);
+        acq_ds_v2df d = _acq_ds_amp_vec (col_d, comp_size, i);
+
+        acq_ds_v2df sum = (a + b) + (c + d);
+        acq_ds_v2df inv = one / sum;
+        acq_ds_v2di valid = sum > thres;
+        acq_ds_v2df x, y;
+        acq_ds_v2di xy_valid;
+
+        if (mode == ACQ_DS_MODE_PDS) {
+            acq_ds_v2df ac = a + c;
+            acq_ds_v2df db = d + b;
+            acq_ds_v2df r_ac = (a - c) / ac;
+            acq_ds_v2df r_db = (d - b) / db;
+            x = kx * (half * (r_ac + r_db));
+            y = ky * (half * (r_ac - r_db));
+            xy_valid = valid & (ac != zero) & (db != zero);
+        }
+        else {
+            x = kx * (((a + d) - (b + c)) * inv);
+            y = ky * (((a + b) - (c + d)) * inv);
+            xy_valid = valid;
+        }
+
+        /* Lanes divided by 0 are masked out along with the ones under
+         * the threshold */
+        x = _acq_ds_mask (x, xy_valid);
+        y = _acq_ds_mask (y, xy_valid);
+        acq_ds_v2df q = _acq_ds_mask (((a + c) - (b + d)) * inv, valid);
+        sum = sum * ksum;
+
+        for (uint32_t j = 0; j < ACQ_DS_VEC_SAMPLES; j++) {
+            double p [SMIO_ACQ_NUM_COMP] = {x [j], y [j], q [j], sum [j]};
+            memcpy (pos + (i + j)*pos_sample_size, p, sizeof (p));
+        }
+    }
+#endif
+
+    for (; i < num_samples; i++) {
+        _acq_ds_calc_sample (cal, mode,
+                _acq_ds_amp (col_a, comp_size, i),
+                _acq_ds_amp (col_b, comp_size, i),
+                _acq_ds_amp (col_c, comp_size, i),
+                _acq_ds_amp (col_d, comp_size, i),
+                pos + i*pos_sample_size);
+    }
+}
+
+/* Amplitude "i" of a column */
+static double _acq_ds_amp (const uint8_t *col, uint32_t comp_size, uint32_t i)
+{
+    if (comp_size == sizeof (int16_t)) {
+        int16_t amp;
+        memcpy (&amp, col + i*sizeof (amp), sizeof (amp));
+        return amp;
+    }
+
+    int32_t amp;
+    memcpy (&amp, col + i*sizeof (amp), sizeof (amp));
+    return amp;
+}
+
+/* Same operations, in the same order, as the vector loop, so both give the
+ * same results */
+static void _acq_ds_calc_sample (const acq_pos_cal_t *cal, uint32_t mode,
+        double a, double b, double c, double d, uint8_t *pos)
+{
+    double sum = (a + b) + (c + d);
+    double inv = 1.0 / sum;
+    bool valid = sum > (double) cal->ds_thres;
+    double p [SMIO_ACQ_NUM_COMP] = {0.0, 0.0, 0.0, 0.0};
+
+    if (mode == ACQ_DS_MODE_PDS) {
+        double ac = a + c;
+        double db = d + b;
+
+        if (valid && ac != 0.0 && db != 0.0) {
+            double r_ac = (a - c) / ac;
+            double r_db = (d - b) / db;
+            p [0] = cal->kx * (0.5 * (r_ac + r_db));
+            p [1] = cal->ky * (0.5 * (r_ac - r_db));
+        }
+    }
+    else if (valid) {
+        p [0] = cal->kx * (((a + d) - (b + c)) * inv);
+        p [1] = cal->ky * (((a + b) - (c + d)) * inv);
+    }
+
+    if (valid) {
+        p [2] = ((a + c) - (b + d)) * inv;
+    }
+    p [3] = sum * cal->scale [3];
+
+    memcpy (pos, p, sizeof (p));
+}
+
+#ifdef ACQ_DS_CONVERTVECTOR
+/* Amplitudes "i" and "i"+1 of a column */
+static acq_ds_v2df _acq_ds_amp_vec (const uint8_t *col, uint32_t comp_size,
+        uint32_t i)
+{
+    if (comp_size == sizeof (int16_t)) {
+        acq_ds_v2hi amp;
+        memcpy (&amp, col + i*sizeof (int16_t), sizeof (amp));
+        return __builtin_convertvector (amp, acq_ds_v2df);
+    }
+
+    acq_ds_v2si amp;
+    memcpy (&amp, col + i*sizeof (int32_t), sizeof (amp));
+    return __builtin_convertvector (amp, acq_ds_v2df);
+}
+
+/* Lanes of "v" where "valid" is not set are zeroed */
+static acq_ds_v2df _acq_ds_mask (acq_ds_v2df v, acq_ds_v2di valid)
+{
+    return (acq_ds_v2df) ((acq_ds_v2di) v & valid);
+}
+#endif
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_ACQ_DS_H_
+#define _SM_IO_ACQ_DS_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "sm_io_acq_codes.h"
+#include "sm_io_acq_pos.h"
+
+/* The A, B, C and D amplitudes give, as in the position calculation core:
+ *
+ *   X = KX*((A+D)-(B+C))/SUM      Y = KY*((A+B)-(C+D))/SUM
+ *   Q = ((A+C)-(B+D))/SUM         SUM = KSUM*(A+B+C+D)
+ *
+ * With ACQ_DS_MODE_PDS, X and Y are computed from the A/C and B/D pairs
+ * instead, each of them normalized by its own sum:
+ *
+ *   X = KX*((A-C)/(A+C) + (D-B)/(D+B))/2
+ *   Y = KY*((A-C)/(A+C) - (D-B)/(D+B))/2
+ *
+ * X, Y and Q are 0 when SUM is not above the delta over sum threshold, or,
+ * with ACQ_DS_MODE_PDS, when a pair sums to 0 */
+
+/***************** Our methods *****************/
+
+/* Whether channel "chan" holds amplitudes */
+bool acq_ds_chan_ok (uint32_t chan);
+/* Compute the positions of "num_samples" samples of "sample_size" bytes
+ * from their SMIO_ACQ_NUM_COMP columns of amplitudes, in "cols", as laid
+ * out by acq_soa_deinterleave (). The SMIO_ACQ_NUM_COMP doubles of each
+ * sample go to "pos" */
+void acq_ds_calc (const acq_pos_cal_t *cal, uint32_t mode, const uint8_t *cols,
+        uint32_t num_samples, uint32_t sample_size, uint8_t *pos);
+
+#endif
@@ -6,6 +6,7 @@
  */
 
 #include <stdlib.h>
+#include <stddef.h>
 
 #include "sm_io_acq_exp.h"
 #include "sm_io_acq_codes.h"
@@ -16,8 +17,15 @@
 #include "ddr3_map.h"
 #include "board.h"
 #include "rw_param.h"
+#include "rw_param_codes.h"
 #include "wb_acq_core_regs.h"
 #include "sm_io_acq_exports.h"
+#include "sm_io_acq_stream.h"
+#include "sm_io_acq_decim.h"
+#include "sm_io_acq_soa.h"
+#include "sm_io_acq_pos.h"
+#include "sm_io_acq_ds.h"
+#include "sm_io_acq_cache.h"
 #include "hal_stddef.h"
 
 /* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
@@ -45,6 +53,24 @@
 
 #define SMIO_ACQ_HANDLER(self) ((smio_acq_t *) self->smio_handler)
 
+static uint32_t _acq_align_samples (uint32_t num_samples, uint32_t div);
+static bool _acq_is_done (SMIO_OWNER_TYPE *self);
+static bool _acq_check_done (SMIO_OWNER_TYPE *self);
+static void _acq_cache_overwrite (SMIO_OWNER_TYPE *self, uint32_t start_addr,
+        uint32_t size);
+static ssize_t _acq_cache_fill (void *owner, uint32_t chan, uint32_t off,
+        uint32_t size, uint8_t *data);
+static uint32_t _acq_pp_bank_samples (SMIO_OWNER_TYPE *self, uint32_t chan);
+static void _acq_pp_promote (SMIO_OWNER_TYPE *self);
+static ssize_t _acq_read_trig_off (SMIO_OWNER_TYPE *self, uint32_t chan);
+static int _acq_get_block (SMIO_OWNER_TYPE *self, uint32_t chan,
+        uint32_t first_shot, uint32_t num_shots, uint32_t block_n, bool soa,
+        smio_acq_data_block_t *data_block);
+static ssize_t _acq_read_curve (SMIO_OWNER_TYPE *self, uint32_t chan,
+        uint32_t first_shot, uint32_t off, uint32_t size, uint8_t *data);
+static ssize_t _acq_read_curve_hw (SMIO_OWNER_TYPE *self, uint32_t chan,
+        uint32_t first_shot, uint32_t off, uint32_t size, uint8_t *data);
+
 /************************************************************/
 /***************** Specific ACQ Operations ******************/
 /************************************************************/
@@ -61,10 +87,20 @@ static int _acq_data_acquire (void *owner, void *args, void *ret)
 
     /* Message is:
      * frame 0: operation code
-     * frame 1: number of samples
-     * frame 2: channel                 */
-    uint32_t num_samples = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+     * frame 1: number of pre-trigger samples (all of them, if no trigger)
+     * frame 2: channel
+     * frame 3: number of post-trigger samples
+     * frame 4: number of shots */
+    uint32_t num_samples_pre = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
     uint32_t chan = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+    uint32_t num_samples_post = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+    uint32_t num_shots = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+    uint32_t num_samples = num_samples_pre + num_samples_post;
+
+    /* 0 is the same as a single shot */
+    if (num_shots == 0) {
+        num_shots = 1;
+    }
 
     /* channel required is out of the limit */
     if (chan > SMIO_ACQ_NUM_CHANNELS-1) {
@@ -74,8 +110,21 @@ static int _acq_data_acquire (void *owner, void *args, void *ret)
         return -ACQ_NUM_CHAN_OOR;
     }
 
+    /* The core is busy writing the stream ring */
+    if (SMIO_ACQ_HANDLER(self)->stream.running) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] data_acquire: "
+                "A streaming acquisition is running\n");
+        return -ACQ_STREAM_BUSY;
+    }
+
+    /* In ping-pong mode, an acquisition only gets half of the channel
+     * memory */
+    bool pingpong = SMIO_ACQ_HANDLER(self)->pingpong;
+    uint32_t max_samples = pingpong ? _acq_pp_bank_samples (self, chan) :
+        SMIO_ACQ_HANDLER(self)->acq_buf[chan].max_samples;
+
     /* number of samples required is out of the maximum limit */
-    if (num_samples > SMIO_ACQ_HANDLER(self)->acq_buf[chan].max_samples) {
+    if (num_samples < num_samples_pre || num_samples > max_samples) {
         DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] data_acquire: "
                 "Number of samples required is out of the maximum limit\n");
         return -ACQ_NUM_SAMPLES_OOR;
@@ -89,21 +138,55 @@ static int _acq_data_acquire (void *owner, void *args, void *ret)
             "\n\tPrevious acq params for channel #%u: number of samples = %u\n",
             chan, SMIO_ACQ_HANDLER(self)->acq_params[chan].num_samples);
 
-    /* Set the parameters: number of samples of this channel */
-    SMIO_ACQ_HANDLER(self)->acq_params[chan].num_samples = num_samples;
-
-    /* Default SHOTS value is 1 */
-    uint32_t acq_core_shots = ACQ_CORE_SHOTS_NB_W(1);
+    uint32_t trig_type = SMIO_ACQ_HANDLER(self)->trig_type;
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] data_acquire: "
-            "Number of shots = %u\n", acq_core_shots);
-    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_SHOTS, &acq_core_shots);
+            "Trigger type = %u, post-trigger samples = %u\n", trig_type,
+            num_samples_post);
+
+    /* Nothing would tell pre and post-trigger samples, or shots, apart */
+    if (trig_type == ACQ_TRIG_SKIP && (num_samples_post != 0 || num_shots > 1)) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] data_acquire: "
+                "Post-trigger samples and multiple shots require a trigger\n");
+        return -ACQ_NUM_SAMPLES_OOR;
+    }
+
+    /* The core only tells where the trigger of the last shot was. The ones
+     * before it could be anywhere in the pre-trigger samples written while
+     * waiting for it, so the shots of a multi-shot acquisition start right
+     * at their trigger instead */
+    if (num_shots > 1 && (num_samples_pre != 0 || num_samples_post == 0)) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] data_acquire: "
+                "Multiple shots take post-trigger samples only\n");
+        return -ACQ_NUM_SAMPLES_OOR;
+    }
 
     /* FIXME FPGA Firmware requires number of samples to be divisible by
      * acquisition channel sample size */
     uint32_t num_samples_div_pre =
         DDR3_PAYLOAD_SIZE/SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size;
-    uint32_t num_samples_aligned_pre = num_samples + num_samples_div_pre -
-        (num_samples % num_samples_div_pre);
+    uint32_t num_samples_aligned_pre = (num_shots > 1) ? 0 :
+        num_samples_pre + num_samples_div_pre -
+        (num_samples_pre % num_samples_div_pre);
+    /* Post trigger samples. Same alignment as above */
+    uint32_t num_samples_aligned_post = _acq_align_samples (num_samples_post,
+            num_samples_div_pre);
+
+    /* The shots go one after the other in the channel memory. The alignment
+     * could take more than the channel has, too */
+    uint64_t num_samples_hw = (uint64_t) (num_samples_aligned_pre +
+            num_samples_aligned_post) * num_shots;
+    if (num_shots > ACQ_CORE_SHOTS_NB_R(ACQ_CORE_SHOTS_NB_MASK) ||
+            num_samples_hw > max_samples) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] data_acquire: "
+                "Number of shots or of aligned samples is out of the maximum limit\n");
+        return -ACQ_NUM_SAMPLES_OOR;
+    }
+
+    uint32_t acq_core_shots = ACQ_CORE_SHOTS_NB_W(num_shots);
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] data_acquire: "
+            "Number of shots = %u\n", num_shots);
+    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_SHOTS, &acq_core_shots);
+
     /* Pre trigger samples */
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] data_acquire: "
             "Number of pre-trigger samples (aligned to sample size) = %u\n",
@@ -111,22 +194,72 @@ static int _acq_data_acquire (void *owner, void *args, void *ret)
     smio_thsafe_client_write_32 (self, ACQ_CORE_REG_PRE_SAMPLES, &num_samples_aligned_pre);
 
     /* Post trigger samples */
-    uint32_t num_samples_post = 0;
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] data_acquire: "
-            "Number of post-trigger samples = %u\n",
-            num_samples_post);
-    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_POST_SAMPLES, &num_samples_post);
+            "Number of post-trigger samples (aligned to sample size) = %u\n",
+            num_samples_aligned_post);
+    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_POST_SAMPLES, &num_samples_aligned_post);
+
+    /* DDR3 start address, in bytes. In ping-pong mode, the acquisition goes
+     * to the bank not holding the last completed acquisition of the channel,
+     * which clients might be reading. An acquisition still in flight is
+     * replaced by this one */
+    uint32_t start_addr = SMIO_ACQ_HANDLER(self)->acq_buf[chan].start_addr;
+    acq_params_t *acq_params = &SMIO_ACQ_HANDLER(self)->acq_params[chan];
+
+    if (pingpong) {
+        if (SMIO_ACQ_HANDLER(self)->pp_armed && _acq_is_done (self)) {
+            _acq_pp_promote (self);
+        }
+
+        if (acq_params->start_addr == start_addr) {
+            start_addr += _acq_pp_bank_samples (self, chan) *
+                SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size;
+        }
+
+        acq_params = &SMIO_ACQ_HANDLER(self)->pp_params;
+        SMIO_ACQ_HANDLER(self)->pp_chan = chan;
+        SMIO_ACQ_HANDLER(self)->pp_armed = true;
+    }
+
+    /* Set the parameters: number of samples of this channel. The trigger
+     * position is only known once the acquisition is over */
+    acq_params->start_addr = start_addr;
+    acq_params->num_samples = num_samples;
+    acq_params->num_samples_pre = num_samples_pre;
+    acq_params->num_samples_pre_hw = num_samples_aligned_pre;
+    acq_params->num_samples_hw = num_samples_aligned_pre + num_samples_aligned_post;
+    acq_params->num_shots = num_shots;
+    acq_params->triggered = (trig_type != ACQ_TRIG_SKIP);
+    acq_params->trig_off_valid = false;
+
+    /* Positions are calibrated, or computed from the amplitudes, with the
+     * constants in use while they are acquired, so clients don't have to
+     * read them on their own */
+    acq_params->pos_cal_valid = (acq_pos_chan_ok (chan) || acq_ds_chan_ok (chan)) &&
+        acq_pos_cal_read (self, chan, &acq_params->pos_cal) == SMIO_SUCCESS;
+
+    /* Out of ping-pong mode, the last acquisition of the channel is gone.
+     * The curves of the channels sharing the memory written go as well,
+     * unless they are cached in full */
+    SMIO_ACQ_HANDLER(self)->acq_pending = !pingpong;
+    SMIO_ACQ_HANDLER(self)->acq_pending_chan = chan;
+    if (!pingpong) {
+        acq_cache_drop (&SMIO_ACQ_HANDLER(self)->cache, chan);
+    }
+    _acq_cache_overwrite (self, start_addr, acq_params->num_samples_hw *
+            num_shots * SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size);
 
     /* DDR3 start address. Convert Byte address to Word address, as we specify only
      * the start address */
-    uint32_t start_addr = (uint32_t)
-        SMIO_ACQ_HANDLER(self)->acq_buf[chan].start_addr/DDR3_ADDR_WORD_2_BYTE;
+    start_addr /= DDR3_ADDR_WORD_2_BYTE;
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] data_acquire: "
             "DDR3 start address: 0x%08x\n", start_addr);
     smio_thsafe_client_write_32 (self, ACQ_CORE_REG_DDR3_START_ADDR, &start_addr );
 
-    /* Prepare core_ctl register */
-    uint32_t acq_core_ctl_reg = ACQ_CORE_CTL_FSM_ACQ_NOW;
+    /* Prepare core_ctl register. Without ACQ_NOW, the core waits for the
+     * trigger set by acq_cfg_trig */
+    uint32_t acq_core_ctl_reg = acq_params->triggered ? 0 :
+        ACQ_CORE_CTL_FSM_ACQ_NOW;
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] data_acquire: "
             "Control register is: 0x%08x\n",
             acq_core_ctl_reg);
@@ -160,13 +293,7 @@ static int _acq_check_data_acquire (void *owner, void *args, void *ret)
 
     SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
 
-    uint32_t status_done = 0;
-    /* Check for completion */
-    smio_thsafe_client_read_32 (self, ACQ_CORE_REG_STA, &status_done );
-    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] data_acquire: "
-            "Status done = 0x%08x\n", status_done);
-
-    if (!(status_done & ACQ_CORE_STA_DDR3_TRANS_DONE)) {
+    if (!_acq_check_done (self)) {
         DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] acq_check_data_acquire: "
                 "Acquisition is not done\n");
         return -ACQ_NOT_COMPLETED;
@@ -203,6 +330,785 @@ static int _acq_get_data_block (void *owner, void *args, void *ret)
         return -ACQ_NUM_CHAN_OOR;
     }
 
+    /* All of the shots, one after the other */
+    return _acq_get_block (self, chan, 0,
+            SMIO_ACQ_HANDLER(self)->acq_params[chan].num_shots, block_n, false,
+            (smio_acq_data_block_t *) ret);
+}
+
+static int _acq_get_shot_data_block (void *owner, void *args, void *ret)
+{
+    assert (owner);
+    assert (args);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] "
+            "Calling _acq_get_shot_data_block\n");
+
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    /* Message is:
+     * frame 0: channel
+     * frame 1: shot required
+     * frame 2: block required      */
+    uint32_t chan = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+    uint32_t shot = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+    uint32_t block_n = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_shot_data_block: "
+            "chan = %u, shot = %u, block_n = %u\n", chan, shot, block_n);
+
+    /* channel required is out of the limit */
+    if (chan > SMIO_ACQ_NUM_CHANNELS-1) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] get_shot_data_block: "
+                "Channel required is out of the maximum limit\n");
+
+        return -ACQ_NUM_CHAN_OOR;
+    }
+
+    if (shot >= SMIO_ACQ_HANDLER(self)->acq_params[chan].num_shots) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] get_shot_data_block: "
+                "Shot %u of channel %u was not acquired\n", shot, chan);
+
+        return -ACQ_SHOT_OOR;
+    }
+
+    return _acq_get_block (self, chan, shot, 1, block_n, false,
+            (smio_acq_data_block_t *) ret);
+}
+
+static int _acq_get_soa_data_block (void *owner, void *args, void *ret)
+{
+    assert (owner);
+    assert (args);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] "
+            "Calling _acq_get_soa_data_block\n");
+
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    /* Message is:
+     * frame 0: channel
+     * frame 1: block required      */
+    uint32_t chan = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+    uint32_t block_n = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_soa_data_block: "
+            "chan = %u, block_n = %u\n", chan, block_n);
+
+    /* channel required is out of the limit */
+    if (chan > SMIO_ACQ_NUM_CHANNELS-1) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] get_soa_data_block: "
+                "Channel required is out of the maximum limit\n");
+
+        return -ACQ_NUM_CHAN_OOR;
+    }
+
+    /* The same block as get_data_block, in columns */
+    return _acq_get_block (self, chan, 0,
+            SMIO_ACQ_HANDLER(self)->acq_params[chan].num_shots, block_n, true,
+            (smio_acq_data_block_t *) ret);
+}
+
+static int _acq_get_pos_data_block (void *owner, void *args, void *ret)
+{
+    assert (owner);
+    assert (args);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] "
+            "Calling _acq_get_pos_data_block\n");
+
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    /* Message is:
+     * frame 0: channel
+     * frame 1: block required      */
+    uint32_t chan = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+    uint32_t block_n = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_pos_data_block: "
+            "chan = %u, block_n = %u\n", chan, block_n);
+
+    /* channel required is out of the limit */
+    if (chan > SMIO_ACQ_NUM_CHANNELS-1) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] get_pos_data_block: "
+                "Channel required is out of the maximum limit\n");
+
+        return -ACQ_NUM_CHAN_OOR;
+    }
+
+    if (!acq_pos_chan_ok (chan) ||
+            SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size !=
+            SMIO_ACQ_NUM_COMP*sizeof (int32_t)) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] get_pos_data_block: "
+                "Channel %u does not hold positions\n", chan);
+
+        return -ACQ_NOT_POS_CHAN;
+    }
+
+    const acq_params_t *acq_params = &SMIO_ACQ_HANDLER(self)->acq_params[chan];
+    if (!acq_params->pos_cal_valid) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_ERR, "[sm_io:acq] get_pos_data_block: "
+                "No calibration for the last acquisition of channel %u\n", chan);
+
+        return -ACQ_COULD_NOT_READ;
+    }
+
+    /* All of the shots, one after the other, as get_data_block */
+    uint32_t sample_size = SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size;
+    uint32_t num_samples = acq_params->num_samples * acq_params->num_shots;
+    uint64_t first_sample = (uint64_t) block_n * SMIO_ACQ_POS_BLOCK_SAMPLES;
+    if (first_sample >= num_samples) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_ERR, "[sm_io:acq] get_pos_data_block: "
+                "Block %u of channel %u is not valid\n", block_n, chan);
+
+        return -ACQ_BLOCK_OOR;
+    }
+
+    uint32_t n = num_samples - first_sample;
+    if (n > SMIO_ACQ_POS_BLOCK_SAMPLES) {
+        n = SMIO_ACQ_POS_BLOCK_SAMPLES;
+    }
+
+    int retf = -ACQ_COULD_NOT_READ;
+    uint8_t *data = (uint8_t *) malloc (n * sample_size);
+    ASSERT_ALLOC(data, err_data_alloc);
+
+    ssize_t valid_bytes = _acq_read_curve (self, chan, 0,
+            first_sample * sample_size, n * sample_size, data);
+    ASSERT_TEST(valid_bytes == (ssize_t) (n * sample_size),
+            "Could not read the curve", err_read_curve);
+
+    smio_acq_data_block_t *data_block = (smio_acq_data_block_t *) ret;
+    acq_pos_convert (&acq_params->pos_cal, data, n, data_block->data);
+    data_block->valid_bytes = n * SMIO_ACQ_NUM_COMP * sizeof (double);
+    retf = data_block->valid_bytes + sizeof (data_block->valid_bytes);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_pos_data_block: "
+            "%u samples of channel %u converted\n", n, chan);
+
+err_read_curve:
+    free (data);
+err_data_alloc:
+    return retf;
+}
+
+static int _acq_get_ds_data_block (void *owner, void *args, void *ret)
+{
+    assert (owner);
+    assert (args);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] "
+            "Calling _acq_get_ds_data_block\n");
+
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    /* Message is:
+     * frame 0: channel
+     * frame 1: block required
+     * frame 2: position computation */
+    uint32_t chan = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+    uint32_t block_n = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+    uint32_t mode = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_ds_data_block: "
+            "chan = %u, block_n = %u, mode = %u\n", chan, block_n, mode);
+
+    /* channel required is out of the limit */
+    if (chan > SMIO_ACQ_NUM_CHANNELS-1) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] get_ds_data_block: "
+                "Channel required is out of the maximum limit\n");
+
+        return -ACQ_NUM_CHAN_OOR;
+    }
+
+    uint32_t sample_size = SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size;
+    if (!acq_ds_chan_ok (chan) || !acq_soa_sample_size_ok (sample_size)) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] get_ds_data_block: "
+                "Channel %u does not hold amplitudes\n", chan);
+
+        return -ACQ_NOT_AMP_CHAN;
+    }
+
+    if (mode >= ACQ_DS_MODE_END) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] get_ds_data_block: "
+                "Position computation %u is not valid\n", mode);
+
+        return -ACQ_DS_MODE_OOR;
+    }
+
+    const acq_params_t *acq_params = &SMIO_ACQ_HANDLER(self)->acq_params[chan];
+    if (!acq_params->pos_cal_valid) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_ERR, "[sm_io:acq] get_ds_data_block: "
+                "No calibration for the last acquisition of channel %u\n", chan);
+
+        return -ACQ_COULD_NOT_READ;
+    }
+
+    /* Same blocks as get_pos_data_block */
+    uint32_t num_samples = acq_params->num_samples * acq_params->num_shots;
+    uint64_t first_sample = (uint64_t) block_n * SMIO_ACQ_POS_BLOCK_SAMPLES;
+    if (first_sample >= num_samples) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_ERR, "[sm_io:acq] get_ds_data_block: "
+                "Block %u of channel %u is not valid\n", block_n, chan);
+
+        return -ACQ_BLOCK_OOR;
+    }
+
+    uint32_t n = num_samples - first_sample;
+    if (n > SMIO_ACQ_POS_BLOCK_SAMPLES) {
+        n = SMIO_ACQ_POS_BLOCK_SAMPLES;
+    }
+
+    /* The amplitudes are deinterleaved first, so the positions of
+     * consecutive samples can be computed at once */
+    int retf = -ACQ_COULD_NOT_READ;
+    uint8_t *data = (uint8_t *) malloc (n * sample_size);
+    ASSERT_ALLOC(data, err_data_alloc);
+    uint8_t *cols = (uint8_t *) malloc (n * sample_size);
+    ASSERT_ALLOC(cols, err_cols_alloc);
+
+    ssize_t valid_bytes = _acq_read_curve (self, chan, 0,
+            first_sample * sample_size, n * sample_size, data);
+    ASSERT_TEST(valid_bytes == (ssize_t) (n * sample_size),
+            "Could not read the curve", err_read_curve);
+
+    acq_soa_deinterleave (cols, data, n, sample_size);
+
+    smio_acq_data_block_t *data_block = (smio_acq_data_block_t *) ret;
+    acq_ds_calc (&acq_params->pos_cal, mode, cols, n, sample_size,
+            data_block->data);
+    data_block->valid_bytes = n * SMIO_ACQ_NUM_COMP * sizeof (double);
+    retf = data_block->valid_bytes + sizeof (data_block->valid_bytes);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_ds_data_block: "
+            "Positions of %u samples of channel %u computed\n", n, chan);
+
+err_read_curve:
+    free (cols);
+err_cols_alloc:
+    free (data);
+err_data_alloc:
+    return retf;
+}
+
+static int _acq_get_decim_curve (void *owner, void *args, void *ret)
+{
+    assert (owner);
+    assert (args);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] "
+            "Calling _acq_get_decim_curve\n");
+
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    /* Message is:
+     * frame 0: channel
+     * frame 1: number of buckets   */
+    uint32_t chan = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+    uint32_t num_buckets = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_decim_curve: "
+            "chan = %u, num_buckets = %u\n", chan, num_buckets);
+
+    /* channel required is out of the limit */
+    if (chan > SMIO_ACQ_NUM_CHANNELS-1) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] get_decim_curve: "
+                "Channel required is out of the maximum limit\n");
+
+        return -ACQ_NUM_CHAN_OOR;
+    }
+
+    if (num_buckets == 0 || num_buckets > SMIO_ACQ_DECIM_MAX_BUCKETS) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] get_decim_curve: "
+                "Number of buckets is out of range\n");
+
+        return -ACQ_BUCKETS_OOR;
+    }
+
+    uint32_t sample_size = SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size;
+    if (!acq_decim_sample_size_ok (sample_size)) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_ERR, "[sm_io:acq] get_decim_curve: "
+                "Samples of channel %u can't be decimated\n", chan);
+
+        return -ACQ_COULD_NOT_READ;
+    }
+
+    /* All of the shots, one after the other, as get_data_block */
+    const acq_params_t *acq_params = &SMIO_ACQ_HANDLER(self)->acq_params[chan];
+    uint32_t num_samples = acq_params->num_samples * acq_params->num_shots;
+    if (num_buckets > num_samples) {
+        num_buckets = num_samples;
+    }
+
+    smio_acq_decim_curve_t *curve = (smio_acq_decim_curve_t *) ret;
+    curve->num_buckets = num_buckets;
+    curve->num_samples = num_samples;
+
+    int retf = -ACQ_COULD_NOT_READ;
+    uint8_t *data = (uint8_t *) malloc (BLOCK_SIZE);
+    ASSERT_ALLOC(data, err_data_alloc);
+
+    /* Bucket b holds samples b*num_samples/num_buckets up to, but not
+     * including, (b+1)*num_samples/num_buckets. None of them is empty */
+    acq_decim_acc_t acc;
+    acq_decim_acc_init (&acc);
+    uint32_t bucket = 0;
+    uint32_t bucket_end = (num_buckets == 0) ? 0 :
+        (uint64_t) num_samples / num_buckets;
+    uint32_t block_samples = BLOCK_SIZE / sample_size;
+
+    for (uint32_t pos = 0; pos < num_samples; ) {
+        uint32_t n = num_samples - pos;
+        if (n > block_samples) {
+            n = block_samples;
+        }
+
+        ssize_t valid_bytes = _acq_read_curve (self, chan, 0, pos * sample_size,
+                n * sample_size, data);
+        ASSERT_TEST(valid_bytes == (ssize_t) (n * sample_size),
+                "Could not read the curve", err_read_curve);
+
+        for (uint32_t i = 0; i < n; ) {
+            uint32_t k = bucket_end - (pos + i);
+            if (k > n - i) {
+                k = n - i;
+            }
+
+            acq_decim_reduce (&acc, data + i * sample_size, k, sample_size);
+            i += k;
+
+            if (pos + i == bucket_end) {
+                acq_decim_acc_fill (&acc, &curve->buckets[bucket]);
+                acq_decim_acc_init (&acc);
+                bucket++;
+                bucket_end = (uint64_t) (bucket + 1) * num_samples / num_buckets;
+            }
+        }
+
+        pos += n;
+    }
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_decim_curve: "
+            "%u samples of channel %u reduced to %u buckets\n", num_samples,
+            chan, num_buckets);
+    retf = offsetof (smio_acq_decim_curve_t, buckets) +
+        num_buckets * sizeof (smio_acq_decim_bucket_t);
+
+err_read_curve:
+    free (data);
+err_data_alloc:
+    return retf;
+}
+
+RW_PARAM_FUNC(acq, cfg_trig) {
+    assert (owner);
+    assert (args);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] "
+            "Calling _acq_set_get_cfg_trig\n");
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    /* Message is:
+     * frame 0: operation code
+     * frame 1: rw      R /W    1 = read mode, 0 = write mode
+     * frame 2: trigger type (rw = 0) or dummy value (rw = 1) */
+    uint32_t rw = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+    uint32_t trig_type = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+
+    if (rw) {
+        *(uint32_t *) ret = SMIO_ACQ_HANDLER(self)->trig_type;
+        return sizeof (uint32_t);
+    }
+
+    if (trig_type >= ACQ_TRIG_END) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] cfg_trig: "
+                "Invalid trigger type %u\n", trig_type);
+        return -RW_USR_ERR;
+    }
+
+    uint32_t trig_cfg = 0;
+    ssize_t rw_bytes = smio_thsafe_client_read_32 (self, ACQ_CORE_REG_TRIG_CFG,
+            &trig_cfg);
+    if (rw_bytes != sizeof (uint32_t)) {
+        return -RW_READ_EAGAIN;
+    }
+
+    /* Keep the polarity and the data-driven trigger settings */
+    trig_cfg &= ~(ACQ_CORE_TRIG_CFG_HW_TRIG_SEL | ACQ_CORE_TRIG_CFG_HW_TRIG_EN |
+            ACQ_CORE_TRIG_CFG_SW_TRIG_EN);
+    switch (trig_type) {
+        case ACQ_TRIG_EXTERNAL:
+            trig_cfg |= ACQ_CORE_TRIG_CFG_HW_TRIG_EN | ACQ_CORE_TRIG_CFG_HW_TRIG_SEL;
+            break;
+        case ACQ_TRIG_DATA_DRIVEN:
+            trig_cfg |= ACQ_CORE_TRIG_CFG_HW_TRIG_EN;
+            break;
+        case ACQ_TRIG_SOFTWARE:
+            trig_cfg |= ACQ_CORE_TRIG_CFG_SW_TRIG_EN;
+            break;
+        default:
+            break;
+    }
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] cfg_trig: "
+            "Trigger configuration register is: 0x%08x\n", trig_cfg);
+    rw_bytes = smio_thsafe_client_write_32 (self, ACQ_CORE_REG_TRIG_CFG,
+            &trig_cfg);
+    if (rw_bytes != sizeof (uint32_t)) {
+        return -RW_WRITE_EAGAIN;
+    }
+
+    SMIO_ACQ_HANDLER(self)->trig_type = trig_type;
+    return -RW_OK;
+}
+
+RW_PARAM_FUNC(acq, hw_trig_pol) {
+    SET_GET_PARAM(acq, 0x0, ACQ_CORE, TRIG_CFG, HW_TRIG_POL, SINGLE_BIT_PARAM,
+            /* No minimum check*/, /* No maximum check */, NO_CHK_FUNC,
+            NO_FMT_FUNC, SET_FIELD);
+}
+
+#define HW_DATA_TRIG_SEL_MIN                0
+#define HW_DATA_TRIG_SEL_MAX                ((1<<2)-1)
+RW_PARAM_FUNC(acq, hw_data_trig_sel) {
+    SET_GET_PARAM(acq, 0x0, ACQ_CORE, TRIG_CFG, INT_TRIG_SEL, MULT_BIT_PARAM,
+            HW_DATA_TRIG_SEL_MIN, HW_DATA_TRIG_SEL_MAX, NO_CHK_FUNC,
+            NO_FMT_FUNC, SET_FIELD);
+}
+
+#define HW_DATA_TRIG_THRES_MIN              0
+#define HW_DATA_TRIG_THRES_MAX              ((1<<16)-1)
+RW_PARAM_FUNC(acq, hw_data_trig_thres) {
+    SET_GET_PARAM(acq, 0x0, ACQ_CORE, TRIG_CFG, INT_TRIG_THRES, MULT_BIT_PARAM,
+            HW_DATA_TRIG_THRES_MIN, HW_DATA_TRIG_THRES_MAX, NO_CHK_FUNC,
+            NO_FMT_FUNC, SET_FIELD);
+}
+
+#define ACQ_CORE_TRIG_DLY_R(val)            (val)
+#define ACQ_CORE_TRIG_DLY_W(val)            (val)
+#define ACQ_CORE_TRIG_DLY_MASK              ((1ULL<<32)-1)
+RW_PARAM_FUNC(acq, hw_trig_dly) {
+    SET_GET_PARAM(acq, 0x0, ACQ_CORE, TRIG_DLY, /* No field */, MULT_BIT_PARAM,
+            /* No minimum check*/, /* No maximum check */, NO_CHK_FUNC,
+            NO_FMT_FUNC, SET_FIELD);
+}
+
+/* Writing to it fires the software trigger */
+#define ACQ_CORE_SW_TRIG_R(val)             (val)
+#define ACQ_CORE_SW_TRIG_W(val)             (val)
+#define ACQ_CORE_SW_TRIG_MASK               ((1ULL<<32)-1)
+RW_PARAM_FUNC(acq, sw_trig) {
+    SET_GET_PARAM(acq, 0x0, ACQ_CORE, SW_TRIG, /* No field */, MULT_BIT_PARAM,
+            /* No minimum check*/, /* No maximum check */, NO_CHK_FUNC,
+            NO_FMT_FUNC, SET_FIELD);
+}
+
+/* Gives up on an acquisition still waiting for its trigger */
+RW_PARAM_FUNC(acq, fsm_stop) {
+    SET_GET_PARAM(acq, 0x0, ACQ_CORE, CTL, FSM_STOP_ACQ, SINGLE_BIT_PARAM,
+            /* No minimum check*/, /* No maximum check */, NO_CHK_FUNC,
+            NO_FMT_FUNC, SET_FIELD);
+}
+
+RW_PARAM_FUNC(acq, pingpong) {
+    assert (owner);
+    assert (args);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] "
+            "Calling _acq_set_get_pingpong\n");
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    /* Message is:
+     * frame 0: operation code
+     * frame 1: rw      R /W    1 = read mode, 0 = write mode
+     * frame 2: ping-pong mode (rw = 0) or dummy value (rw = 1) */
+    uint32_t rw = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+    uint32_t pingpong = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+
+    if (rw) {
+        *(uint32_t *) ret = SMIO_ACQ_HANDLER(self)->pingpong;
+        return sizeof (uint32_t);
+    }
+
+    if (pingpong > 1) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] pingpong: "
+                "Invalid ping-pong mode %u\n", pingpong);
+        return -RW_USR_ERR;
+    }
+
+    /* An acquisition armed in the other mode is forgotten. It is still
+     * there for the clients if it is over and check_data_acquire was
+     * called */
+    SMIO_ACQ_HANDLER(self)->pingpong = pingpong;
+    SMIO_ACQ_HANDLER(self)->pp_armed = false;
+    return -RW_OK;
+}
+
+static int _acq_stream_start (void *owner, void *args, void *ret)
+{
+    (void) ret;
+    assert (owner);
+    assert (args);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] "
+            "Calling _acq_stream_start\n");
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    /* Message is:
+     * frame 0: channel
+     * frame 1: number of samples of the ring */
+    uint32_t chan = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+    uint32_t num_samples = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+
+    int retf = acq_stream_start (self, chan, num_samples);
+    /* The stream takes the core over, and its ring the start of the
+     * channel memory */
+    if (retf == -ACQ_OK) {
+        SMIO_ACQ_HANDLER(self)->pp_armed = false;
+        SMIO_ACQ_HANDLER(self)->acq_pending = false;
+        _acq_cache_overwrite (self, SMIO_ACQ_HANDLER(self)->acq_buf[chan].start_addr,
+                SMIO_ACQ_HANDLER(self)->stream.num_samples *
+                SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size);
+    }
+
+    return retf;
+}
+
+static int _acq_stream_stop (void *owner, void *args, void *ret)
+{
+    (void) args;
+    (void) ret;
+    assert (owner);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] "
+            "Calling _acq_stream_stop\n");
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    return acq_stream_stop (self);
+}
+
+static int _acq_stream_status (void *owner, void *args, void *ret)
+{
+    (void) args;
+    assert (owner);
+    assert (ret);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] "
+            "Calling _acq_stream_status\n");
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    acq_stream_status (self, (smio_acq_stream_status_t *) ret);
+    return sizeof (smio_acq_stream_status_t);
+}
+
+static int _acq_get_gen (void *owner, void *args, void *ret)
+{
+    assert (owner);
+    assert (args);
+    assert (ret);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] "
+            "Calling _acq_get_gen\n");
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    /* Message is:
+     * frame 0: channel
+     * frame 1: generation already known */
+    uint32_t chan = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+    uint32_t min_gen = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+
+    /* channel required is out of the limit */
+    if (chan > SMIO_ACQ_NUM_CHANNELS-1) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq] get_gen: "
+                "Channel required is out of the maximum limit\n");
+
+        return -ACQ_NUM_CHAN_OOR;
+    }
+
+    /* Readers may be waiting on an acquisition nobody checks for */
+    _acq_check_done (self);
+
+    uint32_t gen = acq_cache_gen (&SMIO_ACQ_HANDLER(self)->cache, chan);
+    if (gen <= min_gen) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_gen: "
+                "Channel %u is at generation %u\n", chan, gen);
+        return -ACQ_NOT_COMPLETED;
+    }
+
+    *(uint32_t *) ret = gen;
+    return sizeof (uint32_t);
+}
+
+/* Exported function pointers */
+const disp_table_func_fp acq_exp_fp [] = {
+    _acq_data_acquire,
+    _acq_check_data_acquire,
+    _acq_get_data_block,
+    RW_PARAM_FUNC_NAME(acq, cfg_trig),
+    RW_PARAM_FUNC_NAME(acq, hw_trig_pol),
+    RW_PARAM_FUNC_NAME(acq, hw_data_trig_sel),
+    RW_PARAM_FUNC_NAME(acq, hw_data_trig_thres),
+    RW_PARAM_FUNC_NAME(acq, hw_trig_dly),
+    RW_PARAM_FUNC_NAME(acq, sw_trig),
+    RW_PARAM_FUNC_NAME(acq, fsm_stop),
+    _acq_get_shot_data_block,
+    _acq_stream_start,
+    _acq_stream_stop,
+    _acq_stream_status,
+    RW_PARAM_FUNC_NAME(acq, pingpong),
+    _acq_get_decim_curve,
+    _acq_get_soa_data_block,
+    _acq_get_pos_data_block,
+    _acq_get_ds_data_block,
+    _acq_get_gen,
+    NULL
+};
+
+/* Bits accepted by the set/get operations above, so values from the
+ * configuration file can be checked before they are written */
+const smio_param_mask_t acq_param_masks [] = {
+    {ACQ_OPCODE_HW_TRIG_POL,
+        RW_PARAM_MASK(ACQ_CORE, TRIG_CFG, HW_TRIG_POL, SINGLE_BIT_PARAM)},
+    {ACQ_OPCODE_HW_DATA_TRIG_SEL,
+        RW_PARAM_MASK(ACQ_CORE, TRIG_CFG, INT_TRIG_SEL, MULT_BIT_PARAM)},
+    {ACQ_OPCODE_HW_DATA_TRIG_THRES,
+        RW_PARAM_MASK(ACQ_CORE, TRIG_CFG, INT_TRIG_THRES, MULT_BIT_PARAM)},
+    {ACQ_OPCODE_FSM_STOP,
+        RW_PARAM_MASK(ACQ_CORE, CTL, FSM_STOP_ACQ, SINGLE_BIT_PARAM)},
+    /* Ping-pong mode is either on or off */
+    {ACQ_OPCODE_PINGPONG, 0x1},
+    SMIO_PARAM_MASK_END
+};
+
+/* Round up to a multiple of div. 0 stays 0 */
+static uint32_t _acq_align_samples (uint32_t num_samples, uint32_t div)
+{
+    return ((num_samples + div - 1) / div) * div;
+}
+
+/* Whether the last acquisition started is over */
+static bool _acq_is_done (SMIO_OWNER_TYPE *self)
+{
+    uint32_t status_done = 0;
+    smio_thsafe_client_read_32 (self, ACQ_CORE_REG_STA, &status_done );
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] data_acquire: "
+            "Status done = 0x%08x\n", status_done);
+
+    return status_done & ACQ_CORE_STA_DDR3_TRANS_DONE;
+}
+
+/* Whether the last acquisition started is over. The first time it is seen
+ * over, it becomes the one read by the clients of its channel */
+static bool _acq_check_done (SMIO_OWNER_TYPE *self)
+{
+    if (!_acq_is_done (self)) {
+        return false;
+    }
+
+    if (SMIO_ACQ_HANDLER(self)->pp_armed) {
+        _acq_pp_promote (self);
+    }
+
+    if (SMIO_ACQ_HANDLER(self)->acq_pending) {
+        uint32_t chan = SMIO_ACQ_HANDLER(self)->acq_pending_chan;
+        const acq_params_t *acq_params = &SMIO_ACQ_HANDLER(self)->acq_params[chan];
+
+        SMIO_ACQ_HANDLER(self)->acq_pending = false;
+        acq_cache_complete (&SMIO_ACQ_HANDLER(self)->cache, chan,
+                acq_params->num_samples * acq_params->num_shots *
+                SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size);
+    }
+
+    return true;
+}
+
+/* "size" bytes are about to be written from byte address "start_addr" on.
+ * The cached curves of the channels in the way can't be filled from the
+ * DDR3 anymore */
+static void _acq_cache_overwrite (SMIO_OWNER_TYPE *self, uint32_t start_addr,
+        uint32_t size)
+{
+    uint64_t end_addr = (uint64_t) start_addr + size;
+
+    for (uint32_t i = 0; i < END_CHAN_ID; i++) {
+        const acq_params_t *acq_params = &SMIO_ACQ_HANDLER(self)->acq_params[i];
+        uint64_t region_end = acq_params->start_addr + (uint64_t)
+            acq_params->num_samples_hw * acq_params->num_shots *
+            SMIO_ACQ_HANDLER(self)->acq_buf[i].sample_size;
+
+        if (acq_params->start_addr < end_addr && start_addr < region_end) {
+            acq_cache_overwrite (&SMIO_ACQ_HANDLER(self)->cache, i);
+        }
+    }
+}
+
+/* Size of each of the two ping-pong banks of a channel, in samples. Aligned
+ * as the acquisitions, so the second bank starts at a DDR3 word */
+static uint32_t _acq_pp_bank_samples (SMIO_OWNER_TYPE *self, uint32_t chan)
+{
+    uint32_t num_samples_div =
+        DDR3_PAYLOAD_SIZE/SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size;
+    return SMIO_ACQ_HANDLER(self)->acq_buf[chan].max_samples / 2 /
+        num_samples_div * num_samples_div;
+}
+
+/* The armed ping-pong acquisition is over. Make it the one read by the
+ * clients of its channel */
+static void _acq_pp_promote (SMIO_OWNER_TYPE *self)
+{
+    uint32_t chan = SMIO_ACQ_HANDLER(self)->pp_chan;
+    acq_params_t *acq_params = &SMIO_ACQ_HANDLER(self)->acq_params[chan];
+
+    *acq_params = SMIO_ACQ_HANDLER(self)->pp_params;
+    SMIO_ACQ_HANDLER(self)->pp_armed = false;
+    acq_cache_complete (&SMIO_ACQ_HANDLER(self)->cache, chan,
+            acq_params->num_samples * acq_params->num_shots *
+            SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size);
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] pingpong: "
+            "Acquisition of channel %u at 0x%08x is complete\n", chan,
+            acq_params->start_addr);
+
+    /* The trigger position only holds until the next acquisition starts */
+    if (acq_params->triggered && acq_params->num_shots == 1) {
+        _acq_read_trig_off (self, chan);
+    }
+}
+
+/* Offset of the trigger sample from the acquisition start address, in bytes.
+ * Read from the hardware once per acquisition. Returns -1 on error */
+static ssize_t _acq_read_trig_off (SMIO_OWNER_TYPE *self, uint32_t chan)
+{
+    acq_params_t *acq_params = &SMIO_ACQ_HANDLER(self)->acq_params[chan];
+    if (acq_params->trig_off_valid) {
+        return acq_params->trig_off;
+    }
+
+    /* Word address, as the start address */
+    uint32_t trig_pos = 0;
+    ssize_t rw_bytes = smio_thsafe_client_read_32 (self, ACQ_CORE_REG_TRIG_POS,
+            &trig_pos);
+    if (rw_bytes != sizeof (uint32_t)) {
+        return -1;
+    }
+
+    uint32_t trig_addr = trig_pos * DDR3_ADDR_WORD_2_BYTE;
+    uint32_t start_addr = acq_params->start_addr;
+    uint32_t region_size = acq_params->num_samples_hw *
+        SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size;
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_data_block: "
+            "Trigger address of channel %u = 0x%08x\n", chan, trig_addr);
+
+    if (trig_addr < start_addr || trig_addr - start_addr >= region_size) {
+        return -1;
+    }
+
+    acq_params->trig_off = trig_addr - start_addr;
+    acq_params->trig_off_valid = true;
+    return acq_params->trig_off;
+}
+
+/* Read block "block_n" of the curve made of shots "first_shot" to
+ * "first_shot + num_shots - 1" of a channel, one after the other. With
+ * "soa", the samples of the block are deinterleaved in columns */
+static int _acq_get_block (SMIO_OWNER_TYPE *self, uint32_t chan,
+        uint32_t first_shot, uint32_t num_shots, uint32_t block_n, bool soa,
+        smio_acq_data_block_t *data_block)
+{
     /* Channel features */
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_data_block: "
             "\t[channel = %u], id = %u, start addr = 0x%08x\n"
@@ -229,7 +1135,7 @@ static int _acq_get_data_block (void *owner, void *args, void *ret)
 
     /* Get number of samples */
     uint32_t num_samples =
-        SMIO_ACQ_HANDLER(self)->acq_params[chan].num_samples;
+        SMIO_ACQ_HANDLER(self)->acq_params[chan].num_samples * num_shots;
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_data_block: "
             "last num_samples = %u\n", num_samples);
 
@@ -267,21 +1173,34 @@ static int _acq_get_data_block (void *owner, void *args, void *ret)
             "Reading block %u of channel %u with %u valid samples\n",
             block_n, chan, reply_size);
 
-    uint32_t addr_i = SMIO_ACQ_HANDLER(self)->acq_buf[chan].start_addr +
-        block_n * BLOCK_SIZE;
-    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_data_block: "
-            "Block %u of channel %u start address = 0x%08x\n", block_n,
-            chan, addr_i);
+    uint32_t sample_size = SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size;
+    if (soa && !acq_soa_sample_size_ok (sample_size)) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_ERR, "[sm_io:acq] get_data_block: "
+                "Samples of channel %u can't be deinterleaved\n", chan);
+        return -ACQ_COULD_NOT_READ;
+    }
 
-    smio_acq_data_block_t *data_block = (smio_acq_data_block_t *) ret;
+    /* The samples are read as they are in memory and deinterleaved to the
+     * reply afterwards */
+    uint8_t *data = data_block->data;
+    if (soa) {
+        data = (uint8_t *) malloc (reply_size);
+        ASSERT_ALLOC(data, err_data_alloc);
+    }
 
-    /* Here we must use the "raw" version, as we can't have
-     * LARGE_MEM_ADDR mangled with the bas address of this SMIO */
-    ssize_t valid_bytes = smio_thsafe_raw_client_read_block (self, LARGE_MEM_ADDR | addr_i,
-            reply_size, (uint32_t *) data_block->data);
+    ssize_t valid_bytes = _acq_read_curve (self, chan, first_shot,
+            block_n * BLOCK_SIZE, reply_size, data);
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_data_block: "
             "%ld bytes read\n", valid_bytes);
 
+    if (soa) {
+        if (valid_bytes > 0) {
+            acq_soa_deinterleave (data_block->data, data,
+                    valid_bytes / sample_size, sample_size);
+        }
+        free (data);
+    }
+
     /* Check if we could read successfully */
     int retf = 0;
     if (valid_bytes >= 0) {
@@ -294,15 +1213,110 @@ static int _acq_get_data_block (void *owner, void *args, void *ret)
     }
 
     return retf;
+
+err_data_alloc:
+    return -ACQ_COULD_NOT_READ;
 }
 
-/* Exported function pointers */
-const disp_table_func_fp acq_exp_fp [] = {
-    _acq_data_acquire,
-    _acq_check_data_acquire,
-    _acq_get_data_block,
-    NULL
-};
+/* Read "size" bytes of the curve made of the shots from "first_shot" on,
+ * starting at byte "off" of it. Returns the number of bytes read or -1 on
+ * error. The last completed acquisition of a channel is read from the DDR3
+ * only once, the following reads are served by the cache */
+static ssize_t _acq_read_curve (SMIO_OWNER_TYPE *self, uint32_t chan,
+        uint32_t first_shot, uint32_t off, uint32_t size, uint8_t *data)
+{
+    uint32_t curve_size = SMIO_ACQ_HANDLER(self)->acq_params[chan].num_samples *
+        SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size;
+
+    return acq_cache_read (&SMIO_ACQ_HANDLER(self)->cache, chan,
+            first_shot * curve_size + off, size, data, _acq_cache_fill, self);
+}
+
+/* Fill the cache of channel "chan" from the DDR3 */
+static ssize_t _acq_cache_fill (void *owner, uint32_t chan, uint32_t off,
+        uint32_t size, uint8_t *data)
+{
+    return _acq_read_curve_hw ((SMIO_OWNER_TYPE *) owner, chan, 0, off, size,
+            data);
+}
+
+/* Same as _acq_read_curve, but always from the DDR3.
+ *
+ * Each shot has its own region of "num_samples_hw" samples in the channel
+ * memory, one after the other. While waiting for the trigger of a single
+ * shot acquisition, the core writes the pre-trigger samples circularly in
+ * its region, so the curve starts "num_samples_pre" samples before the
+ * trigger and might wrap around the end of the region. It is reordered
+ * here, so the client gets it in time order. The shots of a multi-shot
+ * acquisition have no pre-trigger samples and start at their region */
+static ssize_t _acq_read_curve_hw (SMIO_OWNER_TYPE *self, uint32_t chan,
+        uint32_t first_shot, uint32_t off, uint32_t size, uint8_t *data)
+{
+    const acq_params_t *acq_params = &SMIO_ACQ_HANDLER(self)->acq_params[chan];
+    uint32_t start_addr = acq_params->start_addr;
+    uint32_t sample_size = SMIO_ACQ_HANDLER(self)->acq_buf[chan].sample_size;
+    uint32_t region_size = acq_params->num_samples_hw * sample_size;
+    uint32_t curve_size = acq_params->num_samples * sample_size;
+    /* Offset of the first curve sample from the start of the region */
+    uint32_t curve_off = 0;
+
+    if (acq_params->triggered) {
+        /* Without pre-trigger samples, the trigger is the first sample
+         * written. data_acquire only lets a single shot have them */
+        ssize_t trig_off = 0;
+        if (acq_params->num_samples_pre_hw != 0) {
+            trig_off = _acq_read_trig_off (self, chan);
+        }
+
+        if (trig_off < 0) {
+            DBE_DEBUG (DBG_SM_IO | DBG_LVL_ERR, "[sm_io:acq] get_data_block: "
+                    "Could not read the trigger position of channel %u\n", chan);
+            return -1;
+        }
+
+        curve_off = (trig_off + region_size -
+                (acq_params->num_samples_pre * sample_size) % region_size) %
+            region_size;
+    }
+
+    uint32_t read_bytes = 0;
+    while (read_bytes < size) {
+        uint32_t shot = first_shot + off / curve_size;
+        uint32_t shot_off = off % curve_size;
+        uint32_t region_off = (curve_off + shot_off) % region_size;
+
+        /* Stop at the end of the curve or at the end of the region */
+        uint32_t chunk_size = size - read_bytes;
+        if (chunk_size > curve_size - shot_off) {
+            chunk_size = curve_size - shot_off;
+        }
+        if (chunk_size > region_size - region_off) {
+            chunk_size = region_size - region_off;
+        }
+
+        uint32_t addr_i = start_addr + shot * region_size + region_off;
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq] get_data_block: "
+                "Reading %u bytes of shot %u of channel %u at address 0x%08x\n",
+                chunk_size, shot, chan, addr_i);
+
+        /* Here we must use the "raw" version, as we can't have
+         * LARGE_MEM_ADDR mangled with the bas address of this SMIO */
+        ssize_t chunk_bytes = smio_thsafe_raw_client_read_block (self,
+                LARGE_MEM_ADDR | addr_i, chunk_size,
+                (uint32_t *) (data + read_bytes));
+        if (chunk_bytes < 0) {
+            return -1;
+        }
+
+        read_bytes += chunk_bytes;
+        off += chunk_bytes;
+        if (chunk_bytes != (ssize_t) chunk_size) {
+            break;
+        }
+    }
+
+    return read_bytes;
+}
 
 /************************************************************/
 /***************** Export methods functions *****************/
@@ -356,12 +1370,26 @@ smio_err_e acq_do_op (void *self, void *msg)
     return _acq_do_op (self, msg);
 }
 
+/* Publish the new samples of the stream, if any */
+smio_err_e acq_tick (smio_t *self)
+{
+    return acq_stream_tick (self);
+}
+
+/* Only a running stream has anything to publish */
+bool acq_tick_pending (smio_t *self)
+{
+    return acq_stream_is_running (self);
+}
+
 const smio_ops_t acq_ops = {
     .attach             = acq_attach,          /* Attach sm_io instance to dev_io */
     .deattach           = acq_deattach,        /* Deattach sm_io instance to dev_io */
     .export_ops         = acq_export_ops,      /* Export sm_io operations to dev_io */
     .unexport_ops       = acq_unexport_ops,    /* Unexport sm_io operations to dev_io */
-    .do_op              = acq_do_op            /* Generic wrapper for handling specific operations */
+    .do_op              = acq_do_op,           /* Generic wrapper for handling specific operations */
+    .tick               = acq_tick,            /* Periodic work, between requests */
+    .tick_pending       = acq_tick_pending     /* Whether there is periodic work */
 };
 
 /************************************************************/
@@ -393,6 +1421,7 @@ smio_err_e acq_init (smio_t * self)
             "function descriptors with the callbacks", err_fill_desc);
 
     self->exp_ops = acq_exp_ops;
+    self->param_masks = acq_param_masks;
 
     /* Initialize specific structure */
     self->smio_handler = smio_acq_new (self, 0); /* Default: num_samples = 0 */
@@ -412,8 +1441,12 @@ smio_err_e acq_shutdown (smio_t *self)
 {
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq_exp] Shutting down acq\n");
 
+    /* A running stream is left to the core. The DEVIO may not be
+     * listening to us anymore */
+    acq_stream_close (self);
     smio_acq_destroy ((smio_acq_t **)&self->smio_handler);
     self->exp_ops = NULL;
+    self->param_masks = NULL;
     self->thsafe_client_ops = NULL;
     self->ops = NULL;
     free (self->name);
@@ -15,6 +15,7 @@
 
 /* Known modules IDs (from SDB records defined in FPGA) */
 #define ACQ_SDB_DEVID       0x4519a0ad
+#define ACQ_SDB_VENDORID    0x1000000000001215ULL
 #define ACQ_SDB_NAME        "ACQ"
 
 extern const smio_bootstrap_ops_t acq_bootstrap_ops;
@@ -16,6 +16,8 @@ disp_op_t acq_data_acquire_exp = {
     .retval = DISP_ARG_END,
     .retval_owner = DISP_OWNER_OTHER,
     .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_END
@@ -27,6 +29,7 @@ disp_op_t acq_check_data_acquire_exp = {
     .opcode = ACQ_OPCODE_CHECK_DATA_ACQUIRE,
     .retval = DISP_ARG_END,
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_READ_ONLY | DISP_OP_FLAG_MOD_STATE,
     .args = {
         DISP_ARG_END
     }
@@ -37,6 +40,224 @@ disp_op_t acq_get_data_block_exp = {
     .opcode = ACQ_OPCODE_GET_DATA_BLOCK,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_STRUCT, smio_acq_data_block_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_READ_ONLY | DISP_OP_FLAG_MOD_STATE,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_cfg_trig_exp = {
+    .name = ACQ_NAME_CFG_TRIG,
+    .opcode = ACQ_OPCODE_CFG_TRIG,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_hw_trig_pol_exp = {
+    .name = ACQ_NAME_HW_TRIG_POL,
+    .opcode = ACQ_OPCODE_HW_TRIG_POL,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_hw_data_trig_sel_exp = {
+    .name = ACQ_NAME_HW_DATA_TRIG_SEL,
+    .opcode = ACQ_OPCODE_HW_DATA_TRIG_SEL,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_hw_data_trig_thres_exp = {
+    .name = ACQ_NAME_HW_DATA_TRIG_THRES,
+    .opcode = ACQ_OPCODE_HW_DATA_TRIG_THRES,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_hw_trig_dly_exp = {
+    .name = ACQ_NAME_HW_TRIG_DLY,
+    .opcode = ACQ_OPCODE_HW_TRIG_DLY,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_sw_trig_exp = {
+    .name = ACQ_NAME_SW_TRIG,
+    .opcode = ACQ_OPCODE_SW_TRIG,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_fsm_stop_exp = {
+    .name = ACQ_NAME_FSM_STOP,
+    .opcode = ACQ_OPCODE_FSM_STOP,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_get_shot_data_block_exp = {
+    .name = ACQ_NAME_GET_SHOT_DATA_BLOCK,
+    .opcode = ACQ_OPCODE_GET_SHOT_DATA_BLOCK,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_STRUCT, smio_acq_data_block_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_READ_ONLY | DISP_OP_FLAG_MOD_STATE,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_stream_start_exp = {
+    .name = ACQ_NAME_STREAM_START,
+    .opcode = ACQ_OPCODE_STREAM_START,
+    .retval = DISP_ARG_END,
+    .retval_owner = DISP_OWNER_OTHER,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_stream_stop_exp = {
+    .name = ACQ_NAME_STREAM_STOP,
+    .opcode = ACQ_OPCODE_STREAM_STOP,
+    .retval = DISP_ARG_END,
+    .retval_owner = DISP_OWNER_OTHER,
+    .args = {
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_stream_status_exp = {
+    .name = ACQ_NAME_STREAM_STATUS,
+    .opcode = ACQ_OPCODE_STREAM_STATUS,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_STRUCT, smio_acq_stream_status_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_READ_ONLY,
+    .args = {
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_pingpong_exp = {
+    .name = ACQ_NAME_PINGPONG,
+    .opcode = ACQ_OPCODE_PINGPONG,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_get_decim_curve_exp = {
+    .name = ACQ_NAME_GET_DECIM_CURVE,
+    .opcode = ACQ_OPCODE_GET_DECIM_CURVE,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_STRUCT, smio_acq_decim_curve_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_READ_ONLY | DISP_OP_FLAG_MOD_STATE,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_get_soa_data_block_exp = {
+    .name = ACQ_NAME_GET_SOA_DATA_BLOCK,
+    .opcode = ACQ_OPCODE_GET_SOA_DATA_BLOCK,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_STRUCT, smio_acq_data_block_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_READ_ONLY | DISP_OP_FLAG_MOD_STATE,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_get_pos_data_block_exp = {
+    .name = ACQ_NAME_GET_POS_DATA_BLOCK,
+    .opcode = ACQ_OPCODE_GET_POS_DATA_BLOCK,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_STRUCT, smio_acq_data_block_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_READ_ONLY | DISP_OP_FLAG_MOD_STATE,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_get_ds_data_block_exp = {
+    .name = ACQ_NAME_GET_DS_DATA_BLOCK,
+    .opcode = ACQ_OPCODE_GET_DS_DATA_BLOCK,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_STRUCT, smio_acq_data_block_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_READ_ONLY | DISP_OP_FLAG_MOD_STATE,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+disp_op_t acq_get_gen_exp = {
+    .name = ACQ_NAME_GET_GEN,
+    .opcode = ACQ_OPCODE_GET_GEN,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_READ_ONLY | DISP_OP_FLAG_MOD_STATE,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -49,6 +270,23 @@ const disp_op_t *acq_exp_ops [] = {
     &acq_data_acquire_exp,
     &acq_check_data_acquire_exp,
     &acq_get_data_block_exp,
+    &acq_cfg_trig_exp,
+    &acq_hw_trig_pol_exp,
+    &acq_hw_data_trig_sel_exp,
+    &acq_hw_data_trig_thres_exp,
+    &acq_hw_trig_dly_exp,
+    &acq_sw_trig_exp,
+    &acq_fsm_stop_exp,
+    &acq_get_shot_data_block_exp,
+    &acq_stream_start_exp,
+    &acq_stream_stop_exp,
+    &acq_stream_status_exp,
+    &acq_pingpong_exp,
+    &acq_get_decim_curve_exp,
+    &acq_get_soa_data_block_exp,
+    &acq_get_pos_data_block_exp,
+    &acq_get_ds_data_block_exp,
+    &acq_get_gen_exp,
     NULL
 };
 
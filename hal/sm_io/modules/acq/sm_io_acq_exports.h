@@ -13,6 +13,23 @@
 extern disp_op_t acq_data_acquire_exp;
 extern disp_op_t acq_check_data_acquire_exp;
 extern disp_op_t acq_get_data_block_exp;
+extern disp_op_t acq_cfg_trig_exp;
+extern disp_op_t acq_hw_trig_pol_exp;
+extern disp_op_t acq_hw_data_trig_sel_exp;
+extern disp_op_t acq_hw_data_trig_thres_exp;
+extern disp_op_t acq_hw_trig_dly_exp;
+extern disp_op_t acq_sw_trig_exp;
+extern disp_op_t acq_fsm_stop_exp;
+extern disp_op_t acq_get_shot_data_block_exp;
+extern disp_op_t acq_stream_start_exp;
+extern disp_op_t acq_stream_stop_exp;
+extern disp_op_t acq_stream_status_exp;
+extern disp_op_t acq_pingpong_exp;
+extern disp_op_t acq_get_decim_curve_exp;
+extern disp_op_t acq_get_soa_data_block_exp;
+extern disp_op_t acq_get_pos_data_block_exp;
+extern disp_op_t acq_get_ds_data_block_exp;
+extern disp_op_t acq_get_gen_exp;
 
 extern const disp_op_t *acq_exp_ops [];
 
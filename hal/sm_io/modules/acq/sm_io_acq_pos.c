@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "sm_io_acq_pos.h"
+#include "hal_assert.h"
+#include "board.h"
+#include "wb_pos_calc_regs.h"
+
+/* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
+#ifdef ASSERT_TEST
+#undef ASSERT_TEST
+#endif
+#define ASSERT_TEST(test_boolean, err_str, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_TEST(test_boolean, SM_IO, "[sm_io:acq_pos]",     \
+            err_str, err_goto_label, /* err_core */ __VA_ARGS__)
+
+/* Position calculation core fed to each ACQ core, as in the static layout
+ * of dev_io */
+#if defined(__BOARD_ML605__)
+static const uint32_t _acq_pos_dsp_base [NUM_ACQ_CORE_SMIOS] = {
+    DSP1_BASE_ADDR
+};
+#elif defined(__BOARD_AFCV3__)
+static const uint32_t _acq_pos_dsp_base [NUM_ACQ_CORE_SMIOS] = {
+    DSP1_BASE_ADDR,
+    DSP2_BASE_ADDR
+};
+#else
+#error "Could not initialize the DSP base addresses. Unsupported board!"
+#endif
+
+/* A sample is converted at once: its 4 words are a vector of 4 lanes,
+ * converted to 4 doubles and multiplied by the 4 factors. SSE2 does it with
+ * two conversions and two multiplications. __builtin_convertvector is only
+ * available on clang and on GCC 9 on, so anything else gets the scalar
+ * loop */
+#if defined (__clang__) || (defined (__GNUC__) && __GNUC__ >= 9)
+#define ACQ_POS_CONVERTVECTOR
+typedef int32_t acq_pos_v4si __attribute__ ((vector_size (16)));
+typedef double acq_pos_v4df __attribute__ ((vector_size (32)));
+#endif
+
+static ssize_t _acq_pos_read_k (smio_t *self, uint32_t reg, uint32_t *val);
+static bool _acq_pos_thres_reg (uint32_t chan, uint32_t *reg);
+
+bool acq_pos_chan_ok (uint32_t chan)
+{
+    return chan == TBTPOS0_CHAN_ID || chan == FOFBPOS0_CHAN_ID ||
+        chan == MONITPOS0_CHAN_ID || chan == MONIT1POS0_CHAN_ID;
+}
+
+smio_err_e acq_pos_cal_read (smio_t *self, uint32_t chan, acq_pos_cal_t *cal)
+{
+    assert (self);
+    assert (cal);
+
+    smio_err_e err = SMIO_SUCCESS;
+    uint32_t kx = 0;
+    uint32_t ky = 0;
+    uint32_t ksum = 0;
+    uint32_t thres_reg = 0;
+    uint32_t thres = 0;
+
+    ASSERT_TEST(self->inst_id < NUM_ACQ_CORE_SMIOS, "Instance ID invalid",
+            err_read_k, SMIO_ERR_WRONG_PARAM);
+    ASSERT_TEST(_acq_pos_read_k (self, POS_CALC_REG_KX, &kx) == sizeof (kx) &&
+            _acq_pos_read_k (self, POS_CALC_REG_KY, &ky) == sizeof (ky) &&
+            _acq_pos_read_k (self, POS_CALC_REG_KSUM, &ksum) == sizeof (ksum),
+            "Could not read the position calculation constants",
+            err_read_k, SMIO_ERR_LLIO);
+    /* Channels not fed to the position calculation, as the ADC, have no
+     * threshold */
+    if (_acq_pos_thres_reg (chan, &thres_reg)) {
+        ASSERT_TEST(_acq_pos_read_k (self, thres_reg, &thres) == sizeof (thres),
+                "Could not read the delta over sum threshold",
+                err_read_k, SMIO_ERR_LLIO);
+    }
+
+    cal->kx = POS_CALC_KX_VAL_R(kx);
+    cal->ky = POS_CALC_KY_VAL_R(ky);
+    cal->ksum = POS_CALC_KSUM_VAL_R(ksum);
+    /* The threshold registers all have the same layout */
+    cal->ds_thres = POS_CALC_DS_TBT_THRES_VAL_R(thres);
+
+    cal->scale [0] = (double) cal->kx / (1 << ACQ_POS_DS_FRAC_BITS);
+    cal->scale [1] = (double) cal->ky / (1 << ACQ_POS_DS_FRAC_BITS);
+    cal->scale [2] = 1.0 / (1 << ACQ_POS_DS_FRAC_BITS);
+    cal->scale [3] = (double) cal->ksum / (1 << ACQ_POS_KSUM_FRAC_BITS);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:acq_pos] KX = %u, KY = %u, "
+            "KSUM = 0x%08x, threshold = %u\n", cal->kx, cal->ky, cal->ksum,
+            cal->ds_thres);
+
+err_read_k:
+    return err;
+}
+
+void acq_pos_convert (const acq_pos_cal_t *cal, const uint8_t *data,
+        uint32_t num_samples, uint8_t *pos)
+{
+    assert (cal);
+
+#ifdef ACQ_POS_CONVERTVECTOR
+    acq_pos_v4df scale;
+    memcpy (&scale, cal->scale, sizeof (scale));
+
+    for (uint32_t i = 0; i < num_samples; i++) {
+        acq_pos_v4si v;
+        memcpy (&v, data + i*sizeof (v), sizeof (v));
+        acq_pos_v4df d = __builtin_convertvector (v, acq_pos_v4df) * scale;
+        memcpy (pos + i*sizeof (d), &d, sizeof (d));
+    }
+#else
+    const int32_t *raw = (const int32_t *) data;
+    double *d = (double *) pos;
+
+    for (uint32_t i = 0; i < num_samples*SMIO_ACQ_NUM_COMP; i++) {
+        d [i] = raw [i] * cal->scale [i % SMIO_ACQ_NUM_COMP];
+    }
+#endif
+}
+
+/* Read register "reg" of the position calculation core. It is not part of
+ * our SMIO, so our base address does not apply */
+static ssize_t _acq_pos_read_k (smio_t *self, uint32_t reg, uint32_t *val)
+{
+    return smio_thsafe_raw_client_read_32 (self,
+            _acq_pos_dsp_base [self->inst_id] | DSP_CTRL_REGS_OFFS | reg, val);
+}
+
+/* Delta over sum threshold of the rate channel "chan" is acquired at */
+static bool _acq_pos_thres_reg (uint32_t chan, uint32_t *reg)
+{
+    switch (chan) {
+        case TBTAMP0_CHAN_ID:
+        case TBTPOS0_CHAN_ID:
+            *reg = POS_CALC_REG_DS_TBT_THRES;
+            return true;
+        case FOFBAMP0_CHAN_ID:
+        case FOFBPOS0_CHAN_ID:
+            *reg = POS_CALC_REG_DS_FOFB_THRES;
+            return true;
+        case MONITAMP0_CHAN_ID:
+        case MONITPOS0_CHAN_ID:
+        case MONIT1POS0_CHAN_ID:
+            *reg = POS_CALC_REG_DS_MONIT_THRES;
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_ACQ_POS_H_
+#define _SM_IO_ACQ_POS_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "sm_io_acq_codes.h"
+#include "sm_io_err.h"
+#include "sm_io.h"
+
+/* The position channels hold X, Y, Q and SUM words. X, Y and Q are the
+ * delta over sum ratios, in signed fixed point with ACQ_POS_DS_FRAC_BITS
+ * fractional bits. SUM is the raw sum of the amplitudes. The calibration
+ * turns them into X and Y in nm, with the KX and KY sensitivities of the
+ * position calculation core, and into SUM scaled by KSUM, in FIX25_24 */
+#define ACQ_POS_DS_FRAC_BITS            25
+#define ACQ_POS_KSUM_FRAC_BITS          24
+
+struct _acq_pos_cal_t {
+    uint32_t kx;                    /* KX, in nm */
+    uint32_t ky;                    /* KY, in nm */
+    uint32_t ksum;                  /* KSUM, in FIX25_24 */
+    uint32_t ds_thres;              /* Delta over sum threshold on the SUM
+                                       of the amplitudes */
+    double scale [SMIO_ACQ_NUM_COMP];   /* Factor of each word */
+};
+
+typedef struct _acq_pos_cal_t acq_pos_cal_t;
+
+/***************** Our methods *****************/
+
+/* Whether channel "chan" holds positions */
+bool acq_pos_chan_ok (uint32_t chan);
+/* Read the current KX, KY and KSUM of the position calculation core paired
+ * with the ACQ core, and the delta over sum threshold of the rate of
+ * channel "chan", and fill "cal" with them */
+smio_err_e acq_pos_cal_read (smio_t *self, uint32_t chan, acq_pos_cal_t *cal);
+/* Convert "num_samples" position samples from "data" to SMIO_ACQ_NUM_COMP
+ * doubles each, in "pos" */
+void acq_pos_convert (const acq_pos_cal_t *cal, const uint8_t *data,
+        uint32_t num_samples, uint8_t *pos);
+
+#endif
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "sm_io_acq_soa.h"
+
+/* Samples are deinterleaved a vector tile at a time: 4 vectors of 16 bytes
+ * are loaded, transposed with a few rounds of shuffles, and stored as a
+ * piece of each of the 4 columns. __builtin_shuffle is GCC only, so anything else
+ * gets the scalar loop */
+#if defined (__GNUC__) && !defined (__clang__)
+#define ACQ_SOA_SHUFFLE
+#endif
+
+#ifdef ACQ_SOA_SHUFFLE
+typedef int32_t acq_soa_v4si __attribute__ ((vector_size (16)));
+typedef int16_t acq_soa_v8hi __attribute__ ((vector_size (16)));
+
+/* Samples in a tile of 4 vectors */
+#define ACQ_SOA_TILE_SAMPLES_16         8
+#define ACQ_SOA_TILE_SAMPLES_32         4
+#endif
+
+static void _acq_soa_deinterleave_16 (int16_t *cols, const int16_t *data,
+        uint32_t num_samples);
+static void _acq_soa_deinterleave_32 (int32_t *cols, const int32_t *data,
+        uint32_t num_samples);
+
+bool acq_soa_sample_size_ok (uint32_t sample_size)
+{
+    return sample_size == SMIO_ACQ_NUM_COMP*sizeof (int16_t) ||
+        sample_size == SMIO_ACQ_NUM_COMP*sizeof (int32_t);
+}
+
+void acq_soa_deinterleave (uint8_t *cols, const uint8_t *data,
+        uint32_t num_samples, uint32_t sample_size)
+{
+    assert (acq_soa_sample_size_ok (sample_size));
+
+    if (sample_size == SMIO_ACQ_NUM_COMP*sizeof (int16_t)) {
+        _acq_soa_deinterleave_16 ((int16_t *) cols, (const int16_t *) data,
+                num_samples);
+    }
+    else {
+        _acq_soa_deinterleave_32 ((int32_t *) cols, (const int32_t *) data,
+                num_samples);
+    }
+}
+
+static void _acq_soa_deinterleave_16 (int16_t *cols, const int16_t *data,
+        uint32_t num_samples)
+{
+    uint32_t i = 0;
+
+#ifdef ACQ_SOA_SHUFFLE
+    /* Each vector holds 2 samples. All of the shuffles interleave the
+     * halves of two vectors, which SSE2 does in a single instruction. After
+     * two rounds, lo holds the components 0 and 1 of 4 samples and hi the
+     * components 2 and 3 */
+    const acq_soa_v8hi unpack_lo_mask = {0, 8, 1, 9, 2, 10, 3, 11};
+    const acq_soa_v8hi unpack_hi_mask = {4, 12, 5, 13, 6, 14, 7, 15};
+    const acq_soa_v8hi first_mask = {0, 1, 2, 3, 8, 9, 10, 11};
+    const acq_soa_v8hi second_mask = {4, 5, 6, 7, 12, 13, 14, 15};
+
+    for (; i + ACQ_SOA_TILE_SAMPLES_16 <= num_samples;
+            i += ACQ_SOA_TILE_SAMPLES_16, data += ACQ_SOA_TILE_SAMPLES_16*SMIO_ACQ_NUM_COMP) {
+        acq_soa_v8hi v0, v1, v2, v3;
+        memcpy (&v0, data, sizeof (v0));
+        memcpy (&v1, data + 8, sizeof (v1));
+        memcpy (&v2, data + 16, sizeof (v2));
+        memcpy (&v3, data + 24, sizeof (v3));
+
+        acq_soa_v8hi t0 = __builtin_shuffle (v0, v1, unpack_lo_mask);
+        acq_soa_v8hi t1 = __builtin_shuffle (v0, v1, unpack_hi_mask);
+        acq_soa_v8hi t2 = __builtin_shuffle (v2, v3, unpack_lo_mask);
+        acq_soa_v8hi t3 = __builtin_shuffle (v2, v3, unpack_hi_mask);
+
+        acq_soa_v8hi lo0 = __builtin_shuffle (t0, t1, unpack_lo_mask);
+        acq_soa_v8hi hi0 = __builtin_shuffle (t0, t1, unpack_hi_mask);
+        acq_soa_v8hi lo1 = __builtin_shuffle (t2, t3, unpack_lo_mask);
+        acq_soa_v8hi hi1 = __builtin_shuffle (t2, t3, unpack_hi_mask);
+
+        acq_soa_v8hi c0 = __builtin_shuffle (lo0, lo1, first_mask);
+        acq_soa_v8hi c1 = __builtin_shuffle (lo0, lo1, second_mask);
+        acq_soa_v8hi c2 = __builtin_shuffle (hi0, hi1, first_mask);
+        acq_soa_v8hi c3 = __builtin_shuffle (hi0, hi1, second_mask);
+
+        memcpy (cols + i, &c0, sizeof (c0));
+        memcpy (cols + num_samples + i, &c1, sizeof (c1));
+        memcpy (cols + 2*num_samples + i, &c2, sizeof (c2));
+        memcpy (cols + 3*num_samples + i, &c3, sizeof (c3));
+    }
+#endif
+
+    for (; i < num_samples; i++, data += SMIO_ACQ_NUM_COMP) {
+        cols [i] = data [0];
+        cols [num_samples + i] = data [1];
+        cols [2*num_samples + i] = data [2];
+        cols [3*num_samples + i] = data [3];
+    }
+}
+
+static void _acq_soa_deinterleave_32 (int32_t *cols, const int32_t *data,
+        uint32_t num_samples)
+{
+    uint32_t i = 0;
+
+#ifdef ACQ_SOA_SHUFFLE
+    /* Each vector holds a sample. This is a 4x4 transpose */
+    const acq_soa_v4si lo_mask = {0, 4, 1, 5};
+    const acq_soa_v4si hi_mask = {2, 6, 3, 7};
+    const acq_soa_v4si first_mask = {0, 1, 4, 5};
+    const acq_soa_v4si second_mask = {2, 3, 6, 7};
+
+    for (; i + ACQ_SOA_TILE_SAMPLES_32 <= num_samples;
+            i += ACQ_SOA_TILE_SAMPLES_32, data += ACQ_SOA_TILE_SAMPLES_32*SMIO_ACQ_NUM_COMP) {
+        acq_soa_v4si v0, v1, v2, v3;
+        memcpy (&v0, data, sizeof (v0));
+        memcpy (&v1, data + 4, sizeof (v1));
+        memcpy (&v2, data + 8, sizeof (v2));
+        memcpy (&v3, data + 12, sizeof (v3));
+
+        acq_soa_v4si lo0 = __builtin_shuffle (v0, v1, lo_mask);
+        acq_soa_v4si hi0 = __builtin_shuffle (v0, v1, hi_mask);
+        acq_soa_v4si lo1 = __builtin_shuffle (v2, v3, lo_mask);
+        acq_soa_v4si hi1 = __builtin_shuffle (v2, v3, hi_mask);
+
+        acq_soa_v4si c0 = __builtin_shuffle (lo0, lo1, first_mask);
+        acq_soa_v4si c1 = __builtin_shuffle (lo0, lo1, second_mask);
+        acq_soa_v4si c2 = __builtin_shuffle (hi0, hi1, first_mask);
+        acq_soa_v4si c3 = __builtin_shuffle (hi0, hi1, second_mask);
+
+        memcpy (cols + i, &c0, sizeof (c0));
+        memcpy (cols + num_samples + i, &c1, sizeof (c1));
+        memcpy (cols + 2*num_samples + i, &c2, sizeof (c2));
+        memcpy (cols + 3*num_samples + i, &c3, sizeof (c3));
+    }
+#endif
+
+    for (; i < num_samples; i++, data += SMIO_ACQ_NUM_COMP) {
+        cols [i] = data [0];
+        cols [num_samples + i] = data [1];
+        cols [2*num_samples + i] = data [2];
+        cols [3*num_samples + i] = data [3];
+    }
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_ACQ_SOA_H_
+#define _SM_IO_ACQ_SOA_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "sm_io_acq_codes.h"
+
+/***************** Our methods *****************/
+
+/* Whether samples of "sample_size" bytes can be deinterleaved */
+bool acq_soa_sample_size_ok (uint32_t sample_size);
+/* Deinterleave "num_samples" samples of "sample_size" bytes from "data"
+ * into SMIO_ACQ_NUM_COMP columns, one after the other, in "cols". The
+ * buffers must not overlap */
+void acq_soa_deinterleave (uint8_t *cols, const uint8_t *data,
+        uint32_t num_samples, uint32_t sample_size);
+
+#endif
@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <czmq.h>
+
+#include "sm_io_acq_stream.h"
+#include "sm_io_acq_core.h"
+#include "sm_io_exports.h"
+#include "smio_thsafe_zmq_client.h"
+#include "hal_assert.h"
+#include "ddr3_map.h"
+#include "wb_acq_core_regs.h"
+
+/* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
+#ifdef ASSERT_TEST
+#undef ASSERT_TEST
+#endif
+#define ASSERT_TEST(test_boolean, err_str, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_TEST(test_boolean, SM_IO, "[sm_io:acq_stream]",  \
+            err_str, err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef ASSERT_ALLOC
+#undef ASSERT_ALLOC
+#endif
+#define ASSERT_ALLOC(ptr, err_goto_label, /* err_core */ ...)   \
+    ASSERT_HAL_ALLOC(ptr, SM_IO, "[sm_io:acq_stream]",          \
+            smio_err_str(SMIO_ERR_ALLOC),                       \
+            err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef CHECK_ERR
+#undef CHECK_ERR
+#endif
+#define CHECK_ERR(err, err_type)                                \
+    CHECK_HAL_ERR(err, SM_IO, "[sm_io:acq_stream]",             \
+            smio_err_str (err_type))
+
+#define SMIO_ACQ_HANDLER(self) ((smio_acq_t *) self->smio_handler)
+
+/* The core keeps writing while we read the ring, so only this fraction of
+ * it is read back. Whatever is older than that is reported as lost */
+#define ACQ_STREAM_GUARD_DIV            4
+
+static zctx_t *_acq_stream_ctx (smio_t *self);
+static int _acq_stream_bind (smio_t *self, acq_stream_t *stream);
+static ssize_t _acq_stream_publish (smio_t *self, acq_stream_t *stream,
+        uint32_t num_samples, uint64_t lost);
+
+int acq_stream_start (smio_t *self, uint32_t chan, uint32_t num_samples)
+{
+    assert (self);
+    acq_stream_t *stream = &SMIO_ACQ_HANDLER(self)->stream;
+
+    if (stream->running) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq_stream] "
+                "Stream of channel %u is already running\n", stream->chan);
+        return -ACQ_STREAM_BUSY;
+    }
+
+    if (chan > SMIO_ACQ_NUM_CHANNELS-1) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq_stream] "
+                "Channel required is out of the maximum limit\n");
+        return -ACQ_NUM_CHAN_OOR;
+    }
+
+    /* Same alignment as the pre-trigger samples of an acquisition */
+    const acq_buf_t *acq_buf = &SMIO_ACQ_HANDLER(self)->acq_buf[chan];
+    uint32_t num_samples_div = DDR3_PAYLOAD_SIZE/acq_buf->sample_size;
+    uint32_t num_samples_aligned = ((num_samples + num_samples_div - 1) /
+            num_samples_div) * num_samples_div;
+    if (num_samples == 0 || num_samples_aligned > acq_buf->max_samples) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq_stream] "
+                "Number of samples required is out of the maximum limit\n");
+        return -ACQ_NUM_SAMPLES_OOR;
+    }
+
+    if (stream->pub == NULL) {
+        int err = _acq_stream_bind (self, stream);
+        if (err != -ACQ_OK) {
+            return err;
+        }
+    }
+
+    /* Nothing may trigger the core, so it never stops writing the ring.
+     * The trigger configuration is restored when the stream is stopped */
+    uint32_t trig_cfg = 0;
+    ssize_t rw_bytes = smio_thsafe_client_read_32 (self, ACQ_CORE_REG_TRIG_CFG,
+            &trig_cfg);
+    if (rw_bytes != sizeof (uint32_t)) {
+        return -ACQ_COULD_NOT_READ;
+    }
+
+    uint32_t stream_trig_cfg = trig_cfg & ~(ACQ_CORE_TRIG_CFG_HW_TRIG_EN |
+            ACQ_CORE_TRIG_CFG_SW_TRIG_EN);
+    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_TRIG_CFG, &stream_trig_cfg);
+
+    uint32_t acq_core_shots = ACQ_CORE_SHOTS_NB_W(1);
+    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_SHOTS, &acq_core_shots);
+    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_PRE_SAMPLES, &num_samples_aligned);
+    uint32_t num_samples_post = 0;
+    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_POST_SAMPLES, &num_samples_post);
+
+    /* DDR3 start address. Convert Byte address to Word address */
+    uint32_t start_addr = acq_buf->start_addr/DDR3_ADDR_WORD_2_BYTE;
+    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_DDR3_START_ADDR, &start_addr);
+
+    uint32_t acq_chan_ctl = ACQ_CORE_ACQ_CHAN_CTL_WHICH_W(chan);
+    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_ACQ_CHAN_CTL, &acq_chan_ctl);
+
+    /* The data of the channel is not the one of the last acquisition
+     * anymore */
+    SMIO_ACQ_HANDLER(self)->acq_params[chan].num_samples = 0;
+
+    stream->chan = chan;
+    stream->num_samples = num_samples_aligned;
+    stream->trig_cfg = trig_cfg;
+    stream->last_cnt = 0;
+    stream->pending = 0;
+    stream->pos = 0;
+    stream->lost = 0;
+    stream->overruns = 0;
+    stream->seq = 0;
+    __atomic_store_n (&stream->running, true, __ATOMIC_SEQ_CST);
+
+    /* Starting acquisition, without ACQ_NOW... */
+    uint32_t acq_core_ctl_reg = ACQ_CORE_CTL_FSM_START_ACQ;
+    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_CTL, &acq_core_ctl_reg);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io:acq_stream] "
+            "Streaming channel %u with a ring of %u samples to %s\n", chan,
+            num_samples_aligned, stream->endpoint);
+    return -ACQ_OK;
+}
+
+int acq_stream_stop (smio_t *self)
+{
+    assert (self);
+    acq_stream_t *stream = &SMIO_ACQ_HANDLER(self)->stream;
+
+    if (!stream->running) {
+        return -ACQ_OK;
+    }
+
+    /* Publish whatever is left before stopping */
+    acq_stream_tick (self);
+
+    uint32_t acq_core_ctl_reg = ACQ_CORE_CTL_FSM_STOP_ACQ;
+    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_CTL, &acq_core_ctl_reg);
+    smio_thsafe_client_write_32 (self, ACQ_CORE_REG_TRIG_CFG, &stream->trig_cfg);
+
+    __atomic_store_n (&stream->running, false, __ATOMIC_SEQ_CST);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io:acq_stream] "
+            "Stream of channel %u stopped. %"PRIu64" samples published, "
+            "%"PRIu64" lost in %u overrun(s)\n", stream->chan, stream->pos,
+            stream->lost, stream->overruns);
+    return -ACQ_OK;
+}
+
+smio_err_e acq_stream_tick (smio_t *self)
+{
+    assert (self);
+    acq_stream_t *stream = &SMIO_ACQ_HANDLER(self)->stream;
+
+    if (!stream->running) {
+        return SMIO_SUCCESS;
+    }
+
+    uint32_t samples_cnt = 0;
+    ssize_t rw_bytes = smio_thsafe_client_read_32 (self, ACQ_CORE_REG_SAMPLES_CNT,
+            &samples_cnt);
+    if (rw_bytes != sizeof (uint32_t)) {
+        return SMIO_ERR_LLIO;
+    }
+
+    /* The counter wraps around, but never more than once between ticks */
+    stream->pending += samples_cnt - stream->last_cnt;
+    stream->last_cnt = samples_cnt;
+
+    /* The core overwrote what we didn't read in time */
+    uint64_t lost = 0;
+    uint32_t max_pending = stream->num_samples -
+        stream->num_samples/ACQ_STREAM_GUARD_DIV;
+    if (stream->pending > max_pending) {
+        lost = stream->pending - max_pending;
+        stream->pending = max_pending;
+        stream->pos += lost;
+        stream->lost += lost;
+        stream->overruns++;
+
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq_stream] "
+                "Overrun on channel %u. %"PRIu64" samples lost\n",
+                stream->chan, lost);
+    }
+
+    uint32_t sample_size = SMIO_ACQ_HANDLER(self)->acq_buf[stream->chan].sample_size;
+    uint32_t max_msg_samples = BLOCK_SIZE/sample_size;
+    while (stream->pending > 0) {
+        /* Stop at the end of the ring */
+        uint32_t ring_off = stream->pos % stream->num_samples;
+        uint32_t num_samples = stream->pending;
+        if (num_samples > max_msg_samples) {
+            num_samples = max_msg_samples;
+        }
+        if (num_samples > stream->num_samples - ring_off) {
+            num_samples = stream->num_samples - ring_off;
+        }
+
+        ssize_t pub_samples = _acq_stream_publish (self, stream, num_samples,
+                lost);
+        if (pub_samples < 0) {
+            return SMIO_ERR_LLIO;
+        }
+
+        lost = 0;
+        stream->pos += pub_samples;
+        stream->pending -= pub_samples;
+    }
+
+    return SMIO_SUCCESS;
+}
+
+bool acq_stream_is_running (smio_t *self)
+{
+    assert (self);
+    acq_stream_t *stream = &SMIO_ACQ_HANDLER(self)->stream;
+
+    return __atomic_load_n (&stream->running, __ATOMIC_SEQ_CST);
+}
+
+void acq_stream_status (smio_t *self, smio_acq_stream_status_t *status)
+{
+    assert (self);
+    assert (status);
+    const acq_stream_t *stream = &SMIO_ACQ_HANDLER(self)->stream;
+
+    memset (status, 0, sizeof (*status));
+    status->running = stream->running;
+    status->chan = stream->chan;
+    status->num_samples = stream->num_samples;
+    status->overruns = stream->overruns;
+    status->pos = stream->pos;
+    status->lost = stream->lost;
+    snprintf (status->endpoint, sizeof (status->endpoint), "%s", stream->endpoint);
+}
+
+void acq_stream_close (smio_t *self)
+{
+    assert (self);
+    acq_stream_t *stream = &SMIO_ACQ_HANDLER(self)->stream;
+
+    if (stream->pub != NULL) {
+        zsocket_destroy (_acq_stream_ctx (self), stream->pub);
+        stream->pub = NULL;
+    }
+}
+
+/**************** Static Functions ***************/
+
+/* Context of the SMIO thread. With a pool, the stream is started by one of
+ * the workers, but published by the ticks of the SMIO thread, which
+ * outlives them. They never use the socket at the same time, as both hold
+ * the pool handler lock for themselves */
+static zctx_t *_acq_stream_ctx (smio_t *self)
+{
+    return (self->pool != NULL) ? self->pool->parent->ctx : self->ctx;
+}
+
+/* Bind the PUB socket next to the broker: in the same directory for IPC,
+ * or in an ephemeral port of the same host for TCP */
+static int _acq_stream_bind (smio_t *self, acq_stream_t *stream)
+{
+    int err = -ACQ_OK;
+    const char *broker = self->broker;
+
+    stream->pub = zsocket_new (_acq_stream_ctx (self), ZMQ_PUB);
+    ASSERT_ALLOC(stream->pub, err_pub_alloc, -ACQ_STREAM_UNAVAIL);
+
+    if (strncmp (broker, "ipc://", strlen ("ipc://")) == 0) {
+        snprintf (stream->endpoint, sizeof (stream->endpoint), "%s-%s.stream",
+                broker, self->service);
+        int rc = zsocket_bind (stream->pub, "%s", stream->endpoint);
+        ASSERT_TEST(rc == 0, "Could not bind the stream endpoint", err_bind,
+                -ACQ_STREAM_UNAVAIL);
+    }
+    else if (strncmp (broker, "tcp://", strlen ("tcp://")) == 0) {
+        const char *host = broker + strlen ("tcp://");
+        const char *port_sep = strrchr (host, ':');
+        ASSERT_TEST(port_sep != NULL, "Broker endpoint has no port", err_bind,
+                -ACQ_STREAM_UNAVAIL);
+
+        int port = zsocket_bind (stream->pub, "tcp://*:*");
+        ASSERT_TEST(port > 0, "Could not bind the stream endpoint", err_bind,
+                -ACQ_STREAM_UNAVAIL);
+        snprintf (stream->endpoint, sizeof (stream->endpoint), "tcp://%.*s:%d",
+                (int) (port_sep - host), host, port);
+    }
+    else {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:acq_stream] "
+                "Unknown broker transport. Use ipc:// or tcp://\n");
+        err = -ACQ_STREAM_UNAVAIL;
+        goto err_bind;
+    }
+
+    return err;
+
+err_bind:
+    zsocket_destroy (_acq_stream_ctx (self), stream->pub);
+    stream->pub = NULL;
+    stream->endpoint [0] = '\0';
+err_pub_alloc:
+    return err;
+}
+
+/* Read up to "num_samples" samples from the current stream position and
+ * publish them. They must not wrap around the ring. Returns the number of
+ * samples published or -1 on error */
+static ssize_t _acq_stream_publish (smio_t *self, acq_stream_t *stream,
+        uint32_t num_samples, uint64_t lost)
+{
+    const acq_buf_t *acq_buf = &SMIO_ACQ_HANDLER(self)->acq_buf[stream->chan];
+    uint32_t addr_i = acq_buf->start_addr +
+        (stream->pos % stream->num_samples) * acq_buf->sample_size;
+
+    zframe_t *data_frame = zframe_new (NULL, num_samples * acq_buf->sample_size);
+    ASSERT_ALLOC(data_frame, err_data_frame_alloc);
+
+    /* Here we must use the "raw" version, as we can't have
+     * LARGE_MEM_ADDR mangled with the bas address of this SMIO */
+    ssize_t valid_bytes = smio_thsafe_raw_client_read_block (self,
+            LARGE_MEM_ADDR | addr_i, zframe_size (data_frame),
+            (uint32_t *) zframe_data (data_frame));
+    ASSERT_TEST(valid_bytes == (ssize_t) zframe_size (data_frame),
+            "Could not read the stream samples", err_read);
+
+    smio_acq_stream_hdr_t hdr = {
+        .seq = stream->seq++,
+        .chan = stream->chan,
+        .first_sample = stream->pos,
+        .lost = lost
+    };
+
+    /* PUB sockets never block. Slow subscribers miss messages, which they
+     * can tell by the sequence number */
+    zmsg_t *msg = zmsg_new ();
+    ASSERT_ALLOC(msg, err_msg_alloc);
+    zmsg_addmem (msg, &hdr, sizeof (hdr));
+    zmsg_append (msg, &data_frame);
+    zmsg_send (&msg, stream->pub);
+
+    return num_samples;
+
+err_msg_alloc:
+err_read:
+    zframe_destroy (&data_frame);
+err_data_frame_alloc:
+    return -1;
+}
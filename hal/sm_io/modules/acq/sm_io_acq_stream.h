@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_ACQ_STREAM_H_
+#define _SM_IO_ACQ_STREAM_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "sm_io_acq_codes.h"
+#include "sm_io.h"
+
+/* Streaming acquisition. The core is armed to wait for a trigger that never
+ * comes, so it keeps writing the pre-trigger samples of a channel in a ring
+ * at the start of the channel DDR3 region. On each tick, the samples counter
+ * of the core tells how far it got and the samples written since the last
+ * tick are published, in order, to the subscribers of the stream endpoint.
+ * The samples the core overwrites before we get to read them are reported
+ * as lost */
+struct _acq_stream_t {
+    bool running;                   /* Stream is started. Read without the
+                                       handler lock by the SMIO thread, so
+                                       it is set atomically */
+    uint32_t chan;                  /* Channel being streamed */
+    uint32_t num_samples;           /* Size of the ring, in samples */
+    uint32_t trig_cfg;              /* Trigger configuration to restore when
+                                       the stream is stopped */
+    uint32_t last_cnt;              /* Samples counter at the last tick */
+    uint32_t pending;               /* Samples written, but not published */
+    uint64_t pos;                   /* Stream index of the next sample to be
+                                       published */
+    uint64_t lost;                  /* Samples lost to overruns */
+    uint32_t overruns;              /* Number of overruns */
+    uint32_t seq;                   /* Sequence number of the next message */
+    void *pub;                      /* PUB socket. Created on the first start */
+    char endpoint [SMIO_ACQ_STREAM_ENDP_LEN];   /* Where pub is bound */
+};
+
+typedef struct _acq_stream_t acq_stream_t;
+
+/***************** Our methods *****************/
+
+/* Start streaming "num_samples" samples ring of channel "chan". Returns
+ * -ACQ_OK or the negated ACQ reply code of the error */
+int acq_stream_start (smio_t *self, uint32_t chan, uint32_t num_samples);
+/* Stop streaming. Returns -ACQ_OK or the negated ACQ reply code of the
+ * error */
+int acq_stream_stop (smio_t *self);
+/* Publish the samples written since the last tick */
+smio_err_e acq_stream_tick (smio_t *self);
+/* Whether the stream is started. Safe to call without the handler lock */
+bool acq_stream_is_running (smio_t *self);
+/* Fill the stream status */
+void acq_stream_status (smio_t *self, smio_acq_stream_status_t *status);
+/* Release the PUB socket */
+void acq_stream_close (smio_t *self);
+
+#endif
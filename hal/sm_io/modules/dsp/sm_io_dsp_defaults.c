@@ -1,8 +1,8 @@
 #include "hal_assert.h"
 #include "sm_io_err.h"
+#include "sm_io.h"
+#include "sm_io_dsp_codes.h"
 #include "sm_io_dsp_defaults.h"
-/* We actually use the libclient to do the "heavy" work for us */
-#include "bpm_client.h"
 
 /* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
 #ifdef ASSERT_TEST
@@ -27,53 +27,36 @@
     CHECK_HAL_ERR(err, SM_IO, "[sm_io:dsp_defaults]",               \
             smio_err_str (err_type))
 
-#define SMIO_DSP_LIBCLIENT_LOG_MODE                "a"
-
-/* We use the actual libclient to send and configure our default values,
- * maintaining internal consistency. So, in fact, we are sending ourselves
- * a message containing the default values. Because of this approach, we
- * only get to default our values when the functions are already exported
- * to the broker, which happens on a late stage. This could cause a fast
- * client to get an inconsistent state from our server */
-/* TODO: Avoid exporting the functions before we have initialized
- * our server with the default values */
-smio_err_e dsp_config_defaults (char *broker_endp, char *service,
-       const char *log_file_name)
+smio_err_e dsp_config_defaults (smio_t *self)
 {
-    (void) log_file_name;
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io:dsp_defaults] Configuring SMIO "
             "DSP with default values ...\n");
-    bpm_client_err_e client_err = BPM_CLIENT_SUCCESS;
     smio_err_e err = SMIO_SUCCESS;
 
-    bpm_client_t *config_client = bpm_client_new_log_mode (broker_endp, 0,
-            log_file_name, SMIO_DSP_LIBCLIENT_LOG_MODE);
-
-    client_err = bpm_set_kx (config_client, service, DSP_DFLT_KX_VAL);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not set KX value",
+    err = smio_config_param_32 (self, DSP_OPCODE_SET_GET_KX, DSP_DFLT_KX_VAL);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not set KX value",
             err_param_set, SMIO_ERR_CONFIG_DFLT);
 
-    client_err = bpm_set_ky (config_client, service, DSP_DFLT_KY_VAL);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not set KY value",
+    err = smio_config_param_32 (self, DSP_OPCODE_SET_GET_KY, DSP_DFLT_KY_VAL);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not set KY value",
             err_param_set, SMIO_ERR_CONFIG_DFLT);
 
-    client_err = bpm_set_ksum (config_client, service, DSP_DFLT_KSUM_VAL);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not set KSUM value",
+    err = smio_config_param_32 (self, DSP_OPCODE_SET_GET_KSUM, DSP_DFLT_KSUM_VAL);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not set KSUM value",
             err_param_set, SMIO_ERR_CONFIG_DFLT);
 
-    client_err = bpm_set_ds_tbt_thres (config_client, service, DSP_DFLT_DS_TBT_THRES);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not set Delta-Sigma TBT threshold",
+    err = smio_config_param_32 (self, DSP_OPCODE_SET_GET_DS_TBT_THRES, DSP_DFLT_DS_TBT_THRES);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not set Delta-Sigma TBT threshold",
             err_param_set, SMIO_ERR_CONFIG_DFLT);
 
-    client_err = bpm_set_ds_fofb_thres (config_client, service, DSP_DFLT_DS_FOFB_THRES);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not set Delta-Sigma FOFB threshold",
+    err = smio_config_param_32 (self, DSP_OPCODE_SET_GET_DS_FOFB_THRES, DSP_DFLT_DS_FOFB_THRES);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not set Delta-Sigma FOFB threshold",
             err_param_set, SMIO_ERR_CONFIG_DFLT);
 
-    client_err = bpm_set_ds_monit_thres (config_client, service, DSP_DFLT_DS_MONIT_THRES);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not set Delta-Sigma MONIT threshold",
+    err = smio_config_param_32 (self, DSP_OPCODE_SET_GET_DS_MONIT_THRES, DSP_DFLT_DS_MONIT_THRES);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not set Delta-Sigma MONIT threshold",
             err_param_set, SMIO_ERR_CONFIG_DFLT);
 
 err_param_set:
-    bpm_client_destroy (&config_client);
     return err;
 }
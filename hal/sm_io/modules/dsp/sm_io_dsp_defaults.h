@@ -19,8 +19,9 @@
 #define DSP_DFLT_DS_FOFB_THRES          0           /* No minimum threslhold */
 #define DSP_DFLT_DS_MONIT_THRES         0           /* No minimum threslhold */
 
-smio_err_e dsp_config_defaults (char *broker_endp, char *service,
-        const char *log_file_name);
+struct _smio_t;
+
+smio_err_e dsp_config_defaults (struct _smio_t *self);
 
 #endif
 
@@ -188,6 +188,21 @@ const disp_table_func_fp dsp_exp_fp [] = {
     NULL
 };
 
+/* Bits accepted by the set/get operations above, so values from the
+ * configuration file can be checked before they are written */
+const smio_param_mask_t dsp_param_masks [] = {
+    {DSP_OPCODE_SET_GET_KX, RW_PARAM_MASK(POS_CALC, KX, VAL, MULT_BIT_PARAM)},
+    {DSP_OPCODE_SET_GET_KY, RW_PARAM_MASK(POS_CALC, KY, VAL, MULT_BIT_PARAM)},
+    {DSP_OPCODE_SET_GET_KSUM, RW_PARAM_MASK(POS_CALC, KSUM, VAL, MULT_BIT_PARAM)},
+    {DSP_OPCODE_SET_GET_DS_TBT_THRES,
+        RW_PARAM_MASK(POS_CALC, DS_TBT_THRES, VAL, MULT_BIT_PARAM)},
+    {DSP_OPCODE_SET_GET_DS_FOFB_THRES,
+        RW_PARAM_MASK(POS_CALC, DS_FOFB_THRES, VAL, MULT_BIT_PARAM)},
+    {DSP_OPCODE_SET_GET_DS_MONIT_THRES,
+        RW_PARAM_MASK(POS_CALC, DS_MONIT_THRES, VAL, MULT_BIT_PARAM)},
+    SMIO_PARAM_MASK_END
+};
+
 /************************************************************/
 /***************** Export methods functions *****************/
 /************************************************************/
@@ -274,6 +289,7 @@ smio_err_e dsp_init (smio_t * self)
             "function descriptors with the callbacks", err_fill_desc);
 
     self->exp_ops = dsp_exp_ops;
+    self->param_masks = dsp_param_masks;
 
     /* Initialize specific structure */
     self->smio_handler = smio_dsp_new (self);
@@ -295,6 +311,7 @@ smio_err_e dsp_shutdown (smio_t *self)
 
     smio_dsp_destroy ((smio_dsp_t **)&self->smio_handler);
     self->exp_ops = NULL;
+    self->param_masks = NULL;
     self->thsafe_client_ops = NULL;
     self->ops = NULL;
     free (self->name);
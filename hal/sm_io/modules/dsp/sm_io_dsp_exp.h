@@ -15,6 +15,7 @@
 
 /* Known modules IDs (from SDB records defined in FPGA) */
 #define DSP_SDB_DEVID       0x1bafbf1e
+#define DSP_SDB_VENDORID    0x1000000000001215ULL
 #define DSP_SDB_NAME        "DSP"
 
 extern const smio_bootstrap_ops_t dsp_bootstrap_ops;
@@ -15,6 +15,7 @@ disp_op_t dsp_set_get_kx_exp = {
     .opcode = DSP_OPCODE_SET_GET_KX,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -27,6 +28,7 @@ disp_op_t dsp_set_get_ky_exp = {
     .opcode = DSP_OPCODE_SET_GET_KY,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -39,6 +41,7 @@ disp_op_t dsp_set_get_ksum_exp = {
     .opcode = DSP_OPCODE_SET_GET_KSUM,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -51,6 +54,7 @@ disp_op_t dsp_set_get_ds_tbt_thres_exp = {
     .opcode = DSP_OPCODE_SET_GET_DS_TBT_THRES,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -63,6 +67,7 @@ disp_op_t dsp_set_get_ds_fofb_thres_exp = {
     .opcode = DSP_OPCODE_SET_GET_DS_FOFB_THRES,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -75,6 +80,7 @@ disp_op_t dsp_set_get_ds_monit_thres_exp = {
     .opcode = DSP_OPCODE_SET_GET_DS_MONIT_THRES,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -87,6 +93,7 @@ disp_op_t dsp_set_get_monit_amp_ch0_exp = {
     .opcode = DSP_OPCODE_SET_GET_MONIT_AMP_CH0,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -99,6 +106,7 @@ disp_op_t dsp_set_get_monit_amp_ch1_exp = {
     .opcode = DSP_OPCODE_SET_GET_MONIT_AMP_CH1,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -111,6 +119,7 @@ disp_op_t dsp_set_get_monit_amp_ch2_exp = {
     .opcode = DSP_OPCODE_SET_GET_MONIT_AMP_CH2,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -123,6 +132,7 @@ disp_op_t dsp_set_get_monit_amp_ch3_exp = {
     .opcode = DSP_OPCODE_SET_GET_MONIT_AMP_CH3,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -135,6 +145,7 @@ disp_op_t dsp_set_get_monit_pos_x_exp = {
     .opcode = DSP_OPCODE_SET_GET_MONIT_POS_X,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -147,6 +158,7 @@ disp_op_t dsp_set_get_monit_pos_y_exp = {
     .opcode = DSP_OPCODE_SET_GET_MONIT_POS_Y,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -159,6 +171,7 @@ disp_op_t dsp_set_get_monit_pos_q_exp = {
     .opcode = DSP_OPCODE_SET_GET_MONIT_POS_Q,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -171,6 +184,7 @@ disp_op_t dsp_set_get_monit_pos_sum_exp = {
     .opcode = DSP_OPCODE_SET_GET_MONIT_POS_SUM,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
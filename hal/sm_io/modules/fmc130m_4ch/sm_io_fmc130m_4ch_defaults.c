@@ -1,8 +1,9 @@
 #include "hal_assert.h"
 #include "sm_io_err.h"
+#include "sm_io.h"
+#include "sm_io_fmc130m_4ch_codes.h"
 #include "sm_io_fmc130m_4ch_defaults.h"
-/* We actually use the libclient to do the "heavy" work for us */
-#include "bpm_client.h"
+#include "sm_io_fmc130m_4ch_core.h"
 
 /* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
 #ifdef ASSERT_TEST
@@ -27,58 +28,74 @@
     CHECK_HAL_ERR(err, SM_IO, "[sm_io:fmc130m_4ch_defaults]",               \
             smio_err_str (err_type))
 
-#define SMIO_FMC130M_4CH_LIBCLIENT_LOG_MODE                "a"
-
-/* We use the actual libclient to send and configure our default values,
- * maintaining internal consistency. So, in fact, we are sending ourselves
- * a message containing the default values. Because of this approach, we
- * only get to default our values when the functions are already exported
- * to the broker, which happens on a late stage. This could cause a fast
- * client to get an inconsistent state from our server */
-/* TODO: Avoid exporting the functions before we have initialized
- * our server with the default values */
-smio_err_e fmc130m_4ch_config_defaults (char *broker_endp, char *service,
-       const char *log_file_name)
+smio_err_e fmc130m_4ch_config_defaults (smio_t *self)
 {
-    (void) log_file_name;
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io:fmc130m_4ch_defaults] Configuring SMIO "
             "FMC130M_4CH with default values ...\n");
-    bpm_client_err_e client_err = BPM_CLIENT_SUCCESS;
     smio_err_e err = SMIO_SUCCESS;
 
-    bpm_client_t *config_client = bpm_client_new_log_mode (broker_endp, 0,
-            log_file_name, SMIO_FMC130M_4CH_LIBCLIENT_LOG_MODE);
-
-    client_err = bpm_set_fmc_pll_function (config_client, service, FMC130M_4CH_DFLT_PLL_FUNC);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not set FMC PLL function",
+    err = smio_config_param_32 (self, FMC130M_4CH_OPCODE_PLL_FUNCTION,
+            FMC130M_4CH_DFLT_PLL_FUNC);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not set FMC PLL function",
             err_param_set, SMIO_ERR_CONFIG_DFLT);
 
-    client_err = bpm_set_fmc_clk_sel (config_client, service, FMC130M_4CH_DFLT_CLK_SEL);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not set FMC CLK SEL function",
+    err = smio_config_param_32 (self, FMC130M_4CH_OPCODE_CLK_SEL,
+            FMC130M_4CH_DFLT_CLK_SEL);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not set FMC CLK SEL function",
             err_param_set, SMIO_ERR_CONFIG_DFLT);
 
-    client_err = bpm_set_trig_dir (config_client, service, FMC130M_4CH_DFLT_TRIG_DIR);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not set FMC TRIG DIR function",
+    err = smio_config_param_32 (self, FMC130M_4CH_OPCODE_TRIG_DIR,
+            FMC130M_4CH_DFLT_TRIG_DIR);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not set FMC TRIG DIR function",
             err_param_set, SMIO_ERR_CONFIG_DFLT);
 
-    client_err = bpm_ad9510_cfg_defaults (config_client, service);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS ||
-            client_err == BPM_CLIENT_ERR_AGAIN, "Could not configure AD9510",
-            err_param_set, SMIO_ERR_CONFIG_DFLT);
+    /* Reprogramming the clock chips glitches the ADC clocks, so, when
+     * asked to, skip it if they are already generating what we want */
+    bool ad9510_match = false;
+    bool si571_match = false;
+    if (self->config_mode == SMIO_CONFIG_MODE_DIFF &&
+            SMIO_FMC130_HANDLER(self)->type == TYPE_FMC130M_4CH_ACTIVE) {
+        /* On errors, just go on and configure them */
+        smch_ad9510_cfg_defaults_match (SMIO_AD9510_HANDLER(self), &ad9510_match);
+        smch_si57x_match_freq (SMIO_SI57X_HANDLER(self),
+                FMC130M_4CH_DFLT_SI57X_FOUT, &si571_match);
+    }
 
-    client_err = bpm_set_si571_defaults (config_client, service, FMC130M_4CH_DFLT_SI57X_FOUT_FACTORY);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not get Si571 defaults",
-            err_param_set, SMIO_ERR_CONFIG_DFLT);
+    if (!ad9510_match) {
+        /* AD9510 defaults take no arguments */
+        zmsg_t *args = zmsg_new ();
+        ASSERT_ALLOC(args, err_param_set, SMIO_ERR_ALLOC);
+        int ret = smio_exec_op (self, FMC130M_4CH_OPCODE_AD9510_CFG_DEFAULTS, &args,
+                NULL, 0);
+        ASSERT_TEST(ret >= 0, "Could not configure AD9510",
+                err_param_set, SMIO_ERR_CONFIG_DFLT);
 
-    client_err = bpm_set_si571_set_freq (config_client, service, FMC130M_4CH_DFLT_SI57X_FOUT);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not set Si571 frequency",
-            err_param_set, SMIO_ERR_CONFIG_DFLT);
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io:fmc130m_4ch_defaults] "
+                "%s: AD9510 configuration changed\n", self->service);
+        self->config_changed++;
+    }
+
+    if (!si571_match) {
+        err = smio_set_param_double (self, FMC130M_4CH_OPCODE_SI571_GET_DEFAULTS,
+                FMC130M_4CH_DFLT_SI57X_FOUT_FACTORY);
+        ASSERT_TEST(err == SMIO_SUCCESS, "Could not get Si571 defaults",
+                err_param_set, SMIO_ERR_CONFIG_DFLT);
+
+        err = smio_set_param_double (self, FMC130M_4CH_OPCODE_SI571_SET_FREQ,
+                FMC130M_4CH_DFLT_SI57X_FOUT);
+        ASSERT_TEST(err == SMIO_SUCCESS, "Could not set Si571 frequency",
+                err_param_set, SMIO_ERR_CONFIG_DFLT);
+
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io:fmc130m_4ch_defaults] "
+                "%s: Si571 frequency changed\n", self->service);
+        self->config_changed++;
+    }
 
-    client_err = bpm_set_si571_oe (config_client, service, FMC130M_4CH_DFLT_SI571_OE);
-    ASSERT_TEST(client_err == BPM_CLIENT_SUCCESS, "Could not enable SI571 Output",
+    err = smio_config_param_32 (self, FMC130M_4CH_OPCODE_SI571_OE,
+            FMC130M_4CH_DFLT_SI571_OE);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not enable SI571 Output",
             err_param_set, SMIO_ERR_CONFIG_DFLT);
 
 err_param_set:
-    bpm_client_destroy (&config_client);
     return err;
 }
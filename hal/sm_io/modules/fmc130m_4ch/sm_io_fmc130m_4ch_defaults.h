@@ -21,8 +21,9 @@
 #define FMC130M_4CH_DFLT_SI57X_FOUT_FACTORY         SI57X_FOUT_FACTORY_DFLT
 #define FMC130M_4CH_DFLT_SI57X_FOUT                 113040445   /* 113.040445 MHz default */
 
-smio_err_e fmc130m_4ch_config_defaults (char *broker_endp, char *service,
-        const char *log_file_name);
+struct _smio_t;
+
+smio_err_e fmc130m_4ch_config_defaults (struct _smio_t *self);
 
 #endif
 
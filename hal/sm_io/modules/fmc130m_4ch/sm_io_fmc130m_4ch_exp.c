@@ -698,6 +698,58 @@ const disp_table_func_fp fmc130m_4ch_exp_fp [] = {
     NULL
 };
 
+/* Bits accepted by the set/get operations above, so values from the
+ * configuration file can be checked before they are written */
+const smio_param_mask_t fmc130m_4ch_param_masks [] = {
+    {FMC130M_4CH_OPCODE_SI571_OE,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, CLK_DISTRIB, SI571_OE, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_PLL_FUNCTION,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, CLK_DISTRIB, PLL_FUNCTION, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_CLK_SEL,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, CLK_DISTRIB, CLK_SEL, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_RAND,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, ADC, RAND, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DITH,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, ADC, DITH, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_SHDN,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, ADC, SHDN, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_PGA,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, ADC, PGA, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_VAL0,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY0_CAL, VAL, MULT_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_VAL1,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY1_CAL, VAL, MULT_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_VAL2,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY2_CAL, VAL, MULT_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_VAL3,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY3_CAL, VAL, MULT_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_LINE0,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY0_CAL, LINE, MULT_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_LINE1,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY1_CAL, LINE, MULT_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_LINE2,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY2_CAL, LINE, MULT_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_LINE3,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY3_CAL, LINE, MULT_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_UPDT0,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY0_CAL, UPDATE, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_UPDT1,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY1_CAL, UPDATE, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_UPDT2,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY2_CAL, UPDATE, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_ADC_DLY_UPDT3,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, IDELAY3_CAL, UPDATE, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_TEST_DATA_EN,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, FPGA_CTRL, TEST_DATA_EN, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_TRIG_DIR,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, TRIGGER, DIR, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_TRIG_TERM,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, TRIGGER, TERM, SINGLE_BIT_PARAM)},
+    {FMC130M_4CH_OPCODE_TRIG_VAL,
+        RW_PARAM_MASK(WB_FMC_130M_4CH_CSR, TRIGGER, TRIG_VAL, SINGLE_BIT_PARAM)},
+    SMIO_PARAM_MASK_END
+};
+
 /************************************************************/
 /***************** Export methods functions *****************/
 /************************************************************/
@@ -789,6 +841,7 @@ smio_err_e fmc130m_4ch_init (smio_t * self)
             "function descriptors with the callbacks", err_fill_desc);
 
     self->exp_ops = fmc130m_4ch_exp_ops;
+    self->param_masks = fmc130m_4ch_param_masks;
 
     /* Initialize specific structure */
     self->smio_handler = smio_fmc130m_4ch_new (self);
@@ -810,6 +863,7 @@ smio_err_e fmc130m_4ch_shutdown (smio_t *self)
 
     smio_fmc130m_4ch_destroy ((smio_fmc130m_4ch_t **) &self->smio_handler);
     self->exp_ops = NULL;
+    self->param_masks = NULL;
     self->thsafe_client_ops = NULL;
     self->ops = NULL;
     free (self->name);
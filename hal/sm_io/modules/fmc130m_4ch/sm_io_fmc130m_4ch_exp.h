@@ -15,6 +15,7 @@
 
 /* Known modules IDs (from SDB records defined in FPGA) */
 #define FMC130M_4CH_SDB_DEVID       0x7085ef15
+#define FMC130M_4CH_SDB_VENDORID    0x1000000000001215ULL
 #define FMC130M_4CH_SDB_NAME        "FMC130M_4CH"
 
 extern const smio_bootstrap_ops_t fmc130m_4ch_bootstrap_ops;
@@ -8,6 +8,9 @@ sm_io_modules_DIR = hal/sm_io/modules
 
 sm_io_modules_OBJS = $(sm_io_modules_DIR)/sm_io_mod_dispatch.o \
 		     $(sm_io_modules_DIR)/sm_io_codes.o \
+		     $(sm_io_modules_DIR)/sm_io_stats_exports.o \
+		     $(sm_io_modules_DIR)/sm_io_coalesce_exports.o \
+		     $(sm_io_modules_DIR)/sm_io_reload_exports.o \
 		     $(sm_io_fmc130m_4ch_OBJS) \
 		     $(sm_io_acq_OBJS) \
 		     $(sm_io_dsp_OBJS) \
@@ -12,8 +12,9 @@
 #define RFFE_DFLT_ATT1                              31.5            /* 31.1 dB attenuation */
 #define RFFE_DFLT_ATT2                              31.5            /* 31.1 dB attenuation */
 
-smio_err_e rffe_config_defaults (char *broker_endp, char *service,
-        const char *log_file_name);
+struct _smio_t;
+
+smio_err_e rffe_config_defaults (struct _smio_t *self);
 
 #endif
 
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_COALESCE_CODES_H_
+#define _SM_IO_COALESCE_CODES_H_
+
+#include <inttypes.h>
+
+/* Messaging OPCODES */
+#define SMIO_COALESCE_OPCODE_SIZE       (sizeof(uint32_t))
+#define SMIO_COALESCE_OPCODE_TYPE       uint32_t
+
+/* Generic operations are exported by every SMIO, so their opcodes are taken
+ * from the top of the opcode space, right after the statistics ones */
+#define SMIO_COALESCE_OPCODE_SET_OP_WINDOW  191
+#define SMIO_COALESCE_NAME_SET_OP_WINDOW    "smio_set_op_coalesce_window"
+#define SMIO_COALESCE_OPCODE_END            192
+
+/* Messaging Reply OPCODES */
+#define SMIO_COALESCE_REPLY_SIZE        (sizeof(uint32_t))
+#define SMIO_COALESCE_REPLY_TYPE        uint32_t
+
+#define SMIO_COALESCE_OK                0   /* Operation was successful */
+#define SMIO_COALESCE_ERR               1   /* Could not set the window */
+#define SMIO_COALESCE_NOT_READ_ONLY     2   /* Operation is not registered or
+                                               has side effects, so its
+                                               results are never shared */
+#define SMIO_COALESCE_REPLY_END         3   /* End marker */
+
+#endif
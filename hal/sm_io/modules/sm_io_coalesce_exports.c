@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include "sm_io_coalesce_exports.h"
+#include "sm_io_coalesce_codes.h"
+
+/* Description of the generic SMIO request coalescing functions */
+
+disp_op_t smio_coalesce_set_op_window_exp = {
+    .name = SMIO_COALESCE_NAME_SET_OP_WINDOW,
+    .opcode = SMIO_COALESCE_OPCODE_SET_OP_WINDOW,
+    .retval = DISP_ARG_END,
+    .retval_owner = DISP_OWNER_OTHER,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+/* Exported function description */
+const disp_op_t *smio_coalesce_exp_ops [] = {
+    &smio_coalesce_set_op_window_exp,
+    NULL
+};
@@ -13,6 +13,9 @@ const disp_op_t **smio_exp_ops [] = {
     fmc130m_4ch_exp_ops,
     swap_exp_ops,
     rffe_exp_ops,
+    smio_stats_exp_ops,
+    smio_coalesce_exp_ops,
+    smio_reload_exp_ops,
     NULL
 };
 
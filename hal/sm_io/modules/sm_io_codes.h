@@ -14,6 +14,10 @@
 #include "sm_io_dsp_codes.h"
 #include "sm_io_swap_codes.h"
 #include "sm_io_rffe_codes.h"
+#include "sm_io_stats_codes.h"
+#include "sm_io_coalesce_codes.h"
+#include "sm_io_deadline_codes.h"
+#include "sm_io_reload_codes.h"
 
 /* Include all function descriptors */
 #include "sm_io_fmc130m_4ch_exports.h"
@@ -21,6 +25,9 @@
 #include "sm_io_dsp_exports.h"
 #include "sm_io_swap_exports.h"
 #include "sm_io_rffe_exports.h"
+#include "sm_io_stats_exports.h"
+#include "sm_io_coalesce_exports.h"
+#include "sm_io_reload_exports.h"
 
 /* Merge all function descriptors in a single structure */
 extern const disp_op_t **smio_exp_ops [];
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_DEADLINE_CODES_H_
+#define _SM_IO_DEADLINE_CODES_H_
+
+#include <inttypes.h>
+
+/* Any request to a SMIO might be preceded by this optional frame, carrying
+ * how long the client is still interested in the reply:
+ *
+ * frame 0: deadline (optional)
+ * frame 1: operation code
+ * frame n: arguments
+ *
+ * The time-to-live is relative, so the client and the server clocks need
+ * not agree. The server counts it from the arrival of the request, on its
+ * monotonic clock. The time the request spent getting there is not
+ * counted */
+#define SMIO_DEADLINE_TAG               0x0dead11e
+
+struct _smio_deadline_t {
+    uint32_t tag;                       /* Must be SMIO_DEADLINE_TAG */
+    uint32_t reserved;                  /* Must be zero */
+    uint64_t ttl_us;                    /* Time-to-live, in us. 0 means
+                                           the request has already expired */
+};
+
+typedef struct _smio_deadline_t smio_deadline_t;
+
+/* Messaging Reply OPCODES */
+
+/* Request expired while waiting to be served and was dropped. Far above
+ * any module specific reply code */
+#define SMIO_DEADLINE_EXPIRED           255
+
+#endif
@@ -12,24 +12,32 @@
 #include "sm_io_dsp_exp.h"
 #include "sm_io_swap_exp.h"
 #include "sm_io_rffe_exp.h"
+#include "board.h"
 
 /* Table of all known modules we can handle */
 const smio_mod_dispatch_t smio_mod_dispatch[MOD_DISPATCH_END] = {
     [0] = { .id = FMC130M_4CH_SDB_DEVID,
             .name = FMC130M_4CH_SDB_NAME,
-            .bootstrap_ops = &fmc130m_4ch_bootstrap_ops
+            .bootstrap_ops = &fmc130m_4ch_bootstrap_ops,
+            .sdb_vendor_id = FMC130M_4CH_SDB_VENDORID
     },
     [1] = { .id = ACQ_SDB_DEVID,
             .name = ACQ_SDB_NAME,
-            .bootstrap_ops = &acq_bootstrap_ops
+            .bootstrap_ops = &acq_bootstrap_ops,
+            .sdb_vendor_id = ACQ_SDB_VENDORID
     },
     [2] = { .id = DSP_SDB_DEVID,
             .name = DSP_SDB_NAME,
-            .bootstrap_ops = &dsp_bootstrap_ops
+            .bootstrap_ops = &dsp_bootstrap_ops,
+            .sdb_vendor_id = DSP_SDB_VENDORID
     },
     [3] = { .id = SWAP_SDB_DEVID,
             .name = SWAP_SDB_NAME,
-            .bootstrap_ops = &swap_bootstrap_ops
+            .bootstrap_ops = &swap_bootstrap_ops,
+            .sdb_vendor_id = SWAP_SDB_VENDORID,
+            /* SWAP lives inside the DSP address space, but it is
+             * addressed from the DSP base */
+            .sdb_base_offs = DSP_BPM_RAW_SWAP_OFFS
     },
     [4] = { .id = RFFE_DEVID, /* No SDB as this is not an FPGA module */
             .name = RFFE_NAME,
@@ -21,6 +21,10 @@ struct _smio_mod_dispatch_t {
     uint32_t id;
     const char *name;
     const struct _smio_bootstrap_ops_t *bootstrap_ops;
+    uint64_t sdb_vendor_id;             /* SDB vendor ID. 0 if the module
+                                           is not described in the SDB */
+    uint32_t sdb_base_offs;             /* Offset of the SDB device address
+                                           from the SMIO base address */
 };
 
 typedef struct _smio_mod_dispatch_t smio_mod_dispatch_t;
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_RELOAD_CODES_H_
+#define _SM_IO_RELOAD_CODES_H_
+
+#include <inttypes.h>
+
+/* Messaging OPCODES */
+#define SMIO_RELOAD_OPCODE_SIZE         (sizeof(uint32_t))
+#define SMIO_RELOAD_OPCODE_TYPE         uint32_t
+
+/* Management operations are exported by the DEVIO, under the service name
+ * of each of its boards (e.g., BPM0:DEVIO), and not by the SMIOs. Their
+ * opcodes are taken from the top of the opcode space, right after the
+ * generic SMIO ones */
+#define SMIO_RELOAD_OPCODE_RELOAD       192
+#define SMIO_RELOAD_NAME_RELOAD         "smio_reload"
+#define SMIO_RELOAD_OPCODE_END          193
+
+/* Maximum length of the name of the SMIO service to be reloaded, including
+ * the terminating NULL */
+#define SMIO_RELOAD_SERVICE_LEN         64
+
+/* Messaging Reply OPCODES */
+#define SMIO_RELOAD_REPLY_SIZE          (sizeof(uint32_t))
+#define SMIO_RELOAD_REPLY_TYPE          uint32_t
+
+#define SMIO_RELOAD_OK                  0   /* SMIO was reloaded */
+#define SMIO_RELOAD_ERR                 1   /* SMIO could not be reloaded */
+#define SMIO_RELOAD_NO_SMIO             2   /* No such SMIO in this DEVIO */
+#define SMIO_RELOAD_REPLY_END           3   /* End marker */
+
+/* How long a reload took, as seen by the DEVIO */
+struct _smio_reload_report_t {
+    uint64_t exit_us;               /* From the self-destruct message until the
+                                       old SMIO acknowledged it exited */
+    uint64_t downtime_us;           /* From the self-destruct message until the
+                                       new SMIO was spawned. The new SMIO still
+                                       applies its default values before
+                                       serving requests, and logs how long
+                                       the whole reload took once it does */
+};
+
+typedef struct _smio_reload_report_t smio_reload_report_t;
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include "sm_io_reload_exports.h"
+#include "sm_io_reload_codes.h"
+
+/* Description of the DEVIO reload functions */
+
+disp_op_t smio_reload_reload_exp = {
+    .name = SMIO_RELOAD_NAME_RELOAD,
+    .opcode = SMIO_RELOAD_OPCODE_RELOAD,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_STRUCT, smio_reload_report_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_STRING, char [SMIO_RELOAD_SERVICE_LEN]),
+        DISP_ARG_END
+    }
+};
+
+/* Exported function description */
+const disp_op_t *smio_reload_exp_ops [] = {
+    &smio_reload_reload_exp,
+    NULL
+};
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_STATS_CODES_H_
+#define _SM_IO_STATS_CODES_H_
+
+#include <inttypes.h>
+
+/* Number of histogram bins. Bin 0 holds latencies below 1 us, bin i
+ * (0 < i < SMIO_STATS_HIST_BINS-1) holds latencies in [2^(i-1), 2^i) us
+ * and the last bin holds everything above that */
+#define SMIO_STATS_HIST_BINS            24
+#define SMIO_STATS_NAME_LEN             48
+
+struct _smio_stats_hist_t {
+    uint64_t total_ns;                  /* Sum of all samples, in ns */
+    uint64_t max_ns;                    /* Largest sample, in ns */
+    uint32_t bins [SMIO_STATS_HIST_BINS]; /* Log2 histogram, in us */
+};
+
+typedef struct _smio_stats_hist_t smio_stats_hist_t;
+
+struct _smio_op_stats_t {
+    uint32_t opcode;                    /* Operation code */
+    char name [SMIO_STATS_NAME_LEN];    /* Operation name */
+    uint64_t calls;                     /* Number of calls */
+    uint64_t errors;                    /* Number of calls that returned an error */
+    uint64_t coalesced;                 /* Number of calls answered with the
+                                           result of an identical call */
+    uint64_t expired;                   /* Number of requests dropped as their
+                                           deadline expired before the call */
+    uint64_t msg_allocs;                /* Messages and frames allocated from
+                                           the heap during the calls */
+    uint64_t msg_reuses;                /* Messages and frames recycled from
+                                           the thread's pool during the calls */
+    smio_stats_hist_t queue;            /* Time spent waiting to be dispatched */
+    smio_stats_hist_t handler;          /* Time spent in the handler, excluding
+                                           the thsafe wait */
+    smio_stats_hist_t thsafe;           /* Time spent waiting for DEVIO replies */
+};
+
+typedef struct _smio_op_stats_t smio_op_stats_t;
+
+/* Messaging OPCODES */
+#define SMIO_STATS_OPCODE_SIZE          (sizeof(uint32_t))
+#define SMIO_STATS_OPCODE_TYPE          uint32_t
+
+/* Generic operations are exported by every SMIO, so their opcodes are taken
+ * from the top of the opcode space, away from the modules' own opcodes */
+#define SMIO_STATS_OPCODE_GET_OP_STATS  190
+#define SMIO_STATS_NAME_GET_OP_STATS    "smio_get_op_stats"
+#define SMIO_STATS_OPCODE_END           191
+
+/* Messaging Reply OPCODES */
+#define SMIO_STATS_REPLY_SIZE           (sizeof(uint32_t))
+#define SMIO_STATS_REPLY_TYPE           uint32_t
+
+#define SMIO_STATS_OK                   0   /* Operation was successful */
+#define SMIO_STATS_ERR                  1   /* Could not get statistics */
+#define SMIO_STATS_NO_MORE_OPS          2   /* No operation registered at or
+                                               above the requested opcode */
+#define SMIO_STATS_REPLY_END            3   /* End marker */
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include "sm_io_stats_exports.h"
+#include "sm_io_stats_codes.h"
+
+/* Description of the generic SMIO statistics functions */
+
+disp_op_t smio_stats_get_op_stats_exp = {
+    .name = SMIO_STATS_NAME_GET_OP_STATS,
+    .opcode = SMIO_STATS_OPCODE_GET_OP_STATS,
+    .retval = DISP_ARG_ENCODE(DISP_ATYPE_STRUCT, smio_op_stats_t),
+    .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_READ_ONLY,
+    .args = {
+        DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
+        DISP_ARG_END
+    }
+};
+
+/* Exported function description */
+const disp_op_t *smio_stats_exp_ops [] = {
+    &smio_stats_get_op_stats_exp,
+    NULL
+};
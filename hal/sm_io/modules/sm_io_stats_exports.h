@@ -0,0 +1,17 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_STATS_EXPORTS_H_
+#define _SM_IO_STATS_EXPORTS_H_
+
+#include "dispatch_table.h"
+
+extern disp_op_t smio_stats_get_op_stats_exp;
+
+extern const disp_op_t *smio_stats_exp_ops [];
+
+#endif
@@ -41,8 +41,9 @@
 #define SWAP_DFLT_GAIN_DD               _SWAP_DFLT_GAIN
 #define SWAP_DFLT_GAIN_DB               _SWAP_DFLT_GAIN
 
-smio_err_e swap_config_defaults (char *broker_endp, char *service,
-        const char *log_file_name);
+struct _smio_t;
+
+smio_err_e swap_config_defaults (struct _smio_t *self);
 
 #endif
 
@@ -185,6 +185,24 @@ const disp_table_func_fp swap_exp_fp [] = {
     NULL
 };
 
+/* Bits accepted by the set/get operations above, so values from the
+ * configuration file can be checked before they are written */
+const smio_param_mask_t swap_param_masks [] = {
+    {SWAP_OPCODE_SET_GET_SW,
+        RW_PARAM_MASK(BPM_SWAP, CTRL, MODE_GLOBAL, MULT_BIT_PARAM)},
+    {SWAP_OPCODE_SET_GET_SW_EN,
+        RW_PARAM_MASK(BPM_SWAP, CTRL, CLK_SWAP_EN, SINGLE_BIT_PARAM)},
+    {SWAP_OPCODE_SET_GET_DIV_CLK,
+        RW_PARAM_MASK(BPM_SWAP, CTRL, SWAP_DIV_F, MULT_BIT_PARAM)},
+    {SWAP_OPCODE_SET_GET_SW_DLY,
+        RW_PARAM_MASK(BPM_SWAP, DLY, GLOBAL, MULT_BIT_PARAM)},
+    {SWAP_OPCODE_SET_GET_WDW_EN,
+        RW_PARAM_MASK(BPM_SWAP, WDW_CTL, EN_GLOBAL, SINGLE_BIT_PARAM)},
+    {SWAP_OPCODE_SET_GET_WDW_DLY,
+        RW_PARAM_MASK(BPM_SWAP, WDW_CTL, DLY, MULT_BIT_PARAM)},
+    SMIO_PARAM_MASK_END
+};
+
 /************************************************************/
 /***************** Export methods functions *****************/
 /************************************************************/
@@ -273,6 +291,7 @@ smio_err_e swap_init (smio_t * self)
             "function descriptors with the callbacks", err_fill_desc);
 
     self->exp_ops = swap_exp_ops;
+    self->param_masks = swap_param_masks;
 
     /* Initialize specific structure */
     self->smio_handler = smio_swap_new (self);
@@ -294,6 +313,7 @@ smio_err_e swap_shutdown (smio_t *self)
 
     smio_swap_destroy ((smio_swap_t **)&self->smio_handler);
     self->exp_ops = NULL;
+    self->param_masks = NULL;
     self->thsafe_client_ops = NULL;
     self->ops = NULL;
     free (self->name);
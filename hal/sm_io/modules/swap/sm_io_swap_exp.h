@@ -15,6 +15,7 @@
 
 /* Known modules IDs (from SDB records defined in FPGA) */
 #define SWAP_SDB_DEVID       0x12897592
+#define SWAP_SDB_VENDORID    0x1000000000001215ULL
 #define SWAP_SDB_NAME        "SWAP"
 
 extern const smio_bootstrap_ops_t swap_bootstrap_ops;
@@ -15,6 +15,7 @@ disp_op_t swap_set_get_sw_exp = {
     .opcode = SWAP_OPCODE_SET_GET_SW,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -27,6 +28,7 @@ disp_op_t swap_set_get_sw_en_exp = {
     .opcode = SWAP_OPCODE_SET_GET_SW_EN,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -39,6 +41,7 @@ disp_op_t swap_set_get_div_clk_exp = {
     .opcode = SWAP_OPCODE_SET_GET_DIV_CLK,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -51,6 +54,7 @@ disp_op_t swap_set_get_sw_dly_exp = {
     .opcode = SWAP_OPCODE_SET_GET_SW_DLY,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -63,6 +67,7 @@ disp_op_t swap_set_get_wdw_en_exp = {
     .opcode = SWAP_OPCODE_SET_GET_WDW_EN,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -75,6 +80,7 @@ disp_op_t swap_set_get_wdw_dly_exp = {
     .opcode = SWAP_OPCODE_SET_GET_WDW_DLY,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -87,6 +93,7 @@ disp_op_t swap_set_get_gain_a_exp = {
     .opcode = SWAP_OPCODE_SET_GET_GAIN_A,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -99,6 +106,7 @@ disp_op_t swap_set_get_gain_b_exp = {
     .opcode = SWAP_OPCODE_SET_GET_GAIN_B,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -111,6 +119,7 @@ disp_op_t swap_set_get_gain_c_exp = {
     .opcode = SWAP_OPCODE_SET_GET_GAIN_C,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -123,6 +132,7 @@ disp_op_t swap_set_get_gain_d_exp = {
     .opcode = SWAP_OPCODE_SET_GET_GAIN_D,
     .retval = DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
     .retval_owner = DISP_OWNER_OTHER,
+    .flags = DISP_OP_FLAG_RW_PARAM,
     .args = {
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
         DISP_ARG_ENCODE(DISP_ATYPE_UINT32, uint32_t),
@@ -227,6 +227,13 @@ typedef int (*rw_param_format_fp) (uint32_t *param);
                 max, chk_funcp, fmt_funcp, clr_field, smio_thsafe_client_read_32, \
                     smio_thsafe_client_write_32)
 
+/* Bits a set/get parameter accepts, right-aligned: a single bit, or as many
+ * bits as its register field has. Used to check values before they get to
+ * SET_PARAM, which would silently drop the bits that do not fit */
+#define RW_PARAM_MASK(prefix, reg, field, single_bit)                           \
+    (WHEN(single_bit)(0x1)                                                      \
+     WHENNOT(single_bit)(CONCAT_NAME4_RW(prefix, reg, field, R(0xFFFFFFFF))))
+
 uint32_t check_param_limits (uint32_t value, uint32_t min, uint32_t max);
 
 #endif
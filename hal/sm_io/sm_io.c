@@ -5,9 +5,15 @@
  * Released according to the GNU LGPL, version 3 or any later version.
  */
 
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
 #include "sm_io.h"
 #include "exp_ops_codes.h"
 #include "rw_param.h"
+#include "sm_io_stats_exports.h"
+#include "sm_io_coalesce_exports.h"
 #include "hal_assert.h"
 
 /* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
@@ -57,7 +63,24 @@
     return self->thsafe_client_ops->func_name (self, ##__VA_ARGS__);  \
 }
 
+/* Default value parsed from the configuration file */
+struct _smio_cfg_param_t {
+    const disp_op_t *disp_op;
+    uint8_t value [sizeof (uint64_t)];
+    size_t size;
+    bool applied;                       /* Written in place of a built-in
+                                           default */
+};
+
+typedef struct _smio_cfg_param_t smio_cfg_param_t;
+
 static smio_err_e _smio_do_op (void *owner, void *msg);
+static int _smio_exec_op (smio_t *self, uint32_t opcode, zmsg_t **args,
+        void *ret, uint32_t ret_size);
+static smio_err_e _smio_parse_cfg_param (smio_t *self, const char *name,
+        const char *value, smio_cfg_param_t *param);
+static smio_cfg_param_t *_smio_lookup_cfg_param (smio_t *self, uint32_t opcode);
+static uint32_t _smio_lookup_param_mask (smio_t *self, uint32_t opcode);
 
 /************************************************************/
 /**************** SMIO Ops wrapper functions ****************/
@@ -104,11 +127,43 @@ smio_err_e smio_export_ops (smio_t *self, const disp_op_t** smio_exp_ops)
     ASSERT_TEST(herr == HALUTILS_SUCCESS, "smio_export_ops: Could not export"
             " SMIO ops", err_export_op, SMIO_ERR_EXPORT_OP);
 
+    /* Export the generic operations, available on every SMIO */
+    err = smio_init_exp_ops (self, (disp_op_t **) smio_stats_exp_ops,
+            smio_stats_exp_fp);
+    ASSERT_TEST(err == SMIO_SUCCESS, "smio_export_ops: Could not fill generic"
+            " SMIO ops description", err_export_gen_op);
+
+    herr = disp_table_insert_all (self->exp_ops_dtable, smio_stats_exp_ops);
+    ASSERT_TEST(herr == HALUTILS_SUCCESS, "smio_export_ops: Could not export"
+            " generic SMIO ops", err_export_gen_op, SMIO_ERR_EXPORT_OP);
+
+    err = smio_init_exp_ops (self, (disp_op_t **) smio_coalesce_exp_ops,
+            smio_coalesce_exp_fp);
+    ASSERT_TEST(err == SMIO_SUCCESS, "smio_export_ops: Could not fill generic"
+            " SMIO ops description", err_export_gen_op);
+
+    herr = disp_table_insert_all (self->exp_ops_dtable, smio_coalesce_exp_ops);
+    ASSERT_TEST(herr == HALUTILS_SUCCESS, "smio_export_ops: Could not export"
+            " generic SMIO ops", err_export_gen_op, SMIO_ERR_EXPORT_OP);
+
+    /* Account for every exported operation */
+    err = smio_stats_register_ops (self->stats, smio_exp_ops);
+    ASSERT_TEST(err == SMIO_SUCCESS, "smio_export_ops: Could not register"
+            " SMIO ops statistics", err_register_stats);
+    err = smio_stats_register_ops (self->stats, smio_stats_exp_ops);
+    ASSERT_TEST(err == SMIO_SUCCESS, "smio_export_ops: Could not register"
+            " generic SMIO ops statistics", err_register_stats);
+    err = smio_stats_register_ops (self->stats, smio_coalesce_exp_ops);
+    ASSERT_TEST(err == SMIO_SUCCESS, "smio_export_ops: Could not register"
+            " generic SMIO ops statistics", err_register_stats);
+
     err = SMIO_FUNC_OPS_NOFAIL_WRAPPER(err, export_ops, smio_exp_ops);
     ASSERT_TEST(err == SMIO_SUCCESS, "Registered SMIO \"export_ops\" function error",
         err_func);
 
 err_func:
+err_register_stats:
+err_export_gen_op:
 err_export_op:
     return err;
 }
@@ -124,6 +179,8 @@ smio_err_e smio_unexport_ops (smio_t *self)
     ASSERT_TEST(herr == HALUTILS_SUCCESS, "smio_export_ops: Could not unexport SMIO ops",
             err_unexport_op, SMIO_ERR_EXPORT_OP);
 
+    smio_stats_unregister_ops (self->stats);
+
     err = SMIO_FUNC_OPS_NOFAIL_WRAPPER(err, unexport_ops);
     ASSERT_TEST(err == SMIO_SUCCESS, "Registered SMIO \"unexport_ops\" function error",
         err_func);
@@ -138,6 +195,251 @@ smio_err_e smio_do_op (void *owner, void *msg)
     return _smio_do_op (owner, msg);
 }
 
+smio_err_e smio_tick (smio_t *self)
+{
+    assert (self);
+    smio_err_e err = SMIO_SUCCESS;
+
+    err = SMIO_FUNC_OPS_NOFAIL_WRAPPER(err, tick);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Registered SMIO \"tick\" function error",
+        err_func);
+
+err_func:
+    return err;
+}
+
+bool smio_tick_pending (smio_t *self)
+{
+    assert (self);
+
+    if (self->ops == NULL || self->ops->tick == NULL) {
+        return false;
+    }
+
+    return (self->ops->tick_pending != NULL) ?
+        self->ops->tick_pending (self) : true;
+}
+
+int smio_exec_op (smio_t *self, uint32_t opcode, zmsg_t **args, void *ret,
+        uint32_t ret_size)
+{
+    return _smio_exec_op (self, opcode, args, ret, ret_size);
+}
+
+smio_err_e smio_set_param (smio_t *self, uint32_t opcode, const void *param,
+        size_t size)
+{
+    assert (self);
+    assert (param);
+
+    smio_err_e err = SMIO_SUCCESS;
+    /* Same frames as the ones sent by the libclient */
+    uint32_t rw = 0;                    /* Write */
+
+    zmsg_t *args = zmsg_new ();
+    ASSERT_ALLOC(args, err_args_alloc, SMIO_ERR_ALLOC);
+    zmsg_addmem (args, &rw, sizeof (rw));
+    zmsg_addmem (args, param, size);
+
+    int ret = _smio_exec_op (self, opcode, &args, NULL, 0);
+    ASSERT_TEST(ret >= 0, "smio_set_param: Could not set parameter",
+            err_exec_op, SMIO_ERR_WRONG_PARAM);
+
+err_exec_op:
+err_args_alloc:
+    return err;
+}
+
+smio_err_e smio_set_param_32 (smio_t *self, uint32_t opcode, uint32_t param)
+{
+    return smio_set_param (self, opcode, &param, sizeof (param));
+}
+
+smio_err_e smio_set_param_double (smio_t *self, uint32_t opcode, double param)
+{
+    return smio_set_param (self, opcode, &param, sizeof (param));
+}
+
+smio_err_e smio_get_param (smio_t *self, uint32_t opcode, void *param,
+        size_t size)
+{
+    assert (self);
+    assert (param);
+
+    smio_err_e err = SMIO_SUCCESS;
+    uint32_t rw = 1;                    /* Read */
+
+    /* The value argument is ignored on reads, but it must still have
+     * the size the operation expects */
+    zmsg_t *args = zmsg_new ();
+    ASSERT_ALLOC(args, err_args_alloc, SMIO_ERR_ALLOC);
+    zmsg_addmem (args, &rw, sizeof (rw));
+    zmsg_addmem (args, param, size);
+
+    int ret = _smio_exec_op (self, opcode, &args, param, size);
+    ASSERT_TEST(ret == (int) size, "smio_get_param: Could not get parameter",
+            err_exec_op, SMIO_ERR_WRONG_PARAM);
+
+err_exec_op:
+err_args_alloc:
+    return err;
+}
+
+smio_err_e smio_config_param (smio_t *self, uint32_t opcode, const void *param,
+        size_t size)
+{
+    assert (self);
+    assert (param);
+
+    smio_err_e err = SMIO_SUCCESS;
+    /* Large enough for every set/get parameter type */
+    uint8_t curr_param [sizeof (uint64_t)];
+
+    /* The configuration file has the last word. Writing its value here,
+     * instead of after the built-in one, keeps SMIO_CONFIG_MODE_DIFF from
+     * toggling the register back and forth */
+    smio_cfg_param_t *cfg_param = _smio_lookup_cfg_param (self, opcode);
+    if (cfg_param != NULL && cfg_param->size == size) {
+        param = cfg_param->value;
+        cfg_param->applied = true;
+    }
+
+    if (self->config_mode == SMIO_CONFIG_MODE_DIFF && size <= sizeof (curr_param)) {
+        memcpy (curr_param, param, size);
+
+        /* If we can't read it, just write it */
+        err = smio_get_param (self, opcode, curr_param, size);
+        if (err == SMIO_SUCCESS && memcmp (curr_param, param, size) == 0) {
+            goto no_change;
+        }
+    }
+
+    err = smio_set_param (self, opcode, param, size);
+    ASSERT_TEST(err == SMIO_SUCCESS, "smio_config_param: Could not set parameter",
+            err_set_param);
+
+    const disp_op_t *disp_op = disp_table_lookup (self->exp_ops_dtable, opcode);
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io] %s: %s changed\n",
+            self->service, (disp_op != NULL) ? disp_op->name : "?");
+    self->config_changed++;
+
+no_change:
+err_set_param:
+    return err;
+}
+
+smio_err_e smio_config_param_32 (smio_t *self, uint32_t opcode, uint32_t param)
+{
+    return smio_config_param (self, opcode, &param, sizeof (param));
+}
+
+smio_err_e smio_config_param_double (smio_t *self, uint32_t opcode, double param)
+{
+    return smio_config_param (self, opcode, &param, sizeof (param));
+}
+
+smio_err_e smio_config_file_load (smio_t *self, const char *cfg_file,
+        const char *cfg_path)
+{
+    assert (self);
+    assert (cfg_file);
+    assert (cfg_path);
+
+    smio_err_e err = SMIO_SUCCESS;
+    smio_cfg_param_t *params = NULL;
+    size_t num_params = 0;
+
+    free (self->cfg_params);
+    self->cfg_params = NULL;
+    self->cfg_num_params = 0;
+
+    zconfig_t *root_cfg = zconfig_load ((char *) cfg_file);
+    /* No configuration file. Nothing to do */
+    if (root_cfg == NULL) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io] %s: could not load "
+                "configuration file %s\n", self->service, cfg_file);
+        goto err_cfg_load;
+    }
+
+    /* No default values for us. Nothing to do */
+    zconfig_t *defaults_cfg = zconfig_locate (root_cfg, (char *) cfg_path);
+    if (defaults_cfg == NULL) {
+        goto err_cfg_locate;
+    }
+
+    zconfig_t *param_cfg = zconfig_child (defaults_cfg);
+    for (; param_cfg != NULL; param_cfg = zconfig_next (param_cfg)) {
+        num_params++;
+    }
+
+    if (num_params == 0) {
+        goto err_cfg_locate;
+    }
+
+    params = zmalloc (sizeof (*params) * num_params);
+    ASSERT_ALLOC(params, err_params_alloc, SMIO_ERR_ALLOC);
+
+    /* Validate all of the values before keeping any of them, so a typo
+     * does not leave the SMIO half-configured. An operation found twice
+     * keeps its last value */
+    size_t i = 0;
+    param_cfg = zconfig_child (defaults_cfg);
+    for (; param_cfg != NULL; param_cfg = zconfig_next (param_cfg)) {
+        err = _smio_parse_cfg_param (self, zconfig_name (param_cfg),
+                zconfig_value (param_cfg), &params [i]);
+        ASSERT_TEST(err == SMIO_SUCCESS, "smio_config_file_load: Invalid "
+                "default value in configuration file", err_parse_param);
+
+        size_t j;
+        for (j = 0; j < i && params [j].disp_op != params [i].disp_op; ++j);
+        if (j < i) {
+            params [j] = params [i];
+        }
+        else {
+            ++i;
+        }
+    }
+
+    self->cfg_params = params;
+    self->cfg_num_params = i;
+    params = NULL;
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io] %s: %zu default value(s) "
+            "loaded from %s\n", self->service, self->cfg_num_params, cfg_file);
+
+err_parse_param:
+    free (params);
+err_params_alloc:
+err_cfg_locate:
+    zconfig_destroy (&root_cfg);
+err_cfg_load:
+    return err;
+}
+
+smio_err_e smio_config_file_apply (smio_t *self)
+{
+    assert (self);
+
+    smio_err_e err = SMIO_SUCCESS;
+    size_t i;
+    for (i = 0; i < self->cfg_num_params; ++i) {
+        if (self->cfg_params [i].applied) {
+            continue;
+        }
+
+        err = smio_config_param (self, self->cfg_params [i].disp_op->opcode,
+                self->cfg_params [i].value, self->cfg_params [i].size);
+        ASSERT_TEST(err == SMIO_SUCCESS, "smio_config_file_apply: Could not "
+                "set default value from configuration file", err_config_param);
+    }
+
+err_config_param:
+    free (self->cfg_params);
+    self->cfg_params = NULL;
+    self->cfg_num_params = 0;
+    return err;
+}
+
 smio_err_e smio_init_exp_ops (smio_t *self, disp_op_t** smio_exp_ops,
         const disp_table_func_fp *func_fps)
 {
@@ -180,6 +482,40 @@ err_do_op:
     return err;
 }
 
+static int _smio_exec_op (smio_t *self, uint32_t opcode, zmsg_t **args,
+        void *ret, uint32_t ret_size)
+{
+    assert (self);
+    assert (args);
+    assert (*args);
+
+    exp_msg_zmq_t smio_args = {
+        .tag = EXP_MSG_ZMQ_TAG,
+        .msg = args,
+        .reply_to = NULL};
+    void *disp_ret = NULL;
+    bool coalesced = false;
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io] Calling opcode %u "
+            "in-process\n", opcode);
+
+    /* Go through the coalescer, so results shared among requests are
+     * dropped if we change anything */
+    int disp_table_ret = smio_coalesce_check_call (self->coalesce,
+            self->exp_ops_dtable, opcode, self, &smio_args, smio_stats_get_ts (),
+            &disp_ret, &coalesced);
+
+    if (disp_table_ret > 0 && ret != NULL) {
+        memcpy (ret, disp_ret, ((uint32_t) disp_table_ret < ret_size) ?
+                (uint32_t) disp_table_ret : ret_size);
+    }
+
+    disp_table_release_ret (self->exp_ops_dtable, &disp_ret);
+    zmsg_destroy (args);
+
+    return disp_table_ret;
+}
+
 /************************************************************/
 /************* SMIO thsafe wrapper functions   **************/
 /************************************************************/
@@ -296,3 +632,104 @@ ssize_t smio_thsafe_raw_client_write_dma (smio_t *self, loff_t offs, size_t size
 /* int smio_thsafe_raw_client_read_info (smio_t *self, llio_dev_info_t *dev_info)
     SMIO_FUNC_WRAPPER (thsafe_client_read_info, dev_info) Moved to dev_io */
 
+/* Check a default value from the configuration file against the
+ * description of the set/get (RW_PARAM) operation with the same name and
+ * convert it to the operation argument type */
+static smio_err_e _smio_parse_cfg_param (smio_t *self, const char *name,
+        const char *value, smio_cfg_param_t *param)
+{
+    smio_err_e err = SMIO_SUCCESS;
+    const disp_op_t *disp_op = NULL;
+
+    /* zconfig gives us NULL for a key without a value. An empty one would
+     * be taken as 0 by strtoull () if not for the endptr check below, but
+     * we'd rather say what is wrong */
+    ASSERT_TEST(value != NULL && value [0] != '\0', "Missing value",
+            err_no_value, SMIO_ERR_WRONG_PARAM);
+
+    unsigned int i;
+    for (i = 0; self->exp_ops [i] != NULL; ++i) {
+        if (streq (self->exp_ops [i]->name, name)) {
+            disp_op = self->exp_ops [i];
+            break;
+        }
+    }
+
+    ASSERT_TEST(disp_op != NULL, "Unknown operation name", err_unknown_op,
+            SMIO_ERR_OPCODE_NOT_SUPP);
+    /* Arguments are rw and the value itself */
+    ASSERT_TEST((disp_op->flags & DISP_OP_FLAG_RW_PARAM) &&
+            disp_op->args [1] != DISP_ARG_END && disp_op->args [2] == DISP_ARG_END,
+            "Operation is not a set/get parameter", err_not_rw_param,
+            SMIO_ERR_OPCODE_NOT_SUPP);
+
+    char *endptr = NULL;
+    errno = 0;
+    switch (DISP_GET_ATYPE(disp_op->args [1])) {
+        case DISP_ATYPE_UINT32:
+            {
+                unsigned long long value_32 = strtoull (value, &endptr, 0);
+                ASSERT_TEST(value_32 <= UINT32_MAX && value [0] != '-',
+                        "Value out of range", err_inv_value, SMIO_ERR_WRONG_PARAM);
+                /* SET_PARAM would drop the bits that do not fit in the
+                 * register field and write something else */
+                ASSERT_TEST((value_32 & ~_smio_lookup_param_mask (self,
+                        disp_op->opcode)) == 0, "Value does not fit in the "
+                        "register field", err_inv_value, SMIO_ERR_WRONG_PARAM);
+                *(uint32_t *) param->value = value_32;
+                param->size = sizeof (uint32_t);
+                break;
+            }
+
+        case DISP_ATYPE_DOUBLE:
+            {
+                double value_double = strtod (value, &endptr);
+                memcpy (param->value, &value_double, sizeof (double));
+                param->size = sizeof (double);
+                break;
+            }
+
+        default:
+            ASSERT_TEST(0, "Unsupported parameter type", err_inv_value,
+                    SMIO_ERR_OPCODE_NOT_SUPP);
+    }
+
+    ASSERT_TEST(errno == 0 && endptr != value && *endptr == '\0',
+            "Invalid value", err_inv_value, SMIO_ERR_WRONG_PARAM);
+    param->disp_op = disp_op;
+
+err_inv_value:
+err_not_rw_param:
+err_unknown_op:
+err_no_value:
+    if (err != SMIO_SUCCESS) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_ERR, "[sm_io] %s: invalid default value "
+                "%s = %s\n", self->service, name, (value != NULL) ? value : "");
+    }
+    return err;
+}
+
+static smio_cfg_param_t *_smio_lookup_cfg_param (smio_t *self, uint32_t opcode)
+{
+    size_t i;
+    for (i = 0; i < self->cfg_num_params; ++i) {
+        if (self->cfg_params [i].disp_op->opcode == opcode) {
+            return &self->cfg_params [i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Operations without a mask take any 32-bit value */
+static uint32_t _smio_lookup_param_mask (smio_t *self, uint32_t opcode)
+{
+    const smio_param_mask_t *param_mask = self->param_masks;
+    for (; param_mask != NULL && param_mask->mask != 0; ++param_mask) {
+        if (param_mask->opcode == opcode) {
+            return param_mask->mask;
+        }
+    }
+
+    return UINT32_MAX;
+}
@@ -20,6 +20,9 @@
 #include "sm_io_exports.h"
 #include "msg.h"
 #include "dispatch_table.h"
+#include "sm_io_stats.h"
+#include "sm_io_pool.h"
+#include "sm_io_coalesce.h"
 #include "mdp.h"
 
 /* SMIO sockets IDs */
@@ -31,6 +34,18 @@ struct _devio_t;
 struct _smio_ops_t;
 struct _smio_thsafe_client_ops_t;
 struct _disp_op_t;
+struct _smio_cfg_param_t;
+
+/* Bits a set/get (RW_PARAM) operation accepts, right-aligned. See
+ * RW_PARAM_MASK (). Tables of these end with SMIO_PARAM_MASK_END */
+struct _smio_param_mask_t {
+    uint32_t opcode;
+    uint32_t mask;
+};
+
+typedef struct _smio_param_mask_t smio_param_mask_t;
+
+#define SMIO_PARAM_MASK_END         {0, 0}
 
 /* Main class object that every sm_io must implement */
 struct _smio_t {
@@ -41,6 +56,8 @@ struct _smio_t {
     uint32_t base;                      /* Base SMIO address */
     char *name;                         /* Identification of this sm_io instance */
     char *service;                      /* Exported service name */
+    char *broker;                       /* Endpoint of the broker we are
+                                           connected to */
     /* int verbose; */                  /* Print activity to stdout */
     mdp_worker_t *worker;               /* zeroMQ Majordomo worker */
     struct _devio_t *parent;            /* Pointer back to parent dev_io */
@@ -62,6 +79,26 @@ struct _smio_t {
      * ones available in llio, changing the llio_t self pointer to a void
      * pointer (socket to parent thread) */
     const struct _smio_thsafe_client_ops_t *thsafe_client_ops;
+    /* Per-operation call, error and latency statistics */
+    struct _smio_stats_t *stats;
+    /* Pool of workers serving this SMIO. NULL if the SMIO thread serves
+     * the requests by itself */
+    struct _smio_pool_t *pool;
+    /* Results of read-only operations shared by identical requests. Shared
+     * by all of the workers of a pool */
+    struct _smio_coalesce_t *coalesce;
+    /* How our default values are applied and how many of them had to be
+     * written to the hardware */
+    smio_config_mode_e config_mode;
+    uint32_t config_changed;
+    /* Default values loaded from the configuration file, but not written
+     * yet. See smio_config_file_load () */
+    struct _smio_cfg_param_t *cfg_params;
+    size_t cfg_num_params;
+    /* Bits accepted by our set/get operations, checked before any default
+     * value from the configuration file is written. Operations not found
+     * here take any value of their type. Optional */
+    const smio_param_mask_t *param_masks;
 };
 
 /* Attach an instance of sm_io to dev_io function pointer */
@@ -75,6 +112,10 @@ typedef enum _smio_err_e (*export_ops_fp)(struct _smio_t *self,
 typedef enum _smio_err_e (*unexport_ops_fp)(struct _smio_t *self);
 /* Generic wrapper for receiving opcodes and arguments to specific funtions function pointer */
 typedef enum _smio_err_e (*do_op_fp)(void *owner, void *msg);
+/* Periodic work of the sm_io, done between the requests function pointer */
+typedef enum _smio_err_e (*tick_fp)(struct _smio_t *self);
+/* Whether the sm_io has periodic work to do function pointer */
+typedef bool (*tick_pending_fp)(struct _smio_t *self);
 
 struct _smio_ops_t {
     attach_fp attach;                   /* Attach sm_io instance to dev_io */
@@ -82,6 +123,13 @@ struct _smio_ops_t {
     export_ops_fp export_ops;           /* Export sm_io operations to dev_io */
     unexport_ops_fp unexport_ops;       /* Unexport sm_io operations to dev_io */
     do_op_fp do_op;                     /* Generic wrapper for handling specific operations */
+    tick_fp tick;                       /* Periodic work, e.g., pushing data
+                                           to subscribers. Optional */
+    tick_pending_fp tick_pending;       /* Whether tick has anything to do.
+                                           Called without the handler lock,
+                                           so a stale answer must only delay
+                                           the work. Optional: without it,
+                                           tick is always called */
 };
 
 /* Open device */
@@ -158,6 +206,51 @@ smio_err_e smio_export_ops (smio_t *self, const disp_op_t** smio_exp_ops);
 smio_err_e smio_unexport_ops (smio_t *self);
 /* Handle the operation */
 smio_err_e smio_do_op (void *owner, void *msg);
+/* Do the periodic work of the sm_io, if any. Called from the SMIO thread
+ * between the requests, at least every SMIO_POLLER_TIMEOUT msec. With a pool
+ * of workers, it is called from the SMIO thread as well, while none of the
+ * workers is in the handler */
+smio_err_e smio_tick (smio_t *self);
+/* Whether smio_tick () has anything to do. False if there is no tick
+ * function */
+bool smio_tick_pending (smio_t *self);
+/* Call one of our own exported operations in-process, without going
+ * through the broker. "args" holds the argument frames, exactly as a client
+ * would send them (without the opcode frame), and is destroyed. Up to
+ * ret_size bytes of the return value are copied to ret. Returns the same
+ * as the exported function (negative on error, size of the data otherwise).
+ * Must be called from the SMIO thread, before it starts serving requests */
+int smio_exec_op (smio_t *self, uint32_t opcode, zmsg_t **args, void *ret,
+        uint32_t ret_size);
+/* Set the value of a set/get (RW_PARAM) operation in-process, the same way
+ * the libclient param_client_write* () functions do */
+smio_err_e smio_set_param (smio_t *self, uint32_t opcode, const void *param,
+        size_t size);
+smio_err_e smio_set_param_32 (smio_t *self, uint32_t opcode, uint32_t param);
+smio_err_e smio_set_param_double (smio_t *self, uint32_t opcode, double param);
+/* Get the value of a set/get (RW_PARAM) operation in-process */
+smio_err_e smio_get_param (smio_t *self, uint32_t opcode, void *param,
+        size_t size);
+/* Apply a default value of a set/get (RW_PARAM) operation, according to
+ * the SMIO config_mode. In SMIO_CONFIG_MODE_DIFF, the current value is read
+ * first and the new one is only written if it differs. Every written value
+ * is reported and counted in config_changed. A value loaded from the
+ * configuration file for the same operation takes the place of "param" */
+smio_err_e smio_config_param (smio_t *self, uint32_t opcode, const void *param,
+        size_t size);
+smio_err_e smio_config_param_32 (smio_t *self, uint32_t opcode, uint32_t param);
+smio_err_e smio_config_param_double (smio_t *self, uint32_t opcode, double param);
+/* Load the default values found in the "cfg_path" section of the
+ * configuration file "cfg_file". Each entry is named after a set/get
+ * (RW_PARAM) operation and all of them are validated against the
+ * operation description and the param_masks before any of them is kept.
+ * Must be called before the built-in defaults are applied, so each
+ * operation is written only once */
+smio_err_e smio_config_file_load (smio_t *self, const char *cfg_file,
+        const char *cfg_path);
+/* Apply the loaded default values that no built-in default took the place
+ * of and forget all of them */
+smio_err_e smio_config_file_apply (smio_t *self);
 
 /************************************************************/
 /***************** Thsafe generic methods API ***************/
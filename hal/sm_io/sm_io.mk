@@ -8,6 +8,9 @@ sm_io_DIR = hal/sm_io
 sm_io_OBJS = $(sm_io_DIR)/sm_io.o \
 	     $(sm_io_DIR)/sm_io_bootstrap.o \
 	     $(sm_io_DIR)/sm_io_err.o \
+	     $(sm_io_DIR)/sm_io_stats.o \
+	     $(sm_io_DIR)/sm_io_pool.o \
+	     $(sm_io_DIR)/sm_io_coalesce.o \
 	     $(sm_io_modules_OBJS) \
 	     $(sm_io_rw_param_OBJS) \
 	     $(sm_io_protocols_OBJS) \
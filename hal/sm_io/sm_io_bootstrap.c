@@ -10,8 +10,10 @@
 #include "sm_io_bootstrap.h"
 #include "sm_io.h"
 #include "exp_ops_codes.h"
+#include "msg_pool.h"
 #include "hal_assert.h"
 #include "hal_utils.h"
+#include "hal_sched.h"
 
 /* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
 #ifdef ASSERT_TEST
@@ -45,6 +47,7 @@ static struct _smio_t *_smio_new (th_boot_args_t *args, struct _zctx_t *ctx,
         void *pipe, char *service);
 static smio_err_e _smio_destroy (struct _smio_t **self_p);
 static smio_err_e _smio_loop (smio_t *self);
+static void _smio_apply_sched (th_boot_args_t *th_args, const char *smio_service);
 
 /************************************************************/
 /****************** SMIO Thread entry-point  ****************/
@@ -69,6 +72,10 @@ void smio_startup (void *args, zctx_t *ctx, void *pipe)
 
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io_bootstrap] SMIO Thread %s "
             "starting ...\n", smio_service);
+    /* Place ourselves before allocating anything, so our memory is
+     * first touched from the CPUs we will run on */
+    _smio_apply_sched (th_args, smio_service);
+
     DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io_bootstrap] SMIO Thread %s "
             "allocating resources ...\n", smio_service);
 
@@ -87,12 +94,77 @@ void smio_startup (void *args, zctx_t *ctx, void *pipe)
     ASSERT_TEST (err == SMIO_SUCCESS, "Could not export specific SMIO operations",
             err_smio_export);
 
-    /* Main loop request-action */
-    err = _smio_loop (self);
-    ASSERT_TEST (err == SMIO_SUCCESS, "Could not loop the SMIO messages",
-            err_smio_loop);
+    /* The values from the configuration file, if any, override the
+     * built-in ones. Load them first, so each of them is written in place
+     * of the built-in value and no setting is written twice */
+    smio_err_e cfg_err = SMIO_SUCCESS;
+    if (th_args->cfg_file != NULL) {
+        cfg_err = smio_config_file_load (self, th_args->cfg_file,
+                th_args->cfg_path);
+    }
+
+    /* Configure our default values before serving any request, so clients
+     * never get to see an unconfigured SMIO. The config_defaults functions
+     * call the SMIO exported functions directly, through its dispatch
+     * table, so the default values go through the same checks as the ones
+     * sent by clients. Every SMIO does this in its own thread, so all of
+     * them are configured in parallel. Not being able to configure the
+     * defaults is not fatal, as clients can still do it */
+    err = SMIO_DISPATCH_FUNC_WRAPPER (config_defaults);
+    if (err != SMIO_SUCCESS && err != SMIO_ERR_FUNC_NOT_IMPL) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io_bootstrap] SMIO Thread %s "
+                "could not configure default values: %s\n", smio_service,
+                smio_err_str (err));
+    }
+
+    /* Then, the values from the configuration file with no built-in
+     * counterpart */
+    if (cfg_err == SMIO_SUCCESS) {
+        cfg_err = smio_config_file_apply (self);
+    }
+
+    if (cfg_err != SMIO_SUCCESS) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io_bootstrap] SMIO Thread %s "
+                "could not configure default values from %s: %s\n",
+                smio_service, th_args->cfg_file, smio_err_str (cfg_err));
+        err = cfg_err;
+    }
+
+    if (err == SMIO_SUCCESS || err == SMIO_ERR_FUNC_NOT_IMPL) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io_bootstrap] SMIO Thread %s "
+                "default values configured, %u setting(s) changed\n",
+                smio_service, self->config_changed);
+    }
+
+    /* The clients of a reloaded SMIO wait from when the old one was told
+     * to exit until now */
+    if (th_args->reload_ts != 0) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io_bootstrap] SMIO Thread %s "
+                "reloaded. Unavailable for %"PRIu64" us\n", smio_service,
+                smio_stats_get_ts () - th_args->reload_ts);
+    }
+
+    /* Spawn a pool of workers, if more than one was requested. In this
+     * case, they serve the requests while we talk to the DEVIO and tick */
+    if (th_args->nworkers > 1) {
+        self->pool = smio_pool_new (self, th_args->nworkers, th_args->broker,
+                th_args->verbose);
+        ASSERT_ALLOC(self->pool, err_pool_alloc);
+
+        err = smio_pool_loop (self->pool);
+        ASSERT_TEST (err == SMIO_SUCCESS, "Could not loop the SMIO pool messages",
+                err_smio_loop);
+    }
+    else {
+        /* Main loop request-action */
+        err = _smio_loop (self);
+        ASSERT_TEST (err == SMIO_SUCCESS, "Could not loop the SMIO messages",
+                err_smio_loop);
+    }
 
 err_smio_loop:
+    smio_pool_destroy (&self->pool);
+err_pool_alloc:
     /* Unexport SMIO specific operations */
     smio_unexport_ops (self);
 err_smio_export:
@@ -105,6 +177,7 @@ err_call_init:
     /* Destroy what we did in _smio_new */
     _smio_destroy (&self);
 err_self_alloc:
+    msg_pool_release ();
     /* We can't output this message at a later time as we depend on the smio_service
      * variable. This is not so bad, though, as most of the time we will not fail
      * in halutils_concat_strings () function */
@@ -115,42 +188,10 @@ err_smio_service_alloc:
     free (inst_id_str);
 err_inst_id_str_alloc:
     free (th_args);
-    return;
-}
-
-/************************************************************/
-/*************** SMIO Config Thread entry-point  ************/
-/************************************************************/
-void smio_config_defaults (void *args, zctx_t *ctx, void *pipe)
-{
-    (void) pipe;
-    (void) ctx;
-    th_config_args_t *th_args = (th_config_args_t *) args;
-
-    /* We must export our service as the combination of the
-     * devio name (coming from devio parent) and our own name ID
-     * followed by an optional parameter coming from priv pointer */
-    char *inst_id_str = halutils_stringify_dec_key (th_args->inst_id);
-    ASSERT_ALLOC(inst_id_str, err_inst_id_str_alloc);
-    char *smio_service = halutils_concat_strings3 (th_args->service,
-            smio_mod_dispatch[th_args->smio_id].name, inst_id_str, ':');
-    ASSERT_ALLOC(smio_service, err_smio_service_alloc);
-
-    DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io_bootstrap] Config Thread %s "
-            "starting ...\n", smio_service);
-    DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io_bootstrap] Config Thread %s "
-            "allocating resources ...\n", smio_service);
-
-    SMIO_DISPATCH_FUNC_WRAPPER_GEN(config_defaults, th_args->broker,
-            smio_service, th_args->log_file);
-
-    DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io_bootstrap] Config Thread %s "
-            "exiting\n", smio_service);
-    free (smio_service);
-err_smio_service_alloc:
-    free (inst_id_str);
-err_inst_id_str_alloc:
-    free (th_args);
+    /* Tell the DEVIO we are gone, with an empty message like the
+     * self-destruct one. It waits for this before spawning us again. If it
+     * already closed its end, there is nobody to tell */
+    zmq_send (pipe, NULL, 0, ZMQ_DONTWAIT);
     return;
 }
 
@@ -190,10 +231,22 @@ static struct _smio_t *_smio_new (th_boot_args_t *args, struct _zctx_t *ctx,
     self->service = strdup (service);
     ASSERT_ALLOC(self->service, err_service_alloc);
 
+    /* Modules publishing data bind next to it */
+    self->broker = strdup (args->broker);
+    ASSERT_ALLOC(self->broker, err_broker_alloc);
+
     /* Setup Dispatch table */
     self->exp_ops_dtable = disp_table_new ();
     ASSERT_ALLOC(self->exp_ops_dtable, err_exp_ops_dtable_alloc);
 
+    /* Setup operations statistics */
+    self->stats = smio_stats_new ();
+    ASSERT_ALLOC(self->stats, err_stats_alloc);
+
+    /* Setup read-only requests coalescing */
+    self->coalesce = smio_coalesce_new ();
+    ASSERT_ALLOC(self->coalesce, err_coalesce_alloc);
+
     self->smio_handler = NULL;      /* This is set by the device functions */
     self->ctx = ctx;
     self->pipe = pipe;
@@ -202,18 +255,33 @@ static struct _smio_t *_smio_new (th_boot_args_t *args, struct _zctx_t *ctx,
     /* Initialize SMIO base address */
     self->base = args->base;
 
-    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io_bootstrap] Creating worker\n");
-    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "\tbroker = %s, service = %s, verbose = %d\n",
-            args->broker, service, args->verbose);
-    self->worker = mdp_worker_new (self->ctx, args->broker, service, args->verbose);
-    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io_bootstrap] Worker created\n");
-    ASSERT_ALLOC(self->worker, err_worker_alloc);
+    /* How to apply our default values */
+    self->config_mode = args->config_mode;
+    self->config_changed = 0;
+
+    /* Workers of a pool register themselves in the broker. If we registered
+     * as well, the broker would send us requests nobody would handle */
+    self->pool = NULL;
+    if (args->nworkers <= 1) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io_bootstrap] Creating worker\n");
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "\tbroker = %s, service = %s, verbose = %d\n",
+                args->broker, service, args->verbose);
+        self->worker = mdp_worker_new (self->ctx, args->broker, service, args->verbose);
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io_bootstrap] Worker created\n");
+        ASSERT_ALLOC(self->worker, err_worker_alloc);
+    }
 
     return self;
 
 err_worker_alloc:
+    smio_coalesce_destroy (&self->coalesce);
+err_coalesce_alloc:
+    smio_stats_destroy (&self->stats);
+err_stats_alloc:
     disp_table_destroy (&self->exp_ops_dtable);
 err_exp_ops_dtable_alloc:
+    free (self->broker);
+err_broker_alloc:
     free (self->service);
 err_service_alloc:
     free (self);
@@ -229,10 +297,14 @@ static smio_err_e _smio_destroy (struct _smio_t **self_p)
         struct _smio_t *self = *self_p;
 
         mdp_worker_destroy (&self->worker);
+        smio_coalesce_destroy (&self->coalesce);
+        smio_stats_destroy (&self->stats);
         disp_table_destroy (&self->exp_ops_dtable);
         self->thsafe_client_ops = NULL;
         self->ops = NULL;
         self->parent = NULL;
+        free (self->cfg_params);
+        free (self->broker);
         free (self->service);
 
         free (self);
@@ -272,7 +344,8 @@ static smio_err_e _smio_loop (smio_t *self)
             exp_msg_zmq_t smio_args = {
                 .tag = EXP_MSG_ZMQ_TAG,
                 .msg = &request,
-                .reply_to = reply_to};
+                .reply_to = reply_to,
+                .recv_ts = smio_stats_get_ts ()};
             err = smio_do_op (self, &smio_args);
 
             /* What can I do in case of error ?*/
@@ -283,8 +356,18 @@ static smio_err_e _smio_loop (smio_t *self)
             }
 
             /* Cleanup */
-            zframe_destroy (&reply_to);
-            zmsg_destroy (&request);
+            msg_pool_frame_destroy (&reply_to);
+            msg_pool_msg_destroy (&request);
+        }
+
+        /* Periodic work of the SMIO, if there is any. Not being able to
+         * do it is not fatal */
+        err = smio_tick_pending (self) ? smio_tick (self) : SMIO_SUCCESS;
+        if (err != SMIO_SUCCESS) {
+            DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE,
+                    "[sm_io_bootstrap] smio_tick: %s\n",
+                    smio_err_str (err));
+            err = SMIO_SUCCESS;
         }
 
         /* Wait up to 100 ms */
@@ -318,3 +401,38 @@ err_loop_interrupted:
     return err;
 }
 
+
+/* Apply the scheduling options of this SMIO from the configuration file, if
+ * any, and report where we ended up running. Not being able to apply them
+ * is not fatal */
+static void _smio_apply_sched (th_boot_args_t *th_args, const char *smio_service)
+{
+    if (th_args->cfg_file != NULL) {
+        zconfig_t *root_cfg = zconfig_load (th_args->cfg_file);
+        if (root_cfg != NULL) {
+            halutils_sched_cfg_t sched_cfg = {0};
+            halutils_err_e err = halutils_sched_cfg_load (root_cfg,
+                    th_args->sched_path, &sched_cfg);
+            if (err == HALUTILS_SUCCESS) {
+                /* Applies to this thread only. Our pool workers inherit it */
+                err = halutils_sched_apply (0, &sched_cfg);
+            }
+
+            if (err != HALUTILS_SUCCESS) {
+                DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io_bootstrap] SMIO "
+                        "Thread %s could not apply the scheduling options from "
+                        "%s: %s\n", smio_service, th_args->sched_path,
+                        halutils_err_str (err));
+            }
+
+            zconfig_destroy (&root_cfg);
+        }
+    }
+
+    char placement [HALUTILS_SCHED_STR_LEN];
+    if (halutils_sched_placement_str (0, placement, sizeof (placement)) ==
+            HALUTILS_SUCCESS) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io_bootstrap] SMIO Thread %s "
+                "placement: %s\n", smio_service, placement);
+    }
+}
@@ -35,6 +35,24 @@
 #define SMIO_DISPATCH_FUNC_WRAPPER(func_name, ...)          \
     SMIO_DISPATCH_FUNC_WRAPPER_GEN(func_name, self, ## __VA_ARGS__)
 
+/* How the SMIO default values are applied */
+enum _smio_config_mode_e {
+    SMIO_CONFIG_MODE_ALL = 0,       /* Write every default value */
+    SMIO_CONFIG_MODE_DIFF           /* Read the hardware first and only write
+                                       the values that differ. Used when
+                                       restarting over a running machine */
+};
+
+typedef enum _smio_config_mode_e smio_config_mode_e;
+
+/* Number of MDP workers serving each SMIO service */
+#define SMIO_DFLT_NUM_WORKERS       1
+#define SMIO_MAX_NUM_WORKERS        16
+
+/* Maximum length of the configuration file section with the SMIO
+ * default values */
+#define SMIO_CFG_PATH_LEN           128
+
 /* Foward declarations. We don't need to include the associated header files.
  * The following should suffice */
 struct _smio_t;
@@ -46,9 +64,9 @@ typedef smio_err_e (*smio_init_fp)(struct _smio_t *self);
 /* Destroy instance of sm)io functuion pointer. This tells how to destroy
  * such an object */
 typedef smio_err_e (*smio_shutdown_fp)(struct _smio_t *self);
-/* Configure SMIO default values using the libclient */
-typedef smio_err_e (*smio_config_defaults_fp)(char *broker_endp, char *service,
-        const char *log_file_name);
+/* Configure SMIO default values. This is called from the SMIO thread, after
+ * the SMIO operations are exported, but before any request is served */
+typedef smio_err_e (*smio_config_defaults_fp)(struct _smio_t *self);
 
 /* Main class object that every sm_io must implement */
 struct _smio_bootstrap_ops_t {
@@ -68,26 +86,26 @@ struct _th_boot_args_t {
     int verbose;                    /* Print trace information to stdout*/
     uint32_t base;                  /* SMIO base address */
     uint32_t inst_id;               /* SMIO instance ID */
+    uint32_t nworkers;              /* Number of MDP workers serving this SMIO */
+    smio_config_mode_e config_mode; /* How the default values are applied */
+    char *cfg_file;                 /* Configuration file with default values
+                                       overriding the built-in ones. NULL if
+                                       none */
+    char cfg_path [SMIO_CFG_PATH_LEN]; /* Section of cfg_file with our
+                                       default values */
+    char sched_path [SMIO_CFG_PATH_LEN]; /* Section of cfg_file with our
+                                       scheduling options */
+    uint64_t reload_ts;             /* When the DEVIO started reloading us,
+                                       as given by smio_stats_get_ts (). 0 if
+                                       this is not a reload */
 };
 
 typedef struct _th_boot_args_t th_boot_args_t;
 
-/* Config thread args structure */
-struct _th_config_args_t {
-    uint32_t smio_id;               /* ID of the SMIO instance */
-    uint32_t inst_id;               /* SMIO instance ID */
-    char *broker;                   /* Endpoint to connect to broker */
-    char *service;                  /* Full name of the exported service */
-    char *log_file;                 /* Thread log file */
-};
-
-typedef struct _th_config_args_t th_config_args_t;
-
 /************************************************************/
 /************************ Our methods ***********************/
 /************************************************************/
 void smio_startup (void *args, zctx_t *ctx, void *pipe);
-void smio_config_defaults (void *args, zctx_t *ctx, void *pipe);
 struct _smio_t *smio_new (th_boot_args_t *args, struct _zctx_t *ctx,
         void *pipe, char *service);
 smio_err_e smio_destroy (struct _smio_t **self_p);
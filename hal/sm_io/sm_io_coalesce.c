@@ -0,0 +1,454 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include <string.h>
+
+#include "sm_io_coalesce.h"
+#include "sm_io.h"
+#include "hal_assert.h"
+
+/* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
+#ifdef ASSERT_TEST
+#undef ASSERT_TEST
+#endif
+#define ASSERT_TEST(test_boolean, err_str, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_TEST(test_boolean, SM_IO, "[sm_io:coalesce]",\
+            err_str, err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef ASSERT_ALLOC
+#undef ASSERT_ALLOC
+#endif
+#define ASSERT_ALLOC(ptr, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_ALLOC(ptr, SM_IO, "[sm_io:coalesce]",        \
+            smio_err_str(SMIO_ERR_ALLOC),                   \
+            err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef CHECK_ERR
+#undef CHECK_ERR
+#endif
+#define CHECK_ERR(err, err_type)                            \
+    CHECK_HAL_ERR(err, SM_IO, "[sm_io:coalesce]",           \
+            smio_err_str (err_type))
+
+#define SMIO_COALESCE_NS_PER_US             1000ULL
+
+static bool _smio_coalesce_get_key (const disp_op_t *disp_op, void *args,
+        uint8_t *key, uint32_t *key_size);
+static bool _smio_coalesce_add_key_frame (zframe_t *frame, uint8_t *key,
+        uint32_t *key_size);
+static smio_coalesce_entry_t *_smio_coalesce_lookup (smio_coalesce_t *self,
+        uint32_t opcode, const uint8_t *key, uint32_t key_size, uint64_t req_ts);
+static smio_coalesce_entry_t *_smio_coalesce_reserve (smio_coalesce_t *self,
+        uint32_t opcode, const uint8_t *key, uint32_t key_size);
+static void _smio_coalesce_finish (smio_coalesce_t *self, uint32_t opcode,
+        smio_coalesce_entry_t *entry, uint64_t gen, const void *ret,
+        int disp_table_ret);
+static bool _smio_coalesce_entry_is_live (smio_coalesce_t *self,
+        const smio_coalesce_entry_t *entry);
+
+/* Creates a new instance of the SMIO request coalescing */
+smio_coalesce_t *smio_coalesce_new (void)
+{
+    smio_coalesce_t *self = (smio_coalesce_t *) zmalloc (sizeof *self);
+    ASSERT_ALLOC(self, err_self_alloc);
+
+    int perr = pthread_mutex_init (&self->lock, NULL);
+    ASSERT_TEST(perr == 0, "Could not initialize coalescing lock",
+            err_lock_init);
+
+    perr = pthread_cond_init (&self->done, NULL);
+    ASSERT_TEST(perr == 0, "Could not initialize coalescing condition",
+            err_done_init);
+
+    return self;
+
+err_done_init:
+    pthread_mutex_destroy (&self->lock);
+err_lock_init:
+    free (self);
+err_self_alloc:
+    return NULL;
+}
+
+/* Destroys an instance of the SMIO request coalescing */
+smio_err_e smio_coalesce_destroy (smio_coalesce_t **self_p)
+{
+    assert (self_p);
+
+    if (*self_p) {
+        smio_coalesce_t *self = *self_p;
+
+        uint32_t i, j;
+        for (i = 0; i < MSG_OPCODE_MAX; ++i) {
+            for (j = 0; j < SMIO_COALESCE_ENTRIES; ++j) {
+                free (self->ops [i].entries [j].data);
+            }
+        }
+
+        pthread_cond_destroy (&self->done);
+        pthread_mutex_destroy (&self->lock);
+        free (self);
+        *self_p = NULL;
+    }
+
+    return SMIO_SUCCESS;
+}
+
+smio_err_e smio_coalesce_set_window (smio_coalesce_t *self, uint32_t opcode,
+        uint32_t window_us)
+{
+    assert (self);
+    smio_err_e err = SMIO_SUCCESS;
+
+    ASSERT_TEST(opcode < MSG_OPCODE_MAX, "Opcode out of range",
+            err_opcode_oor, SMIO_ERR_WRONG_PARAM);
+    ASSERT_TEST(window_us <= SMIO_COALESCE_MAX_WINDOW_US,
+            "Freshness window out of range", err_window_oor,
+            SMIO_ERR_WRONG_PARAM);
+
+    pthread_mutex_lock (&self->lock);
+    self->ops [opcode].window_ns = (uint64_t) window_us*SMIO_COALESCE_NS_PER_US;
+    pthread_mutex_unlock (&self->lock);
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io:coalesce] Freshness window "
+            "of opcode %u set to %u us\n", opcode, window_us);
+
+err_window_oor:
+err_opcode_oor:
+    return err;
+}
+
+bool smio_coalesce_is_read (const disp_op_t *disp_op, void *args)
+{
+    assert (disp_op);
+    assert (args);
+
+    if (disp_op->flags & DISP_OP_FLAG_READ_ONLY) {
+        return true;
+    }
+
+    if (!(disp_op->flags & DISP_OP_FLAG_RW_PARAM)) {
+        return false;
+    }
+
+    /* Set/get functions read if their first argument (rw) is not zero */
+    zframe_t *frame = EXP_MSG_ZMQ_PEEK_FIRST(args);
+    bool is_read = frame != NULL &&
+        EXP_MSG_ZMQ_ARG_SIZE(frame) == sizeof (uint32_t) &&
+        *(uint32_t *) EXP_MSG_ZMQ_ARG_DATA(frame) != 0;
+    EXP_MSG_ZMQ_PEEK_RESTART(args);
+
+    return is_read;
+}
+
+int smio_coalesce_check_call (smio_coalesce_t *self, disp_table_t *disp_table,
+        uint32_t opcode, void *owner, void *args, uint64_t req_ts, void **ret,
+        bool *coalesced)
+{
+    assert (disp_table);
+    assert (ret);
+    assert (coalesced);
+
+    *coalesced = false;
+    if (self == NULL) {
+        return disp_table_check_call (disp_table, opcode, owner, args, ret);
+    }
+
+    uint8_t key [SMIO_COALESCE_KEY_MAX_SIZE];
+    uint32_t key_size = 0;
+    const disp_op_t *disp_op = (opcode < MSG_OPCODE_MAX) ?
+        disp_table_lookup (disp_table, opcode) : NULL;
+
+    if (disp_op == NULL || !_smio_coalesce_get_key (disp_op, args, key,
+                &key_size)) {
+        int disp_table_ret = disp_table_check_call (disp_table, opcode, owner,
+                args, ret);
+        /* Anything but a read might have changed what the reads return */
+        pthread_mutex_lock (&self->lock);
+        self->gen++;
+        pthread_mutex_unlock (&self->lock);
+        return disp_table_ret;
+    }
+
+    pthread_mutex_lock (&self->lock);
+    smio_coalesce_entry_t *entry = _smio_coalesce_lookup (self, opcode, key,
+            key_size, req_ts);
+
+    /* An identical call is in flight. Wait for it and look again, as it
+     * might have failed. A call of our own thread can't be waited for */
+    while (entry != NULL && entry->pending &&
+            !pthread_equal (entry->caller, pthread_self ())) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:coalesce] "
+                "Request to opcode %u waiting for an identical call\n", opcode);
+        pthread_cond_wait (&self->done, &self->lock);
+        entry = _smio_coalesce_lookup (self, opcode, key, key_size, req_ts);
+    }
+
+    if (entry != NULL && !entry->pending &&
+            disp_table_check_args (disp_table, opcode, args, ret) ==
+            HALUTILS_SUCCESS) {
+        if (entry->disp_table_ret > 0) {
+            memcpy (*ret, entry->data, entry->disp_table_ret);
+        }
+        int disp_table_ret = entry->disp_table_ret;
+        pthread_mutex_unlock (&self->lock);
+
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:coalesce] "
+                "Request to opcode %u answered with a previous result\n", opcode);
+        *coalesced = true;
+        return disp_table_ret;
+    }
+    /* Results obtained before a call that is not read-only finishes are
+     * not kept */
+    uint64_t gen = self->gen;
+    /* Identical requests arriving from now on wait for our result. If no
+     * entry is free, they just make their own calls. So do the ones made
+     * from within a pending call of ours, as it already holds the entry */
+    entry = (entry != NULL && entry->pending) ? NULL :
+        _smio_coalesce_reserve (self, opcode, key, key_size);
+    pthread_mutex_unlock (&self->lock);
+
+    /* The arguments might have been rejected above, so the return value
+     * was not handed out. Releasing a NULL one is fine */
+    disp_table_release_ret (disp_table, ret);
+
+    int disp_table_ret = disp_table_check_call (disp_table, opcode, owner,
+            args, ret);
+
+    if (entry != NULL) {
+        pthread_mutex_lock (&self->lock);
+        _smio_coalesce_finish (self, opcode, entry, gen, *ret, disp_table_ret);
+        pthread_cond_broadcast (&self->done);
+        pthread_mutex_unlock (&self->lock);
+    }
+
+    return disp_table_ret;
+}
+
+/************************************************************/
+/*************** Generic exported operations ****************/
+/************************************************************/
+
+static int _smio_coalesce_set_op_window (void *owner, void *args, void *ret)
+{
+    (void) ret;
+    assert (owner);
+    assert (args);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:coalesce] "
+            "Calling _smio_coalesce_set_op_window\n");
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    /* Message is:
+     * frame 0: operation code
+     * frame 1: opcode of the operation to be configured
+     * frame 2: freshness window, in us */
+    uint32_t opcode = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+    uint32_t window_us = *(uint32_t *) EXP_MSG_ZMQ_NEXT_ARG(args);
+
+    const disp_op_t *disp_op = (opcode < MSG_OPCODE_MAX) ?
+        disp_table_lookup (self->exp_ops_dtable, opcode) : NULL;
+    if (disp_op == NULL || !(disp_op->flags & (DISP_OP_FLAG_READ_ONLY |
+                    DISP_OP_FLAG_RW_PARAM))) {
+        return -SMIO_COALESCE_NOT_READ_ONLY;
+    }
+
+    smio_err_e err = smio_coalesce_set_window (self->coalesce, opcode, window_us);
+    if (err != SMIO_SUCCESS) {
+        return -SMIO_COALESCE_ERR;
+    }
+
+    return -SMIO_COALESCE_OK;
+}
+
+const disp_table_func_fp smio_coalesce_exp_fp [] = {
+    _smio_coalesce_set_op_window,
+    NULL
+};
+
+/**************** Static Functions ***************/
+
+/* Build the key identifying the request arguments. Returns false if the
+ * request is not read-only or its arguments are too large to be kept */
+static bool _smio_coalesce_get_key (const disp_op_t *disp_op, void *args,
+        uint8_t *key, uint32_t *key_size)
+{
+    bool coalescable = false;
+    *key_size = 0;
+
+    zframe_t *frame = EXP_MSG_ZMQ_PEEK_FIRST(args);
+
+    if (disp_op->flags & DISP_OP_FLAG_READ_ONLY) {
+        coalescable = true;
+        for ( ; frame != NULL && coalescable;
+                frame = EXP_MSG_ZMQ_PEEK_NEXT_ARG(args)) {
+            coalescable = _smio_coalesce_add_key_frame (frame, key, key_size);
+        }
+    }
+    else if (disp_op->flags & DISP_OP_FLAG_RW_PARAM) {
+        /* Only reads (rw != 0) are coalesced. The value frame of a read is
+         * a dummy one, so it is left out of the key */
+        coalescable = frame != NULL &&
+            EXP_MSG_ZMQ_ARG_SIZE(frame) == sizeof (uint32_t) &&
+            *(uint32_t *) EXP_MSG_ZMQ_ARG_DATA(frame) != 0 &&
+            _smio_coalesce_add_key_frame (frame, key, key_size);
+    }
+
+    EXP_MSG_ZMQ_PEEK_RESTART(args);
+    return coalescable;
+}
+
+/* Append the frame size and contents to the key */
+static bool _smio_coalesce_add_key_frame (zframe_t *frame, uint8_t *key,
+        uint32_t *key_size)
+{
+    uint32_t frame_size = EXP_MSG_ZMQ_ARG_SIZE(frame);
+
+    if (*key_size + sizeof (frame_size) + frame_size > SMIO_COALESCE_KEY_MAX_SIZE) {
+        return false;
+    }
+
+    memcpy (key + *key_size, &frame_size, sizeof (frame_size));
+    *key_size += sizeof (frame_size);
+    memcpy (key + *key_size, EXP_MSG_ZMQ_ARG_DATA(frame), frame_size);
+    *key_size += frame_size;
+
+    return true;
+}
+
+/* Find a result that can answer a request received at req_ts. It must have
+ * been obtained after the request arrived (i.e., the call was in flight or
+ * started afterwards) or within the freshness window of the operation. A
+ * pending entry is returned as well, so the request can wait for it */
+static smio_coalesce_entry_t *_smio_coalesce_lookup (smio_coalesce_t *self,
+        uint32_t opcode, const uint8_t *key, uint32_t key_size, uint64_t req_ts)
+{
+    smio_coalesce_op_t *op = &self->ops [opcode];
+    uint64_t now = smio_stats_get_ts ();
+
+    uint32_t i;
+    for (i = 0; i < SMIO_COALESCE_ENTRIES; ++i) {
+        smio_coalesce_entry_t *entry = &op->entries [i];
+
+        if (entry->pending && entry->key_size == key_size &&
+                memcmp (entry->key, key, key_size) == 0) {
+            return entry;
+        }
+
+        if (!_smio_coalesce_entry_is_live (self, entry) ||
+                entry->key_size != key_size ||
+                memcmp (entry->key, key, key_size) != 0) {
+            continue;
+        }
+
+        if (entry->done_ts >= req_ts || now - entry->done_ts <= op->window_ns) {
+            return entry;
+        }
+
+        /* There is only one entry per key */
+        break;
+    }
+
+    return NULL;
+}
+
+/* Take the entry for a call about to be made: the one with the same key
+ * or, if there is none, an unused entry or the oldest one. Entries of other
+ * calls in flight are never taken. Returns NULL if there is no such entry */
+static smio_coalesce_entry_t *_smio_coalesce_reserve (smio_coalesce_t *self,
+        uint32_t opcode, const uint8_t *key, uint32_t key_size)
+{
+    smio_coalesce_op_t *op = &self->ops [opcode];
+    smio_coalesce_entry_t *entry = NULL;
+    smio_coalesce_entry_t *victim = NULL;
+
+    uint32_t i;
+    for (i = 0; i < SMIO_COALESCE_ENTRIES; ++i) {
+        smio_coalesce_entry_t *it = &op->entries [i];
+
+        if (it->pending) {
+            continue;
+        }
+
+        if (!_smio_coalesce_entry_is_live (self, it)) {
+            if (victim == NULL || _smio_coalesce_entry_is_live (self, victim)) {
+                victim = it;
+            }
+            continue;
+        }
+
+        if (it->key_size == key_size && memcmp (it->key, key, key_size) == 0) {
+            entry = it;
+            break;
+        }
+
+        if (victim == NULL || (_smio_coalesce_entry_is_live (self, victim) &&
+                    it->done_ts < victim->done_ts)) {
+            victim = it;
+        }
+    }
+
+    if (entry == NULL) {
+        entry = victim;
+    }
+
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    memcpy (entry->key, key, key_size);
+    entry->key_size = key_size;
+    entry->valid = false;
+    entry->pending = true;
+    entry->caller = pthread_self ();
+
+    return entry;
+}
+
+/* Store the result of the call of a reserved entry. Errors are not shared,
+ * as they might be transient, and neither are results obtained while a call
+ * that is not read-only was made */
+static void _smio_coalesce_finish (smio_coalesce_t *self, uint32_t opcode,
+        smio_coalesce_entry_t *entry, uint64_t gen, const void *ret,
+        int disp_table_ret)
+{
+    entry->pending = false;
+
+    /* The return value is owned by the function. We can't copy it */
+    if (disp_table_ret < 0 || gen != self->gen ||
+            (disp_table_ret > 0 && ret == NULL)) {
+        return;
+    }
+
+    if (disp_table_ret > 0 && entry->data_size < (uint32_t) disp_table_ret) {
+        void *data = realloc (entry->data, disp_table_ret);
+        if (data == NULL) {
+            DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:coalesce] "
+                    "Could not allocate space for the result of opcode %u\n",
+                    opcode);
+            return;
+        }
+
+        entry->data = data;
+        entry->data_size = disp_table_ret;
+    }
+
+    if (disp_table_ret > 0) {
+        memcpy (entry->data, ret, disp_table_ret);
+    }
+
+    entry->disp_table_ret = disp_table_ret;
+    entry->gen = self->gen;
+    entry->done_ts = smio_stats_get_ts ();
+    entry->valid = true;
+}
+
+/* Entries obtained before the last call that was not read-only are stale */
+static bool _smio_coalesce_entry_is_live (smio_coalesce_t *self,
+        const smio_coalesce_entry_t *entry)
+{
+    return entry->valid && entry->gen == self->gen;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+/* Request coalescing for read-only SMIO operations. Identical read-only
+ * requests (same opcode and arguments) that arrive while one of them is
+ * being served share the result of that single hardware access. Optionally,
+ * a per-operation freshness window allows a result to be reused by requests
+ * arriving up to that long after it was obtained.
+ *
+ * The results are shared by all of the workers of a SMIO, which might call
+ * in concurrently, so they are guarded by a lock of their own. The first of
+ * a set of identical requests marks its entry as pending before the call,
+ * and the ones arriving meanwhile wait for it to finish and take its result,
+ * instead of making the same call themselves */
+
+#ifndef _SM_IO_COALESCE_H_
+#define _SM_IO_COALESCE_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "sm_io_err.h"
+#include "sm_io_coalesce_codes.h"
+#include "dispatch_table.h"
+#include "msg.h"
+
+/* Largest set of arguments of a coalesced request, in bytes */
+#define SMIO_COALESCE_KEY_MAX_SIZE          64
+/* Number of distinct argument sets kept per operation */
+#define SMIO_COALESCE_ENTRIES               4
+/* Largest freshness window, in us */
+#define SMIO_COALESCE_MAX_WINDOW_US         10000000
+
+struct _smio_coalesce_entry_t {
+    bool valid;                         /* Entry holds a result */
+    bool pending;                       /* A call with these arguments is in
+                                           flight. Its result goes here */
+    pthread_t caller;                   /* Thread making the pending call */
+    uint64_t gen;                       /* Generation the result belongs to */
+    uint64_t done_ts;                   /* When the call finished */
+    uint32_t key_size;                  /* Size of the arguments */
+    uint8_t key [SMIO_COALESCE_KEY_MAX_SIZE]; /* Arguments of the call */
+    int disp_table_ret;                 /* Return code of the call */
+    void *data;                         /* Copy of the returned data */
+    uint32_t data_size;                 /* Size of the data buffer */
+};
+
+typedef struct _smio_coalesce_entry_t smio_coalesce_entry_t;
+
+struct _smio_coalesce_op_t {
+    uint64_t window_ns;                 /* Freshness window */
+    smio_coalesce_entry_t entries [SMIO_COALESCE_ENTRIES];
+};
+
+typedef struct _smio_coalesce_op_t smio_coalesce_op_t;
+
+struct _smio_coalesce_t {
+    smio_coalesce_op_t ops [MSG_OPCODE_MAX];
+    uint64_t gen;                       /* Incremented by every call that is
+                                           not read-only, so the results
+                                           obtained before it are dropped */
+    pthread_mutex_t lock;               /* Guards all of the above. Not held
+                                           during the calls */
+    pthread_cond_t done;                /* Signaled whenever a pending call
+                                           is over */
+};
+
+/* Opaque class structure */
+typedef struct _smio_coalesce_t smio_coalesce_t;
+
+/***************** Our methods *****************/
+
+/* Creates a new instance of the SMIO request coalescing */
+smio_coalesce_t *smio_coalesce_new (void);
+/* Destroys an instance of the SMIO request coalescing */
+smio_err_e smio_coalesce_destroy (smio_coalesce_t **self_p);
+
+/* Set the freshness window of an operation, in us. A zero window (the
+ * default) only shares a result among the requests that arrived while it
+ * was being obtained */
+smio_err_e smio_coalesce_set_window (smio_coalesce_t *self, uint32_t opcode,
+        uint32_t window_us);
+
+/* Whether a request with these arguments is a read-only call of disp_op */
+bool smio_coalesce_is_read (const disp_op_t *disp_op, void *args);
+
+/* Same as disp_table_check_call (), but answers the request with a previous
+ * identical result, if there is a fresh enough one, or with the result of an
+ * identical call in flight, once it is over. req_ts is the time the request
+ * was received. "coalesced" is set if no call was made. A NULL self does a
+ * plain disp_table_check_call () */
+int smio_coalesce_check_call (smio_coalesce_t *self, disp_table_t *disp_table,
+        uint32_t opcode, void *owner, void *args, uint64_t req_ts, void **ret,
+        bool *coalesced);
+
+/* Generic request coalescing exported functions, registered on every SMIO */
+extern const disp_table_func_fp smio_coalesce_exp_fp [];
+
+#endif
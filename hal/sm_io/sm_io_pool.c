@@ -0,0 +1,593 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+/* For pthread_rwlockattr_setkind_np () */
+#define _GNU_SOURCE
+#include <string.h>
+
+#include "sm_io_pool.h"
+#include "sm_io.h"
+#include "sm_io_stats_exports.h"
+#include "sm_io_coalesce_exports.h"
+#include "exp_ops_codes.h"
+#include "msg_pool.h"
+#include "hal_assert.h"
+
+/* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
+#ifdef ASSERT_TEST
+#undef ASSERT_TEST
+#endif
+#define ASSERT_TEST(test_boolean, err_str, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_TEST(test_boolean, SM_IO, "[sm_io:pool]",    \
+            err_str, err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef ASSERT_ALLOC
+#undef ASSERT_ALLOC
+#endif
+#define ASSERT_ALLOC(ptr, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_ALLOC(ptr, SM_IO, "[sm_io:pool]",            \
+            smio_err_str(SMIO_ERR_ALLOC),                   \
+            err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef CHECK_ERR
+#undef CHECK_ERR
+#endif
+#define CHECK_ERR(err, err_type)                            \
+    CHECK_HAL_ERR(err, SM_IO, "[sm_io:pool]",               \
+            smio_err_str (err_type))
+
+#define SMIO_POOL_POLLER_TIMEOUT        100        /* in msec */
+/* Poller timeout while waiting for the workers to leave the handler, so
+ * the SMIO can tick */
+#define SMIO_POOL_TICK_WAIT_TIMEOUT     1          /* in msec */
+#define SMIO_POOL_TICK_WAIT_US          100
+#define SMIO_POOL_NS_PER_MS             1000000ULL
+/* PIPE socket to the DEVIO plus one for each worker */
+#define SMIO_POOL_SOCKS_NUM             (SMIO_MAX_NUM_WORKERS+1)
+
+/* Worker thread args structure */
+struct _smio_pool_worker_args_t {
+    smio_pool_t *pool;              /* Pool this worker belongs to */
+    uint32_t id;                    /* Worker index into the pool */
+};
+
+typedef struct _smio_pool_worker_args_t smio_pool_worker_args_t;
+
+static void _smio_pool_worker_startup (void *args, zctx_t *ctx, void *pipe);
+static smio_t *_smio_pool_worker_new (smio_pool_t *pool, zctx_t *ctx, void *pipe);
+static smio_err_e _smio_pool_worker_destroy (smio_t **self_p);
+static smio_err_e _smio_pool_worker_loop (smio_t *self);
+static bool _smio_pool_is_exit_msg (zmsg_t *msg);
+static void _smio_pool_send_exit_msg (void *pipe);
+static void _smio_pool_start_shutdown (smio_pool_t *self);
+static bool _smio_pool_is_shutdown (smio_pool_t *self);
+static void _smio_pool_tick (smio_pool_t *self, uint64_t *tick_ts);
+
+/* Creates a new pool and spawns the worker threads */
+smio_pool_t *smio_pool_new (struct _smio_t *parent, uint32_t nworkers,
+        char *broker, int verbose)
+{
+    assert (parent);
+    assert (broker);
+
+    ASSERT_TEST(nworkers > 0 && nworkers <= SMIO_MAX_NUM_WORKERS,
+            "Invalid number of workers", err_inv_nworkers);
+
+    smio_pool_t *self = (smio_pool_t *) zmalloc (sizeof *self);
+    ASSERT_ALLOC(self, err_self_alloc);
+
+    self->broker = strdup (broker);
+    ASSERT_ALLOC(self->broker, err_broker_alloc);
+
+    int perr = pthread_mutex_init (&self->lock, NULL);
+    ASSERT_TEST(perr == 0, "Could not initialize pool lock", err_lock_init);
+
+    /* A steady stream of reads must not keep writes out of the handler */
+    pthread_rwlockattr_t handler_lock_attr;
+    pthread_rwlockattr_init (&handler_lock_attr);
+    pthread_rwlockattr_setkind_np (&handler_lock_attr,
+            PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    perr = pthread_rwlock_init (&self->handler_lock, &handler_lock_attr);
+    pthread_rwlockattr_destroy (&handler_lock_attr);
+    ASSERT_TEST(perr == 0, "Could not initialize pool handler lock",
+            err_handler_lock_init);
+
+    self->parent = parent;
+    self->verbose = verbose;
+
+    /* Spawn all of the workers. They share our parent state, so we must be
+     * fully initialized by now */
+    for ( ; self->nworkers < nworkers; ++self->nworkers) {
+        smio_pool_worker_args_t *worker_args = zmalloc (sizeof *worker_args);
+        ASSERT_ALLOC(worker_args, err_worker_args_alloc);
+        worker_args->pool = self;
+        worker_args->id = self->nworkers;
+
+        self->pipes [self->nworkers] = zthread_fork (parent->ctx,
+                _smio_pool_worker_startup, worker_args);
+        if (self->pipes [self->nworkers] == NULL) {
+            free (worker_args);
+        }
+        ASSERT_TEST(self->pipes [self->nworkers] != NULL,
+                "Could not spawn SMIO worker thread", err_spawn_worker);
+    }
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io:pool] Spawned %u workers "
+            "for service %s\n", self->nworkers, parent->service);
+
+    return self;
+
+err_spawn_worker:
+err_worker_args_alloc:
+    /* Let the already spawned workers go away */
+    if (self->nworkers > 0) {
+        _smio_pool_start_shutdown (self);
+        smio_pool_loop (self);
+    }
+    pthread_rwlock_destroy (&self->handler_lock);
+err_handler_lock_init:
+    pthread_mutex_destroy (&self->lock);
+err_lock_init:
+    free (self->broker);
+err_broker_alloc:
+    free (self);
+err_self_alloc:
+err_inv_nworkers:
+    return NULL;
+}
+
+/* Destroys the pool */
+smio_err_e smio_pool_destroy (smio_pool_t **self_p)
+{
+    assert (self_p);
+
+    if (*self_p) {
+        smio_pool_t *self = *self_p;
+
+        pthread_rwlock_destroy (&self->handler_lock);
+        pthread_mutex_destroy (&self->lock);
+        self->parent = NULL;
+        free (self->broker);
+
+        free (self);
+        *self_p = NULL;
+    }
+
+    return SMIO_SUCCESS;
+}
+
+smio_err_e smio_pool_loop (smio_pool_t *self)
+{
+    assert (self);
+    smio_t *parent = self->parent;
+    smio_err_e err = SMIO_SUCCESS;
+    uint32_t nalive = self->nworkers;
+    uint64_t tick_ts = smio_stats_get_ts ();
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE,
+            "[sm_io:pool] Pool loop starting\n");
+
+    /* Listen to PIPE (DEVIO) and to each worker PIPE */
+    zmq_pollitem_t items [SMIO_POOL_SOCKS_NUM];
+    memset (items, 0, sizeof (items));
+    items [0].socket = parent->pipe;
+    items [0].events = ZMQ_POLLIN;
+
+    uint32_t i;
+    for (i = 0; i < self->nworkers; ++i) {
+        items [i+1].socket = self->pipes [i];
+        items [i+1].events = ZMQ_POLLIN;
+    }
+
+    while (nalive > 0) {
+        int timeout = __atomic_load_n (&self->tick_waiting, __ATOMIC_SEQ_CST) ?
+            SMIO_POOL_TICK_WAIT_TIMEOUT : SMIO_POOL_POLLER_TIMEOUT;
+        int rc = zmq_poll (items, self->nworkers+1, timeout);
+        if (rc == -1 || zctx_interrupted) {
+            if (!_smio_pool_is_shutdown (self)) {
+                DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:pool] "
+                        "Poller has been interrupted\n");
+                err = SMIO_ERR_INTERRUPTED_POLLER;
+                _smio_pool_start_shutdown (self);
+            }
+
+            if (rc == -1) {
+                continue;
+            }
+        }
+
+        /* Check for activity on the DEVIO PIPE socket. We stop listening to
+         * it after being asked to exit */
+        if (!_smio_pool_is_shutdown (self) && (items [0].revents & ZMQ_POLLIN)) {
+            zmsg_t *msg = zmsg_recv (parent->pipe);
+
+            /* Every message that is not a reply is interpreted as a
+             * self-destruct one */
+            if (msg == NULL || _smio_pool_is_exit_msg (msg)) {
+                DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN,
+                        "[sm_io:pool] Received shutdown message on "
+                        "PIPE socket. Exiting ...\n");
+                zmsg_destroy (&msg);
+                _smio_pool_start_shutdown (self);
+            }
+            else if (self->pending_count == 0) {
+                DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN,
+                        "[sm_io:pool] Unexpected thsafe reply. Discarding it\n");
+                zmsg_destroy (&msg);
+            }
+            else {
+                /* Replies arrive in the same order the requests were sent */
+                uint32_t worker_id = self->pending [self->pending_head];
+                self->pending_head = (self->pending_head+1) % SMIO_MAX_NUM_WORKERS;
+                self->pending_count--;
+
+                zmsg_send (&msg, self->pipes [worker_id]);
+            }
+        }
+
+        /* Check for activity on the worker PIPE sockets */
+        for (i = 0; i < self->nworkers; ++i) {
+            if (!(items [i+1].revents & ZMQ_POLLIN)) {
+                continue;
+            }
+
+            zmsg_t *msg = zmsg_recv (self->pipes [i]);
+            if (msg == NULL) {
+                continue;                       /* Interrupted */
+            }
+
+            /* Worker is gone. Stop listening to it */
+            if (_smio_pool_is_exit_msg (msg)) {
+                zmsg_destroy (&msg);
+                items [i+1].events = 0;
+                nalive--;
+                continue;
+            }
+
+            /* Thsafe request. Fail it right away if we are exiting, as
+             * the DEVIO is not listening to us anymore */
+            if (_smio_pool_is_shutdown (self)) {
+                zmsg_destroy (&msg);
+                _smio_pool_send_exit_msg (self->pipes [i]);
+                continue;
+            }
+
+            uint32_t tail = (self->pending_head + self->pending_count) %
+                SMIO_MAX_NUM_WORKERS;
+            self->pending [tail] = i;
+            self->pending_count++;
+
+            zmsg_send (&msg, parent->pipe);
+        }
+
+        if (!_smio_pool_is_shutdown (self)) {
+            _smio_pool_tick (self, &tick_ts);
+        }
+    }
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO,
+            "[sm_io:pool] All workers are gone. Exiting pool loop\n");
+    return err;
+}
+
+void smio_pool_handler_lock (smio_pool_t *self, bool shared)
+{
+    /* Let the SMIO thread tick first. It is waiting for the calls already in
+     * the handler to be over */
+    while (__atomic_load_n (&self->tick_waiting, __ATOMIC_SEQ_CST) &&
+            !_smio_pool_is_shutdown (self)) {
+        usleep (SMIO_POOL_TICK_WAIT_US);
+    }
+
+    if (shared) {
+        pthread_rwlock_rdlock (&self->handler_lock);
+    }
+    else {
+        pthread_rwlock_wrlock (&self->handler_lock);
+    }
+}
+
+void smio_pool_handler_unlock (smio_pool_t *self)
+{
+    pthread_rwlock_unlock (&self->handler_lock);
+}
+
+void smio_pool_lock (smio_pool_t *self)
+{
+    pthread_mutex_lock (&self->lock);
+}
+
+void smio_pool_unlock (smio_pool_t *self)
+{
+    pthread_mutex_unlock (&self->lock);
+}
+
+smio_err_e smio_pool_get_op_stats (smio_pool_t *self, uint32_t opcode,
+        smio_op_stats_t *op_stats)
+{
+    assert (self);
+    assert (op_stats);
+
+    smio_err_e err = SMIO_ERR_WRONG_PARAM;
+    bool found = false;
+    smio_op_stats_t worker_op_stats;
+
+    smio_pool_lock (self);
+    uint32_t i;
+    for (i = 0; i < self->nworkers; ++i) {
+        smio_t *worker = self->workers [i];
+        if (worker == NULL) {
+            continue;
+        }
+
+        /* Every worker registers the same operations, so the first one
+         * decides which opcode we report */
+        if (!found) {
+            err = smio_stats_get_op (worker->stats, opcode, op_stats);
+            if (err != SMIO_SUCCESS) {
+                break;
+            }
+
+            opcode = op_stats->opcode;
+            found = true;
+            continue;
+        }
+
+        if (smio_stats_get_op (worker->stats, opcode, &worker_op_stats) ==
+                SMIO_SUCCESS && worker_op_stats.opcode == opcode) {
+            smio_stats_merge_op (op_stats, &worker_op_stats);
+        }
+    }
+    smio_pool_unlock (self);
+
+    return err;
+}
+
+/**************** Static Functions ***************/
+
+/* Worker thread entry-point */
+static void _smio_pool_worker_startup (void *args, zctx_t *ctx, void *pipe)
+{
+    smio_pool_worker_args_t *worker_args = (smio_pool_worker_args_t *) args;
+    smio_pool_t *pool = worker_args->pool;
+    uint32_t id = worker_args->id;
+    free (worker_args);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_INFO, "[sm_io:pool] Worker %u of %s "
+            "starting ...\n", id, pool->parent->service);
+
+    smio_t *self = _smio_pool_worker_new (pool, ctx, pipe);
+    ASSERT_ALLOC(self, err_self_alloc);
+
+    smio_pool_lock (pool);
+    pool->workers [id] = self;
+    smio_pool_unlock (pool);
+
+    _smio_pool_worker_loop (self);
+
+    smio_pool_lock (pool);
+    pool->workers [id] = NULL;
+    smio_pool_unlock (pool);
+
+    _smio_pool_worker_destroy (&self);
+err_self_alloc:
+    msg_pool_release ();
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_WARN, "[sm_io:pool] Worker %u exiting ...\n",
+            id);
+    /* Tell the pool we are gone */
+    _smio_pool_send_exit_msg (pipe);
+    return;
+}
+
+/* Create a worker SMIO instance. Everything but the Majordomo worker, the
+ * PIPE socket, the dispatch table and the statistics is shared with
+ * the parent SMIO */
+static smio_t *_smio_pool_worker_new (smio_pool_t *pool, zctx_t *ctx, void *pipe)
+{
+    smio_t *parent = pool->parent;
+    smio_t *self = (smio_t *) zmalloc (sizeof *self);
+    ASSERT_ALLOC(self, err_self_alloc);
+
+    *self = *parent;
+    self->ctx = ctx;
+    self->pipe = pipe;
+    self->pool = pool;
+
+    /* Own dispatch table, so each worker gets its own return value arena.
+     * The descriptors were already filled by our parent */
+    self->exp_ops_dtable = disp_table_new ();
+    ASSERT_ALLOC(self->exp_ops_dtable, err_exp_ops_dtable_alloc);
+    halutils_err_e herr = disp_table_insert_all (self->exp_ops_dtable,
+            parent->exp_ops);
+    ASSERT_TEST(herr == HALUTILS_SUCCESS, "Could not export SMIO ops",
+            err_export_op);
+    herr = disp_table_insert_all (self->exp_ops_dtable, smio_stats_exp_ops);
+    ASSERT_TEST(herr == HALUTILS_SUCCESS, "Could not export generic SMIO ops",
+            err_export_op);
+    herr = disp_table_insert_all (self->exp_ops_dtable, smio_coalesce_exp_ops);
+    ASSERT_TEST(herr == HALUTILS_SUCCESS, "Could not export generic SMIO ops",
+            err_export_op);
+
+    self->stats = smio_stats_new ();
+    ASSERT_ALLOC(self->stats, err_stats_alloc);
+    smio_err_e err = smio_stats_register_ops (self->stats, parent->exp_ops);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not register SMIO ops statistics",
+            err_register_stats);
+    err = smio_stats_register_ops (self->stats, smio_stats_exp_ops);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not register generic SMIO ops "
+            "statistics", err_register_stats);
+    err = smio_stats_register_ops (self->stats, smio_coalesce_exp_ops);
+    ASSERT_TEST(err == SMIO_SUCCESS, "Could not register generic SMIO ops "
+            "statistics", err_register_stats);
+
+    /* Register in broker last, when we are ready to handle requests */
+    self->worker = mdp_worker_new (ctx, pool->broker, parent->service,
+            pool->verbose);
+    ASSERT_ALLOC(self->worker, err_worker_alloc);
+
+    return self;
+
+err_worker_alloc:
+err_register_stats:
+    smio_stats_destroy (&self->stats);
+err_stats_alloc:
+err_export_op:
+    disp_table_destroy (&self->exp_ops_dtable);
+err_exp_ops_dtable_alloc:
+    free (self);
+err_self_alloc:
+    return NULL;
+}
+
+static smio_err_e _smio_pool_worker_destroy (smio_t **self_p)
+{
+    assert (self_p);
+
+    if (*self_p) {
+        smio_t *self = *self_p;
+
+        /* Only destroy what is ours. The rest belongs to the parent SMIO */
+        mdp_worker_destroy (&self->worker);
+        smio_stats_destroy (&self->stats);
+        disp_table_destroy (&self->exp_ops_dtable);
+
+        free (self);
+        *self_p = NULL;
+    }
+
+    return SMIO_SUCCESS;
+}
+
+static smio_err_e _smio_pool_worker_loop (smio_t *self)
+{
+    smio_err_e err = SMIO_SUCCESS;
+
+    while (!zctx_interrupted && !_smio_pool_is_shutdown (self->pool)) {
+        zmq_pollitem_t items [] = {
+            [SMIO_PIPE_SOCK] = {
+                .socket = self->pipe,
+                .fd = 0,
+                .events = ZMQ_POLLIN,
+                .revents = 0
+            }
+        };
+
+        /* Check for activity on WORKER socket */
+        zframe_t *reply_to = NULL;
+        zmsg_t *request = mdp_worker_recv (self->worker, &reply_to, true);
+
+        if (request != NULL) {
+            exp_msg_zmq_t smio_args = {
+                .tag = EXP_MSG_ZMQ_TAG,
+                .msg = &request,
+                .reply_to = reply_to,
+                .recv_ts = smio_stats_get_ts ()};
+            err = smio_do_op (self, &smio_args);
+
+            if (err != SMIO_SUCCESS) {
+                DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE,
+                        "[sm_io:pool] smio_do_op: %s\n",
+                        smio_err_str (err));
+            }
+
+            msg_pool_frame_destroy (&reply_to);
+            msg_pool_msg_destroy (&request);
+
+            /* Look for more requests before going idle */
+            continue;
+        }
+
+        /* Nothing is expected on the PIPE socket outside a thsafe
+         * transaction, so this just waits for up to 100 ms */
+        int rc = zmq_poll (items, SMIO_SOCKS_NUM, SMIO_POOL_POLLER_TIMEOUT);
+        ASSERT_TEST(rc != -1, "Poller has been interrupted",
+                err_loop_interrupted, SMIO_ERR_INTERRUPTED_POLLER);
+
+        if (items [SMIO_PIPE_SOCK].revents & ZMQ_POLLIN) {
+            zmsg_t *msg = zmsg_recv (self->pipe);
+            zmsg_destroy (&msg);
+            break;
+        }
+    }
+
+err_loop_interrupted:
+    return err;
+}
+
+/* An empty message means to selfdestruct, as in the DEVIO/SMIO protocol */
+static bool _smio_pool_is_exit_msg (zmsg_t *msg)
+{
+    return zmsg_size (msg) == 1 && zframe_size (zmsg_first (msg)) == 0;
+}
+
+static void _smio_pool_send_exit_msg (void *pipe)
+{
+    zmsg_t *msg = zmsg_new ();
+    ASSERT_ALLOC(msg, err_msg_alloc);
+    zmsg_pushstr (msg, "");
+    zmsg_send (&msg, pipe);
+
+err_msg_alloc:
+    return;
+}
+
+static void _smio_pool_start_shutdown (smio_pool_t *self)
+{
+    __atomic_store_n (&self->shutdown, 1, __ATOMIC_SEQ_CST);
+    __atomic_store_n (&self->tick_waiting, 0, __ATOMIC_SEQ_CST);
+
+    /* Fail every pending thsafe request, as we won't listen to the DEVIO
+     * anymore. An empty reply is rejected by the thsafe client */
+    for ( ; self->pending_count > 0; --self->pending_count) {
+        _smio_pool_send_exit_msg (self->pipes [self->pending [self->pending_head]]);
+        self->pending_head = (self->pending_head+1) % SMIO_MAX_NUM_WORKERS;
+    }
+}
+
+static bool _smio_pool_is_shutdown (smio_pool_t *self)
+{
+    return __atomic_load_n (&self->shutdown, __ATOMIC_SEQ_CST) != 0;
+}
+
+/* Do the periodic work of the SMIO, at most every SMIO_POOL_POLLER_TIMEOUT
+ * msec. The handler must be free, but we can't wait for it, as the workers
+ * in it might need us to forward their thsafe requests. So, we just try and,
+ * if it is busy, have the workers hold off new calls until we get it */
+static void _smio_pool_tick (smio_pool_t *self, uint64_t *tick_ts)
+{
+    if (smio_stats_get_ts () - *tick_ts <
+            SMIO_POOL_POLLER_TIMEOUT*SMIO_POOL_NS_PER_MS) {
+        return;
+    }
+
+    /* Most of the time there is nothing to do (e.g., no ACQ stream is
+     * running), so don't take the handler from the workers for it */
+    if (!smio_tick_pending (self->parent)) {
+        __atomic_store_n (&self->tick_waiting, 0, __ATOMIC_SEQ_CST);
+        *tick_ts = smio_stats_get_ts ();
+        return;
+    }
+
+    if (pthread_rwlock_trywrlock (&self->handler_lock) != 0) {
+        __atomic_store_n (&self->tick_waiting, 1, __ATOMIC_SEQ_CST);
+        return;
+    }
+
+    /* No worker is in the handler, so no thsafe reply is on its way and
+     * the PIPE socket is all ours */
+    smio_err_e err = smio_tick (self->parent);
+    __atomic_store_n (&self->tick_waiting, 0, __ATOMIC_SEQ_CST);
+    pthread_rwlock_unlock (&self->handler_lock);
+
+    /* Not being able to do it is not fatal */
+    if (err != SMIO_SUCCESS) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:pool] smio_tick: %s\n",
+                smio_err_str (err));
+    }
+
+    *tick_ts = smio_stats_get_ts ();
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+/* Pool of MDP workers serving the same SMIO service. Each worker runs in its
+ * own thread, with its own Majordomo worker, dispatch table (and, so, return
+ * value arena) and statistics, sharing everything else with the SMIO that
+ * spawned it (most notably, the smio_handler).
+ *
+ * Calls to the SMIO handler go through the handler lock. Read-only calls
+ * share it, so their thsafe requests can be in flight at the same time.
+ * Every other call, as well as the read-only ones that update state kept by
+ * the SMIO (DISP_OP_FLAG_MOD_STATE), has the handler for itself. The SMIO
+ * thread itself does not serve any requests. Instead, it forwards the thsafe
+ * requests of the workers to the DEVIO through its PIPE socket and routes the
+ * replies back, in order, as ZMQ sockets must not be shared among threads */
+
+#ifndef _SM_IO_POOL_H_
+#define _SM_IO_POOL_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "sm_io_err.h"
+#include "sm_io_stats.h"
+#include "sm_io_bootstrap.h"
+
+struct _smio_t;
+
+struct _smio_pool_t {
+    struct _smio_t *parent;             /* SMIO owning this pool */
+    char *broker;                       /* Endpoint to connect to broker */
+    int verbose;                        /* Print trace information to stdout*/
+    uint32_t nworkers;                  /* Number of spawned workers */
+    pthread_rwlock_t handler_lock;      /* Calls to the SMIO handler */
+    pthread_mutex_t lock;               /* Guards the worker list and the
+                                           statistics of the workers */
+    void *pipes [SMIO_MAX_NUM_WORKERS]; /* PIPE sockets to each worker */
+    struct _smio_t *workers [SMIO_MAX_NUM_WORKERS]; /* Running workers.
+                                           Protected by the pool lock */
+    int shutdown;                       /* Workers must exit */
+    int tick_waiting;                   /* The SMIO thread waits for the
+                                           handler to tick. Workers hold
+                                           off new calls meanwhile */
+    /* Workers with a thsafe request forwarded to the DEVIO, in the order
+     * they were forwarded. Each worker has, at most, one pending request */
+    uint32_t pending [SMIO_MAX_NUM_WORKERS];
+    uint32_t pending_head;
+    uint32_t pending_count;
+};
+
+/* Opaque class structure */
+typedef struct _smio_pool_t smio_pool_t;
+
+/***************** Our methods *****************/
+
+/* Creates a new pool and spawns nworkers worker threads for the parent SMIO.
+ * The SMIO must have exported its operations already */
+smio_pool_t *smio_pool_new (struct _smio_t *parent, uint32_t nworkers,
+        char *broker, int verbose);
+/* Destroys the pool. smio_pool_loop () must have returned already */
+smio_err_e smio_pool_destroy (smio_pool_t **self_p);
+
+/* Forward the thsafe requests of the workers until the DEVIO asks the SMIO
+ * to exit (or we are interrupted). The SMIO is ticked from here, whenever
+ * no worker is in the handler. Returns only after all of the workers are
+ * gone */
+smio_err_e smio_pool_loop (smio_pool_t *self);
+
+/* Enter the SMIO handler. Calls with "shared" set run alongside each other,
+ * the others have the handler for themselves */
+void smio_pool_handler_lock (smio_pool_t *self, bool shared);
+void smio_pool_handler_unlock (smio_pool_t *self);
+
+/* Guard the worker list and the statistics of the workers */
+void smio_pool_lock (smio_pool_t *self);
+void smio_pool_unlock (smio_pool_t *self);
+
+/* Get the statistics of the first registered operation with opcode equal or
+ * greater than the requested one, summed over all of the running workers */
+smio_err_e smio_pool_get_op_stats (smio_pool_t *self, uint32_t opcode,
+        smio_op_stats_t *op_stats);
+
+#endif
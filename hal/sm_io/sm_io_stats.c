@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "sm_io_stats.h"
+#include "sm_io.h"
+#include "hal_assert.h"
+
+/* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
+#ifdef ASSERT_TEST
+#undef ASSERT_TEST
+#endif
+#define ASSERT_TEST(test_boolean, err_str, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_TEST(test_boolean, SM_IO, "[sm_io:stats]",   \
+            err_str, err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef ASSERT_ALLOC
+#undef ASSERT_ALLOC
+#endif
+#define ASSERT_ALLOC(ptr, err_goto_label, /* err_core */ ...) \
+    ASSERT_HAL_ALLOC(ptr, SM_IO, "[sm_io:stats]",           \
+            smio_err_str(SMIO_ERR_ALLOC),                   \
+            err_goto_label, /* err_core */ __VA_ARGS__)
+
+#ifdef CHECK_ERR
+#undef CHECK_ERR
+#endif
+#define CHECK_ERR(err, err_type)                            \
+    CHECK_HAL_ERR(err, SM_IO, "[sm_io:stats]",              \
+            smio_err_str (err_type))
+
+#define SMIO_STATS_NS_PER_US                1000ULL
+#define SMIO_STATS_NS_PER_S                 1000000000ULL
+
+static void _smio_stats_hist_add (smio_stats_hist_t *hist, uint64_t sample_ns);
+static void _smio_stats_hist_merge (smio_stats_hist_t *dst,
+        const smio_stats_hist_t *src);
+static uint32_t _smio_stats_hist_bin (uint64_t sample_ns);
+
+/* Creates a new instance of the SMIO statistics */
+smio_stats_t *smio_stats_new (void)
+{
+    smio_stats_t *self = (smio_stats_t *) zmalloc (sizeof *self);
+    ASSERT_ALLOC(self, err_self_alloc);
+
+    return self;
+
+err_self_alloc:
+    return NULL;
+}
+
+/* Destroys an instance of the SMIO statistics */
+smio_err_e smio_stats_destroy (smio_stats_t **self_p)
+{
+    assert (self_p);
+
+    if (*self_p) {
+        smio_stats_t *self = *self_p;
+
+        free (self);
+        *self_p = NULL;
+    }
+
+    return SMIO_SUCCESS;
+}
+
+uint64_t smio_stats_get_ts (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec*SMIO_STATS_NS_PER_S + (uint64_t) ts.tv_nsec;
+}
+
+smio_err_e smio_stats_register_ops (smio_stats_t *self,
+        const disp_op_t **smio_exp_ops)
+{
+    assert (self);
+    assert (smio_exp_ops);
+
+    smio_err_e err = SMIO_SUCCESS;
+    const disp_op_t **disp_op_it = smio_exp_ops;
+
+    for ( ; *disp_op_it != NULL; ++disp_op_it) {
+        uint32_t opcode = (*disp_op_it)->opcode;
+        ASSERT_TEST(opcode < MSG_OPCODE_MAX, "Opcode out of range",
+                err_opcode_oor, SMIO_ERR_WRONG_PARAM);
+
+        smio_stats_op_t *op = &self->ops [opcode];
+        op->registered = true;
+        op->op_stats.opcode = opcode;
+        strncpy (op->op_stats.name, (*disp_op_it)->name,
+                sizeof (op->op_stats.name)-1);
+    }
+
+err_opcode_oor:
+    return err;
+}
+
+smio_err_e smio_stats_unregister_ops (smio_stats_t *self)
+{
+    assert (self);
+    memset (self->ops, 0, sizeof (self->ops));
+
+    return SMIO_SUCCESS;
+}
+
+void smio_stats_call_begin (smio_stats_t *self, uint64_t recv_ts)
+{
+    if (self == NULL) {
+        return;
+    }
+
+    self->call_ts = smio_stats_get_ts ();
+    /* Time from the worker taking the request off its socket to the call.
+     * What it spent in the socket before that is not known to us */
+    self->queue_ns = (recv_ts != 0 && recv_ts < self->call_ts) ?
+        self->call_ts - recv_ts : 0;
+    self->thsafe_ns = 0;
+    msg_pool_get_stats (&self->call_pool_stats);
+}
+
+void smio_stats_call_end (smio_stats_t *self, uint32_t opcode, int disp_table_ret)
+{
+    if (self == NULL) {
+        return;
+    }
+
+    uint64_t end_ts = smio_stats_get_ts ();
+
+    /* Requests to unknown opcodes are rejected by the dispatch table
+     * and are not accounted */
+    if (opcode >= MSG_OPCODE_MAX || !self->ops [opcode].registered) {
+        goto err_not_registered;
+    }
+
+    smio_op_stats_t *op_stats = &self->ops [opcode].op_stats;
+    uint64_t call_ns = end_ts - self->call_ts;
+    uint64_t handler_ns = (call_ns > self->thsafe_ns) ?
+        call_ns - self->thsafe_ns : 0;
+    /* The call runs on this thread, so whatever its pool handed out since
+     * smio_stats_call_begin () was used by it */
+    msg_pool_stats_t pool_stats;
+    msg_pool_get_stats (&pool_stats);
+
+    op_stats->calls++;
+    if (disp_table_ret < 0) {
+        op_stats->errors++;
+    }
+
+    op_stats->msg_allocs += (pool_stats.msg_allocs - self->call_pool_stats.msg_allocs) +
+        (pool_stats.frame_allocs - self->call_pool_stats.frame_allocs);
+    op_stats->msg_reuses += (pool_stats.msg_reuses - self->call_pool_stats.msg_reuses) +
+        (pool_stats.frame_reuses - self->call_pool_stats.frame_reuses);
+
+    _smio_stats_hist_add (&op_stats->queue, self->queue_ns);
+    _smio_stats_hist_add (&op_stats->handler, handler_ns);
+    _smio_stats_hist_add (&op_stats->thsafe, self->thsafe_ns);
+
+err_not_registered:
+    return;
+}
+
+void smio_stats_add_coalesced (smio_stats_t *self, uint32_t opcode)
+{
+    if (self == NULL || opcode >= MSG_OPCODE_MAX ||
+            !self->ops [opcode].registered) {
+        return;
+    }
+
+    self->ops [opcode].op_stats.coalesced++;
+}
+
+void smio_stats_add_expired (smio_stats_t *self, uint32_t opcode)
+{
+    if (self == NULL) {
+        return;
+    }
+
+    if (opcode < MSG_OPCODE_MAX && self->ops [opcode].registered) {
+        self->ops [opcode].op_stats.expired++;
+    }
+}
+
+void smio_stats_add_thsafe_wait (smio_stats_t *self, uint64_t wait_ns)
+{
+    if (self == NULL) {
+        return;
+    }
+
+    self->thsafe_ns += wait_ns;
+}
+
+smio_err_e smio_stats_get_op (smio_stats_t *self, uint32_t opcode,
+        smio_op_stats_t *op_stats)
+{
+    assert (self);
+    assert (op_stats);
+
+    for ( ; opcode < MSG_OPCODE_MAX && !self->ops [opcode].registered;
+            ++opcode);
+
+    /* This is the expected way of ending a walk through all the operations,
+     * so don't log it as an error */
+    if (opcode >= MSG_OPCODE_MAX) {
+        DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:stats] "
+                "No more registered operations\n");
+        return SMIO_ERR_WRONG_PARAM;
+    }
+
+    *op_stats = self->ops [opcode].op_stats;
+    return SMIO_SUCCESS;
+}
+
+void smio_stats_merge_op (smio_op_stats_t *dst, const smio_op_stats_t *src)
+{
+    assert (dst);
+    assert (src);
+
+    dst->calls += src->calls;
+    dst->errors += src->errors;
+    dst->coalesced += src->coalesced;
+    dst->expired += src->expired;
+    dst->msg_allocs += src->msg_allocs;
+    dst->msg_reuses += src->msg_reuses;
+    _smio_stats_hist_merge (&dst->queue, &src->queue);
+    _smio_stats_hist_merge (&dst->handler, &src->handler);
+    _smio_stats_hist_merge (&dst->thsafe, &src->thsafe);
+}
+
+/************************************************************/
+/*************** Generic exported operations ****************/
+/************************************************************/
+
+static int _smio_stats_get_op_stats (void *owner, void *args, void *ret)
+{
+    assert (owner);
+    assert (args);
+    assert (ret);
+
+    DBE_DEBUG (DBG_SM_IO | DBG_LVL_TRACE, "[sm_io:stats] "
+            "Calling _smio_stats_get_op_stats\n");
+    SMIO_OWNER_TYPE *self = SMIO_EXP_OWNER(owner);
+
+    /* Message is:
+     * frame 0: operation code
+     * frame 1: first opcode to look for */
+    uint32_t opcode = *(uint32_t *) EXP_MSG_ZMQ_FIRST_ARG(args);
+    smio_op_stats_t *op_stats = (smio_op_stats_t *) ret;
+
+    /* Workers of a pool have their own statistics. Report all of them */
+    smio_err_e err = (self->pool != NULL) ?
+        smio_pool_get_op_stats (self->pool, opcode, op_stats) :
+        smio_stats_get_op (self->stats, opcode, op_stats);
+    if (err != SMIO_SUCCESS) {
+        return -SMIO_STATS_NO_MORE_OPS;
+    }
+
+    return sizeof (*op_stats);
+}
+
+const disp_table_func_fp smio_stats_exp_fp [] = {
+    _smio_stats_get_op_stats,
+    NULL
+};
+
+/**************** Static Functions ***************/
+
+static void _smio_stats_hist_add (smio_stats_hist_t *hist, uint64_t sample_ns)
+{
+    hist->total_ns += sample_ns;
+    if (sample_ns > hist->max_ns) {
+        hist->max_ns = sample_ns;
+    }
+
+    hist->bins [_smio_stats_hist_bin (sample_ns)]++;
+}
+
+static void _smio_stats_hist_merge (smio_stats_hist_t *dst,
+        const smio_stats_hist_t *src)
+{
+    dst->total_ns += src->total_ns;
+    if (src->max_ns > dst->max_ns) {
+        dst->max_ns = src->max_ns;
+    }
+
+    uint32_t i;
+    for (i = 0; i < SMIO_STATS_HIST_BINS; ++i) {
+        dst->bins [i] += src->bins [i];
+    }
+}
+
+static uint32_t _smio_stats_hist_bin (uint64_t sample_ns)
+{
+    uint64_t sample_us = sample_ns/SMIO_STATS_NS_PER_US;
+
+    if (sample_us == 0) {
+        return 0;
+    }
+
+    /* 1 + floor(log2(sample_us)) */
+    uint32_t bin = 64 - __builtin_clzll (sample_us);
+    return (bin < SMIO_STATS_HIST_BINS) ? bin : SMIO_STATS_HIST_BINS-1;
+}
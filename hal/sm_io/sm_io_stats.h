@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ */
+
+#ifndef _SM_IO_STATS_H_
+#define _SM_IO_STATS_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "sm_io_err.h"
+#include "sm_io_stats_codes.h"
+#include "dispatch_table.h"
+#include "msg.h"
+
+struct _smio_stats_op_t {
+    bool registered;                    /* Operation is exported by this SMIO */
+    smio_op_stats_t op_stats;           /* Accumulated statistics */
+};
+
+typedef struct _smio_stats_op_t smio_stats_op_t;
+
+struct _smio_stats_t {
+    smio_stats_op_t ops [MSG_OPCODE_MAX];
+    uint64_t call_ts;                   /* Dispatch time of the current call */
+    uint64_t queue_ns;                  /* Queue wait of the current call */
+    uint64_t thsafe_ns;                 /* Accumulated thsafe wait of the
+                                           current call */
+    msg_pool_stats_t call_pool_stats;   /* Message pool counters at the
+                                           beginning of the current call */
+};
+
+/* Opaque class structure */
+typedef struct _smio_stats_t smio_stats_t;
+
+/***************** Our methods *****************/
+
+/* Creates a new instance of the SMIO statistics */
+smio_stats_t *smio_stats_new (void);
+/* Destroys an instance of the SMIO statistics */
+smio_err_e smio_stats_destroy (smio_stats_t **self_p);
+
+/* Monotonic timestamp, in ns */
+uint64_t smio_stats_get_ts (void);
+
+/* Mark every operation in the NULL-terminated smio_exp_ops as registered,
+ * so it is reported by the STATS operation */
+smio_err_e smio_stats_register_ops (smio_stats_t *self,
+        const disp_op_t **smio_exp_ops);
+/* Clear all the registered operations and their statistics */
+smio_err_e smio_stats_unregister_ops (smio_stats_t *self);
+
+/* Mark the beginning of a dispatch table call. recv_ts is the time its
+ * request was received, so the queue wait is measured from there */
+void smio_stats_call_begin (smio_stats_t *self, uint64_t recv_ts);
+/* Mark the end of a dispatch table call and account it to opcode */
+void smio_stats_call_end (smio_stats_t *self, uint32_t opcode, int disp_table_ret);
+/* Account the current call as answered by a previous identical one. Must
+ * be called after smio_stats_call_end () */
+void smio_stats_add_coalesced (smio_stats_t *self, uint32_t opcode);
+/* Account a request to opcode dropped as its deadline expired. No call
+ * is made, so there is no smio_stats_call_begin ()/end () pair for it */
+void smio_stats_add_expired (smio_stats_t *self, uint32_t opcode);
+/* Account time blocked waiting for a DEVIO thsafe reply to the current call */
+void smio_stats_add_thsafe_wait (smio_stats_t *self, uint64_t wait_ns);
+
+/* Get the statistics of the first registered operation with opcode equal or
+ * greater than the requested one */
+smio_err_e smio_stats_get_op (smio_stats_t *self, uint32_t opcode,
+        smio_op_stats_t *op_stats);
+/* Accumulate the statistics in src into dst */
+void smio_stats_merge_op (smio_op_stats_t *dst, const smio_op_stats_t *src);
+
+/* Generic statistics exported functions, registered on every SMIO */
+extern const disp_table_func_fp smio_stats_exp_fp [];
+
+#endif
@@ -5,6 +5,8 @@
  * Released according to the GNU LGPL, version 3 or any later version.
  */
 
+#include <time.h>
+
 #include "bpm_client.h"
 #include "hal_assert.h"
 
@@ -40,6 +42,9 @@
             bpm_client_err_str (err_type))
 
 #define BPMCLIENT_DFLT_LOG_MODE             "w"
+#define BPMCLIENT_US_PER_MS                 1000ULL
+#define BPMCLIENT_US_PER_S                  1000000ULL
+#define BPMCLIENT_NS_PER_US                 1000ULL
 
 static bpm_client_t *_bpm_client_new (char *broker_endp, int verbose,
         const char *log_file_name, const char *log_mode);
@@ -142,6 +147,63 @@ err_self_alloc:
     return NULL;
 }
 
+void bpm_client_set_request_ttl (bpm_client_t *self, uint32_t ttl_ms)
+{
+    assert (self);
+    self->request_ttl_ms = ttl_ms;
+}
+
+void bpm_client_set_request_deadline (bpm_client_t *self, uint64_t deadline_us)
+{
+    assert (self);
+    self->request_deadline_us = deadline_us;
+}
+
+void bpm_client_send (bpm_client_t *self, char *service, zmsg_t **request)
+{
+    assert (self);
+    assert (request);
+
+    /* The server only gets how long the request may wait, so the clocks
+     * of both never have to agree */
+    bool with_ttl = false;
+    uint64_t ttl_us = 0;
+
+    if (self->request_ttl_ms != 0) {
+        with_ttl = true;
+        ttl_us = (uint64_t) self->request_ttl_ms*BPMCLIENT_US_PER_MS;
+    }
+
+    if (self->request_deadline_us != 0) {
+        struct timespec now;
+        clock_gettime (CLOCK_REALTIME, &now);
+
+        uint64_t now_us = (uint64_t) now.tv_sec*BPMCLIENT_US_PER_S +
+            (uint64_t) now.tv_nsec/BPMCLIENT_NS_PER_US;
+        uint64_t deadline_ttl_us = (self->request_deadline_us > now_us) ?
+            self->request_deadline_us - now_us : 0;
+
+        if (!with_ttl || deadline_ttl_us < ttl_us) {
+            ttl_us = deadline_ttl_us;
+        }
+        with_ttl = true;
+    }
+
+    /* Message is:
+     * frame 0: deadline (optional)
+     * frame 1: operation code
+     * frame n: arguments */
+    if (with_ttl && *request != NULL) {
+        smio_deadline_t deadline = {
+            .tag = SMIO_DEADLINE_TAG,
+            .reserved = 0,
+            .ttl_us = ttl_us};
+        zmsg_pushmem (*request, &deadline, sizeof (deadline));
+    }
+
+    mdp_client_send (self->mdp_client, service, request);
+}
+
 /**************** General Function to call the others *********/
 
 bpm_client_err_e bpm_func_exec (bpm_client_t *self, const disp_op_t *func, char *service, uint32_t *input, uint32_t *output)
@@ -171,7 +233,7 @@ bpm_client_err_e bpm_func_exec (bpm_client_t *self, const disp_op_t *func, char
         input += in_size;
     }
 
-    mdp_client_send (self->mdp_client, service, &msg);
+    bpm_client_send (self, service, &msg);
 
     /* Receive report */
     zmsg_t *report = mdp_client_recv (self->mdp_client, NULL, NULL);
@@ -191,6 +253,10 @@ bpm_client_err_e bpm_func_exec (bpm_client_t *self, const disp_op_t *func, char
     zframe_t *err_code = zmsg_pop(report);
     ASSERT_TEST(err_code != NULL, "Could not receive error code", err_msg);
     err = *(uint32_t *)zframe_data(err_code);
+    /* The server dropped the request, as it waited too long to be served */
+    if (*(uint32_t *)zframe_data(err_code) == SMIO_DEADLINE_EXPIRED) {
+        err = BPM_CLIENT_ERR_EXPIRED;
+    }
 
     zframe_t *data_size_frm = NULL;
     zframe_t *data_frm = NULL;
@@ -268,7 +334,7 @@ bpm_client_err_e bpm_blink_leds (bpm_client_t *self, char *service, uint32_t led
     ASSERT_ALLOC(request, err_send_msg_alloc, BPM_CLIENT_ERR_ALLOC);
     zmsg_addmem (request, &operation, sizeof (operation));
     zmsg_addmem (request, &leds, sizeof (leds));
-    mdp_client_send (self->mdp_client, service, &request);
+    bpm_client_send (self, service, &request);
 
 err_send_msg_alloc:
     return err;
@@ -324,7 +390,7 @@ bpm_client_err_e bpm_ad9510_cfg_defaults (bpm_client_t *self, char *service)
     zmsg_t *request = zmsg_new ();
     ASSERT_ALLOC(request, err_send_msg_alloc, BPM_CLIENT_ERR_ALLOC);
     zmsg_addmem (request, &operation, sizeof (operation));
-    mdp_client_send (self->mdp_client, service, &request);
+    bpm_client_send (self, service, &request);
 
 err_send_msg_alloc:
     return err;
@@ -785,7 +851,16 @@ static bpm_client_err_e _bpm_acq_start (bpm_client_t *self, char *service, acq_r
 static bpm_client_err_e _bpm_acq_check (bpm_client_t *self, char *service);
 static bpm_client_err_e _bpm_acq_get_data_block (bpm_client_t *self, char *service, acq_trans_t *acq_trans);
 static bpm_client_err_e _bpm_acq_get_curve (bpm_client_t *self, char *service, acq_trans_t *acq_trans);
+static bpm_client_err_e _bpm_acq_get_shot_data_block (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans, uint32_t shot);
+static uint32_t _bpm_acq_num_samples (const acq_req_t *acq_req);
+static bpm_client_err_e _bpm_acq_get_soa_curve (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans);
+static bpm_client_err_e _bpm_acq_get_pos_curve (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans, char *name, uint32_t mode);
 static bpm_client_err_e _bpm_full_acq (bpm_client_t *self, char *service, acq_trans_t *acq_trans, int timeout);
+static bpm_client_err_e _bpm_full_acq_multi (bpm_client_t *self, char **services,
+        acq_trans_t *acq_trans, uint32_t num_acqs, int timeout);
 
 bpm_client_err_e bpm_data_acquire (bpm_client_t *self, char *service, acq_req_t *acq_req)
 {
@@ -829,11 +904,69 @@ bpm_client_err_e bpm_acq_get_curve (bpm_client_t *self, char *service, acq_trans
     return _bpm_acq_get_curve (self, service, acq_trans);
 }
 
+bpm_client_err_e bpm_acq_get_shot_curve (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans, uint32_t shot)
+{
+    assert (self);
+    assert (service);
+    assert (acq_trans);
+    assert (acq_trans->block.data);
+
+    bpm_client_err_e err = BPM_CLIENT_SUCCESS;
+
+    /* FIXME: When the last block is full 'block_n_valid exceeds by one */
+    uint32_t block_n_valid = (acq_trans->req.num_samples + acq_trans->req.num_samples_post) /
+        (BLOCK_SIZE/self->acq_chan[acq_trans->req.chan].sample_size);
+    DBE_DEBUG (DBG_LIB_CLIENT | DBG_LVL_TRACE, "[libclient] bpm_acq_get_shot_curve: "
+            "block_n_valid = %u\n", block_n_valid);
+
+    uint32_t total_bread = 0;   /* Total bytes read */
+    uint32_t data_size = acq_trans->block.data_size;  /* Save the original buffer size for later */
+    uint32_t *original_data_pt = acq_trans->block.data;
+
+    for (uint32_t block_n = 0; block_n <= block_n_valid; block_n++) {
+        if (zctx_interrupted) {
+            err = BPM_CLIENT_INT;
+            goto bpm_zctx_interrupted;
+        }
+
+        acq_trans->block.idx = block_n;
+        err = _bpm_acq_get_shot_data_block (self, service, acq_trans, shot);
+
+        /* Check for return code */
+        ASSERT_TEST(err == BPM_CLIENT_SUCCESS,
+                "_bpm_acq_get_shot_data_block failed. shot or block_n is probably out of range",
+                err_bpm_get_data_block);
+
+        total_bread += acq_trans->block.bytes_read;
+        acq_trans->block.data = (uint32_t *)((uint8_t *)acq_trans->block.data + acq_trans->block.bytes_read);
+        acq_trans->block.data_size -= acq_trans->block.bytes_read;
+    }
+
+    DBE_DEBUG (DBG_LIB_CLIENT | DBG_LVL_TRACE, "[libclient] bpm_acq_get_shot_curve: "
+            "Data curve of shot %u with %u bytes was successfully acquired\n",
+            shot, total_bread);
+
+err_bpm_get_data_block:
+bpm_zctx_interrupted:
+    /* Return to client the total number of bytes read */
+    acq_trans->block.bytes_read = total_bread;
+    acq_trans->block.data_size = data_size;
+    acq_trans->block.data = original_data_pt;
+    return err;
+}
+
 bpm_client_err_e bpm_full_acq (bpm_client_t *self, char *service, acq_trans_t *acq_trans, int timeout)
 {
     return _bpm_full_acq (self, service, acq_trans, timeout);
 }
 
+bpm_client_err_e bpm_full_acq_multi (bpm_client_t *self, char **services,
+        acq_trans_t *acq_trans, uint32_t num_acqs, int timeout)
+{
+    return _bpm_full_acq_multi (self, services, acq_trans, num_acqs, timeout);
+}
+
 static bpm_client_err_e _bpm_data_acquire (bpm_client_t *self, char *service,
         acq_req_t *acq_req)
 {
@@ -846,13 +979,17 @@ static bpm_client_err_e _bpm_data_acquire (bpm_client_t *self, char *service,
 
     /* Message is:
      * frame 0: operation code
-     * frame 1: number of samples
-     * frame 2: channel             */
+     * frame 1: number of pre-trigger samples
+     * frame 2: channel
+     * frame 3: number of post-trigger samples
+     * frame 4: number of shots */
     zmsg_t *request = zmsg_new ();
     zmsg_addmem (request, &operation, sizeof (operation));
     zmsg_addmem (request, &acq_req->num_samples, sizeof (acq_req->num_samples));
     zmsg_addmem (request, &acq_req->chan, sizeof (acq_req->chan));
-    mdp_client_send (self->mdp_client, service, &request);
+    zmsg_addmem (request, &acq_req->num_samples_post, sizeof (acq_req->num_samples_post));
+    zmsg_addmem (request, &acq_req->num_shots, sizeof (acq_req->num_shots));
+    bpm_client_send (self, service, &request);
 
     /* Receive report */
     zmsg_t *report = mdp_client_recv (self->mdp_client, NULL, NULL);
@@ -898,7 +1035,7 @@ static bpm_client_err_e _bpm_check_data_acquire (bpm_client_t *self, char *servi
      * frame 0: operation code      */
     zmsg_t *request = zmsg_new ();
     zmsg_addmem (request, &operation, sizeof (operation));
-    mdp_client_send (self->mdp_client, service, &request);
+    bpm_client_send (self, service, &request);
 
     /* Receive report */
     zmsg_t *report = mdp_client_recv (self->mdp_client, NULL, NULL);
@@ -986,7 +1123,8 @@ static bpm_client_err_e _bpm_get_data_block (bpm_client_t *self, char *service,
     assert (acq_trans->block.data);
 
     bpm_client_err_e err = BPM_CLIENT_SUCCESS;
-    ACQ_OPCODE_TYPE operation = ACQ_OPCODE_GET_DATA_BLOCK;
+    ACQ_OPCODE_TYPE operation = acq_trans->block.soa ?
+        ACQ_OPCODE_GET_SOA_DATA_BLOCK : ACQ_OPCODE_GET_DATA_BLOCK;
 
     /* Message is:
      * frame 0: operation code
@@ -996,7 +1134,7 @@ static bpm_client_err_e _bpm_get_data_block (bpm_client_t *self, char *service,
     zmsg_addmem (request, &operation, sizeof (operation));
     zmsg_addmem (request, &acq_trans->req.chan, sizeof (acq_trans->req.chan));
     zmsg_addmem (request, &acq_trans->block.idx, sizeof (acq_trans->block.idx));
-    mdp_client_send (self->mdp_client, service, &request);
+    bpm_client_send (self, service, &request);
 
     /* Receive report */
     zmsg_t *report = mdp_client_recv (self->mdp_client, NULL, NULL);
@@ -1094,8 +1232,13 @@ bpm_client_err_e bpm_get_curve (bpm_client_t *self, char *service,
                 err_bpm_wait_data_acquire);
     }
 
+    /* The columns of each block go to their own place in the curve */
+    if (acq_trans->block.soa) {
+        return _bpm_acq_get_soa_curve (self, service, acq_trans);
+    }
+
     /* FIXME: When the last block is full 'block_n_valid exceeds by one */
-    uint32_t block_n_valid = acq_trans->req.num_samples /
+    uint32_t block_n_valid = _bpm_acq_num_samples (&acq_trans->req) /
         (BLOCK_SIZE/self->acq_chan[acq_trans->req.chan].sample_size);
     DBE_DEBUG (DBG_LIB_CLIENT | DBG_LVL_TRACE, "[libclient] bpm_get_curve: "
             "block_n_valid = %u\n", block_n_valid);
@@ -1146,9 +1289,11 @@ err_bpm_data_acquire:
 
 static bpm_client_err_e _bpm_acq_start (bpm_client_t *self, char *service, acq_req_t *acq_req)
 {
-    uint32_t write_val[sizeof(uint32_t)*2] = {0};
+    uint32_t write_val[sizeof(uint32_t)*4] = {0};
     *write_val = acq_req->num_samples;
     *(write_val+4) = acq_req->chan;
+    *(write_val+8) = acq_req->num_samples_post;
+    *(write_val+12) = acq_req->num_shots;
 
     const disp_op_t* func = bpm_func_translate(ACQ_NAME_DATA_ACQUIRE);
     bpm_client_err_e err = bpm_func_exec(self, func, service, write_val, NULL);
@@ -1201,7 +1346,8 @@ static bpm_client_err_e _bpm_acq_get_data_block (bpm_client_t *self, char *servi
      * frame 1: channel
      * frame 2: block required */
 
-    const disp_op_t* func = bpm_func_translate(ACQ_NAME_GET_DATA_BLOCK);
+    const disp_op_t* func = bpm_func_translate(acq_trans->block.soa ?
+            ACQ_NAME_GET_SOA_DATA_BLOCK : ACQ_NAME_GET_DATA_BLOCK);
     bpm_client_err_e err = bpm_func_exec(self, func, service, write_val, (uint32_t *) read_val);
 
     /* Received Message is:
@@ -1242,8 +1388,13 @@ static bpm_client_err_e _bpm_acq_get_curve (bpm_client_t *self, char *service, a
     assert (acq_trans->block.data);
 
     bpm_client_err_e err = BPM_CLIENT_SUCCESS;
-    
-    uint32_t block_n_valid = acq_trans->req.num_samples /
+
+    /* The columns of each block go to their own place in the curve */
+    if (acq_trans->block.soa) {
+        return _bpm_acq_get_soa_curve (self, service, acq_trans);
+    }
+
+    uint32_t block_n_valid = _bpm_acq_num_samples (&acq_trans->req) /
         (BLOCK_SIZE/self->acq_chan[acq_trans->req.chan].sample_size);
     DBE_DEBUG (DBG_LIB_CLIENT | DBG_LVL_TRACE, "[libclient] bpm_full_acq: "
             "block_n_valid = %u\n", block_n_valid);
@@ -1318,7 +1469,7 @@ static bpm_client_err_e _bpm_full_acq (bpm_client_t *self, char *service, acq_tr
             "Check ok: data acquire was successfully completed\n");
 
     /* FIXME: When the last block is full 'block_n_valid exceeds by one */
-    uint32_t block_n_valid = acq_trans->req.num_samples /
+    uint32_t block_n_valid = _bpm_acq_num_samples (&acq_trans->req) /
         (BLOCK_SIZE/self->acq_chan[acq_trans->req.chan].sample_size);
     DBE_DEBUG (DBG_LIB_CLIENT | DBG_LVL_TRACE, "[libclient] bpm_full_acq: "
             "block_n_valid = %u\n", block_n_valid);
@@ -1370,6 +1521,592 @@ err_bpm_get_data_block:
 err_check_data_acquire:
     return err;
 }
+
+static bpm_client_err_e _bpm_full_acq_multi (bpm_client_t *self, char **services,
+        acq_trans_t *acq_trans, uint32_t num_acqs, int timeout)
+{
+    assert (self);
+    assert (services);
+    assert (acq_trans);
+
+    if (num_acqs == 0) {
+        return BPM_CLIENT_SUCCESS;
+    }
+
+    if (timeout < 0) {
+        timeout = INT_MAX;
+    }
+
+    bpm_client_err_e err = BPM_CLIENT_SUCCESS;
+    /* Acquisitions not read yet */
+    bool *pending = zmalloc (num_acqs * sizeof (*pending));
+    ASSERT_ALLOC(pending, err_pending_alloc, BPM_CLIENT_ERR_ALLOC);
+
+    /* Arm all of them first, so they run at the same time */
+    uint32_t i;
+    for (i = 0; i < num_acqs; i++) {
+        err = bpm_acq_start (self, services[i], &acq_trans[i].req);
+        ASSERT_TEST(err == BPM_CLIENT_SUCCESS, "bpm_full_acq_multi: "
+                "Could not start an acquisition", err_acq_start);
+        pending[i] = true;
+    }
+
+    /* Read each curve as soon as it is done. The others keep acquiring in
+     * the meantime */
+    uint32_t num_pending = num_acqs;
+    time_t start = time(NULL);
+    while (num_pending > 0) {
+        if (zctx_interrupted) {
+            err = BPM_CLIENT_INT;
+            goto bpm_zctx_interrupted;
+        }
+
+        bool read_any = false;
+        for (i = 0; i < num_acqs; i++) {
+            if (!pending[i] || bpm_acq_check (self, services[i]) != BPM_CLIENT_SUCCESS) {
+                continue;
+            }
+
+            DBE_DEBUG (DBG_LIB_CLIENT | DBG_LVL_TRACE, "[libclient] bpm_full_acq_multi: "
+                    "Acquisition of %s is done\n", services[i]);
+            err = bpm_acq_get_curve (self, services[i], &acq_trans[i]);
+            ASSERT_TEST(err == BPM_CLIENT_SUCCESS, "bpm_full_acq_multi: "
+                    "Could not read a curve", err_acq_get_curve);
+
+            pending[i] = false;
+            num_pending--;
+            read_any = true;
+        }
+
+        if (!read_any) {
+            ASSERT_TEST(time(NULL) - start < timeout, "bpm_full_acq_multi: "
+                    "Acquisitions were not completed in time", err_timeout,
+                    BPM_CLIENT_ERR_TIMEOUT);
+            usleep (1000);
+        }
+    }
+
+err_timeout:
+err_acq_get_curve:
+bpm_zctx_interrupted:
+err_acq_start:
+    free (pending);
+err_pending_alloc:
+    return err;
+}
+
+static bpm_client_err_e _bpm_acq_get_shot_data_block (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans, uint32_t shot)
+{
+    uint32_t write_val[sizeof(uint32_t)*3] = {0};
+    *write_val = acq_trans->req.chan;
+    *(write_val+4) = shot;
+    *(write_val+8) = acq_trans->block.idx;
+
+    smio_acq_data_block_t read_val[1];
+
+    /* Sent Message is:
+     * frame 0: operation code
+     * frame 1: channel
+     * frame 2: shot required
+     * frame 3: block required */
+
+    const disp_op_t* func = bpm_func_translate(ACQ_NAME_GET_SHOT_DATA_BLOCK);
+    bpm_client_err_e err = bpm_func_exec(self, func, service, write_val, (uint32_t *) read_val);
+
+    /* Check if any error ocurred */
+    ASSERT_TEST(err == BPM_CLIENT_SUCCESS,
+            "bpm_acq_get_shot_data_block: Data block was not acquired",
+            err_get_data_block, BPM_CLIENT_ERR_SERVER);
+
+    /* Data size effectively returned */
+    uint32_t read_size = (acq_trans->block.data_size < read_val->valid_bytes) ?
+        acq_trans->block.data_size : read_val->valid_bytes;
+
+    /* Copy message contents to user */
+    memcpy (acq_trans->block.data, read_val->data, read_size);
+
+    /* Inform user about the number of bytes effectively copied */
+    acq_trans->block.bytes_read = read_size;
+
+err_get_data_block:
+    return err;
+}
+
+/* Samples of all of the shots of a request */
+static uint32_t _bpm_acq_num_samples (const acq_req_t *acq_req)
+{
+    uint32_t num_shots = (acq_req->num_shots == 0) ? 1 : acq_req->num_shots;
+    return (acq_req->num_samples + acq_req->num_samples_post) * num_shots;
+}
+
+/* Read a curve, block by block, deinterleaved by the server. Block n holds
+ * the columns of its own samples only, so each column of it is copied to
+ * where it belongs in the column of the whole curve */
+static bpm_client_err_e _bpm_acq_get_soa_curve (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans)
+{
+    assert (self);
+    assert (service);
+    assert (acq_trans);
+    assert (acq_trans->block.data);
+
+    bpm_client_err_e err = BPM_CLIENT_SUCCESS;
+    uint32_t sample_size = self->acq_chan[acq_trans->req.chan].sample_size;
+    uint32_t comp_size = sample_size / SMIO_ACQ_NUM_COMP;
+    uint32_t block_samples = BLOCK_SIZE / sample_size;
+
+    /* Samples of each column */
+    uint32_t num_samples = _bpm_acq_num_samples (&acq_trans->req);
+    if (num_samples > acq_trans->block.data_size / sample_size) {
+        num_samples = acq_trans->block.data_size / sample_size;
+    }
+    DBE_DEBUG (DBG_LIB_CLIENT | DBG_LVL_TRACE, "[libclient] bpm_get_soa_curve: "
+            "num_samples = %u\n", num_samples);
+
+    /* Save the original buffer for later */
+    uint8_t *curve = (uint8_t *) acq_trans->block.data;
+    uint32_t data_size = acq_trans->block.data_size;
+    uint32_t total_bread = 0;
+
+    uint8_t *block = (uint8_t *) zmalloc (BLOCK_SIZE);
+    ASSERT_ALLOC(block, err_block_alloc, BPM_CLIENT_ERR_ALLOC);
+    acq_trans->block.data = (uint32_t *) block;
+    acq_trans->block.data_size = BLOCK_SIZE;
+
+    for (uint32_t block_n = 0; block_n*block_samples < num_samples; block_n++) {
+        if (zctx_interrupted) {
+            err = BPM_CLIENT_INT;
+            goto bpm_zctx_interrupted;
+        }
+
+        acq_trans->block.idx = block_n;
+        err = _bpm_acq_get_data_block (self, service, acq_trans);
+        ASSERT_TEST(err == BPM_CLIENT_SUCCESS,
+                "_bpm_acq_get_data_block failed. block_n is probably out of range",
+                err_bpm_get_data_block);
+
+        /* The server might have aligned the curve to more samples than
+         * requested */
+        uint32_t first_sample = block_n*block_samples;
+        uint32_t block_n_samples = acq_trans->block.bytes_read / sample_size;
+        uint32_t copy_samples = num_samples - first_sample;
+        if (copy_samples > block_n_samples) {
+            copy_samples = block_n_samples;
+        }
+
+        for (uint32_t i = 0; i < SMIO_ACQ_NUM_COMP; i++) {
+            memcpy (curve + (i*num_samples + first_sample)*comp_size,
+                    block + i*block_n_samples*comp_size, copy_samples*comp_size);
+        }
+        total_bread += copy_samples*sample_size;
+
+        DBE_DEBUG (DBG_LIB_CLIENT | DBG_LVL_TRACE, "[libclient] bpm_get_soa_curve: "
+                "Total bytes read up to now: %u\n", total_bread);
+
+        /* A short block is the last one */
+        if (block_n_samples < block_samples) {
+            break;
+        }
+    }
+
+    DBE_DEBUG (DBG_LIB_CLIENT | DBG_LVL_TRACE, "[libclient] bpm_get_soa_curve: "
+            "Data curve of %u bytes was successfully acquired\n", total_bread);
+
+err_bpm_get_data_block:
+bpm_zctx_interrupted:
+    free (block);
+    /* Return to client the total number of bytes read */
+    acq_trans->block.data = (uint32_t *) curve;
+    acq_trans->block.data_size = data_size;
+    acq_trans->block.bytes_read = total_bread;
+err_block_alloc:
+    return err;
+}
+
+/* Streaming functions */
+bpm_client_err_e bpm_acq_stream_start (bpm_client_t *self, char *service,
+        uint32_t chan, uint32_t num_samples)
+{
+    assert (self);
+    assert (service);
+
+    uint32_t write_val[sizeof(uint32_t)*2] = {0};
+    *write_val = chan;
+    *(write_val+4) = num_samples;
+
+    /* Sent Message is:
+     * frame 0: operation code
+     * frame 1: channel
+     * frame 2: number of samples of the ring */
+    const disp_op_t* func = bpm_func_translate(ACQ_NAME_STREAM_START);
+    bpm_client_err_e err = bpm_func_exec(self, func, service, write_val, NULL);
+
+    /* Check if any error ocurred */
+    ASSERT_TEST(err == BPM_CLIENT_SUCCESS,
+            "bpm_acq_stream_start: Stream could not be started",
+            err_stream_start, BPM_CLIENT_ERR_SERVER);
+
+err_stream_start:
+    return err;
+}
+
+bpm_client_err_e bpm_acq_stream_stop (bpm_client_t *self, char *service)
+{
+    assert (self);
+    assert (service);
+
+    const disp_op_t* func = bpm_func_translate(ACQ_NAME_STREAM_STOP);
+    bpm_client_err_e err = bpm_func_exec(self, func, service, NULL, NULL);
+
+    /* Check if any error ocurred */
+    ASSERT_TEST(err == BPM_CLIENT_SUCCESS,
+            "bpm_acq_stream_stop: Stream could not be stopped",
+            err_stream_stop, BPM_CLIENT_ERR_SERVER);
+
+err_stream_stop:
+    return err;
+}
+
+bpm_client_err_e bpm_acq_get_decim_curve (bpm_client_t *self, char *service,
+        uint32_t chan, uint32_t num_buckets, smio_acq_decim_curve_t *curve)
+{
+    assert (self);
+    assert (service);
+    assert (curve);
+
+    uint32_t write_val[sizeof(uint32_t)*2] = {0};
+    *write_val = chan;
+    *(write_val+4) = num_buckets;
+
+    /* Sent Message is:
+     * frame 0: operation code
+     * frame 1: channel
+     * frame 2: number of buckets */
+    const disp_op_t* func = bpm_func_translate(ACQ_NAME_GET_DECIM_CURVE);
+    bpm_client_err_e err = bpm_func_exec(self, func, service, write_val,
+            (uint32_t *) curve);
+
+    /* Received Message is:
+     * frame 0: error code
+     * frame 1: data size
+     * frame 2: decimated curve, up to the last bucket returned */
+
+    /* Check if any error ocurred */
+    ASSERT_TEST(err == BPM_CLIENT_SUCCESS,
+            "bpm_acq_get_decim_curve: Could not get the decimated curve",
+            err_get_decim_curve, BPM_CLIENT_ERR_SERVER);
+
+    DBE_DEBUG (DBG_LIB_CLIENT | DBG_LVL_TRACE, "[libclient] bpm_acq_get_decim_curve: "
+            "%u samples in %u buckets\n", curve->num_samples, curve->num_buckets);
+
+err_get_decim_curve:
+    return err;
+}
+
+bpm_client_err_e bpm_acq_get_pos_curve (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans)
+{
+    return _bpm_acq_get_pos_curve (self, service, acq_trans,
+            ACQ_NAME_GET_POS_DATA_BLOCK, 0);
+}
+
+bpm_client_err_e bpm_acq_get_ds_curve (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans, uint32_t mode)
+{
+    return _bpm_acq_get_pos_curve (self, service, acq_trans,
+            ACQ_NAME_GET_DS_DATA_BLOCK, mode);
+}
+
+bpm_client_err_e bpm_acq_wait_gen (bpm_client_t *self, char *service,
+        uint32_t chan, uint32_t min_gen, uint32_t *gen, int timeout)
+{
+    assert (self);
+    assert (service);
+    assert (gen);
+
+    /* Sent Message is:
+     * frame 0: operation code
+     * frame 1: channel
+     * frame 2: generation already known */
+    uint32_t write_val[sizeof(uint32_t)*2] = {0};
+    *write_val = chan;
+    *(write_val+4) = min_gen;
+
+    return func_polling (self, ACQ_NAME_GET_GEN, service, write_val, gen,
+            timeout);
+}
+
+/* Blocks of positions, from ACQ_NAME_GET_POS_DATA_BLOCK or
+ * ACQ_NAME_GET_DS_DATA_BLOCK, which ignores "mode" */
+static bpm_client_err_e _bpm_acq_get_pos_curve (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans, char *name, uint32_t mode)
+{
+    assert (self);
+    assert (service);
+    assert (acq_trans);
+    assert (acq_trans->block.data);
+
+    bpm_client_err_e err = BPM_CLIENT_SUCCESS;
+    uint32_t pos_sample_size = SMIO_ACQ_NUM_COMP*sizeof (double);
+
+    /* Samples that fit the buffer */
+    uint32_t num_samples = _bpm_acq_num_samples (&acq_trans->req);
+    if (num_samples > acq_trans->block.data_size / pos_sample_size) {
+        num_samples = acq_trans->block.data_size / pos_sample_size;
+    }
+
+    uint32_t write_val[sizeof(uint32_t)*3] = {0};
+    *write_val = acq_trans->req.chan;
+    *(write_val+8) = mode;
+
+    smio_acq_data_block_t *read_val = zmalloc (sizeof (*read_val));
+    ASSERT_ALLOC(read_val, err_read_val_alloc, BPM_CLIENT_ERR_ALLOC);
+
+    const disp_op_t* func = bpm_func_translate(name);
+    uint8_t *data = (uint8_t *) acq_trans->block.data;
+    uint32_t total_bread = 0;
+
+    for (uint32_t block_n = 0; block_n*SMIO_ACQ_POS_BLOCK_SAMPLES < num_samples;
+            block_n++) {
+        if (zctx_interrupted) {
+            err = BPM_CLIENT_INT;
+            goto bpm_zctx_interrupted;
+        }
+
+        /* Sent Message is:
+         * frame 0: operation code
+         * frame 1: channel
+         * frame 2: block required
+         * frame 3: position computation, for ACQ_NAME_GET_DS_DATA_BLOCK */
+        *(write_val+4) = block_n;
+        err = bpm_func_exec(self, func, service, write_val, (uint32_t *) read_val);
+
+        /* Received Message is:
+         * frame 0: error code
+         * frame 1: data size
+         * frame 2: data block, in doubles */
+
+        /* Check if any error ocurred */
+        ASSERT_TEST(err == BPM_CLIENT_SUCCESS,
+                "_bpm_acq_get_pos_curve: Could not get the positions",
+                err_get_pos_block, BPM_CLIENT_ERR_SERVER);
+
+        uint32_t read_size = num_samples*pos_sample_size - total_bread;
+        if (read_size > read_val->valid_bytes) {
+            read_size = read_val->valid_bytes;
+        }
+
+        memcpy (data + total_bread, read_val->data, read_size);
+        total_bread += read_size;
+
+        DBE_DEBUG (DBG_LIB_CLIENT | DBG_LVL_TRACE, "[libclient] _bpm_acq_get_pos_curve: "
+                "Total bytes read up to now: %u\n", total_bread);
+
+        /* A short block is the last one */
+        if (read_val->valid_bytes < SMIO_ACQ_POS_BLOCK_SAMPLES*pos_sample_size) {
+            break;
+        }
+    }
+
+err_get_pos_block:
+bpm_zctx_interrupted:
+    acq_trans->block.bytes_read = total_bread;
+    free (read_val);
+err_read_val_alloc:
+    return err;
+}
+
+bpm_client_err_e bpm_acq_stream_status (bpm_client_t *self, char *service,
+        smio_acq_stream_status_t *status)
+{
+    assert (self);
+    assert (service);
+    assert (status);
+
+    /* Received Message is:
+     * frame 0: error code
+     * frame 1: data size
+     * frame 2: stream status */
+    const disp_op_t* func = bpm_func_translate(ACQ_NAME_STREAM_STATUS);
+    bpm_client_err_e err = bpm_func_exec(self, func, service, NULL,
+            (uint32_t *) status);
+
+    /* Check if any error ocurred */
+    ASSERT_TEST(err == BPM_CLIENT_SUCCESS,
+            "bpm_acq_stream_status: Could not get the stream status",
+            err_stream_status, BPM_CLIENT_ERR_SERVER);
+
+err_stream_status:
+    return err;
+}
+
+bpm_acq_stream_t *bpm_acq_stream_subscribe (bpm_client_t *self, char *service)
+{
+    assert (self);
+    assert (service);
+
+    /* The server binds the stream endpoint when it is first started */
+    smio_acq_stream_status_t status;
+    bpm_client_err_e err = bpm_acq_stream_status (self, service, &status);
+    ASSERT_TEST(err == BPM_CLIENT_SUCCESS, "Could not get the stream endpoint",
+            err_stream_status);
+    status.endpoint [sizeof (status.endpoint)-1] = '\0';
+    ASSERT_TEST(status.endpoint [0] != '\0', "Stream was never started",
+            err_stream_status);
+
+    bpm_acq_stream_t *stream = (bpm_acq_stream_t *) zmalloc (sizeof *stream);
+    ASSERT_ALLOC(stream, err_stream_alloc);
+    stream->ctx = zctx_new ();
+    ASSERT_ALLOC(stream->ctx, err_ctx_alloc);
+    stream->sub = zsocket_new (stream->ctx, ZMQ_SUB);
+    ASSERT_ALLOC(stream->sub, err_sub_alloc);
+
+    zsocket_set_subscribe (stream->sub, "");
+    int rc = zsocket_connect (stream->sub, "%s", status.endpoint);
+    ASSERT_TEST(rc == 0, "Could not connect to the stream endpoint",
+            err_connect);
+
+    return stream;
+
+err_connect:
+err_sub_alloc:
+    zctx_destroy (&stream->ctx);
+err_ctx_alloc:
+    free (stream);
+err_stream_alloc:
+err_stream_status:
+    return NULL;
+}
+
+void bpm_acq_stream_unsubscribe (bpm_acq_stream_t **self_p)
+{
+    assert (self_p);
+
+    if (*self_p) {
+        bpm_acq_stream_t *self = *self_p;
+
+        zctx_destroy (&self->ctx);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+bpm_client_err_e bpm_acq_stream_recv (bpm_acq_stream_t *self,
+        smio_acq_stream_hdr_t *hdr, void *data, uint32_t *data_size,
+        int timeout)
+{
+    assert (self);
+    assert (hdr);
+    assert (data);
+    assert (data_size);
+
+    bpm_client_err_e err = BPM_CLIENT_SUCCESS;
+    zmsg_t *msg = NULL;
+
+    if (!zsocket_poll (self->sub, timeout)) {
+        err = zctx_interrupted ? BPM_CLIENT_INT : BPM_CLIENT_ERR_TIMEOUT;
+        goto err_poll;
+    }
+
+    /* Message is:
+     * frame 0: header
+     * frame 1: samples */
+    msg = zmsg_recv (self->sub);
+    ASSERT_TEST(msg != NULL, "Stream message received is NULL", err_null_msg,
+            BPM_CLIENT_INT);
+    ASSERT_TEST(zmsg_size (msg) == 2, "Unexpected stream message received",
+            err_msg, BPM_CLIENT_ERR_MSG);
+
+    zframe_t *hdr_frm = zmsg_first (msg);
+    zframe_t *data_frm = zmsg_next (msg);
+    ASSERT_TEST(zframe_size (hdr_frm) == sizeof (*hdr),
+            "Wrong stream header size", err_msg, BPM_CLIENT_ERR_MSG);
+
+    memcpy (hdr, zframe_data (hdr_frm), sizeof (*hdr));
+    if (*data_size > zframe_size (data_frm)) {
+        *data_size = zframe_size (data_frm);
+    }
+    memcpy (data, zframe_data (data_frm), *data_size);
+
+err_msg:
+    zmsg_destroy (&msg);
+err_null_msg:
+err_poll:
+    return err;
+}
+
+/* Trigger functions */
+PARAM_FUNC_CLIENT_WRITE(acq_trig)
+{
+    return param_client_write (self, service, ACQ_OPCODE_CFG_TRIG, acq_trig);
+}
+
+PARAM_FUNC_CLIENT_READ(acq_trig)
+{
+    return param_client_read (self, service, ACQ_OPCODE_CFG_TRIG, acq_trig);
+}
+
+PARAM_FUNC_CLIENT_WRITE(acq_hw_trig_pol)
+{
+    return param_client_write (self, service, ACQ_OPCODE_HW_TRIG_POL, acq_hw_trig_pol);
+}
+
+PARAM_FUNC_CLIENT_READ(acq_hw_trig_pol)
+{
+    return param_client_read (self, service, ACQ_OPCODE_HW_TRIG_POL, acq_hw_trig_pol);
+}
+
+PARAM_FUNC_CLIENT_WRITE(acq_hw_data_trig_sel)
+{
+    return param_client_write (self, service, ACQ_OPCODE_HW_DATA_TRIG_SEL, acq_hw_data_trig_sel);
+}
+
+PARAM_FUNC_CLIENT_READ(acq_hw_data_trig_sel)
+{
+    return param_client_read (self, service, ACQ_OPCODE_HW_DATA_TRIG_SEL, acq_hw_data_trig_sel);
+}
+
+PARAM_FUNC_CLIENT_WRITE(acq_hw_data_trig_thres)
+{
+    return param_client_write (self, service, ACQ_OPCODE_HW_DATA_TRIG_THRES, acq_hw_data_trig_thres);
+}
+
+PARAM_FUNC_CLIENT_READ(acq_hw_data_trig_thres)
+{
+    return param_client_read (self, service, ACQ_OPCODE_HW_DATA_TRIG_THRES, acq_hw_data_trig_thres);
+}
+
+PARAM_FUNC_CLIENT_WRITE(acq_hw_trig_dly)
+{
+    return param_client_write (self, service, ACQ_OPCODE_HW_TRIG_DLY, acq_hw_trig_dly);
+}
+
+PARAM_FUNC_CLIENT_READ(acq_hw_trig_dly)
+{
+    return param_client_read (self, service, ACQ_OPCODE_HW_TRIG_DLY, acq_hw_trig_dly);
+}
+
+PARAM_FUNC_CLIENT_WRITE(acq_sw_trig)
+{
+    return param_client_write (self, service, ACQ_OPCODE_SW_TRIG, acq_sw_trig);
+}
+
+PARAM_FUNC_CLIENT_WRITE(acq_fsm_stop)
+{
+    return param_client_write (self, service, ACQ_OPCODE_FSM_STOP, acq_fsm_stop);
+}
+
+PARAM_FUNC_CLIENT_WRITE(acq_pingpong)
+{
+    return param_client_write (self, service, ACQ_OPCODE_PINGPONG, acq_pingpong);
+}
+
+PARAM_FUNC_CLIENT_READ(acq_pingpong)
+{
+    return param_client_read (self, service, ACQ_OPCODE_PINGPONG, acq_pingpong);
+}
+
 /**************** DSP SMIO Functions ****************/
 
 /* Kx functions */
@@ -1864,6 +2601,123 @@ PARAM_FUNC_CLIENT_READ(rffe_sw_lvl)
             rffe_sw_lvl);
 }
 
+/**************** Generic SMIO Functions ****************/
+
+bpm_client_err_e bpm_get_smio_op_stats (bpm_client_t *self, char *service,
+        uint32_t opcode, smio_op_stats_t *op_stats)
+{
+    assert (self);
+    assert (service);
+    assert (op_stats);
+
+    /* Sent Message is:
+     * frame 0: operation code
+     * frame 1: first opcode to look for */
+    const disp_op_t* func = bpm_func_translate(SMIO_STATS_NAME_GET_OP_STATS);
+    bpm_client_err_e err = bpm_func_exec(self, func, service, &opcode,
+            (uint32_t *) op_stats);
+
+    /* Received Message is:
+     * frame 0: error code
+     * frame 1: data size
+     * frame 2: operation statistics */
+
+    /* Check if any error ocurred */
+    ASSERT_TEST(err == BPM_CLIENT_SUCCESS,
+            "bpm_get_smio_op_stats: No more operations or could not get statistics",
+            err_get_op_stats, BPM_CLIENT_ERR_SERVER);
+
+err_get_op_stats:
+    return err;
+}
+
+bpm_client_err_e bpm_set_smio_op_coalesce_window (bpm_client_t *self,
+        char *service, uint32_t opcode, uint32_t window_us)
+{
+    assert (self);
+    assert (service);
+
+    uint32_t write_val[sizeof(uint32_t)*2] = {0};
+    *write_val = opcode;
+    *(write_val+4) = window_us;
+
+    /* Sent Message is:
+     * frame 0: operation code
+     * frame 1: opcode of the operation to be configured
+     * frame 2: freshness window, in us */
+    const disp_op_t* func = bpm_func_translate(SMIO_COALESCE_NAME_SET_OP_WINDOW);
+    bpm_client_err_e err = bpm_func_exec(self, func, service, write_val, NULL);
+
+    /* Received Message is:
+     * frame 0: error code */
+
+    /* Check if any error ocurred */
+    ASSERT_TEST(err == BPM_CLIENT_SUCCESS,
+            "bpm_set_smio_op_coalesce_window: Could not set freshness window",
+            err_set_window, BPM_CLIENT_ERR_SERVER);
+
+err_set_window:
+    return err;
+}
+
+bpm_client_err_e bpm_smio_reload (bpm_client_t *self, char *service,
+        smio_reload_report_t *report)
+{
+    assert (self);
+    assert (service);
+
+    bpm_client_err_e err = BPM_CLIENT_SUCCESS;
+
+    /* The reload is served by the DEVIO owning the SMIO, which is exported
+     * as the SMIO service name minus its last component, e.g.
+     * "BPM0:DEVIO:DSP0" is reloaded through "BPM0:DEVIO" */
+    char *smio_name = strrchr (service, ':');
+    ASSERT_TEST(smio_name != NULL && smio_name != service,
+            "bpm_smio_reload: Invalid SMIO service name",
+            err_inv_service, BPM_CLIENT_ERR_INV_PARAM);
+
+    size_t devio_service_len = smio_name - service;
+    char *devio_service = strndup (service, devio_service_len);
+    ASSERT_ALLOC(devio_service, err_devio_service_alloc, BPM_CLIENT_ERR_ALLOC);
+
+    /* The SMIO is identified by its full service name, always sent as a
+     * zero-padded fixed size argument */
+    uint32_t smio_key [SMIO_RELOAD_SERVICE_LEN/sizeof (uint32_t)] = {0};
+    ASSERT_TEST(strlen (service) < sizeof (smio_key),
+            "bpm_smio_reload: SMIO service name too long",
+            err_service_len, BPM_CLIENT_ERR_INV_PARAM);
+    strncpy ((char *) smio_key, service, sizeof (smio_key)-1);
+
+    /* Sent Message is:
+     * frame 0: operation code
+     * frame 1: SMIO service name */
+    smio_reload_report_t reload_report;
+    const disp_op_t* func = bpm_func_translate(SMIO_RELOAD_NAME_RELOAD);
+    err = bpm_func_exec(self, func, devio_service, smio_key,
+            (uint32_t *) &reload_report);
+
+    /* Received Message is:
+     * frame 0: error code
+     * frame 1: size of the report
+     * frame 2: report */
+
+    /* Check if any error ocurred */
+    ASSERT_TEST(err == BPM_CLIENT_SUCCESS,
+            "bpm_smio_reload: Could not reload SMIO",
+            err_reload, BPM_CLIENT_ERR_SERVER);
+
+    if (report != NULL) {
+        *report = reload_report;
+    }
+
+err_reload:
+err_service_len:
+    free (devio_service);
+err_devio_service_alloc:
+err_inv_service:
+    return err;
+}
+
 /**************** Helper Function ****************/
 
 static bpm_client_err_e _func_polling (bpm_client_t *self, char *name, char *service, uint32_t *input, uint32_t *output, int timeout);
@@ -21,6 +21,10 @@ struct _acq_chan_t;
 struct _bpm_client_t {
     mdp_client_t *mdp_client;                   /* Majordomo client instance */
     const struct _acq_chan_t *acq_chan;         /* Acquisition buffer table */
+    uint32_t request_ttl_ms;                    /* Time-to-live of the requests.
+                                                   0 means no time-to-live */
+    uint64_t request_deadline_us;               /* Absolute deadline of the
+                                                   requests. 0 means none */
 };
 
 typedef struct _bpm_client_t bpm_client_t;
@@ -47,6 +51,25 @@ bpm_client_t *bpm_client_new_log_mode (char *broker_endp, int verbose,
  * server */
 void bpm_client_destroy (bpm_client_t **self_p);
 
+/* Set the time-to-live, in ms, of every request sent from now on. Requests
+ * still waiting to be served by the server when it expires are dropped
+ * and fail with BPM_CLIENT_ERR_EXPIRED, instead of delaying the fresh ones.
+ * The server counts it from the arrival of the request, so the time spent
+ * in the network and in the broker is not included.
+ * A zero ttl_ms (the default) disables it */
+void bpm_client_set_request_ttl (bpm_client_t *self, uint32_t ttl_ms);
+
+/* Same as bpm_client_set_request_ttl (), but with an absolute deadline, in
+ * us since the Epoch (CLOCK_REALTIME), applied to every request sent until
+ * it is changed. Each request is sent with the time left until then, as
+ * measured by the client clock. If both are set, the earliest one is used.
+ * A zero deadline_us (the default) disables it */
+void bpm_client_set_request_deadline (bpm_client_t *self, uint64_t deadline_us);
+
+/* Send a request to the service, preceded by the deadline frame if a
+ * time-to-live or a deadline is set. Used by all of the functions below */
+void bpm_client_send (bpm_client_t *self, char *service, zmsg_t **request);
+
 /* General function to execute all the other modules functions */
 bpm_client_err_e bpm_func_exec (bpm_client_t *self, const disp_op_t *func,
         char *service, uint32_t *input, uint32_t *output);
@@ -345,8 +368,15 @@ bpm_client_err_e bpm_set_si571_defaults (bpm_client_t *self, char *service,
 
 /* Acquistion request */
 struct _acq_req_t {
-    uint32_t num_samples;                       /* Number of samples */
+    uint32_t num_samples;                       /* Number of pre-trigger samples.
+                                                   All of them, if no trigger */
     uint32_t chan;                              /* Acquisition channel number */
+    uint32_t num_samples_post;                  /* Number of post-trigger samples.
+                                                   Must be 0 if no trigger */
+    uint32_t num_shots;                         /* Number of shots, one per trigger.
+                                                   0 is the same as 1. More than
+                                                   1 requires a trigger and
+                                                   post-trigger samples only */
 };
 
 typedef struct _acq_req_t acq_req_t;
@@ -358,6 +388,11 @@ struct _acq_block_t {
     uint32_t *data;                             /* Block or complete curve read */
     uint32_t data_size;                         /* data_out buffer size */
     uint32_t bytes_read;                        /* Number of bytes effectively read */
+    bool soa;                                   /* Deinterleave the samples: the
+                                                   SMIO_ACQ_NUM_COMP components of
+                                                   the N samples read come in as
+                                                   many columns of N components,
+                                                   one after the other */
 };
 
 typedef struct _acq_block_t acq_block_t;
@@ -405,7 +440,8 @@ bpm_client_err_e bpm_wait_data_acquire_timed (bpm_client_t *self, char *service,
  * acq_trans->req.channel.
  * Returns BPM_CLIENT_SUCCESS if the block was read or BPM_CLIENT_ERR_SERVER
  * otherwise. The data read is returned in acq_trans->block.data along with
- * the number of bytes effectivly read in acq_trans->block.bytes_read */
+ * the number of bytes effectivly read in acq_trans->block.bytes_read. With
+ * acq_trans->block.soa, the samples of the block come in columns */
 bpm_client_err_e bpm_get_data_block (bpm_client_t *self, char *service,
         acq_trans_t *acq_trans);
 
@@ -413,7 +449,11 @@ bpm_client_err_e bpm_get_data_block (bpm_client_t *self, char *service,
  * the the desired channel in acq_trans->req.channel.
  * Returns BPM_CLIENT_SUCCESS if the curve was read or BPM_CLIENT_ERR_SERVER
  * otherwise. The data read is returned in acq_trans->block.data along with
- * the number of bytes effectivly read in acq_trans->block.bytes_read */
+ * the number of bytes effectivly read in acq_trans->block.bytes_read. With
+ * acq_trans->block.soa, the server deinterleaves the samples and the whole
+ * curve comes in columns: the N samples read, N being the number of samples
+ * requested or as many as fit acq_trans->block.data_size, whichever is the
+ * smallest, are in SMIO_ACQ_NUM_COMP columns of N components each */
 bpm_client_err_e bpm_get_curve (bpm_client_t *self, char *service,
         acq_trans_t *acq_trans, int timeout, bool new_acq);
 
@@ -430,9 +470,92 @@ bpm_client_err_e bpm_acq_check (bpm_client_t *self, char *service);
 bpm_client_err_e bpm_acq_get_data_block (bpm_client_t *self, char *service, acq_trans_t *acq_trans);
 
 /* New version of bpm_get_curve that uses the general function caller
- * bpm_func_exec */
+ * bpm_func_exec. acq_trans->block.soa works as in bpm_get_curve */
 bpm_client_err_e bpm_acq_get_curve (bpm_client_t *self, char *service, acq_trans_t *acq_trans);
 
+/* Get the curve of a single shot from a previously completed multi-shot
+ * acquisition. bpm_acq_get_curve gets all of the shots, one after the other.
+ * Returns BPM_CLIENT_SUCCESS if the curve was read or BPM_CLIENT_ERR_SERVER
+ * otherwise. The data read is returned in acq_trans->block.data along with
+ * the number of bytes effectivly read in acq_trans->block.bytes_read */
+bpm_client_err_e bpm_acq_get_shot_curve (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans, uint32_t shot);
+
+/* Get the curve of a previously completed acquisition of channel "chan",
+ * decimated to "num_buckets" buckets (up to SMIO_ACQ_DECIM_MAX_BUCKETS) of
+ * consecutive samples. For each bucket, the server sends the minimum,
+ * maximum and mean of each component of the samples instead of the samples
+ * themselves. Returns BPM_CLIENT_SUCCESS if the curve was read or
+ * BPM_CLIENT_ERR_SERVER otherwise. Only curve->num_buckets buckets are
+ * filled */
+bpm_client_err_e bpm_acq_get_decim_curve (bpm_client_t *self, char *service,
+        uint32_t chan, uint32_t num_buckets, smio_acq_decim_curve_t *curve);
+
+/* Get the curve of a previously completed acquisition of the position
+ * channel acq_trans->req.chan, calibrated by the server with the KX, KY and
+ * KSUM in use when the acquisition was started. Each sample is made of
+ * SMIO_ACQ_NUM_COMP doubles: X and Y in nm, Q and SUM. Returns
+ * BPM_CLIENT_SUCCESS if the curve was read or BPM_CLIENT_ERR_SERVER otherwise.
+ * The samples are returned in acq_trans->block.data along with the number
+ * of bytes effectively read in acq_trans->block.bytes_read */
+bpm_client_err_e bpm_acq_get_pos_curve (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans);
+
+/* Get the positions computed by the server from the curve of a previously
+ * completed acquisition of the amplitude channel acq_trans->req.chan (ADC or
+ * amplitudes), with the delta over sum (mode = ACQ_DS_MODE_DS) or the
+ * partial delta over sum (mode = ACQ_DS_MODE_PDS) of the A, B, C and D
+ * amplitudes. KX, KY, KSUM and the threshold are the ones in use when the
+ * acquisition was started. The samples are returned as with
+ * bpm_acq_get_pos_curve. Returns BPM_CLIENT_SUCCESS if the curve was read
+ * or BPM_CLIENT_ERR_SERVER otherwise */
+bpm_client_err_e bpm_acq_get_ds_curve (bpm_client_t *self, char *service,
+        acq_trans_t *acq_trans, uint32_t mode);
+
+/* Wait up to "timeout" seconds for an acquisition of channel "chan" newer
+ * than generation "min_gen" to be completed, whoever started it. The server
+ * keeps the last completed acquisition of each channel in memory, so any
+ * number of clients can then read it with bpm_acq_get_curve, and the other
+ * curve readers, without reading it from the DDR3 again. Generations start
+ * at 1, so "min_gen" = 0 waits for any acquisition. The generation
+ * completed is returned in "gen". Returns BPM_CLIENT_SUCCESS if there is
+ * one or BPM_CLIENT_ERR_TIMEOUT otherwise */
+bpm_client_err_e bpm_acq_wait_gen (bpm_client_t *self, char *service,
+        uint32_t chan, uint32_t min_gen, uint32_t *gen, int timeout);
+
+/* Streaming acquisition. Instead of discrete acquisitions, the server keeps
+ * the core writing channel "chan" in a ring of "num_samples" samples and
+ * publishes the new samples to the subscribers as they land. No other
+ * acquisition can be done by the same ACQ service while the stream runs.
+ * All of the functions returns BPM_CLIENT_SUCCESS if ok or error (see
+ * bpm_client_err.h for all possible errors) */
+bpm_client_err_e bpm_acq_stream_start (bpm_client_t *self, char *service,
+        uint32_t chan, uint32_t num_samples);
+bpm_client_err_e bpm_acq_stream_stop (bpm_client_t *self, char *service);
+/* Stream state, counters and endpoint */
+bpm_client_err_e bpm_acq_stream_status (bpm_client_t *self, char *service,
+        smio_acq_stream_status_t *status);
+
+/* Subscriber of the stream of an ACQ service */
+struct _bpm_acq_stream_t {
+    zctx_t *ctx;                                /* Our own context */
+    void *sub;                                  /* SUB socket */
+};
+
+typedef struct _bpm_acq_stream_t bpm_acq_stream_t;
+
+/* Subscribe to the stream of the ACQ service. It may be started before or
+ * after subscribing. Returns NULL on error */
+bpm_acq_stream_t *bpm_acq_stream_subscribe (bpm_client_t *self, char *service);
+void bpm_acq_stream_unsubscribe (bpm_acq_stream_t **self_p);
+/* Receive the next message of the stream, waiting up to "timeout" msec
+ * (-1 waits forever). Up to *data_size bytes of samples are copied to data
+ * and *data_size is set to the number of bytes copied. Returns
+ * BPM_CLIENT_ERR_TIMEOUT if nothing arrived in time */
+bpm_client_err_e bpm_acq_stream_recv (bpm_acq_stream_t *self,
+        smio_acq_stream_hdr_t *hdr, void *data, uint32_t *data_size,
+        int timeout);
+
 /* Perform a full acquisition process (Acquisition request, checking if
  * its done and receiving the full curve).
  * Returns BPM_CLIENT_SUCCESS if the curve was read or BPM_CLIENT_ERR_SERVER
@@ -440,6 +563,68 @@ bpm_client_err_e bpm_acq_get_curve (bpm_client_t *self, char *service, acq_trans
  * the number of bytes effectivly read in acq_trans->block.bytes_read */
 bpm_client_err_e bpm_full_acq (bpm_client_t *self, char *service, acq_trans_t *acq_trans, int timeout);
 
+/* Perform "num_acqs" full acquisitions at the same time, one per ACQ service
+ * (e.g. one per acquisition core of an AFCv3). All of them are started
+ * first, then each curve is read as soon as its acquisition is done, while
+ * the others are still going. acq_trans[i] is the acquisition of services[i].
+ * The timeout is in seconds, -1 waits forever.
+ * Returns BPM_CLIENT_SUCCESS if all of the curves were read or error
+ * otherwise (see bpm_client_err.h for all possible errors) */
+bpm_client_err_e bpm_full_acq_multi (bpm_client_t *self, char **services,
+        acq_trans_t *acq_trans, uint32_t num_acqs, int timeout);
+
+/* Acquisition trigger functions. The trigger type (ACQ_TRIG_SKIP,
+ * ACQ_TRIG_EXTERNAL, ACQ_TRIG_DATA_DRIVEN or ACQ_TRIG_SOFTWARE) applies to
+ * the next acquisitions. With a trigger, the curve holds acq_req->num_samples
+ * before it and acq_req->num_samples_post after it, in time order.
+ * All of the functions returns BPM_CLIENT_SUCCESS if the parameter was
+ * correctly set or error (see bpm_client_err.h for all possible errors) */
+bpm_client_err_e bpm_set_acq_trig (bpm_client_t *self, char *service,
+        uint32_t acq_trig);
+bpm_client_err_e bpm_get_acq_trig (bpm_client_t *self, char *service,
+        uint32_t *acq_trig);
+
+/* Polarity of the hardware (external or data-driven) trigger */
+bpm_client_err_e bpm_set_acq_hw_trig_pol (bpm_client_t *self, char *service,
+        uint32_t acq_hw_trig_pol);
+bpm_client_err_e bpm_get_acq_hw_trig_pol (bpm_client_t *self, char *service,
+        uint32_t *acq_hw_trig_pol);
+
+/* Which component of the acquired samples the data-driven trigger looks at */
+bpm_client_err_e bpm_set_acq_hw_data_trig_sel (bpm_client_t *self, char *service,
+        uint32_t acq_hw_data_trig_sel);
+bpm_client_err_e bpm_get_acq_hw_data_trig_sel (bpm_client_t *self, char *service,
+        uint32_t *acq_hw_data_trig_sel);
+
+/* Threshold of the data-driven trigger */
+bpm_client_err_e bpm_set_acq_hw_data_trig_thres (bpm_client_t *self, char *service,
+        uint32_t acq_hw_data_trig_thres);
+bpm_client_err_e bpm_get_acq_hw_data_trig_thres (bpm_client_t *self, char *service,
+        uint32_t *acq_hw_data_trig_thres);
+
+/* Delay between the hardware trigger and the first post-trigger sample */
+bpm_client_err_e bpm_set_acq_hw_trig_dly (bpm_client_t *self, char *service,
+        uint32_t acq_hw_trig_dly);
+bpm_client_err_e bpm_get_acq_hw_trig_dly (bpm_client_t *self, char *service,
+        uint32_t *acq_hw_trig_dly);
+
+/* Fire the software trigger */
+bpm_client_err_e bpm_set_acq_sw_trig (bpm_client_t *self, char *service,
+        uint32_t acq_sw_trig);
+
+/* Stop an acquisition still waiting for its trigger */
+bpm_client_err_e bpm_set_acq_fsm_stop (bpm_client_t *self, char *service,
+        uint32_t acq_fsm_stop);
+
+/* Ping-pong mode (1 = on, 0 = off). The acquisitions alternate between two
+ * halves of the channel memory, so a new acquisition can be started as soon
+ * as bpm_acq_check reports the previous one done, and run while the previous
+ * curve is read. Each acquisition gets at most half of the channel memory */
+bpm_client_err_e bpm_set_acq_pingpong (bpm_client_t *self, char *service,
+        uint32_t acq_pingpong);
+bpm_client_err_e bpm_get_acq_pingpong (bpm_client_t *self, char *service,
+        uint32_t *acq_pingpong);
+
 /********************** DSP Functions ********************/
 
 /* K<direction> functions */
@@ -724,6 +909,37 @@ bpm_client_err_e bpm_set_rffe_sw_lvl (bpm_client_t *self, char *service,
 bpm_client_err_e bpm_get_rffe_sw_lvl (bpm_client_t *self, char *service,
         uint32_t *rffe_sw_lvl);
 
+/******************** Generic SMIO Functions ******************/
+
+/* Get the call, error and latency statistics of the first operation exported
+ * by the SMIO with opcode equal or greater than "opcode". To walk through all
+ * of the operations, start with opcode 0 and call it again with
+ * op_stats->opcode + 1 until it fails.
+ * Returns BPM_CLIENT_SUCCESS if ok and BPM_CLIENT_ERR_SERVER if there are
+ * no more operations or the server could not complete the request */
+bpm_client_err_e bpm_get_smio_op_stats (bpm_client_t *self, char *service,
+        uint32_t opcode, smio_op_stats_t *op_stats);
+
+/* Set the freshness window, in us, of a read-only operation exported by the
+ * SMIO. Identical read requests arriving within the window after a result
+ * was obtained are answered with that same result, without accessing the
+ * hardware. A zero window (the default) only shares a result among the
+ * requests that arrived while it was being obtained.
+ * Returns BPM_CLIENT_SUCCESS if ok and BPM_CLIENT_ERR_SERVER if the
+ * operation is not read-only or the window is out of range */
+bpm_client_err_e bpm_set_smio_op_coalesce_window (bpm_client_t *self,
+        char *service, uint32_t opcode, uint32_t window_us);
+
+/* Reload the SMIO exported as service, without disturbing the other SMIOs of
+ * the same DEVIO. The request is served by the DEVIO owning the SMIO, which
+ * waits for the SMIO to exit and spawns it again, applying its default
+ * values. If report is not NULL, it is filled with the time the SMIO took to
+ * exit and the time its service was down, both in us.
+ * Returns BPM_CLIENT_SUCCESS if the SMIO was reloaded and
+ * BPM_CLIENT_ERR_SERVER if the server could not complete the request */
+bpm_client_err_e bpm_smio_reload (bpm_client_t *self, char *service,
+        smio_reload_report_t *report);
+
 /* Helper Function */
 
 /* This function execute the given function *func in a disp_op_t
@@ -20,6 +20,7 @@ static const char *bpm_client_err [BPM_CLIENT_ERR_END] =
     [BPM_CLIENT_ERR_MSG]              = "Unexpected message",
     [BPM_CLIENT_ERR_INV_PARAM]        = "Invalid function parameters",
     [BPM_CLIENT_ERR_INV_FUNCTION]     = "Invalid function",
+    [BPM_CLIENT_ERR_EXPIRED]          = "Request expired before being served",
     [BPM_CLIENT_INT]                  = "Interrupt occured"
 };
 
@@ -10,6 +10,7 @@
 #include "bpm_client.h"
 #include "rw_param_client.h"
 #include "rw_param_codes.h"
+#include "sm_io_deadline_codes.h"
 
 /* Undef ASSERT_ALLOC to avoid conflicting with other ASSERT_ALLOC */
 #ifdef ASSERT_TEST
@@ -48,7 +49,7 @@ bpm_client_err_e param_client_send_gen_rw (bpm_client_t *self, char *service,
     zmsg_addmem (request, &rw, sizeof (rw));
     zmsg_addmem (request, param, size);
 
-    mdp_client_send (self->mdp_client, service, &request);
+    bpm_client_send (self, service, &request);
 
 err_send_msg_alloc:
 err_param_null:
@@ -99,6 +100,9 @@ bpm_client_err_e param_client_write_gen (bpm_client_t *self, char *service,
     ASSERT_TEST(err_code != NULL, "Could not receive error code", err_null_code,
             BPM_CLIENT_ERR_SERVER);
     /* Check for return code from server */
+    ASSERT_TEST(*(RW_REPLY_TYPE *) zframe_data(err_code) != SMIO_DEADLINE_EXPIRED,
+            "rw_param_client: parameter SET request expired",
+            err_set_param, BPM_CLIENT_ERR_EXPIRED);
     ASSERT_TEST(*(RW_REPLY_TYPE *) zframe_data(err_code) == RW_OK,
             "rw_param_client: parameter SET error, try again",
             err_set_param, BPM_CLIENT_ERR_AGAIN);
@@ -167,6 +171,9 @@ bpm_client_err_e param_client_read_gen (bpm_client_t *self, char *service,
     ASSERT_TEST(err_code != NULL, "Could not receive error code", err_null_code);
 
     /* Check for return code from server */
+    ASSERT_TEST(*(RW_REPLY_TYPE *) zframe_data(err_code) != SMIO_DEADLINE_EXPIRED,
+            "rw_param_client: parameter GET request expired",
+            err_error_code, BPM_CLIENT_ERR_EXPIRED);
     ASSERT_TEST(*(RW_REPLY_TYPE *) zframe_data(err_code) == RW_OK,
             "rw_param_client: parameter GET error, try again",
             err_error_code, BPM_CLIENT_ERR_AGAIN);
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ *
+ * Delta over sum test. Fixed A, B, C and D amplitudes, in the 16 and 32-bit
+ * layouts of the amplitude channels, go through acq_soa_deinterleave () and
+ * acq_ds_calc (), and the positions are checked against values worked out
+ * by hand from the formulas of sm_io_acq_ds.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sm_io_acq_ds.h"
+#include "sm_io_acq_soa.h"
+
+#define TEST_KX                     10000000        /* 10 mm, in nm */
+#define TEST_KY                     10000000
+#define TEST_KSUM                   (3 << 23)       /* 1.5 in FIX25_24 */
+#define TEST_DS_THRES               100
+/* Relative error allowed. Every expected value is exact or a ratio of
+ * small integers */
+#define TEST_TOL                    1e-12
+
+#define TEST_CHECK(test_boolean, ...)                                       \
+    do {                                                                    \
+        if (!(test_boolean)) {                                              \
+            fprintf (stderr, "[acq_ds_test] %s:%d: ", __FILE__, __LINE__);  \
+            fprintf (stderr, __VA_ARGS__);                                  \
+            fprintf (stderr, "\n");                                         \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+typedef struct {
+    int32_t amp [SMIO_ACQ_NUM_COMP];            /* A, B, C and D */
+    double ds [SMIO_ACQ_NUM_COMP];              /* X, Y, Q and SUM */
+    double pds [SMIO_ACQ_NUM_COMP];             /* Same, partial */
+} test_sample_t;
+
+/* 9 samples: more than a deinterleaving tile, and an odd number, so the
+ * scalar tails of both loops run as well */
+static const test_sample_t samples [] = {
+    /* Centered */
+    {{1000, 1000, 1000, 1000},
+        {0.0, 0.0, 0.0, 1.5*4000},
+        {0.0, 0.0, 0.0, 1.5*4000}},
+    /* Towards A and D: X = KX/2 */
+    {{3000, 1000, 1000, 3000},
+        {TEST_KX*0.5, 0.0, 0.0, 1.5*8000},
+        {TEST_KX*0.5, 0.0, 0.0, 1.5*8000}},
+    /* Towards A and B: Y = KY/3 */
+    {{2000, 2000, 1000, 1000},
+        {0.0, TEST_KY/3.0, 0.0, 1.5*6000},
+        {0.0, TEST_KY/3.0, 0.0, 1.5*6000}},
+    /* Skewed: Q = 1/2. The partial sums give X = Y = K/6 */
+    {{4000, 1000, 2000, 1000},
+        {TEST_KX*0.25, TEST_KY*0.25, 0.5, 1.5*8000},
+        {TEST_KX/6.0, TEST_KY/6.0, 0.5, 1.5*8000}},
+    /* SUM not above the threshold */
+    {{10, 20, 30, 5},
+        {0.0, 0.0, 0.0, 1.5*65},
+        {0.0, 0.0, 0.0, 1.5*65}},
+    /* A and C sum to 0, so there is no partial X or Y */
+    {{0, 3000, 0, 1000},
+        {-TEST_KX*0.5, TEST_KY*0.5, -1.0, 1.5*4000},
+        {0.0, 0.0, -1.0, 1.5*4000}},
+    /* A negative amplitude. Partial: (A-C)/(A+C) = -3, (D-B)/(D+B) = 1/7 */
+    {{-1000, 3000, 2000, 4000},
+        {-TEST_KX*0.25, -TEST_KY*0.5, -0.75, 1.5*8000},
+        {-TEST_KX*10.0/7.0, -TEST_KY*11.0/7.0, -0.75, 1.5*8000}},
+    /* No signal at all. 1/SUM is infinite and must not leak out */
+    {{0, 0, 0, 0},
+        {0.0, 0.0, 0.0, 0.0},
+        {0.0, 0.0, 0.0, 0.0}},
+    /* Full scale on A only. B and D sum to 0 */
+    {{32767, 0, 0, 0},
+        {TEST_KX, TEST_KY, 1.0, 1.5*32767},
+        {0.0, 0.0, 1.0, 1.5*32767}}
+};
+
+#define TEST_NUM_SAMPLES            (sizeof (samples)/sizeof (samples [0]))
+
+static unsigned int failures;
+
+static bool _test_close (double value, double expected)
+{
+    return fabs (value - expected) <= TEST_TOL * fabs (expected) ||
+        (expected == 0.0 && value == 0.0);
+}
+
+/* Interleave the amplitudes of every sample, with components of
+ * "comp_size" bytes, as the ACQ core writes them */
+static void _test_interleave (uint8_t *data, uint32_t comp_size)
+{
+    uint32_t i, j;
+    for (i = 0; i < TEST_NUM_SAMPLES; ++i) {
+        for (j = 0; j < SMIO_ACQ_NUM_COMP; ++j) {
+            uint8_t *comp = data + (i*SMIO_ACQ_NUM_COMP + j)*comp_size;
+            int32_t amp = samples [i].amp [j];
+
+            if (comp_size == sizeof (int16_t)) {
+                int16_t amp_16 = amp;
+                memcpy (comp, &amp_16, sizeof (amp_16));
+            }
+            else {
+                memcpy (comp, &amp, sizeof (amp));
+            }
+        }
+    }
+}
+
+static void _test_check_pos (uint32_t mode, uint32_t comp_size, uint32_t i,
+        const char *how, const double *pos, const double *expected)
+{
+    static const char *comp_names [SMIO_ACQ_NUM_COMP] = {"X", "Y", "Q", "SUM"};
+
+    uint32_t j;
+    for (j = 0; j < SMIO_ACQ_NUM_COMP; ++j) {
+        TEST_CHECK(_test_close (pos [j], expected [j]),
+                "%u-bit, mode %u, sample %u %s: %s is %.17g, expected %.17g",
+                comp_size*8, mode, i, how, comp_names [j], pos [j],
+                expected [j]);
+    }
+}
+
+static void _test_calc (const acq_pos_cal_t *cal, uint32_t mode,
+        uint32_t comp_size)
+{
+    uint32_t sample_size = SMIO_ACQ_NUM_COMP*comp_size;
+    uint8_t data [TEST_NUM_SAMPLES*SMIO_ACQ_NUM_COMP*sizeof (int32_t)];
+    uint8_t cols [TEST_NUM_SAMPLES*SMIO_ACQ_NUM_COMP*sizeof (int32_t)];
+    double pos [TEST_NUM_SAMPLES][SMIO_ACQ_NUM_COMP];
+
+    _test_interleave (data, comp_size);
+    acq_soa_deinterleave (cols, data, TEST_NUM_SAMPLES, sample_size);
+    acq_ds_calc (cal, mode, cols, TEST_NUM_SAMPLES, sample_size,
+            (uint8_t *) pos);
+
+    uint32_t i;
+    for (i = 0; i < TEST_NUM_SAMPLES; ++i) {
+        const double *expected = (mode == ACQ_DS_MODE_PDS) ?
+            samples [i].pds : samples [i].ds;
+        _test_check_pos (mode, comp_size, i, "batch", pos [i], expected);
+
+        /* A sample computed on its own always takes the scalar path */
+        uint8_t one_cols [SMIO_ACQ_NUM_COMP*sizeof (int32_t)];
+        double one_pos [SMIO_ACQ_NUM_COMP];
+        acq_soa_deinterleave (one_cols, data + i*sample_size, 1, sample_size);
+        acq_ds_calc (cal, mode, one_cols, 1, sample_size, (uint8_t *) one_pos);
+        _test_check_pos (mode, comp_size, i, "alone", one_pos, expected);
+    }
+}
+
+int main (void)
+{
+    acq_pos_cal_t cal;
+    memset (&cal, 0, sizeof (cal));
+    cal.kx = TEST_KX;
+    cal.ky = TEST_KY;
+    cal.ksum = TEST_KSUM;
+    cal.ds_thres = TEST_DS_THRES;
+    cal.scale [3] = (double) cal.ksum / (1 << ACQ_POS_KSUM_FRAC_BITS);
+
+    _test_calc (&cal, ACQ_DS_MODE_DS, sizeof (int16_t));
+    _test_calc (&cal, ACQ_DS_MODE_DS, sizeof (int32_t));
+    _test_calc (&cal, ACQ_DS_MODE_PDS, sizeof (int16_t));
+    _test_calc (&cal, ACQ_DS_MODE_PDS, sizeof (int32_t));
+
+    if (failures > 0) {
+        fprintf (stderr, "[acq_ds_test] %u check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    printf ("[acq_ds_test] All checks passed\n");
+    return EXIT_SUCCESS;
+}
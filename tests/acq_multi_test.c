@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ *
+ * Two-core acquisition test. Both ACQ SMIOs of the AFCv3 run on top of two
+ * simulated ACQ cores, sharing a simulated DDR3. The thread safe client
+ * functions are stubbed by the simulation and the exported operations are
+ * called the way the dispatch table would.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <czmq.h>
+
+#include "sm_io_acq_exp.h"
+#include "sm_io_acq_exports.h"
+#include "sm_io_acq_codes.h"
+#include "wb_acq_core_regs.h"
+
+#define TEST_NUM_CORES              2
+#define TEST_NUM_REGS               (ACQ_CORE_REG_ACQ_CHAN_CTL + 1)
+#define TEST_MAX_SPANS              16
+#define TEST_UNWRITTEN              0xFFFFFFFF
+
+#define TEST_CHAN                   ADC0_CHAN_ID
+/* More than a block, so the readout takes several requests */
+#define TEST_SAMPLES_0              (BLOCK_SIZE/8 + 1000)
+#define TEST_SAMPLES_1              (BLOCK_SIZE/16 + 300)
+
+#define TEST_CHECK(test_boolean, ...)                                         \
+    do {                                                                      \
+        if (!(test_boolean)) {                                                \
+            fprintf (stderr, "[acq_multi_test] %s:%d: ", __FILE__, __LINE__); \
+            fprintf (stderr, __VA_ARGS__);                                    \
+            fprintf (stderr, "\n");                                           \
+            failures++;                                                       \
+        }                                                                     \
+    } while (0)
+
+/* What an acquisition wrote to the DDR3. Each word tells the acquisition
+ * it belongs to and its position in it */
+typedef struct {
+    uint32_t start_addr;
+    uint32_t size;
+    uint32_t tag;
+} test_span_t;
+
+/* Simulated ACQ cores. An acquisition is in flight from its start until
+ * the test finishes it with _test_core_finish () */
+static uint32_t regs [TEST_NUM_CORES][TEST_NUM_REGS];
+static bool running [TEST_NUM_CORES];
+static uint32_t next_tag [TEST_NUM_CORES];
+static uint32_t reg_writes [TEST_NUM_CORES];
+
+/* Simulated DDR3, shared by the cores. The latest span wins */
+static test_span_t spans [TEST_MAX_SPANS];
+static unsigned int num_spans;
+
+static unsigned int failures;
+
+static uint32_t _test_word (uint32_t tag, uint32_t index)
+{
+    return (tag << 24) | (index & 0xFFFFFF);
+}
+
+static uint32_t _test_ddr3_read (uint32_t addr)
+{
+    unsigned int i;
+    for (i = num_spans; i > 0; --i) {
+        const test_span_t *span = &spans [i-1];
+        if (addr >= span->start_addr && addr - span->start_addr < span->size) {
+            return _test_word (span->tag, (addr - span->start_addr) /
+                    sizeof (uint32_t));
+        }
+    }
+
+    return TEST_UNWRITTEN;
+}
+
+/* The acquisition in flight on core "core" is over. It writes the whole
+ * region it was given and returns the tag of its words */
+static uint32_t _test_core_finish (uint32_t core)
+{
+    uint32_t *r = regs [core];
+    uint32_t chan = ACQ_CORE_ACQ_CHAN_CTL_WHICH_R(r [ACQ_CORE_REG_ACQ_CHAN_CTL]);
+    uint32_t shots = ACQ_CORE_SHOTS_NB_R(r [ACQ_CORE_REG_SHOTS]);
+    uint32_t samples = r [ACQ_CORE_REG_PRE_SAMPLES] + r [ACQ_CORE_REG_POST_SAMPLES];
+
+    test_span_t *span = &spans [num_spans++ % TEST_MAX_SPANS];
+    span->start_addr = r [ACQ_CORE_REG_DDR3_START_ADDR] * DDR3_ADDR_WORD_2_BYTE;
+    span->size = samples * shots * __acq_buf [core][chan].sample_size;
+    span->tag = (core << 4) | (next_tag [core]++ & 0xF);
+
+    running [core] = false;
+    r [ACQ_CORE_REG_STA] |= ACQ_CORE_STA_DDR3_TRANS_DONE;
+    return span->tag;
+}
+
+/* Stubs for the functions sm_io.c would provide */
+const smio_thsafe_client_ops_t smio_thsafe_client_zmq_ops;
+
+smio_err_e smio_init_exp_ops (smio_t *self, disp_op_t** smio_exp_ops,
+        const disp_table_func_fp *func_fps)
+{
+    (void) self;
+
+    for ( ; *smio_exp_ops != NULL && *func_fps != NULL; ++smio_exp_ops,
+            ++func_fps) {
+        (*smio_exp_ops)->func_fp = *func_fps;
+    }
+
+    return (*smio_exp_ops == NULL && *func_fps == NULL) ? SMIO_SUCCESS :
+        SMIO_ERR_EXPORT_OP;
+}
+
+/* Stubs for the thread safe client functions. Each SMIO talks to the core
+ * of its instance */
+ssize_t smio_thsafe_client_read_32 (smio_t *self, loff_t offs, uint32_t *data)
+{
+    if (self->inst_id >= TEST_NUM_CORES || offs < 0 || offs >= TEST_NUM_REGS) {
+        return -1;
+    }
+
+    *data = regs [self->inst_id][offs];
+    return sizeof (uint32_t);
+}
+
+ssize_t smio_thsafe_client_write_32 (smio_t *self, loff_t offs,
+        const uint32_t *data)
+{
+    if (self->inst_id >= TEST_NUM_CORES || offs < 0 || offs >= TEST_NUM_REGS) {
+        return -1;
+    }
+
+    uint32_t core = self->inst_id;
+    regs [core][offs] = *data;
+    reg_writes [core]++;
+
+    if (offs == ACQ_CORE_REG_CTL && (*data & ACQ_CORE_CTL_FSM_START_ACQ)) {
+        running [core] = true;
+        regs [core][ACQ_CORE_REG_STA] &= ~ACQ_CORE_STA_DDR3_TRANS_DONE;
+    }
+
+    return sizeof (uint32_t);
+}
+
+/* The position calculation core is not simulated */
+ssize_t smio_thsafe_raw_client_read_32 (smio_t *self, loff_t offs,
+        uint32_t *data)
+{
+    (void) self;
+    (void) offs;
+    (void) data;
+    return -1;
+}
+
+ssize_t smio_thsafe_raw_client_read_block (smio_t *self, loff_t offs,
+        size_t size, uint32_t *data)
+{
+    (void) self;
+
+    if ((offs & LARGE_MEM_ADDR) != LARGE_MEM_ADDR) {
+        return -1;
+    }
+
+    uint32_t addr = offs & ~((loff_t) LARGE_MEM_ADDR);
+    size_t i;
+    for (i = 0; i < size/sizeof (uint32_t); ++i) {
+        data [i] = _test_ddr3_read (addr + i*sizeof (uint32_t));
+    }
+
+    return size;
+}
+
+/* Call exported operation "opcode" with arguments "args", as the dispatch
+ * table would */
+static int _test_exec (smio_t *smio, uint32_t opcode, const uint32_t *args,
+        size_t num_args, void *ret)
+{
+    const disp_op_t **op;
+    for (op = acq_exp_ops; *op != NULL && (*op)->opcode != opcode; ++op);
+    if (*op == NULL) {
+        return -ACQ_NOT_COMPLETED;
+    }
+
+    zmsg_t *msg = zmsg_new ();
+    size_t i;
+    for (i = 0; i < num_args; ++i) {
+        zmsg_addmem (msg, &args [i], sizeof (args [i]));
+    }
+
+    exp_msg_zmq_t exp_msg = {
+        .tag = EXP_MSG_ZMQ_TAG,
+        .msg = &msg,
+        .reply_to = NULL,
+        .recv_ts = 0
+    };
+
+    int err = (*op)->func_fp (smio, &exp_msg, ret);
+    zmsg_destroy (&msg);
+    return err;
+}
+
+static int _test_acquire (smio_t *smio, uint32_t num_samples)
+{
+    uint32_t args [] = {num_samples, TEST_CHAN, 0, 1};
+    return _test_exec (smio, ACQ_OPCODE_DATA_ACQUIRE, args, 4, NULL);
+}
+
+static int _test_check (smio_t *smio)
+{
+    return _test_exec (smio, ACQ_OPCODE_CHECK_DATA_ACQUIRE, NULL, 0, NULL);
+}
+
+/* Read the whole curve of the last acquisition of "smio" and check it is
+ * the one tagged "tag" */
+static void _test_read_curve (smio_t *smio, uint32_t num_samples, uint32_t tag)
+{
+    static smio_acq_data_block_t block;
+    uint32_t curve_size = num_samples * __acq_buf [smio->inst_id][TEST_CHAN].sample_size;
+    uint32_t read_bytes = 0;
+    uint32_t block_n;
+
+    for (block_n = 0; read_bytes < curve_size; ++block_n) {
+        uint32_t args [] = {TEST_CHAN, block_n};
+        int err = _test_exec (smio, ACQ_OPCODE_GET_DATA_BLOCK, args, 2, &block);
+        TEST_CHECK(err > 0, "core %u: block %u not read (%d)", smio->inst_id,
+                block_n, err);
+        if (err <= 0) {
+            return;
+        }
+
+        const uint32_t *words = (const uint32_t *) block.data;
+        uint32_t first = read_bytes / sizeof (uint32_t);
+        uint32_t i;
+        for (i = 0; i < block.valid_bytes / sizeof (uint32_t); ++i) {
+            if (words [i] != _test_word (tag, first + i)) {
+                TEST_CHECK(false, "core %u: word %u is 0x%08"PRIX32", expected "
+                        "0x%08"PRIX32, smio->inst_id, first + i, words [i],
+                        _test_word (tag, first + i));
+                return;
+            }
+        }
+
+        read_bytes += block.valid_bytes;
+    }
+
+    TEST_CHECK(read_bytes == curve_size, "core %u: read %u bytes, expected %u",
+            smio->inst_id, read_bytes, curve_size);
+}
+
+/* The channel regions of a core share no DDR3 memory with the other's */
+static void _test_regions (smio_t *smio)
+{
+    const acq_buf_t *buf_0 = ((smio_acq_t *) smio [0].smio_handler)->acq_buf;
+    const acq_buf_t *buf_1 = ((smio_acq_t *) smio [1].smio_handler)->acq_buf;
+
+    TEST_CHECK(buf_0 == __acq_buf [0] && buf_1 == __acq_buf [1],
+            "cores not given their own DDR3 table");
+
+    uint32_t i, j;
+    for (i = 0; i < END_CHAN_ID; ++i) {
+        for (j = 0; j < END_CHAN_ID; ++j) {
+            if (buf_0 [i].max_samples == 0 || buf_1 [j].max_samples == 0) {
+                continue;
+            }
+
+            TEST_CHECK(buf_0 [i].end_addr < buf_1 [j].start_addr ||
+                    buf_1 [j].end_addr < buf_0 [i].start_addr,
+                    "channel %u of core 0 overlaps channel %u of core 1", i, j);
+        }
+    }
+}
+
+/* Each core is armed on its own and read while the other one is still
+ * acquiring */
+static void _test_overlap (smio_t *smio)
+{
+    int err = _test_acquire (&smio [0], TEST_SAMPLES_0);
+    TEST_CHECK(err == -ACQ_OK, "core 0 not started (%d)", err);
+    err = _test_acquire (&smio [1], TEST_SAMPLES_1);
+    TEST_CHECK(err == -ACQ_OK, "core 1 not started with core 0 running (%d)",
+            err);
+    TEST_CHECK(running [0] && running [1], "both cores should be acquiring");
+
+    uint32_t addr_0 = regs [0][ACQ_CORE_REG_DDR3_START_ADDR] * DDR3_ADDR_WORD_2_BYTE;
+    uint32_t addr_1 = regs [1][ACQ_CORE_REG_DDR3_START_ADDR] * DDR3_ADDR_WORD_2_BYTE;
+    TEST_CHECK(addr_0 == __acq_buf [0][TEST_CHAN].start_addr,
+            "core 0 acquires at 0x%08"PRIX32, addr_0);
+    TEST_CHECK(addr_1 == __acq_buf [1][TEST_CHAN].start_addr,
+            "core 1 acquires at 0x%08"PRIX32, addr_1);
+
+    TEST_CHECK(_test_check (&smio [0]) == -ACQ_NOT_COMPLETED,
+            "core 0 done before finishing");
+    TEST_CHECK(_test_check (&smio [1]) == -ACQ_NOT_COMPLETED,
+            "core 1 done before finishing");
+
+    /* Core 1 finishes first and is read while core 0 still acquires. The
+     * readout must leave core 0 alone */
+    uint32_t tag_1 = _test_core_finish (1);
+    uint32_t writes_0 = reg_writes [0];
+    TEST_CHECK(_test_check (&smio [1]) == -ACQ_OK, "core 1 not done");
+    _test_read_curve (&smio [1], TEST_SAMPLES_1, tag_1);
+    TEST_CHECK(_test_check (&smio [0]) == -ACQ_NOT_COMPLETED,
+            "core 0 done after reading core 1");
+    TEST_CHECK(reg_writes [0] == writes_0 && running [0],
+            "reading core 1 touched core 0");
+
+    /* Core 1 is armed again, still with core 0 in flight */
+    err = _test_acquire (&smio [1], TEST_SAMPLES_1);
+    TEST_CHECK(err == -ACQ_OK, "core 1 not restarted (%d)", err);
+
+    /* Core 0 is read while core 1 acquires */
+    uint32_t tag_0 = _test_core_finish (0);
+    uint32_t writes_1 = reg_writes [1];
+    TEST_CHECK(_test_check (&smio [0]) == -ACQ_OK, "core 0 not done");
+    _test_read_curve (&smio [0], TEST_SAMPLES_0, tag_0);
+    TEST_CHECK(reg_writes [1] == writes_1 && running [1],
+            "reading core 0 touched core 1");
+
+    /* The second acquisition of core 1 replaced its first one. Core 0 still
+     * reads its own */
+    tag_1 = _test_core_finish (1);
+    TEST_CHECK(_test_check (&smio [1]) == -ACQ_OK, "core 1 not done again");
+    _test_read_curve (&smio [1], TEST_SAMPLES_1, tag_1);
+    _test_read_curve (&smio [0], TEST_SAMPLES_0, tag_0);
+}
+
+int main (void)
+{
+    smio_t smio [TEST_NUM_CORES + 1];
+    memset (smio, 0, sizeof (smio));
+
+    uint32_t i;
+    for (i = 0; i < TEST_NUM_CORES + 1; ++i) {
+        smio [i].inst_id = i;
+    }
+
+    /* There is no third core */
+    smio_err_e err = acq_bootstrap_ops.init (&smio [TEST_NUM_CORES]);
+    TEST_CHECK(err != SMIO_SUCCESS, "ACQ instance %u initialized",
+            TEST_NUM_CORES);
+
+    for (i = 0; i < TEST_NUM_CORES; ++i) {
+        err = acq_bootstrap_ops.init (&smio [i]);
+        TEST_CHECK(err == SMIO_SUCCESS, "ACQ instance %u not initialized", i);
+        if (err != SMIO_SUCCESS) {
+            goto err_init;
+        }
+    }
+
+    _test_regions (smio);
+    _test_overlap (smio);
+
+err_init:
+    while (i-- > 0) {
+        acq_bootstrap_ops.shutdown (&smio [i]);
+    }
+
+    if (failures > 0) {
+        fprintf (stderr, "[acq_multi_test] %u check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    printf ("[acq_multi_test] All checks passed\n");
+    return EXIT_SUCCESS;
+}
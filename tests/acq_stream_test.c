@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ *
+ * Streaming acquisition test. The thread safe client functions are stubbed
+ * with a simulated ACQ core, which writes a known pattern to a ring in
+ * memory, and the published messages are read back by a SUB socket.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <czmq.h>
+
+#include "sm_io_acq_core.h"
+#include "sm_io_acq_stream.h"
+#include "wb_acq_core_regs.h"
+
+#define TEST_BROKER                 "ipc:///tmp/bpm_sw_acq_stream_test"
+#define TEST_SERVICE                "ACQ0"
+#define TEST_ENDPOINT               TEST_BROKER"-"TEST_SERVICE".stream"
+#define TEST_RCV_TIMEOUT            1000    /* in ms */
+#define TEST_CONNECT_WAIT           200     /* in ms */
+
+#define TEST_CHAN                   0
+#define TEST_SAMPLE_WORDS           4
+#define TEST_SAMPLE_SIZE            (TEST_SAMPLE_WORDS*sizeof (uint32_t))
+#define TEST_RING_SAMPLES           1000
+#define TEST_MAX_SAMPLES            4096
+#define TEST_TRIG_CFG               (ACQ_CORE_TRIG_CFG_HW_TRIG_EN | \
+                                        ACQ_CORE_TRIG_CFG_SW_TRIG_EN | 0x1)
+#define TEST_NUM_REGS               (ACQ_CORE_REG_ACQ_CHAN_CTL + 1)
+
+#define TEST_CHECK(test_boolean, ...)                                          \
+    do {                                                                       \
+        if (!(test_boolean)) {                                                 \
+            fprintf (stderr, "[acq_stream_test] %s:%d: ", __FILE__, __LINE__); \
+            fprintf (stderr, __VA_ARGS__);                                     \
+            fprintf (stderr, "\n");                                            \
+            failures++;                                                        \
+        }                                                                      \
+    } while (0)
+
+/* Simulated ACQ core: registers, samples counter and DDR3 ring */
+static uint32_t regs [TEST_NUM_REGS];
+static uint32_t ddr3 [TEST_MAX_SAMPLES*TEST_SAMPLE_WORDS];
+static uint64_t core_written;
+static unsigned int failures;
+
+static acq_buf_t acq_buf [END_CHAN_ID];
+
+/* Every word of a sample tells which stream sample it is */
+static void _test_sample (uint64_t index, uint32_t *sample)
+{
+    sample [0] = index & 0xFFFFFFFF;
+    sample [1] = index >> 32;
+    sample [2] = ~sample [0];
+    sample [3] = 0xACC00000 | TEST_CHAN;
+}
+
+/* The core writes "num_samples" more samples into the ring */
+static void _test_core_write (uint32_t num_samples)
+{
+    uint32_t ring_samples = regs [ACQ_CORE_REG_PRE_SAMPLES];
+
+    uint32_t i;
+    for (i = 0; i < num_samples; ++i, ++core_written) {
+        uint32_t ring_off = core_written % ring_samples;
+        _test_sample (core_written, ddr3 + ring_off*TEST_SAMPLE_WORDS);
+    }
+
+    regs [ACQ_CORE_REG_SAMPLES_CNT] = core_written & 0xFFFFFFFF;
+}
+
+/* Stubs for the thread safe client functions sm_io_acq_stream.c uses */
+ssize_t smio_thsafe_client_read_32 (smio_t *self, loff_t offs, uint32_t *data)
+{
+    (void) self;
+
+    if (offs < 0 || offs >= TEST_NUM_REGS) {
+        return -1;
+    }
+
+    *data = regs [offs];
+    return sizeof (uint32_t);
+}
+
+ssize_t smio_thsafe_client_write_32 (smio_t *self, loff_t offs,
+        const uint32_t *data)
+{
+    (void) self;
+
+    if (offs < 0 || offs >= TEST_NUM_REGS) {
+        return -1;
+    }
+
+    regs [offs] = *data;
+
+    /* Starting an acquisition restarts the samples counter */
+    if (offs == ACQ_CORE_REG_CTL && (*data & ACQ_CORE_CTL_FSM_START_ACQ)) {
+        core_written = 0;
+        regs [ACQ_CORE_REG_SAMPLES_CNT] = 0;
+    }
+
+    return sizeof (uint32_t);
+}
+
+ssize_t smio_thsafe_raw_client_read_block (smio_t *self, loff_t offs,
+        size_t size, uint32_t *data)
+{
+    (void) self;
+
+    if ((offs & LARGE_MEM_ADDR) != LARGE_MEM_ADDR) {
+        return -1;
+    }
+
+    offs &= ~((loff_t) LARGE_MEM_ADDR);
+    if (offs < 0 || (size_t) offs + size > sizeof (ddr3)) {
+        return -1;
+    }
+
+    memcpy (data, (const uint8_t *) ddr3 + offs, size);
+    return size;
+}
+
+/* Receive one stream message and check it carries "num_samples" samples
+ * of the pattern, starting at "first_sample" */
+static void _test_recv (void *sub, uint32_t seq, uint64_t first_sample,
+        uint32_t num_samples, uint64_t lost)
+{
+    zmsg_t *msg = zmsg_recv (sub);
+    TEST_CHECK(msg != NULL, "message %u not received", seq);
+    if (msg == NULL) {
+        return;
+    }
+
+    zframe_t *hdr_frame = zmsg_pop (msg);
+    zframe_t *data_frame = zmsg_pop (msg);
+    TEST_CHECK(hdr_frame != NULL && zframe_size (hdr_frame) ==
+            sizeof (smio_acq_stream_hdr_t), "message %u has a bad header", seq);
+    TEST_CHECK(data_frame != NULL, "message %u has no samples", seq);
+    if (hdr_frame == NULL || data_frame == NULL ||
+            zframe_size (hdr_frame) != sizeof (smio_acq_stream_hdr_t)) {
+        goto err_frames;
+    }
+
+    smio_acq_stream_hdr_t hdr;
+    memcpy (&hdr, zframe_data (hdr_frame), sizeof (hdr));
+    TEST_CHECK(hdr.seq == seq, "sequence %"PRIu32", expected %"PRIu32, hdr.seq,
+            seq);
+    TEST_CHECK(hdr.chan == TEST_CHAN, "message %u from channel %"PRIu32, seq,
+            hdr.chan);
+    TEST_CHECK(hdr.first_sample == first_sample, "message %u starts at %"PRIu64
+            ", expected %"PRIu64, seq, hdr.first_sample, first_sample);
+    TEST_CHECK(hdr.lost == lost, "message %u lost %"PRIu64", expected %"PRIu64, seq,
+            hdr.lost, lost);
+    TEST_CHECK(zframe_size (data_frame) == num_samples*TEST_SAMPLE_SIZE,
+            "message %u has %zu bytes, expected %zu", seq,
+            zframe_size (data_frame), num_samples*TEST_SAMPLE_SIZE);
+    if (zframe_size (data_frame) != num_samples*TEST_SAMPLE_SIZE) {
+        goto err_frames;
+    }
+
+    const uint32_t *data = (const uint32_t *) zframe_data (data_frame);
+    uint32_t i;
+    for (i = 0; i < num_samples; ++i) {
+        uint32_t expected [TEST_SAMPLE_WORDS];
+        _test_sample (first_sample + i, expected);
+        if (memcmp (data + i*TEST_SAMPLE_WORDS, expected,
+                    TEST_SAMPLE_SIZE) != 0) {
+            TEST_CHECK(false, "message %u sample %"PRIu64" does not match", seq,
+                    first_sample + i);
+            break;
+        }
+    }
+
+err_frames:
+    zframe_destroy (&data_frame);
+    zframe_destroy (&hdr_frame);
+    zmsg_destroy (&msg);
+}
+
+static void _test_no_msg (void *sub)
+{
+    zmsg_t *msg = zmsg_recv (sub);
+    TEST_CHECK(msg == NULL, "unexpected message");
+    zmsg_destroy (&msg);
+}
+
+static void _test_start_errors (smio_t *smio)
+{
+    int err = acq_stream_start (smio, END_CHAN_ID, TEST_RING_SAMPLES);
+    TEST_CHECK(err == -ACQ_NUM_CHAN_OOR, "channel out of range returned %d", err);
+
+    err = acq_stream_start (smio, TEST_CHAN, 0);
+    TEST_CHECK(err == -ACQ_NUM_SAMPLES_OOR, "no samples returned %d", err);
+
+    err = acq_stream_start (smio, TEST_CHAN, TEST_MAX_SAMPLES+1);
+    TEST_CHECK(err == -ACQ_NUM_SAMPLES_OOR, "too many samples returned %d", err);
+}
+
+static void _test_stream (smio_t *smio, zctx_t *ctx)
+{
+    regs [ACQ_CORE_REG_TRIG_CFG] = TEST_TRIG_CFG;
+
+    int err = acq_stream_start (smio, TEST_CHAN, TEST_RING_SAMPLES);
+    TEST_CHECK(err == -ACQ_OK, "start returned %d", err);
+    if (err != -ACQ_OK) {
+        return;
+    }
+
+    TEST_CHECK(acq_stream_is_running (smio), "stream not running after start");
+
+    err = acq_stream_start (smio, TEST_CHAN, TEST_RING_SAMPLES);
+    TEST_CHECK(err == -ACQ_STREAM_BUSY, "second start returned %d", err);
+
+    /* The core must be waiting for a trigger that never comes */
+    TEST_CHECK((regs [ACQ_CORE_REG_TRIG_CFG] & (ACQ_CORE_TRIG_CFG_HW_TRIG_EN |
+                    ACQ_CORE_TRIG_CFG_SW_TRIG_EN)) == 0,
+            "triggers left enabled: 0x%08"PRIX32, regs [ACQ_CORE_REG_TRIG_CFG]);
+    TEST_CHECK(regs [ACQ_CORE_REG_SHOTS] == ACQ_CORE_SHOTS_NB_W(1), "%"PRIu32
+            " shots", regs [ACQ_CORE_REG_SHOTS]);
+    TEST_CHECK(regs [ACQ_CORE_REG_PRE_SAMPLES] == TEST_RING_SAMPLES, "ring of %"
+            PRIu32" samples", regs [ACQ_CORE_REG_PRE_SAMPLES]);
+    TEST_CHECK(regs [ACQ_CORE_REG_POST_SAMPLES] == 0, "%"PRIu32" post-trigger "
+            "samples", regs [ACQ_CORE_REG_POST_SAMPLES]);
+
+    smio_acq_stream_status_t status;
+    acq_stream_status (smio, &status);
+    TEST_CHECK(strcmp (status.endpoint, TEST_ENDPOINT) == 0, "endpoint \"%s\"",
+            status.endpoint);
+
+    void *sub = zsocket_new (ctx, ZMQ_SUB);
+    TEST_CHECK(sub != NULL, "could not create the SUB socket");
+    if (sub == NULL) {
+        goto err_sub_alloc;
+    }
+    zsocket_set_subscribe (sub, "");
+    zsocket_set_rcvtimeo (sub, TEST_RCV_TIMEOUT);
+    int rc = zsocket_connect (sub, "%s", status.endpoint);
+    TEST_CHECK(rc == 0, "could not connect to %s", status.endpoint);
+    if (rc != 0) {
+        goto err_sub_connect;
+    }
+    zclock_sleep (TEST_CONNECT_WAIT);
+
+    /* Nothing written, nothing published */
+    acq_stream_tick (smio);
+
+    /* Within the ring */
+    _test_core_write (300);
+    acq_stream_tick (smio);
+    _test_recv (sub, 0, 0, 300, 0);
+
+    _test_core_write (600);
+    acq_stream_tick (smio);
+    _test_recv (sub, 1, 300, 600, 0);
+
+    /* Across the end of the ring, split in two messages */
+    _test_core_write (500);
+    acq_stream_tick (smio);
+    _test_recv (sub, 2, 900, 100, 0);
+    _test_recv (sub, 3, 1000, 400, 0);
+
+    /* More than the guard allows. Only the newest 3/4 of the ring are
+     * read and the rest is reported as lost */
+    _test_core_write (900);
+    acq_stream_tick (smio);
+    _test_recv (sub, 4, 1550, 450, 150);
+    _test_recv (sub, 5, 2000, 300, 0);
+
+    acq_stream_status (smio, &status);
+    TEST_CHECK(status.running == 1, "stream not running");
+    TEST_CHECK(status.pos == 2300, "%"PRIu64" samples published", status.pos);
+    TEST_CHECK(status.lost == 150, "%"PRIu64" samples lost", status.lost);
+    TEST_CHECK(status.overruns == 1, "%"PRIu32" overruns", status.overruns);
+
+    /* Stopping publishes what is left and restores the triggers */
+    _test_core_write (50);
+    err = acq_stream_stop (smio);
+    TEST_CHECK(err == -ACQ_OK, "stop returned %d", err);
+    TEST_CHECK(!acq_stream_is_running (smio), "stream running after stop");
+    _test_recv (sub, 6, 2300, 50, 0);
+    TEST_CHECK(regs [ACQ_CORE_REG_CTL] == ACQ_CORE_CTL_FSM_STOP_ACQ,
+            "core not stopped: 0x%08"PRIX32, regs [ACQ_CORE_REG_CTL]);
+    TEST_CHECK(regs [ACQ_CORE_REG_TRIG_CFG] == TEST_TRIG_CFG, "trigger "
+            "configuration not restored: 0x%08"PRIX32,
+            regs [ACQ_CORE_REG_TRIG_CFG]);
+
+    /* A stopped stream publishes nothing */
+    _test_core_write (10);
+    acq_stream_tick (smio);
+    _test_no_msg (sub);
+
+err_sub_connect:
+    zsocket_destroy (ctx, sub);
+err_sub_alloc:
+    acq_stream_close (smio);
+}
+
+int main (void)
+{
+    zctx_t *ctx = zctx_new ();
+    if (ctx == NULL) {
+        fprintf (stderr, "[acq_stream_test] Could not create the context\n");
+        return EXIT_FAILURE;
+    }
+
+    acq_buf [TEST_CHAN].id = TEST_CHAN;
+    acq_buf [TEST_CHAN].start_addr = 0;
+    acq_buf [TEST_CHAN].end_addr = sizeof (ddr3) - 1;
+    acq_buf [TEST_CHAN].max_samples = TEST_MAX_SAMPLES;
+    acq_buf [TEST_CHAN].sample_size = TEST_SAMPLE_SIZE;
+
+    smio_acq_t *acq = calloc (1, sizeof (*acq));
+    if (acq == NULL) {
+        fprintf (stderr, "[acq_stream_test] Could not allocate memory\n");
+        zctx_destroy (&ctx);
+        return EXIT_FAILURE;
+    }
+    acq->acq_buf = acq_buf;
+
+    smio_t smio;
+    memset (&smio, 0, sizeof (smio));
+    smio.service = TEST_SERVICE;
+    smio.broker = TEST_BROKER;
+    smio.ctx = ctx;
+    smio.smio_handler = acq;
+
+    _test_start_errors (&smio);
+    _test_stream (&smio, ctx);
+
+    free (acq);
+    zctx_destroy (&ctx);
+
+    if (failures > 0) {
+        fprintf (stderr, "[acq_stream_test] %u check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    printf ("[acq_stream_test] All checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,463 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ *
+ * Front-end event loop test. Each board is a simulated RFFE listening on
+ * the loopback interface, reached through the real ll_io_eth code. The
+ * replies to the SMIOs are caught by a stub msg_send_sock_reply ().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <czmq.h>
+
+#include "dev_io_fe_loop.h"
+#include "ll_io_eth.h"
+#include "ll_io_endpoint.h"
+#include "msg.h"
+#include "sm_io_thsafe_codes.h"
+
+#define TEST_NUM_RFFES              4
+#define TEST_SLOW_DELAY             200     /* in ms */
+#define TEST_WAIT_TIMEOUT           (DEVIO_FE_LOOP_XFER_TIMEOUT + \
+                                        DEVIO_FE_LOOP_REOPEN_MIN + 1000) /* in ms */
+
+/* Requests and replies look like BSMP messages: command, 16-bit payload
+ * size and payload. The reply command is the request one plus 1 and its
+ * payload is the inverted request payload */
+#define TEST_HDR_SIZE               3
+#define TEST_PAYLOAD_SIZE           8
+#define TEST_MSG_SIZE               (TEST_HDR_SIZE + TEST_PAYLOAD_SIZE)
+#define TEST_CMD                    0x10
+
+#define TEST_CHECK(test_boolean, ...)                                       \
+    do {                                                                    \
+        if (!(test_boolean)) {                                              \
+            fprintf (stderr, "[fe_loop_test] %s:%d: ", __FILE__, __LINE__); \
+            fprintf (stderr, __VA_ARGS__);                                  \
+            fprintf (stderr, "\n");                                         \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+enum _test_sim_mode_e {
+    TEST_SIM_FAST = 0,                  /* Replies right away */
+    TEST_SIM_SLOW,                      /* Replies in two parts, with a
+                                           delay in between */
+    TEST_SIM_SILENT,                    /* Never replies */
+    TEST_SIM_HANGUP                     /* Hangs up on the first request,
+                                           then behaves as TEST_SIM_FAST */
+};
+
+typedef enum _test_sim_mode_e test_sim_mode_e;
+
+/* A simulated RFFE and the board that reaches it */
+struct _test_rffe_t {
+    test_sim_mode_e mode;
+    int listen_fd;
+    uint16_t port;
+    pthread_t thread;
+
+    char endpoint_name [64];
+    llio_t llio;
+    devio_board_t board;
+
+    /* Last reply to the SMIO */
+    unsigned int replies;
+    int reply_ret;
+    uint8_t reply_data [TEST_MSG_SIZE];
+};
+
+typedef struct _test_rffe_t test_rffe_t;
+
+static test_rffe_t rffes [TEST_NUM_RFFES];
+static unsigned int failures;
+
+/* Stands for the SMIO pipe. "reply_to" is the simulated RFFE of the board */
+msg_err_e msg_send_sock_reply (void *reply_to, int disp_table_ret, void *ret)
+{
+    test_rffe_t *rffe = (test_rffe_t *) reply_to;
+
+    rffe->replies++;
+    rffe->reply_ret = disp_table_ret;
+    memset (rffe->reply_data, 0, sizeof (rffe->reply_data));
+    if (disp_table_ret > 0 && ret != NULL) {
+        size_t size = (size_t) disp_table_ret < sizeof (rffe->reply_data) ?
+            (size_t) disp_table_ret : sizeof (rffe->reply_data);
+        memcpy (rffe->reply_data, ret, size);
+    }
+
+    return MSG_SUCCESS;
+}
+
+static uint64_t _test_get_ts_ms (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec*1000 + ts.tv_nsec/1000000;
+}
+
+static bool _test_recvall (int fd, uint8_t *buf, size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = recv (fd, buf + done, len - done, 0);
+        if (n <= 0) {
+            return false;
+        }
+        done += n;
+    }
+
+    return true;
+}
+
+static void _test_request (uint8_t *msg)
+{
+    msg [0] = TEST_CMD;
+    msg [1] = 0;
+    msg [2] = TEST_PAYLOAD_SIZE;
+
+    size_t i;
+    for (i = 0; i < TEST_PAYLOAD_SIZE; ++i) {
+        msg [TEST_HDR_SIZE + i] = i;
+    }
+}
+
+static void _test_reply (const uint8_t *request, uint8_t *reply)
+{
+    reply [0] = request [0] + 1;
+    reply [1] = request [1];
+    reply [2] = request [2];
+
+    size_t i;
+    for (i = 0; i < TEST_PAYLOAD_SIZE; ++i) {
+        reply [TEST_HDR_SIZE + i] = ~request [TEST_HDR_SIZE + i];
+    }
+}
+
+/* Simulated RFFE. Serves one connection at a time, for as long as the test
+ * runs */
+static void *_test_sim (void *arg)
+{
+    test_rffe_t *rffe = (test_rffe_t *) arg;
+    bool hangup = (rffe->mode == TEST_SIM_HANGUP);
+
+    while (1) {
+        int fd = accept (rffe->listen_fd, NULL, NULL);
+        if (fd == -1) {
+            break;
+        }
+
+        uint8_t request [TEST_MSG_SIZE];
+        uint8_t reply [TEST_MSG_SIZE];
+        while (_test_recvall (fd, request, sizeof (request))) {
+            if (hangup) {
+                hangup = false;
+                break;
+            }
+
+            if (rffe->mode == TEST_SIM_SILENT) {
+                continue;
+            }
+
+            _test_reply (request, reply);
+            if (rffe->mode == TEST_SIM_SLOW) {
+                send (fd, reply, TEST_HDR_SIZE, MSG_NOSIGNAL);
+                usleep (TEST_SLOW_DELAY*1000);
+                send (fd, reply + TEST_HDR_SIZE, TEST_PAYLOAD_SIZE, MSG_NOSIGNAL);
+            }
+            else {
+                send (fd, reply, sizeof (reply), MSG_NOSIGNAL);
+            }
+        }
+
+        close (fd);
+    }
+
+    return NULL;
+}
+
+static bool _test_sim_start (test_rffe_t *rffe, test_sim_mode_e mode)
+{
+    rffe->mode = mode;
+    rffe->listen_fd = socket (AF_INET, SOCK_STREAM, 0);
+    if (rffe->listen_fd == -1) {
+        return false;
+    }
+
+    /* Any free port on the loopback interface */
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof (addr);
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    if (bind (rffe->listen_fd, (struct sockaddr *) &addr, sizeof (addr)) == -1 ||
+            listen (rffe->listen_fd, 1) == -1 ||
+            getsockname (rffe->listen_fd, (struct sockaddr *) &addr,
+                &addr_len) == -1) {
+        close (rffe->listen_fd);
+        return false;
+    }
+    rffe->port = ntohs (addr.sin_port);
+
+    if (pthread_create (&rffe->thread, NULL, _test_sim, rffe) != 0) {
+        close (rffe->listen_fd);
+        return false;
+    }
+    pthread_detach (rffe->thread);
+
+    return true;
+}
+
+/* Connect the board to its simulated RFFE, the same way the DEVIO does */
+static bool _test_board_open (test_rffe_t *rffe, const char *name)
+{
+    snprintf (rffe->endpoint_name, sizeof (rffe->endpoint_name),
+            "tcp://127.0.0.1:%"PRIu16, rffe->port);
+
+    rffe->llio.type = ETH_DEV;
+    rffe->llio.name = (char *) name;
+    rffe->llio.endpoint = llio_endpoint_new (rffe->endpoint_name);
+    rffe->llio.ops = &llio_ops_eth;
+    if (rffe->llio.endpoint == NULL) {
+        return false;
+    }
+
+    rffe->board.name = (char *) name;
+    rffe->board.llio = &rffe->llio;
+
+    return llio_ops_eth.open (&rffe->llio, rffe->llio.endpoint) == 0;
+}
+
+static void _test_board_close (test_rffe_t *rffe)
+{
+    if (rffe->llio.endpoint != NULL) {
+        llio_ops_eth.release (&rffe->llio, rffe->llio.endpoint);
+        llio_endpoint_destroy (&rffe->llio.endpoint);
+    }
+}
+
+/* Hand a block transfer request of the board SMIO to the loop. Returns
+ * whatever devio_fe_loop_start () does */
+static bool _test_start (devio_fe_loop_t *loop, test_rffe_t *rffe,
+        uint32_t opcode, const void *data, size_t size)
+{
+    loff_t offs = 0;
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addmem (msg, &opcode, sizeof (opcode));
+    zmsg_addmem (msg, &offs, sizeof (offs));
+    zmsg_addmem (msg, data, size);
+
+    zmq_server_args_t args = {.tag = ZMQ_SERVER_ARGS_TAG, .msg = &msg,
+        .reply_to = rffe};
+    bool taken = devio_fe_loop_start (loop, &rffe->board, &args);
+
+    zmsg_destroy (&msg);
+    return taken;
+}
+
+static bool _test_write (devio_fe_loop_t *loop, test_rffe_t *rffe)
+{
+    uint8_t request [TEST_MSG_SIZE];
+    _test_request (request);
+    return _test_start (loop, rffe, THSAFE_OPCODE_WRITE_BLOCK, request,
+            sizeof (request));
+}
+
+static bool _test_read (devio_fe_loop_t *loop, test_rffe_t *rffe)
+{
+    size_t size = TEST_MSG_SIZE;
+    return _test_start (loop, rffe, THSAFE_OPCODE_READ_BLOCK, &size,
+            sizeof (size));
+}
+
+/* Run the loop, as the DEVIO poller would, until the board SMIO gets
+ * "replies" replies or the timeout expires */
+static bool _test_wait (devio_fe_loop_t *loop, test_rffe_t *rffe,
+        unsigned int replies, uint32_t timeout_ms)
+{
+    uint64_t deadline_ms = _test_get_ts_ms () + timeout_ms;
+    struct pollfd pfd = {.fd = devio_fe_loop_get_fd (loop), .events = POLLIN};
+
+    while (rffe->replies < replies && _test_get_ts_ms () < deadline_ms) {
+        poll (&pfd, 1, 10);
+        devio_fe_loop_run (loop);
+    }
+
+    return rffe->replies >= replies;
+}
+
+static bool _test_reply_ok (test_rffe_t *rffe)
+{
+    uint8_t request [TEST_MSG_SIZE];
+    uint8_t reply [TEST_MSG_SIZE];
+    _test_request (request);
+    _test_reply (request, reply);
+
+    return rffe->reply_ret == TEST_MSG_SIZE &&
+        memcmp (rffe->reply_data, reply, sizeof (reply)) == 0;
+}
+
+/* Write block replies carry the result as data, as the thsafe server
+ * does */
+static int32_t _test_write_ret (test_rffe_t *rffe)
+{
+    int32_t ret;
+    memcpy (&ret, rffe->reply_data, sizeof (ret));
+    return (rffe->reply_ret == sizeof (ret)) ? ret : INT32_MIN;
+}
+
+static bool _test_write_ok (test_rffe_t *rffe)
+{
+    return _test_write_ret (rffe) == TEST_MSG_SIZE;
+}
+
+/* A slow RFFE must not hold up the others */
+static void _test_slow_board (devio_fe_loop_t *loop, test_rffe_t *fast,
+        test_rffe_t *slow)
+{
+    TEST_CHECK(_test_write (loop, slow) && _test_wait (loop, slow, 1, 0) &&
+            _test_write_ok (slow), "write to the slow RFFE failed");
+    TEST_CHECK(_test_read (loop, slow), "read from the slow RFFE not taken");
+    TEST_CHECK(devio_fe_loop_board_busy (loop, &slow->board),
+            "slow RFFE replied before its delay");
+
+    /* Only one transfer at a time */
+    unsigned int slow_replies = slow->replies;
+    TEST_CHECK(_test_read (loop, slow) && slow->replies == ++slow_replies &&
+            slow->reply_ret == -1, "second transfer to a busy RFFE accepted");
+
+    uint64_t start_ms = _test_get_ts_ms ();
+    TEST_CHECK(_test_write (loop, fast) && _test_wait (loop, fast, 1, 0) &&
+            _test_write_ok (fast), "write to the fast RFFE failed");
+    TEST_CHECK(_test_read (loop, fast), "read from the fast RFFE not taken");
+    TEST_CHECK(_test_wait (loop, fast, 2, TEST_SLOW_DELAY/2) &&
+            _test_reply_ok (fast), "fast RFFE reply was held up");
+    TEST_CHECK(devio_fe_loop_board_busy (loop, &slow->board),
+            "slow RFFE replied after %"PRIu64" ms", _test_get_ts_ms () - start_ms);
+
+    TEST_CHECK(_test_wait (loop, slow, slow_replies + 1, TEST_WAIT_TIMEOUT) &&
+            _test_reply_ok (slow), "slow RFFE reply is wrong");
+    TEST_CHECK(!devio_fe_loop_board_busy (loop, &slow->board),
+            "slow RFFE still busy after its reply");
+}
+
+/* Anything but block transfers is left to the thsafe server */
+static void _test_not_taken (devio_fe_loop_t *loop, test_rffe_t *rffe)
+{
+    uint32_t value = 0;
+    TEST_CHECK(!_test_start (loop, rffe, THSAFE_OPCODE_READ_32, &value,
+                sizeof (value)), "read_32 taken by the loop");
+
+    /* The read size must be a size_t */
+    unsigned int replies = rffe->replies;
+    TEST_CHECK(_test_start (loop, rffe, THSAFE_OPCODE_READ_BLOCK, &value,
+                sizeof (value)) && rffe->replies == replies + 1 &&
+            rffe->reply_ret == -1, "read with a bad size argument accepted");
+}
+
+/* A hung up RFFE fails the transfer and is reconnected after a while */
+static void _test_hangup (devio_fe_loop_t *loop, test_rffe_t *rffe)
+{
+    unsigned int replies = rffe->replies;
+    TEST_CHECK(_test_write (loop, rffe) && _test_read (loop, rffe),
+            "transfers to the RFFE not taken");
+    TEST_CHECK(_test_wait (loop, rffe, replies + 2, TEST_WAIT_TIMEOUT) &&
+            rffe->reply_ret == -1, "hang up not detected");
+
+    /* Broken until reconnected */
+    replies = rffe->replies;
+    TEST_CHECK(_test_write (loop, rffe) && rffe->replies == replies + 1 &&
+            _test_write_ret (rffe) == -1, "transfer to a broken RFFE accepted");
+
+    /* The reconnection is only tried by the loop, after the backoff */
+    uint64_t deadline_ms = _test_get_ts_ms () + TEST_WAIT_TIMEOUT;
+    bool reconnected = false;
+    while (!reconnected && _test_get_ts_ms () < deadline_ms) {
+        _test_wait (loop, rffe, UINT_MAX, 100);
+
+        replies = rffe->replies;
+        reconnected = _test_write (loop, rffe) &&
+            _test_wait (loop, rffe, replies + 1, 0) && _test_write_ok (rffe);
+    }
+    TEST_CHECK(reconnected, "RFFE not reconnected");
+
+    replies = rffe->replies;
+    TEST_CHECK(_test_read (loop, rffe) &&
+            _test_wait (loop, rffe, replies + 1, TEST_WAIT_TIMEOUT) &&
+            _test_reply_ok (rffe), "RFFE reply after reconnecting is wrong");
+}
+
+/* A silent RFFE does not keep the SMIO waiting forever */
+static void _test_timeout (devio_fe_loop_t *loop, test_rffe_t *rffe)
+{
+    unsigned int replies = rffe->replies;
+    TEST_CHECK(_test_write (loop, rffe) && _test_read (loop, rffe),
+            "transfers to the RFFE not taken");
+
+    uint64_t start_ms = _test_get_ts_ms ();
+    TEST_CHECK(_test_wait (loop, rffe, replies + 2, TEST_WAIT_TIMEOUT) &&
+            rffe->reply_ret == -1, "silent RFFE transfer did not time out");
+
+    uint64_t elapsed_ms = _test_get_ts_ms () - start_ms;
+    TEST_CHECK(elapsed_ms >= DEVIO_FE_LOOP_XFER_TIMEOUT - TEST_SLOW_DELAY,
+            "silent RFFE transfer timed out after %"PRIu64" ms", elapsed_ms);
+}
+
+int main (void)
+{
+    static const test_sim_mode_e modes [TEST_NUM_RFFES] = {
+        TEST_SIM_FAST, TEST_SIM_SLOW, TEST_SIM_HANGUP, TEST_SIM_SILENT};
+    static const char *names [TEST_NUM_RFFES] = {
+        "RFFE0", "RFFE1", "RFFE2", "RFFE3"};
+
+    devio_fe_loop_t *loop = devio_fe_loop_new ();
+    if (loop == NULL) {
+        fprintf (stderr, "[fe_loop_test] Could not create the loop\n");
+        return EXIT_FAILURE;
+    }
+
+    unsigned int i;
+    for (i = 0; i < TEST_NUM_RFFES; ++i) {
+        if (!_test_sim_start (&rffes [i], modes [i]) ||
+                !_test_board_open (&rffes [i], names [i]) ||
+                devio_fe_loop_add_board (loop, &rffes [i].board) != DEVIO_SUCCESS) {
+            fprintf (stderr, "[fe_loop_test] Could not set up %s\n", names [i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    _test_slow_board (loop, &rffes [0], &rffes [1]);
+    _test_not_taken (loop, &rffes [0]);
+    _test_hangup (loop, &rffes [2]);
+    _test_timeout (loop, &rffes [3]);
+
+    for (i = 0; i < TEST_NUM_RFFES; ++i) {
+        devio_fe_loop_remove_board (loop, &rffes [i].board);
+        _test_board_close (&rffes [i]);
+        close (rffes [i].listen_fd);
+    }
+    devio_fe_loop_destroy (&loop);
+
+    if (failures > 0) {
+        fprintf (stderr, "[fe_loop_test] %u check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    printf ("[fe_loop_test] All checks passed\n");
+    return EXIT_SUCCESS;
+}
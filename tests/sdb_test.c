@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2014 LNLS (www.lnls.br)
+ * Author: Lucas Russo <lucas.russo@lnls.br>
+ *
+ * Released according to the GNU LGPL, version 3 or any later version.
+ *
+ * SDB bus walk test. A stub llio_read_block () serves a synthetic SDB ROM,
+ * so no hardware is needed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "sdb.h"
+
+/* Any bit above the ROM size works. sdb.c must OR it into every read */
+#define TEST_ADDR_FLAGS             ((loff_t) 1 << 28)
+
+#define TEST_ROM_SIZE               0x200   /* in bytes */
+#define TEST_ROM_WORDS              (TEST_ROM_SIZE/sizeof (uint32_t))
+#define TEST_ROOT_TABLE             0x000
+#define TEST_CHILD_TABLE            0x100   /* relative to the root bus */
+#define TEST_BRIDGE_BASE            0x10000
+
+#define TEST_VENDOR_ID              0x0000CE42ULL
+#define TEST_ACQ_DEVICE_ID          0x4519A0ADU
+#define TEST_FMC_DEVICE_ID          0x68E3B1AFU
+
+#define TEST_CHECK(test_boolean, ...)                                   \
+    do {                                                                \
+        if (!(test_boolean)) {                                          \
+            fprintf (stderr, "[sdb_test] %s:%d: ", __FILE__, __LINE__); \
+            fprintf (stderr, __VA_ARGS__);                              \
+            fprintf (stderr, "\n");                                     \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+static uint32_t rom [TEST_ROM_WORDS];
+static unsigned int failures;
+
+/* Stub for the only llio function sdb.c uses */
+ssize_t llio_read_block (llio_t *self, loff_t offs, size_t size, uint32_t *data)
+{
+    (void) self;
+
+    if ((offs & TEST_ADDR_FLAGS) == 0) {
+        return -1;
+    }
+
+    offs &= ~TEST_ADDR_FLAGS;
+    if (offs < 0 || (size_t) offs + size > TEST_ROM_SIZE) {
+        return -1;
+    }
+
+    memcpy (data, (const uint8_t *) rom + offs, size);
+    return size;
+}
+
+static uint32_t *_test_record (loff_t table, unsigned int index)
+{
+    return rom + (table + index*SDB_RECORD_SIZE)/sizeof (uint32_t);
+}
+
+/* Names are stored big-endian from word 11, as the bus walk expects */
+static void _test_set_name (uint32_t *rec, const char *name)
+{
+    size_t i;
+    for (i = 0; i < SDB_NAME_SIZE; ++i) {
+        uint8_t c = (i < strlen (name)) ? name [i] : ' ';
+        rec [11 + i/4] |= (uint32_t) c << (24 - 8*(i % 4));
+    }
+}
+
+static void _test_set_record (uint32_t *rec, uint8_t type, uint64_t first,
+        uint64_t last, uint32_t device_id, const char *name)
+{
+    rec [2] = first >> 32;
+    rec [3] = first & 0xFFFFFFFF;
+    rec [4] = last >> 32;
+    rec [5] = last & 0xFFFFFFFF;
+    rec [6] = TEST_VENDOR_ID >> 32;
+    rec [7] = TEST_VENDOR_ID & 0xFFFFFFFF;
+    rec [8] = device_id;
+    _test_set_name (rec, name);
+    rec [15] |= type;
+}
+
+static void _test_set_interconnect (loff_t table, uint16_t records)
+{
+    uint32_t *rec = _test_record (table, 0);
+    rec [0] = SDB_MAGIC;
+    rec [1] = (uint32_t) records << 16;
+    _test_set_record (rec, SDB_INTERCONNET, 0, 0, 0, "WB4-Crossbar-GSI");
+}
+
+/* Root bus: interconnect, ACQ device, bridge and an empty record.
+ * Bridge bus: interconnect and FMC device, with addresses relative
+ * to the bridge */
+static void _test_build_rom (void)
+{
+    memset (rom, 0, sizeof (rom));
+
+    _test_set_interconnect (TEST_ROOT_TABLE, 4);
+    _test_set_record (_test_record (TEST_ROOT_TABLE, 1), SDB_DEVICE,
+            0x1000, 0x1FFF, TEST_ACQ_DEVICE_ID, "BPM_ACQ");
+
+    uint32_t *bridge = _test_record (TEST_ROOT_TABLE, 2);
+    _test_set_record (bridge, SDB_BRIDGE, TEST_BRIDGE_BASE,
+            TEST_BRIDGE_BASE + 0xFFFF, 0, "WB4-Bridge-GSI");
+    bridge [0] = 0;
+    bridge [1] = TEST_CHILD_TABLE;
+
+    _test_record (TEST_ROOT_TABLE, 3) [15] = SDB_EMPTY;
+
+    _test_set_interconnect (TEST_CHILD_TABLE, 2);
+    _test_set_record (_test_record (TEST_CHILD_TABLE, 1), SDB_DEVICE,
+            0x100, 0x1FF, TEST_FMC_DEVICE_ID, "FMC_130M_4CH");
+}
+
+static void _test_checksum (void)
+{
+    /* Standard CRC-32 check value */
+    const char *check = "123456789";
+    uint32_t crc = sdb_checksum ((const uint32_t *) check, strlen (check));
+    TEST_CHECK(crc == 0xCBF43926, "CRC-32 of \"123456789\" is 0x%08"PRIX32, crc);
+
+    /* Updating in pieces must match a single pass */
+    crc = sdb_checksum_update (sdb_checksum ((const uint32_t *) check, 4),
+            (const uint32_t *) (check + 4), 5);
+    TEST_CHECK(crc == 0xCBF43926, "CRC-32 in two pieces is 0x%08"PRIX32, crc);
+}
+
+static void _test_get_devices (llio_t *llio)
+{
+    sdb_dev_t devs [4];
+    sdb_tables_t tables;
+
+    ssize_t num_devs = sdb_get_devices (llio, TEST_ROOT_TABLE, TEST_ADDR_FLAGS,
+            devs, 4, &tables);
+    TEST_CHECK(num_devs == 2, "found %zd devices", num_devs);
+    if (num_devs != 2) {
+        return;
+    }
+
+    TEST_CHECK(devs [0].vendor_id == TEST_VENDOR_ID, "ACQ vendor 0x%016"PRIX64,
+            devs [0].vendor_id);
+    TEST_CHECK(devs [0].device_id == TEST_ACQ_DEVICE_ID, "ACQ device 0x%08"PRIX32,
+            devs [0].device_id);
+    TEST_CHECK(devs [0].addr_first == 0x1000 && devs [0].addr_last == 0x1FFF,
+            "ACQ at 0x%"PRIX64"-0x%"PRIX64, devs [0].addr_first,
+            devs [0].addr_last);
+    TEST_CHECK(strcmp (devs [0].name, "BPM_ACQ") == 0, "ACQ name \"%s\"",
+            devs [0].name);
+
+    TEST_CHECK(devs [1].device_id == TEST_FMC_DEVICE_ID, "FMC device 0x%08"PRIX32,
+            devs [1].device_id);
+    TEST_CHECK(devs [1].addr_first == TEST_BRIDGE_BASE + 0x100 &&
+            devs [1].addr_last == TEST_BRIDGE_BASE + 0x1FF,
+            "FMC at 0x%"PRIX64"-0x%"PRIX64, devs [1].addr_first,
+            devs [1].addr_last);
+    TEST_CHECK(strcmp (devs [1].name, "FMC_130M_4CH") == 0, "FMC name \"%s\"",
+            devs [1].name);
+
+    TEST_CHECK(tables.num_tables == 2, "stored %zu tables", tables.num_tables);
+    TEST_CHECK(tables.table [0].addr == TEST_ROOT_TABLE &&
+            tables.table [0].records == 4, "root table at 0x%"PRIX64
+            " with %"PRIu32" records", tables.table [0].addr,
+            tables.table [0].records);
+    TEST_CHECK(tables.table [1].addr == TEST_CHILD_TABLE &&
+            tables.table [1].records == 2, "child table at 0x%"PRIX64
+            " with %"PRIu32" records", tables.table [1].addr,
+            tables.table [1].records);
+
+    uint32_t checksum = sdb_checksum_update (
+            sdb_checksum (_test_record (TEST_ROOT_TABLE, 0), 4*SDB_RECORD_SIZE),
+            _test_record (TEST_CHILD_TABLE, 0), 2*SDB_RECORD_SIZE);
+    TEST_CHECK(tables.checksum == checksum, "tables checksum 0x%08"PRIX32
+            ", expected 0x%08"PRIX32, tables.checksum, checksum);
+
+    /* Unchanged ROM */
+    TEST_CHECK(sdb_check_tables (llio, TEST_ADDR_FLAGS, &tables),
+            "unchanged tables reported as changed");
+
+    /* A device moved inside the bridge */
+    uint32_t *fmc = _test_record (TEST_CHILD_TABLE, 1);
+    fmc [3] += 0x1000;
+    TEST_CHECK(!sdb_check_tables (llio, TEST_ADDR_FLAGS, &tables),
+            "moved device not detected");
+    fmc [3] -= 0x1000;
+    TEST_CHECK(sdb_check_tables (llio, TEST_ADDR_FLAGS, &tables),
+            "restored tables reported as changed");
+
+    /* A different number of records in the root table */
+    uint32_t *root = _test_record (TEST_ROOT_TABLE, 0);
+    root [1] = 3 << 16;
+    TEST_CHECK(!sdb_check_tables (llio, TEST_ADDR_FLAGS, &tables),
+            "new record count not detected");
+    root [1] = 4 << 16;
+}
+
+static void _test_max_devs (llio_t *llio)
+{
+    sdb_dev_t devs [1];
+
+    ssize_t num_devs = sdb_get_devices (llio, TEST_ROOT_TABLE, TEST_ADDR_FLAGS,
+            devs, 1, NULL);
+    TEST_CHECK(num_devs == 1, "found %zd devices with room for 1", num_devs);
+}
+
+static void _test_bad_magic (llio_t *llio)
+{
+    sdb_dev_t devs [4];
+    sdb_tables_t tables;
+
+    uint32_t *child = _test_record (TEST_CHILD_TABLE, 0);
+    child [0] = ~SDB_MAGIC;
+
+    ssize_t num_devs = sdb_get_devices (llio, TEST_ROOT_TABLE, TEST_ADDR_FLAGS,
+            devs, 4, &tables);
+    TEST_CHECK(num_devs < 0, "bad bridge magic accepted with %zd devices",
+            num_devs);
+
+    child [0] = SDB_MAGIC;
+}
+
+int main (void)
+{
+    llio_t llio;
+    memset (&llio, 0, sizeof (llio));
+
+    _test_build_rom ();
+
+    _test_checksum ();
+    _test_get_devices (&llio);
+    _test_max_devs (&llio);
+    _test_bad_magic (&llio);
+
+    if (failures > 0) {
+        fprintf (stderr, "[sdb_test] %u check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    printf ("[sdb_test] All checks passed\n");
+    return EXIT_SUCCESS;
+}